@@ -37,6 +37,7 @@ namespace lmms
 
 class AudioEngine;
 class AudioPort;
+class MixerChannel;
 
 
 class AudioDevice
@@ -64,6 +65,22 @@ public:
 	virtual void unregisterPort( AudioPort * _port );
 	virtual void renamePort( AudioPort * _port );
 
+	// if audio-driver can provide separate outputs for mixer channels, it
+	// gets every channel right after the mixer processed it, on the
+	// rendering thread - currently only supported by JACK
+	virtual void writeMixerChannel( mix_ch_t /* _index */,
+					MixerChannel * /* _channel */,
+					const fpp_t /* _frames */ )
+	{
+	}
+
+	// whether the audio engine has to render ahead into a FIFO on a thread
+	// of its own; drivers rendering straight from their callback return false
+	virtual bool needsFifo()
+	{
+		return true;
+	}
+
 
 	inline bool supportsCapture() const
 	{
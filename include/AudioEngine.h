@@ -54,6 +54,9 @@ class AudioEngineWorkerThread;
 
 const fpp_t MINIMUM_BUFFER_SIZE = 32;
 const fpp_t DEFAULT_BUFFER_SIZE = 256;
+// largest period an engine only rendering can be created with, see lmms-bench;
+// exports keep the default, as most plugins read their controls once per period
+const fpp_t MAXIMUM_RENDER_BUFFER_SIZE = 8192;
 
 const int BYTES_PER_SAMPLE = sizeof( sample_t );
 const int BYTES_PER_INT_SAMPLE = sizeof( int_sample_t );
@@ -227,6 +230,9 @@ public:
 	{
 		requestChangeInModel();
 		m_audioPorts.push_back(port);
+		// renderStageEffects() splits the ports without allocating
+		m_detectorPorts.reserve(m_audioPorts.size());
+		m_dependentPorts.reserve(m_audioPorts.size());
 		doneChangeInModel();
 	}
 
@@ -355,7 +361,8 @@ public:
 	inline bool isMetronomeActive() const { return m_metronomeActive; }
 	inline void setMetronomeActive(bool value = true) { m_metronomeActive = value; }
 
-	//! Block until a change in model can be done (i.e. wait for audio thread)
+	//! Block until a change in model can be done (i.e. wait for audio thread).
+	//! Changes may nest, the audio thread waits until the outermost one is done.
 	void requestChangeInModel();
 	void doneChangeInModel();
 
@@ -396,7 +403,9 @@ private:
 	} ;
 
 
-	AudioEngine( bool renderOnly );
+	//! @param renderFramesPerPeriod Period size when only rendering, realtime
+	//! engines take theirs from the configuration
+	AudioEngine( bool renderOnly, fpp_t renderFramesPerPeriod = DEFAULT_BUFFER_SIZE );
 	~AudioEngine() override;
 
 	void startProcessing(bool needsFifo = true);
@@ -407,6 +416,7 @@ private:
 	MidiClient * tryMidiClients();
 
 	void renderStageNoteSetup();
+	void renderStageControllers();
 	void renderStageInstruments();
 	void renderStageEffects();
 	void renderStageMix();
@@ -422,6 +432,9 @@ private:
 	bool m_renderOnly;
 
 	std::vector<AudioPort *> m_audioPorts;
+	// the ports running peak controller detectors and the others, reused every period
+	std::vector<AudioPort *> m_detectorPorts;
+	std::vector<AudioPort *> m_dependentPorts;
 
 	fpp_t m_framesPerPeriod;
 
@@ -57,6 +57,7 @@ public:
 
 	enum class DetailType {
 		NoteSetup,
+		Controllers,
 		Instruments,
 		Effects,
 		Mixing,
@@ -70,6 +71,12 @@ public:
 		return m_detailLoad[static_cast<std::size_t>(type)].load(std::memory_order_relaxed);
 	}
 
+	//! Time in microseconds the given stage took in the last period; only meaningful on the rendering thread
+	int detailTime(const DetailType type) const
+	{
+		return m_detailTime[static_cast<std::size_t>(type)];
+	}
+
 	class Probe
 	{
 	public:
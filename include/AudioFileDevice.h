@@ -27,6 +27,17 @@
 #define LMMS_AUDIO_FILE_DEVICE_H
 
 #include <QFile>
+#include <vector>
+
+#ifdef __MINGW32__
+#include <mingw.condition_variable.h>
+#include <mingw.mutex.h>
+#include <mingw.thread.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
 
 #include "AudioDevice.h"
 #include "OutputSettings.h"
@@ -49,6 +60,19 @@ public:
 
 	OutputSettings const & getOutputSettings() const { return m_outputSettings; }
 
+	//! Hands a period rendered at the processing sample rate over to the
+	//! encoder thread, which resamples and encodes it. Periods are gathered
+	//! into large blocks; this only blocks while every block of the ring
+	//! is still waiting for the encoder.
+	void enqueue( const surroundSampleFrame * _ab, const fpp_t _frames,
+						const float _master_gain );
+
+	//! Starts the encoder thread
+	void startProcessing() override;
+	//! Encodes everything enqueued so far and stops the encoder thread;
+	//! has to be called before the device is destroyed
+	void stopProcessing() override;
+
 
 protected:
 	int writeData( const void* data, int len );
@@ -64,8 +88,42 @@ protected:
 	}
 
 private:
+	struct Block
+	{
+		std::vector<surroundSampleFrame> frames;
+		// set when the block is queued, only read by the encoder thread
+		// until it is done with the block
+		fpp_t used = 0;
+		float masterGain = 1.0f;
+	};
+
+	void submitBlock();
+	void encodeBlocks();
+
+	static constexpr std::size_t RingBlocks = 4;
+	// encoders are most efficient with large buffers
+	static constexpr fpp_t MinBlockFrames = 8192;
+
 	QFile m_outputFile;
 	OutputSettings m_outputSettings;
+
+	std::vector<Block> m_blocks;
+	std::vector<surroundSampleFrame> m_resampleBuffer;
+	// the block being filled is always the one after the queued ones; it
+	// only belongs to the rendering thread while m_fillFrames > 0
+	std::size_t m_fillBlock = 0;
+	fpp_t m_fillFrames = 0;
+	float m_fillGain = 1.0f;
+	std::size_t m_encodeBlock = 0;
+
+	// hand-over to the encoder thread, all guarded by m_queueMutex
+	std::mutex m_queueMutex;
+	std::condition_variable m_blockQueued;
+	std::condition_variable m_blockEncoded;
+	std::size_t m_queuedBlocks = 0;
+	bool m_finishing = false;
+
+	std::thread m_encoderThread;
 } ;
 
 using AudioFileDeviceInstantiaton
@@ -29,6 +29,7 @@
 
 #include "AudioFileDevice.h"
 #include <sndfile.h>
+#include <vector>
 
 namespace lmms
 {
@@ -65,6 +66,10 @@ private:
 	SF_INFO  m_sfinfo;
 	SNDFILE* m_sf;
 
+	// interleaved samples, reused for every buffer
+	std::vector<sample_t> m_floatBuffer;
+	std::vector<int_sample_t> m_intBuffer;
+
 	void writeBuffer(surroundSampleFrame const* _ab,
 						fpp_t const frames,
 						float master_gain) override;
@@ -34,6 +34,8 @@
 
 #include "lame/lame.h"
 
+#include <vector>
+
 namespace lmms
 {
 
@@ -69,6 +71,10 @@ private:
 
 private:
 	lame_t m_lame;
+
+	// reused for every buffer, the encoder thread passes large ones
+	std::vector<float> m_interleavedDataBuffer;
+	std::vector<unsigned char> m_encodingBuffer;
 };
 
 } // namespace lmms
@@ -37,10 +37,18 @@
 #include <atomic>
 #include <vector>
 
+#ifdef __MINGW32__
+#include <mingw.mutex.h>
+#else
+#include <mutex>
+#endif
+
 #include "AudioDevice.h"
 #include "AudioDeviceSetupWidget.h"
 
+class QCheckBox;
 class QLineEdit;
+class QTimer;
 
 namespace lmms
 {
@@ -83,10 +91,15 @@ public:
 	private:
 		QLineEdit* m_clientName;
 		gui::LcdSpinBox* m_channels;
+		QCheckBox* m_mixerChannelOutputs;
 	};
 
+	void writeMixerChannel(mix_ch_t index, MixerChannel* channel, const fpp_t frames) override;
+	bool needsFifo() override;
+
 private slots:
 	void restartAfterZombified();
+	void updateMixerChannelPorts();
 
 private:
 	bool initJackClient();
@@ -117,6 +130,23 @@ private:
 	f_cnt_t m_framesDoneInCurBuf;
 	f_cnt_t m_framesToDoInCurBuf;
 
+	//! Stereo output of a mixer channel other than the master
+	struct MixerChannelPorts
+	{
+		QString name;
+		jack_port_t* ports[DEFAULT_CHANNELS];
+		jack_default_audio_sample_t* buffers[DEFAULT_CHANNELS]; //!< Port buffers of the current callback
+		//! One engine period, for when the periods of JACK and the engine differ
+		std::vector<jack_default_audio_sample_t> staging[DEFAULT_CHANNELS];
+	};
+
+	bool m_mixerChannelOutputs;
+	std::vector<MixerChannelPorts> m_mixerChannelPorts; //!< Entry i belongs to mixer channel i + 1
+	std::mutex m_mixerChannelMutex; //!< Guards m_mixerChannelPorts; the callback only ever tries to lock it
+	bool m_mixerChannelsActive; //!< Whether the current callback writes the mixer channel ports
+	bool m_renderDirectly; //!< Whether the current period is rendered straight into the port buffers
+	QTimer* m_mixerChannelTimer;
+
 #ifdef AUDIO_PORT_SUPPORT
 	struct StereoPort
 	{
@@ -26,7 +26,7 @@
 #define LMMS_AUTOMATABLE_MODEL_H
 
 #include <QMap>
-#include <QMutex>
+#include <atomic>
 #include <cmath>
 
 #include "JournallingObject.h"
@@ -175,8 +175,13 @@ public:
 
 	//! @brief Function that returns sample-exact data as a ValueBuffer
 	//! @return pointer to model's valueBuffer when s.ex.data exists, NULL otherwise
+	//! The buffer comes from ValueBufferPool and is only valid during the current period.
 	ValueBuffer * valueBuffer();
 
+	//! @brief Returns the values of the model during the current period
+	//! Unlike valueBuffer(), this does not write ramps to a buffer, so prefer it if you can handle ramps.
+	ValueSpan valueSpan();
+
 	template<class T>
 	T initValue() const
 	{
@@ -213,7 +218,9 @@ public:
 
 	void setInitValue( const float value );
 
-	void setAutomatedValue( const float value );
+	//! @param frameOffset The frame of the current period the value applies from. If automation changes the model
+	//! several times in one period, its values for the period ramp towards each change in turn.
+	void setAutomatedValue( const float value, const f_cnt_t frameOffset = 0 );
 	void setValue( const float value );
 
 	void incValue( int steps )
@@ -288,7 +295,7 @@ public:
 	// has to be accessed by more than one object, then this function shouldn't be used.
 	bool isValueChanged()
 	{
-		if( m_valueChanged || valueBuffer() )
+		if( m_valueChanged || !valueSpan().isConstant() )
 		{
 			m_valueChanged = false;
 			return true;
@@ -407,14 +414,30 @@ private:
 	ControllerConnection* m_controllerConnection;
 
 
-	ValueBuffer m_valueBuffer;
-	long m_lastUpdatedPeriod;
-	static long s_periodCounter;
+	//! Ensures the values of the current period are known, computing them on the first call of the period
+	void updatePeriodValues();
 
-	bool m_hasSampleExactData;
+	// the period the values below belong to, or UpdatingPeriod while a thread computes them
+	std::atomic<long> m_lastUpdatedPeriod;
+	static constexpr long UpdatingPeriod = -2;
+	static long s_periodCounter;
 
-	// prevent several threads from attempting to write the same vb at the same time
-	QMutex m_valueBufferMutex;
+	// during that period the model either ramps from m_rampStart to m_rampEnd,
+	// or has the sample-exact values in m_periodBuffer, which comes from ValueBufferPool;
+	// a ramp is only written to a buffer if somebody asks for one
+	float m_rampStart;
+	float m_rampEnd;
+	std::atomic<ValueBuffer*> m_periodBuffer;
+
+	//! Makes the values of the current period reach @p value at @p frameOffset, coming from the previous change
+	void addAutomationPoint( float oldValue, float value, f_cnt_t frameOffset );
+
+	// automation changing the model within the period m_automationPeriod has written the values
+	// up to m_automationFrame to m_automationBuffer, which come from ValueBufferPool as well
+	long m_automationPeriod;
+	ValueBuffer* m_automationBuffer;
+	f_cnt_t m_automationFrame;
+	float m_automationValue;
 
 	bool m_useControllerValue;
 
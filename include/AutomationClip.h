@@ -69,12 +69,13 @@ public:
 
 	AutomationClip( AutomationTrack * _auto_track );
 	AutomationClip( const AutomationClip & _clip_to_copy );
-	~AutomationClip() override = default;
+	~AutomationClip() override;
 
 	bool addObject( AutomatableModel * _obj, bool _search_dup = true );
 
 	const AutomatableModel * firstObject() const;
 	const objectVector& objects() const;
+	bool automates(const AutomatableModel* model) const;
 
 	// progression-type stuff
 	inline ProgressionType progressionType() const
@@ -205,6 +206,8 @@ public slots:
 
 private:
 	void cleanObjects();
+	//! Informs the song about edits to tempo automation from @p tick on
+	void invalidateTempoMap(tick_t tick) const;
 	void generateTangents();
 	void generateTangents(timeMap::iterator it, int numToGenerate);
 	float valueAt( timeMap::const_iterator v, int offset ) const;
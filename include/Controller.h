@@ -26,6 +26,8 @@
 #ifndef LMMS_CONTROLLER_H
 #define LMMS_CONTROLLER_H
 
+#include <atomic>
+
 #include "lmms_export.h"
 #include "Engine.h"
 #include "Model.h"
@@ -130,6 +132,17 @@ public:
 	static void triggerFrameCounter();
 	static void resetFrameCounter();
 
+	//! Evaluates all controllers in use once for the current period, controllers feeding the models of other
+	//! controllers first. Runs on the rendering thread before any play handle or effect reads a controller, so
+	//! those only read the finished buffers.
+	static void evaluateControllers();
+
+	//! Share of the period in percent this controller took to evaluate, averaged over the last periods
+	int evaluationLoad() const
+	{
+		return static_cast<int>(m_evaluationLoad.load(std::memory_order_relaxed));
+	}
+
 	//Accepts a ControllerConnection * as it may be used in the future.
 	void addConnection( ControllerConnection * );
 	void removeConnection( ControllerConnection * );
@@ -147,7 +160,9 @@ public slots:
 
 
 protected:
-	// The internal per-controller get-value function
+	// The internal per-controller get-value function; updates the buffer
+	// itself if evaluateControllers() didn't for this period, e.g. while
+	// the audio engine isn't running
 	virtual float value( int _offset );
 
 	virtual void updateValueBuffer();
@@ -170,6 +185,17 @@ protected:
 
 	static long s_periods;
 
+private:
+	void evaluate();
+
+	bool m_evaluating = false;
+	int m_evaluationTime = 0;
+	std::atomic<float> m_evaluationLoad = 0.0f;
+
+	// All controllers but the dummy one, including the MIDI controllers
+	// which aren't listed in s_controllers
+	static ControllerVector s_evaluatedControllers;
+
 
 signals:
 	// The value changed while the audio engine isn't running (i.e: MIDI CC)
@@ -69,6 +69,15 @@ public:
 	virtual bool processAudioBuffer( sampleFrame * _buf,
 						const fpp_t _frames ) = 0;
 
+	/*! Number of frames the effect keeps sounding after its input became
+		silent, or -1 if it can't tell. The effect chain stops effects with a
+		known tail as soon as it has been played instead of waiting for the
+		gate to close. */
+	virtual f_cnt_t tailLength() const
+	{
+		return -1;
+	}
+
 	inline ch_cnt_t processorCount() const
 	{
 		return m_processors;
@@ -224,6 +233,7 @@ private:
 	bool m_noRun;
 	bool m_running;
 	f_cnt_t m_bufferCount;
+	f_cnt_t m_silentInputFrames; // frames of silent input since the last sound, counted by EffectChain
 
 	BoolModel m_enabledModel;
 	FloatModel m_wetDryModel;
@@ -52,7 +52,8 @@ class LMMS_EXPORT Engine : public QObject
 {
 	Q_OBJECT
 public:
-	static void init( bool renderOnly );
+	//! @param renderFramesPerPeriod Period size of the audio engine when only rendering, 0 for the realtime default
+	static void init( bool renderOnly, fpp_t renderFramesPerPeriod = 0 );
 	static void destroy();
 
 	// core
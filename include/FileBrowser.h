@@ -42,6 +42,7 @@
 #include "lmmsconfig.h"
 
 class QLineEdit;
+class QTimer;
 
 namespace lmms
 {
@@ -55,6 +56,7 @@ namespace gui
 
 class FileItem;
 class FileBrowserTreeWidget;
+struct DirectoryListing;
 
 class FileBrowser : public SideBarWidget
 {
@@ -94,7 +96,9 @@ public:
 
 private slots:
 	void reloadTree();
-	void expandItems(const QList<QString>& expandedDirs, QTreeWidgetItem* item = nullptr);
+	//! Expands the directories in \p expandedDirs below \p item and removes them from the list
+	void expandItems(QList<QString>& expandedDirs, QTreeWidgetItem* item = nullptr);
+	void restoreDirectoryState(QTreeWidgetItem* item);
 	void giveFocusToFilter();
 
 private:
@@ -138,6 +142,9 @@ class FileBrowserTreeWidget : public QTreeWidget
 {
 	Q_OBJECT
 public:
+	//! Maximum number of entries added to the tree per timer tick while directories are being populated
+	static constexpr int EntriesPerBatch = 256;
+
 	FileBrowserTreeWidget( QWidget * parent );
 	~FileBrowserTreeWidget() override = default;
 
@@ -145,6 +152,15 @@ public:
 	//! that are expanded in the tree.
 	QList<QString> expandedDirs( QTreeWidgetItem * item = nullptr ) const;
 
+	//! Lists the paths of a directory item on the global thread pool. The
+	//! entries are added to the item in batches as they arrive, so that large
+	//! folders do not block the GUI.
+	void listDirectory(std::shared_ptr<DirectoryListing> listing);
+
+signals:
+	//! Emitted once all entries of an expanded directory were added.
+	void directoryPopulated(QTreeWidgetItem* item);
+
 protected:
 	void contextMenuEvent( QContextMenuEvent * e ) override;
 	void mousePressEvent( QMouseEvent * me ) override;
@@ -188,6 +204,11 @@ private slots:
 	void sendToActiveInstrumentTrack( lmms::gui::FileItem* item );
 	void updateDirectory( QTreeWidgetItem * item );
 	void openContainingFolder( lmms::gui::FileItem* item );
+	void addListedEntries();
+
+private:
+	std::vector<std::shared_ptr<DirectoryListing>> m_listings;
+	QTimer* m_listingTimer;
 
 } ;
 
@@ -197,6 +218,7 @@ class Directory : public QTreeWidgetItem
 {
 public:
 	Directory(const QString& filename, const QString& path, const QString& filter, bool disableEntryPopulation = false);
+	~Directory() override;
 
 	void update();
 
@@ -220,8 +242,11 @@ public:
 	}
 
 
+	//! Adds up to \p budget entries of a running listing to this directory.
+	//! Returns true once all of them were added.
+	bool addListedEntries(DirectoryListing& listing, int& budget);
+
 private:
-	bool addItems( const QString & path );
 
 
 	QPixmap m_folderPixmap = embed::getIconPixmap("folder");
@@ -240,6 +265,9 @@ private:
 
 	int m_dirCount;
 	bool m_disableEntryPopulation = false;
+
+	//! The listing that is currently populating this directory, if any
+	std::shared_ptr<DirectoryListing> m_listing;
 } ;
 
 
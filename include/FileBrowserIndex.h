@@ -0,0 +1,150 @@
+/*
+ * FileBrowserIndex.h - Persistent index of a directory tree for the file browser
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_FILE_BROWSER_INDEX_H
+#define LMMS_FILE_BROWSER_INDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <limits>
+#include <vector>
+
+class QDataStream;
+
+namespace lmms::gui {
+
+//! An in-memory copy of a directory tree that is kept on disk between sessions.
+//! Directories are only listed again when their modification time changes, so refreshing a large and mostly static
+//! tree costs one stat per directory instead of a full walk. Audio files additionally carry their format metadata,
+//! which is read lazily and can be used to narrow down searches.
+//! An index is not thread safe; FileBrowserSearcher only touches it from its worker thread.
+class FileBrowserIndex
+{
+public:
+	//! Format information of an audio file. Invalid for anything libsndfile cannot open.
+	struct Metadata
+	{
+		int sampleRate = 0;
+		int channels = 0;
+		qint64 frames = 0;
+
+		auto valid() const -> bool { return sampleRate > 0; }
+		auto duration() const -> double { return valid() ? static_cast<double>(frames) / sampleRate : 0.0; }
+	};
+
+	//! Restricts matches to audio files whose metadata falls within the given bounds.
+	struct MetadataFilter
+	{
+		double minDuration = 0.0;
+		double maxDuration = std::numeric_limits<double>::infinity();
+		int sampleRate = 0; //!< Required sample rate, or 0 for any
+
+		auto active() const -> bool
+		{
+			return minDuration > 0.0 || maxDuration < std::numeric_limits<double>::infinity() || sampleRate > 0;
+		}
+
+		auto accepts(const Metadata& metadata) const -> bool
+		{
+			if (!metadata.valid()) { return false; }
+			const auto duration = metadata.duration();
+			return duration >= minDuration && duration <= maxDuration
+				&& (sampleRate == 0 || metadata.sampleRate == sampleRate);
+		}
+	};
+
+	//! A search over the index. Semantics match the plain filesystem walk the searcher used to do: a directory whose
+	//! name contains the filter is a match and is not searched further, a file is a match if its name contains the
+	//! filter and its suffix is one of the extensions. With an active metadata filter only files can match.
+	struct Query
+	{
+		QString filter;
+		QStringList extensions;
+		MetadataFilter metadataFilter;
+		std::function<void(const QString&)> onMatch;
+	};
+
+	//! Creates an empty index for the given root directory and loads its saved copy if there is one.
+	explicit FileBrowserIndex(const QString& root);
+
+	//! Returns the absolute path of the indexed directory.
+	auto root() const -> const QString& { return m_root; }
+
+	//! Returns true once every directory below the root has been listed at least once.
+	auto complete() const -> bool { return m_complete; }
+
+	//! Returns true if the index has not been refreshed for longer than the given interval.
+	auto stale(std::chrono::steady_clock::duration interval) const -> bool;
+
+	//! Lists every directory whose modification time changed since the last refresh.
+	//! If a query is given, its matches are reported while walking, which lets the first search run while the index
+	//! is being built. Returns false if cancelled; the work done so far is kept and the next refresh continues it.
+	auto refresh(const std::atomic<bool>& cancel, const Query* query = nullptr) -> bool;
+
+	//! Answers a query from memory. Returns false if cancelled.
+	auto query(const Query& query, const std::atomic<bool>& cancel) -> bool;
+
+	//! Reads the metadata of audio files that have not been examined yet. Returns false if cancelled.
+	auto collectMetadata(const std::atomic<bool>& cancel) -> bool;
+
+	//! Writes the index to the cache directory if it changed since it was loaded or last saved.
+	auto save() -> void;
+
+private:
+	struct Node
+	{
+		QString name;
+		bool isDir = false;
+		bool probed = false; //!< Whether the metadata of this file was read
+		qint64 modified = -1; //!< Directories: time of the last listing, or -1 if never listed. Files: file mtime.
+		Metadata metadata;
+		std::vector<Node> children;
+	};
+
+	auto walk(Node& node, const QString& path, const std::atomic<bool>& cancel, const Query* query, bool rescan,
+		bool report) -> bool;
+	auto list(Node& node, const QString& path) -> void;
+	auto matches(Node& node, const QString& path, const Query& query) -> bool;
+	auto probe(Node& node, const QString& path) -> void;
+	auto collectMetadata(Node& node, const QString& path, const std::atomic<bool>& cancel) -> bool;
+
+	auto load() -> void;
+	auto cacheFile() const -> QString;
+
+	static auto readNode(QDataStream& stream, Node& node, int depth) -> bool;
+	static auto writeNode(QDataStream& stream, const Node& node) -> void;
+
+	QString m_root;
+	Node m_tree;
+	bool m_complete = false;
+	bool m_dirty = false;
+	bool m_metadataPending = true; //!< Whether there may be files whose metadata was not read yet
+	std::chrono::steady_clock::time_point m_lastRefresh;
+	bool m_refreshed = false;
+};
+
+} // namespace lmms::gui
+
+#endif // LMMS_FILE_BROWSER_INDEX_H
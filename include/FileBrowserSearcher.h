@@ -28,8 +28,12 @@
 #include <QHash>
 #include <QString>
 #include <QStringList>
+#include <chrono>
+#include <map>
+#include <memory>
 #include <optional>
 #include <queue>
+#include <set>
 
 #ifdef __MINGW32__
 #include <mingw.condition_variable.h>
@@ -41,15 +45,29 @@
 #include <thread>
 #endif
 
+#include "FileBrowserIndex.h"
+
 namespace lmms::gui {
 
 //! An active object that handles searching for files that match a certain filter across the file system.
+//! Searches are answered from a persistent FileBrowserIndex per searched directory. While idle, the worker keeps the
+//! indexes up to date and reads the metadata of audio files.
 class FileBrowserSearcher
 {
 public:
 	//! Number of milliseconds to wait for before a match should be processed by the user.
 	static constexpr int MillisecondsPerMatch = 1;
 
+	//! How long the worker has to be idle before it starts maintaining the indexes.
+	static constexpr auto IdleInterval = std::chrono::seconds{2};
+
+	//! How often an index is checked for changes on disk while the worker is idle.
+	static constexpr auto RefreshInterval = std::chrono::minutes{5};
+
+	//! How old an index may be before a search refreshes the searched directory instead of answering from memory.
+	//! Keeps typing a filter from listing the tree for every key.
+	static constexpr auto SearchRefreshInterval = std::chrono::seconds{10};
+
 	//! The future object for FileBrowserSearcher. It is used to track the current state of search operations, as
 	// well as retrieve matches.
 	class SearchFuture
@@ -64,11 +82,14 @@ public:
 			Completed
 		};
 
-		//! Constructs a future object using the specified filter, paths, and valid file extensions in the Idle state.
-		SearchFuture(const QString& filter, const QStringList& paths, const QStringList& extensions)
+		//! Constructs a future object using the specified filter, paths, valid file extensions and metadata filter in
+		//! the Idle state.
+		SearchFuture(const QString& filter, const QStringList& paths, const QStringList& extensions,
+			const FileBrowserIndex::MetadataFilter& metadataFilter = {})
 			: m_filter(filter)
 			, m_paths(paths)
 			, m_extensions(extensions)
+			, m_metadataFilter(metadataFilter)
 		{
 		}
 
@@ -91,6 +112,9 @@ public:
 		//! Returns the valid file extensions.
 		auto extensions() -> const QStringList& { return m_extensions; }
 
+		//! Returns the metadata filter used.
+		auto metadataFilter() -> const FileBrowserIndex::MetadataFilter& { return m_metadataFilter; }
+
 	private:
 		//! Adds a match to the match list.
 		auto addMatch(const QString& match) -> void
@@ -102,6 +126,7 @@ public:
 		QString m_filter;
 		QStringList m_paths;
 		QStringList m_extensions;
+		FileBrowserIndex::MetadataFilter m_metadataFilter;
 
 		QStringList m_matches;
 		std::mutex m_matchesMutex;
@@ -115,8 +140,16 @@ public:
 
 	//! Enqueues a search to be ran by the worker thread.
 	//! Returns a future that the caller can use to track state and results of the operation.
-	auto search(const QString& filter, const QStringList& paths, const QStringList& extensions)
-		-> std::shared_ptr<SearchFuture>;
+	auto search(const QString& filter, const QStringList& paths, const QStringList& extensions,
+		const FileBrowserIndex::MetadataFilter& metadataFilter = {}) -> std::shared_ptr<SearchFuture>;
+
+	//! Asks the worker to load or build the indexes of the given paths the next time it is idle, so that the first
+	//! search in them does not have to wait for the filesystem. Only paths inside the configured sample, preset and
+	//! project directories are indexed in the background, anything else is only indexed once it is searched.
+	auto prepare(const QStringList& paths) -> void;
+
+	//! Returns true if the worker keeps the index of the given path up to date while idle.
+	static auto indexedInBackground(const QString& path) -> bool;
 
 	//! Sends a signal to cancel a running search.
 	auto cancel() -> void { m_cancelRunningSearch = true; }
@@ -132,12 +165,28 @@ private:
 	//! Event loop for the worker thread.
 	auto run() -> void;
 
-	//! Using Depth-first search (DFS), filters the specified path and adds any matches to the future list.
+	//! Filters the specified path using its index and adds any matches to the future list.
 	auto process(SearchFuture* searchFuture, const QString& path) -> bool;
 
+	//! Refreshes stale indexes and collects metadata until done or interrupted by a search. Runs without holding
+	//! m_workerMutex, so queueing a search never waits for the filesystem.
+	auto maintain() -> void;
+
+	//! Returns the index of the specified path, loading it from disk on first use.
+	auto index(const QString& path) -> FileBrowserIndex&;
+
 	std::queue<std::shared_ptr<SearchFuture>> m_searchQueue;
 	std::atomic<bool> m_cancelRunningSearch = false;
 
+	//! Only accessed by the worker thread.
+	std::map<QString, std::unique_ptr<FileBrowserIndex>> m_indexes;
+
+	//! Roots of the indexes maintained while idle, see prepare(). Only accessed by the worker thread.
+	std::set<QString> m_backgroundRoots;
+
+	QStringList m_pendingPaths;
+	std::mutex m_pendingPathsMutex;
+
 	bool m_workerStopped = false;
 	std::mutex m_workerMutex;
 	std::condition_variable m_workerCond;
@@ -70,6 +70,12 @@ public:
 	void processAudioBuffer( sampleFrame * _buf, const fpp_t _frames,
 							NotePlayHandle * _n );
 
+	//! Whether the last buffer of a single-streamed instrument was silent
+	bool lastBufferSilent() const
+	{
+		return m_silentBuffersProcessed;
+	}
+
 	MidiEvent applyMasterKey( const MidiEvent& event );
 
 	void processInEvent( const MidiEvent& event, const TimePos& time = TimePos(), f_cnt_t offset = 0 ) override;
@@ -30,9 +30,11 @@
 #include <ladspa.h>
 
 #include <QMap>
+#include <QMutex>
 #include <QPair>
 #include <QString>
 #include <QStringList>
+#include <vector>
 
 
 #include "lmms_export.h"
@@ -60,7 +62,12 @@ calls using:
 
 	ladspa_key_t key( "cmt.so", "phasemod" )
 
-as the plug-in key. */
+as the plug-in key.
+
+The metadata of every plug-in is kept in a cache file, validated by the
+path, modification time and size of its library. Libraries whose cache
+entry is still valid are only loaded once one of their plug-ins is
+actually used, i.e. when getDescriptor() is called. */
 
 enum class LadspaPluginType
 {
@@ -74,11 +81,25 @@ enum class LadspaPluginType
 
 struct LadspaManagerDescription
 {
-	LADSPA_Descriptor_Function descriptorFunction;
-	uint32_t index;
-	LadspaPluginType type;
-	uint16_t inputChannels;
-	uint16_t outputChannels;
+	//! Resolved when the library is loaded, nullptr before that
+	LADSPA_Descriptor_Function descriptorFunction = nullptr;
+	uint32_t index = 0;
+	LadspaPluginType type = LadspaPluginType::Other;
+	uint16_t inputChannels = 0;
+	uint16_t outputChannels = 0;
+
+	//! Absolute path of the library providing the plug-in
+	QString file;
+
+	// Copy of the plug-in's LADSPA_Descriptor, available without loading the library
+	QString label;
+	QString name;
+	QString maker;
+	QString copyright;
+	LADSPA_Properties properties = 0;
+	std::vector<LADSPA_PortDescriptor> portDescriptors;
+	std::vector<LADSPA_PortRangeHint> portRangeHints;
+	QStringList portNames;
 };
 
 class LMMS_EXPORT LadspaManager
@@ -88,6 +109,9 @@ public:
 	LadspaManager();
 	virtual ~LadspaManager();
 
+	//! Returns the path of the file caching the metadata of all plug-ins
+	static QString cacheFile();
+
 	l_sortable_plugin_t getSortedPlugins();
 	LadspaManagerDescription * getDescription( const ladspa_key_t &
 								_plugin );
@@ -330,10 +354,23 @@ public:
 						LADSPA_Handle _instance );
 
 private:
-	void  addPlugins( LADSPA_Descriptor_Function _descriptor_func,
+	using LibraryPlugins = QList<LadspaManagerDescription>;
+	struct CachedLibrary
+	{
+		qint64 modified = 0;
+		qint64 size = 0;
+		LibraryPlugins plugins;
+	};
+	using LibraryCache = QMap<QString, CachedLibrary>;
+
+	static LibraryPlugins scanLibrary( const QString & _file );
+	static LibraryCache readCache();
+	static void writeCache( const LibraryCache & _cache );
+
+	void  addPlugins( const LibraryPlugins & _plugins,
 						const QString & _file );
-	uint16_t  getPluginInputs( const LADSPA_Descriptor * _descriptor );
-	uint16_t  getPluginOutputs( const LADSPA_Descriptor * _descriptor );
+	static uint16_t  getPluginInputs( const LadspaManagerDescription & _description );
+	static uint16_t  getPluginOutputs( const LadspaManagerDescription & _description );
 
 	const LADSPA_PortDescriptor* getPortDescriptor( const ladspa_key_t& _plugin,
 													uint32_t _port );
@@ -344,6 +381,9 @@ private:
 	LadspaManagerMapType m_ladspaManagerMap;
 	l_sortable_plugin_t m_sortedPlugins;
 
+	//! Guards loading libraries on first use
+	QMutex m_libraryMutex;
+
 } ;
 
 
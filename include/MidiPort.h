@@ -26,19 +26,30 @@
 #ifndef LMMS_MIDI_PORT_H
 #define LMMS_MIDI_PORT_H
 
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#ifdef __MINGW32__
+#include <mingw.mutex.h>
+#else
+#include <mutex>
+#endif
+
 #include <QString>
 #include <QList>
 #include <QMap>
 
 #include "Midi.h"
+#include "MidiEvent.h"
 #include "TimePos.h"
 #include "AutomatableModel.h"
+#include "LocklessRingBuffer.h"
 
 namespace lmms
 {
 
 class MidiClient;
-class MidiEvent;
 class MidiEventProcessor;
 
 namespace gui
@@ -68,6 +79,7 @@ class MidiPort : public Model, public SerializingObject
 	mapPropertyFromModel(bool,isWritable,setWritable,m_writableModel);
 public:
 	using Map = QMap<QString, bool>;
+	using Clock = std::chrono::steady_clock;
 
 	enum class Mode
 	{
@@ -111,9 +123,34 @@ public:
 		return outputChannel() ? outputChannel() - 1 : 0;
 	}
 
-	void processInEvent( const MidiEvent& event, const TimePos& time = TimePos() );
+	//! Passes an event of the MIDI client, received at @p timestamp, on to the event processor, right away or
+	//! through the input queue
+	void processInEvent(const MidiEvent& event, const TimePos& time = TimePos(),
+		Clock::time_point timestamp = Clock::now());
 	void processOutEvent( const MidiEvent& event, const TimePos& time = TimePos() );
 
+	/**
+		Makes input go through a queue instead of reaching the event processor on the thread of the MIDI client.
+		The audio engine empties the queues at the start of each period, placing every event as far into the
+		period as it arrived into the one before. Notes then start and end with the same latency and without
+		jitter, whenever they arrived.
+
+		The queue takes events from a single MIDI client thread without locking. Only once it is full, events
+		wait in an overflow list, where note offs are never dropped.
+	*/
+	void setInputQueued(bool queued);
+
+	//! Hands the queued input of all ports to their event processors, placed within a period of @p frames frames
+	static void processQueuedInEvents(f_cnt_t frames, sample_rate_t sampleRate);
+
+	//! The frame of the period of @p frames frames starting at @p periodStart that an event received at
+	//! @p timestamp is placed at
+	static f_cnt_t inputFrameOffset(Clock::time_point timestamp, Clock::time_point periodStart, f_cnt_t frames,
+		sample_rate_t sampleRate);
+
+	//! How many events the input queue holds with periods of @p framesPerPeriod frames
+	static std::size_t inputQueueSize(fpp_t framesPerPeriod, sample_rate_t sampleRate);
+
 
 	void saveSettings( QDomDocument& doc, QDomElement& thisElement ) override;
 	void loadSettings( const QDomElement& thisElement ) override;
@@ -153,6 +190,25 @@ private slots:
 
 
 private:
+	struct QueuedEvent
+	{
+		MidiEvent event;
+		TimePos time;
+		Clock::time_point timestamp;
+	};
+
+	//! The input queue holds events of this many periods, for when the engine is late emptying it
+	static constexpr int InputQueuePeriods = 4;
+	//! Several MIDI cables' worth of short messages, USB devices can send faster than a single cable
+	static constexpr int MaxInputEventsPerSecond = 4000;
+	static constexpr std::size_t MinInputQueueSize = 256;
+
+	void queueInEvent(const QueuedEvent& queued);
+	void processQueuedInEvents(Clock::time_point periodStart, f_cnt_t frames, sample_rate_t sampleRate);
+
+	//! Whether @p event ends notes, which would hang if it got lost
+	static bool releasesNotes(const MidiEvent& event);
+
 	MidiClient* m_midiClient;
 	MidiEventProcessor* m_midiEventProcessor;
 
@@ -173,6 +229,19 @@ private:
 	Map m_readablePorts;
 	Map m_writablePorts;
 
+	std::atomic<bool> m_inputQueued;
+	LocklessRingBuffer<QueuedEvent> m_inputQueue;
+	LocklessRingBufferReader<QueuedEvent> m_inputQueueReader;
+	//! Set while events wait in m_inputOverflow, later events then go there as well to keep their order
+	std::atomic<bool> m_inputOverflowed;
+	//! Input which didn't fit into the queue, guarded by m_inputOverflowMutex
+	std::vector<QueuedEvent> m_inputOverflow;
+	std::mutex m_inputOverflowMutex;
+
+	//! The ports with queued input, guarded by s_queuedPortsMutex
+	static std::vector<MidiPort*> s_queuedPorts;
+	static std::mutex s_queuedPortsMutex;
+
 
 	friend class gui::ControllerConnectionDialog;
 	friend class gui::InstrumentMidiIOView;
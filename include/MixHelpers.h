@@ -31,9 +31,13 @@ namespace lmms
 {
 
 class ValueBuffer;
+class ValueSpan;
 namespace MixHelpers
 {
 
+//! Samples below this magnitude count as silence
+constexpr float SilenceThreshold = 0.0000001f;
+
 bool isSilent( const sampleFrame* src, int frames );
 
 bool useNaNHandler();
@@ -67,9 +71,15 @@ void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, f
 /*! \brief Add samples from src multiplied by coeffSrc and coeffSrcBuf to dst - sanitized version */
 void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames );
 
+/*! \brief Add samples from src multiplied by both coefficients of each frame to dst - sanitized version */
+void addSanitizedMultipliedBySpans( sampleFrame* dst, const sampleFrame* src, const ValueSpan& coeffSrc1, const ValueSpan& coeffSrc2, int frames );
+
 /*! \brief Add samples from src multiplied by coeffSrcLeft/coeffSrcRight to dst */
 void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames );
 
+/*! \brief Multiply dst by volume and apply panning, both given in percent like the volume and panning models hold them */
+void multiplyByVolumeAndPanning( sampleFrame* dst, const ValueSpan& volume, const ValueSpan& panning, int frames );
+
 /*! \brief Multiply dst by coeffDst and add samples from src multiplied by coeffSrc */
 void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames );
 
@@ -53,6 +53,9 @@ class MixerChannel : public ThreadableJob
 		bool m_hasInput;
 		// set to true if any effect in the channel is enabled and running
 		bool m_stillRunning;
+		// set to true if the buffer holds more than silence after processing;
+		// receivers skip senders without output
+		bool m_hasOutput;
 
 		float m_peakLeft;
 		float m_peakRight;
@@ -73,6 +76,12 @@ class MixerChannel : public ThreadableJob
 		// pointers to other channels that send to this one
 		MixerRouteVector m_receives;
 
+		// channels with models driven by a peak controller whose detector
+		// runs in this channel, so they wait for it; see Mixer::updateSidechains()
+		std::vector<MixerChannel*> m_sidechainTargets;
+		// number of channels this one waits for that way
+		int m_sidechainSources;
+
 		bool requiresProcessing() const override { return true; }
 		void unmuteForSolo();
 
@@ -207,6 +216,17 @@ public:
 		return m_mixerChannels.size();
 	}
 
+	// let channels wait for the channels running the detectors of the peak
+	// controllers driving them, see MixerChannel::m_sidechainTargets; only
+	// walks the channels again after invalidateSidechains()
+	void updateSidechains();
+
+	// to be called whenever routing, effects or controller connections change
+	void invalidateSidechains()
+	{
+		m_sidechainsValid = false;
+	}
+
 	MixerRouteVector m_mixerRoutes;
 
 private:
@@ -216,7 +236,13 @@ private:
 	// make sure we have at least num channels
 	void allocateChannelsTo(int num);
 
+	void addSidechains(MixerChannel* target, const QObject* models);
+	MixerChannel* channelOf(const EffectChain* chain) const;
+	bool reaches(const MixerChannel* from, const MixerChannel* to) const;
+
 	int m_lastSoloed;
+
+	std::atomic<bool> m_sidechainsValid;
 } ;
 
 
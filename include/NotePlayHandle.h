@@ -250,8 +250,9 @@ public:
 	/*! Process note detuning automation */
 	void processTimePos(const TimePos& time, float pitchValue, bool isRecording);
 
-	/*! Updates total length (m_frames) depending on a new tempo */
-	void resize( const bpm_t newTempo );
+	/*! Updates total length (m_frames) for a tempo change, the frames still to play
+	    are scaled from the old to the new number of frames per tick */
+	void resize( const float oldFramesPerTick, const float newFramesPerTick );
 
 	/*! Set song-global offset (relative to containing MIDI clip) in order to properly perform the note detuning */
 	void setSongGlobalParentOffset( const TimePos& offset )
@@ -317,10 +318,6 @@ private:
 	bool m_muted;							// indicates whether note is muted
 	Track* m_patternTrack;						// related pattern track
 
-	// tempo reaction
-	bpm_t m_origTempo;						// original tempo
-	f_cnt_t m_origFrames;					// original m_frames
-
 	int m_origBaseNote;
 
 	float m_frequency;
@@ -78,6 +78,7 @@ public:
 	} ;
 	constexpr static auto NumModulationAlgos = static_cast<std::size_t>(ModulationAlgo::Count);
 
+	//! The sub-oscillator is not owned, it has to outlive this oscillator
 	Oscillator( const IntModel *wave_shape_model,
 			const IntModel *mod_algo_model,
 			const float &freq,
@@ -85,10 +86,7 @@ public:
 			const float &phase_offset,
 			const float &volume,
 			Oscillator *m_subOsc = nullptr);
-	virtual ~Oscillator()
-	{
-		delete m_subOsc;
-	}
+	virtual ~Oscillator() = default;
 
 	static void waveTableInit();
 	static void destroyFFTPlans();
@@ -274,7 +272,8 @@ private:
 	static fftwf_plan s_fftPlan;
 	static fftwf_plan s_ifftPlan;
 	static fftwf_complex * s_specBuf;
-	static std::array<float, OscillatorConstants::WAVETABLE_LENGTH> s_sampleBuffer;
+	// Aligned like fftwf_malloc() buffers, as required to execute the cached plans on it
+	alignas(64) static std::array<float, OscillatorConstants::WAVETABLE_LENGTH> s_sampleBuffer;
 
 	static void generateSawWaveTable(int bands, sample_t* table, int firstBand = 1);
 	static void generateTriangleWaveTable(int bands, sample_t* table, int firstBand = 1);
@@ -0,0 +1,97 @@
+/*
+ * Oversampler.h - polyphase IIR oversampling for nonlinear processing
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_OVERSAMPLER_H
+#define LMMS_OVERSAMPLER_H
+
+#include <memory>
+#include <vector>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+ * Runs a stereo signal at 2x, 4x or 8x its rate so that nonlinear
+ * processing does not alias.
+ *
+ * Each doubling is a half-band filter from the hiir library. The stage
+ * next to the original rate has the steepest filter. Later stages only
+ * have to reject images far above the audible band, so they use much
+ * cheaper filters. This is a lot cheaper than raising the engine's
+ * processing rate, since only the nonlinear part runs oversampled.
+ *
+ * Usage, once per period:
+ *
+ *     sampleFrame* up = oversampler.upsample(buf, frames);
+ *     // process frames * oversampler.factor() frames of up
+ *     oversampler.downsample(buf, frames);
+ *
+ * The filters are minimum phase, so the output is delayed by a few
+ * samples and the phase response is not linear near the band edge.
+ */
+class LMMS_EXPORT Oversampler
+{
+public:
+	//! Number of doublings supported, i.e. up to 8x
+	static constexpr int MaxStages = 3;
+
+	explicit Oversampler(int stages = 0);
+	~Oversampler();
+
+	Oversampler(const Oversampler&) = delete;
+	Oversampler& operator=(const Oversampler&) = delete;
+
+	//! Sets the oversampling factor to 2^stages and clears the filter states
+	void setStages(int stages);
+	int stages() const { return m_stages; }
+	int factor() const { return 1 << m_stages; }
+
+	//! Clears the filter states, e.g. when the effect is reset
+	void reset();
+
+	//! Upsamples \p frames frames of \p in. Returns a buffer of
+	//! frames * factor() frames that stays valid until the next call.
+	sampleFrame* upsample(const sampleFrame* in, fpp_t frames);
+
+	//! Downsamples the buffer returned by upsample() back into \p frames
+	//! frames of \p out. \p out may be the buffer passed to upsample().
+	void downsample(sampleFrame* out, fpp_t frames);
+
+private:
+	class Filters;
+
+	void reserve(fpp_t frames);
+
+	int m_stages = 0;
+	std::unique_ptr<Filters> m_filters;
+
+	std::vector<sampleFrame> m_buffer;
+	//! Mono scratch buffers that the stages ping-pong between
+	std::vector<float> m_scratch[2];
+};
+
+} // namespace lmms
+
+#endif // LMMS_OVERSAMPLER_H
@@ -0,0 +1,119 @@
+/*
+ * PartitionedConvolver.h - Zero-latency partitioned FFT convolution
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_PARTITIONED_CONVOLVER_H
+#define LMMS_PARTITIONED_CONVOLVER_H
+
+#include <memory>
+#include <vector>
+
+#ifdef __MINGW32__
+#include <mingw.condition_variable.h>
+#include <mingw.mutex.h>
+#include <mingw.thread.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+	Convolves a stereo signal with a long impulse response without adding latency.
+
+	The impulse response is split into three segments:
+	- the first HeadBlockSize frames are applied directly in the time domain,
+	- the frames up to TailOffset are applied by uniformly partitioned FFT convolution with small blocks,
+	- the rest is applied with blocks of TailBlockSize frames on a background thread.
+
+	The tail is computed one block ahead of when it is needed, so the background thread has a whole block worth of
+	audio time to finish. If it falls behind anyway, process() waits for it rather than dropping the tail.
+*/
+class LMMS_EXPORT PartitionedConvolver
+{
+public:
+	static constexpr f_cnt_t HeadBlockSize = 128;
+	static constexpr f_cnt_t TailBlockSize = 4096;
+	static constexpr f_cnt_t TailOffset = 2 * TailBlockSize;
+
+	PartitionedConvolver();
+	~PartitionedConvolver();
+
+	PartitionedConvolver(const PartitionedConvolver&) = delete;
+	PartitionedConvolver& operator=(const PartitionedConvolver&) = delete;
+
+	//! Replaces the impulse response and clears the signal history.
+	//! This transforms the whole response and must not run concurrently with process().
+	void setImpulseResponse(const sampleFrame* ir, f_cnt_t frames);
+
+	//! Returns the length of the impulse response in frames
+	f_cnt_t length() const { return m_length; }
+
+	//! Clears the signal history, so the reverb tail of earlier input is not heard anymore
+	void reset();
+
+	//! Writes the convolution of `in` with the impulse response to `out`, which may be the same buffer
+	void process(const sampleFrame* in, sampleFrame* out, fpp_t frames);
+
+private:
+	class Stage;
+
+	void startTail();
+	void stopTail();
+	void runTail();
+	void exchangeTailBlock();
+
+	f_cnt_t m_length = 0;
+
+	// Direct form part; the history holds every input frame twice, so the taps always see a contiguous window
+	std::vector<sampleFrame> m_directTaps; //!< First HeadBlockSize frames of the impulse response, reversed
+	std::vector<sampleFrame> m_directHistory;
+	f_cnt_t m_directPos = 0;
+
+	std::unique_ptr<Stage> m_head;
+	std::vector<sampleFrame> m_headInput;
+	std::vector<sampleFrame> m_headOutput;
+	f_cnt_t m_headPos = 0;
+
+	std::unique_ptr<Stage> m_tail;
+	std::vector<sampleFrame> m_tailInput;
+	std::vector<sampleFrame> m_tailOutput;
+	f_cnt_t m_tailPos = 0;
+
+	// Hand-over to the background thread, all guarded by m_tailMutex
+	std::vector<sampleFrame> m_tailJobInput;
+	std::vector<sampleFrame> m_tailJobOutput;
+	bool m_tailPending = false;
+	bool m_tailQuit = false;
+	std::mutex m_tailMutex;
+	std::condition_variable m_tailCondition;
+	std::thread m_tailThread;
+};
+
+} // namespace lmms
+
+#endif // LMMS_PARTITIONED_CONVOLVER_H
@@ -34,6 +34,7 @@ namespace lmms
 {
 
 
+class EffectChain;
 class PeakControllerEffect;
 
 using PeakControllerEffectVector = std::vector<PeakControllerEffect*>;
@@ -55,13 +56,36 @@ public:
 	static void initGetControllerBySetting();
 	static PeakController * getControllerBySetting( const QDomElement & _this );
 
+	//! The effect chain the detector of this controller runs in, if any
+	const EffectChain* detectorChain() const;
+
+	/**
+		Hands the envelopes the detectors in @p chain measured in this period over to their controllers, or those of
+		all detectors which measured one and didn't hand it over yet for nullptr.
+
+		Models read the controllers right away, so this must be called where nothing reads them concurrently: by a
+		mixer channel after its effects, with the channels driven by its detectors waiting for it, and by the audio
+		engine after the effects of the tracks running detectors, before those of the other tracks. Models which are
+		read before get the envelope of the last period.
+	*/
+	static void publishEnvelopes(const EffectChain* chain = nullptr);
+
+	//! Whether the detector of a peak controller runs in @p chain
+	static bool hasDetectorIn(const EffectChain* chain);
+
+	//! Register and unregister the detectors, called by PeakControllerEffect. The rendering thread walks the
+	//! detectors every period, so both take the audio engine's change lock. removeDetector() returns whether
+	//! @p effect was registered.
+	static void addDetector(PeakControllerEffect* effect);
+	static bool removeDetector(PeakControllerEffect* effect);
+
+	//! All detectors; only changed through addDetector() and removeDetector()
 	static PeakControllerEffectVector s_effects;
 
 
 public slots:
 	gui::ControllerDialog * createDialog( QWidget * _parent ) override;
 	void handleDestroyedEffect();
-	void updateCoeffs();
 
 protected:
 	// The internal per-controller get-value function
@@ -72,15 +96,13 @@ protected:
 	friend class PeakControllerDialog;
 
 private:
-	float m_currentSample;
+	// the period in which the detector handed over its envelope last
+	long m_publishedPeriod;
+
 	//backward compatibility for <= 0.4.15
 	static int m_getCount;
 	static int m_loadCount;
 	static bool m_buggedFile;
-	
-	float m_attackCoeff;
-	float m_decayCoeff;
-	bool m_coeffNeedsUpdate;
 } ;
 
 namespace gui
@@ -147,6 +147,19 @@ public:
 	
 	sampleFrame * buffer();
 
+	//! Whether play() found its buffer to hold nothing but silence, so the
+	//! audio port can skip it without testing it again
+	bool isBufferSilent() const
+	{
+		return m_bufferSilent;
+	}
+
+protected:
+	void setBufferSilent( const bool silent )
+	{
+		m_bufferSilent = silent;
+	}
+
 private:
 	Type m_type;
 	f_cnt_t m_offset;
@@ -154,6 +167,7 @@ private:
 	QMutex m_processingLock;
 	sampleFrame* m_playHandleBuffer;
 	bool m_bufferReleased;
+	bool m_bufferSilent;
 	bool m_usesBuffer;
 	AudioPort * m_audioPort;
 } ;
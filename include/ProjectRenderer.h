@@ -25,6 +25,9 @@
 #ifndef LMMS_PROJECT_RENDERER_H
 #define LMMS_PROJECT_RENDERER_H
 
+#include <memory>
+#include <vector>
+
 #include "AudioFileDevice.h"
 #include "lmmsconfig.h"
 #include "AudioEngine.h"
@@ -60,11 +63,23 @@ public:
 		AudioFileDeviceInstantiaton m_getDevInst;
 	} ;
 
+	//! A file written while rendering, with its own format and settings
+	struct Output
+	{
+		ExportFileFormat format;
+		OutputSettings settings;
+		QString file;
+	} ;
+
 
 	ProjectRenderer( const AudioEngine::qualitySettings & _qs,
 				const OutputSettings & _os,
 				ExportFileFormat _file_format,
 				const QString & _out_file );
+	//! Renders the project once and encodes it into all given outputs
+	//! in parallel
+	ProjectRenderer( const AudioEngine::qualitySettings & _qs,
+				const std::vector<Output> & _outputs );
 	~ProjectRenderer() override = default;
 
 	bool isReady() const
@@ -93,7 +108,12 @@ signals:
 private:
 	void run() override;
 
+	// the output with the highest sample rate drives the audio engine,
+	// which owns its device
 	AudioFileDevice * m_fileDev;
+	// the other outputs, fed from the same render and resampling on their
+	// own encoder threads
+	std::vector<std::unique_ptr<AudioFileDevice>> m_extraFileDevs;
 	AudioEngine::qualitySettings m_qualitySettings;
 
 	volatile int m_progress;
@@ -27,6 +27,7 @@
 #define LMMS_RENDER_MANAGER_H
 
 #include <memory>
+#include <vector>
 
 #include "ProjectRenderer.h"
 #include "OutputSettings.h"
@@ -46,6 +47,12 @@ public:
 		ProjectRenderer::ExportFileFormat fmt,
 		QString outputPath);
 
+	/// Export into several files at once, rendering only once.
+	/// When rendering tracks, the file of each output is a directory.
+	RenderManager(
+		const AudioEngine::qualitySettings & qualitySettings,
+		std::vector<ProjectRenderer::Output> outputs);
+
 	~RenderManager() override;
 
 	/// Export all unmuted tracks into a single file
@@ -65,16 +72,14 @@ private slots:
 	void updateConsoleProgress();
 
 private:
-	QString pathForTrack( const Track *track, int num );
+	QString pathForTrack( const ProjectRenderer::Output & output, const Track *track, int num );
 	void restoreMutedState();
 
-	void render( QString outputPath );
+	void render( const std::vector<ProjectRenderer::Output> & outputs );
 
 	const AudioEngine::qualitySettings m_qualitySettings;
 	const AudioEngine::qualitySettings m_oldQualitySettings;
-	const OutputSettings m_outputSettings;
-	ProjectRenderer::ExportFileFormat m_format;
-	QString m_outputPath;
+	const std::vector<ProjectRenderer::Output> m_outputs;
 
 	std::unique_ptr<ProjectRenderer> m_activeRenderer;
 
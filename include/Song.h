@@ -26,6 +26,7 @@
 #define LMMS_SONG_H
 
 #include <array>
+#include <atomic>
 #include <memory>
 
 #include <QHash>
@@ -35,6 +36,7 @@
 #include "Controller.h"
 #include "lmms_constants.h"
 #include "MeterModel.h"
+#include "TempoMap.h"
 #include "Timeline.h"
 #include "TrackContainer.h"
 #include "VstSyncController.h"
@@ -156,8 +158,7 @@ public:
 
 	inline void setToTime(TimePos const & pos, PlayMode playMode)
 	{
-		m_elapsedMilliSeconds[static_cast<std::size_t>(playMode)] = pos.getTimeInMilliseconds(getTempo());
-		getPlayPos(playMode).setTicks(pos.getTicks());
+		setToTimeByTicks(pos.getTicks(), playMode);
 	}
 
 	inline void setToTimeByTicks(tick_t ticks)
@@ -167,7 +168,10 @@ public:
 
 	inline void setToTimeByTicks(tick_t ticks, PlayMode playMode)
 	{
-		m_elapsedMilliSeconds[static_cast<std::size_t>(playMode)] = TimePos::ticksToMilliseconds(ticks, getTempo());
+		// Only the song follows its tempo automation
+		m_elapsedMilliSeconds[static_cast<std::size_t>(playMode)] = playMode == PlayMode::Song
+			? tempoMap()->milliseconds(ticks)
+			: TimePos::ticksToMilliseconds(ticks, getTempo());
 		getPlayPos(playMode).setTicks(ticks);
 	}
 
@@ -244,6 +248,8 @@ public:
 	}
 
 	bool isExportDone() const;
+	//! Frames left until the export is done, or the maximum if that isn't known yet because loops are still rendered
+	f_cnt_t exportFramesLeft() const;
 	int getExportProgress() const;
 
 	inline void setRenderBetweenMarkers( bool renderBetweenMarkers )
@@ -359,6 +365,23 @@ public:
 		return m_tempoModel;
 	}
 
+	//! The tempo of the song over its ticks, following the tempo automation of the song editor; any thread may
+	//! call this and keep the map as long as it needs
+	std::shared_ptr<const TempoMap> tempoMap() const
+	{
+		return std::atomic_load(&m_tempoMap);
+	}
+
+	//! The tempo map as processNextBuffer() took it at the start of the period; only for the tracks it plays,
+	//! which would otherwise load the shared map for every note
+	const TempoMap& playbackTempoMap() const
+	{
+		return *m_playbackTempoMap;
+	}
+
+	//! Updates the tempo map from @p tick on, soon after on the GUI thread; may be called from any thread
+	void invalidateTempoMap(tick_t tick = 0);
+
 	void exportProjectMidi(QString const & exportFileName) const;
 
 	inline void setLoadOnLaunch(bool value) { m_loadOnLaunch = value; }
@@ -410,6 +433,7 @@ private slots:
 
 	void updateFramesPerTick();
 
+	void updateTempoMap();
 
 
 private:
@@ -430,7 +454,8 @@ private:
 
 	inline f_cnt_t currentFrame() const
 	{
-		return getPlayPos(m_playMode).getTicks() * Engine::framesPerTick() +
+		const auto ticks = getPlayPos(m_playMode).getTicks();
+		return (m_playMode == PlayMode::Song ? tempoMap()->frames(ticks) : ticks * Engine::framesPerTick()) +
 			getPlayPos(m_playMode).currentFrame();
 	}
 
@@ -447,10 +472,14 @@ private:
 	void saveKeymapStates(QDomDocument &doc, QDomElement &element);
 	void restoreKeymapStates(const QDomElement &element);
 
-	void processAutomations(const TrackList& tracks, TimePos timeStart, fpp_t frames);
+	//! Applies the automation of the tick at @p timeStart, which starts at @p frameOffset in the current period
+	void processAutomations(const TrackList& tracks, TimePos timeStart, fpp_t frames, f_cnt_t frameOffset);
 
 	void setModified(bool value);
 
+	//! Maps the whole song again, right away
+	void rebuildTempoMap();
+
 	void setProjectFileName(QString const & projectFileName);
 
 	AutomationTrack * m_globalAutomationTrack;
@@ -506,13 +535,19 @@ private:
 	TimePos m_exportLoopBegin;
 	TimePos m_exportLoopEnd;
 	TimePos m_exportSongEnd;
-	TimePos m_exportEffectiveLength;
 
 	std::shared_ptr<Scale> m_scales[MaxScaleCount];
 	std::shared_ptr<Keymap> m_keymaps[MaxKeymapCount];
 
 	AutomatedValueMap m_oldAutomatedValues;
 
+	std::shared_ptr<const TempoMap> m_tempoMap;
+	//! First tick of the tempo map which is out of date, the maximum tick when the whole map is up to date
+	std::atomic<tick_t> m_tempoMapOutdatedFrom;
+	std::atomic<bool> m_tempoMapUpdatePending;
+	std::atomic<bool> m_tempoAutomated;
+	std::shared_ptr<const TempoMap> m_playbackTempoMap;
+
 	friend class Engine;
 	friend class gui::SongEditor;
 	friend class gui::ControllerRackView;
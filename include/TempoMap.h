@@ -0,0 +1,104 @@
+/*
+ * TempoMap.h - conversion between ticks and frames across tempo changes
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_TEMPO_MAP_H
+#define LMMS_TEMPO_MAP_H
+
+#include <vector>
+
+#include "lmms_basics.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+	The tempo of a song over its ticks, stored as the ticks at which the tempo changes together with the frame each
+	of them starts at. Converting between ticks and frames is a binary search for the change in effect followed by a
+	multiplication, so it stays cheap and exact however much the tempo is automated.
+
+	Ticks last as long as Engine::framesPerTick() makes them last while playing, so the frames of the map are those
+	the song plays at. Before tick 0 and after the last change, the tempo next to them continues.
+
+	Song keeps the map of its tempo automation up to date and hands out immutable copies, see Song::tempoMap().
+*/
+class LMMS_EXPORT TempoMap
+{
+public:
+	TempoMap(sample_rate_t sampleRate, bpm_t tempo);
+
+	//! Plays @p tempo from @p tick on, dropping the changes at and after it
+	void setTempo(tick_t tick, bpm_t tempo);
+
+	//! Moves the frames of all changes to the given rate
+	void setSampleRate(sample_rate_t sampleRate);
+
+	sample_rate_t sampleRate() const
+	{
+		return m_sampleRate;
+	}
+
+	//! Number of tempo changes, including the tempo at tick 0
+	std::size_t changes() const
+	{
+		return m_segments.size();
+	}
+
+	bpm_t tempoAt(tick_t tick) const;
+	double framesPerTickAt(tick_t tick) const;
+
+	//! Frame at which the given, possibly fractional, tick plays
+	double frames(double ticks) const;
+
+	//! Tick, including the fraction, playing at the given frame
+	double ticks(double frames) const;
+
+	//! Time from tick 0 to the given tick
+	double milliseconds(double ticks) const
+	{
+		return frames(ticks) * 1000.0 / m_sampleRate;
+	}
+
+	//! Length of a tick at the given tempo, rounded like Engine::framesPerTick()
+	static double framesPerTick(sample_rate_t sampleRate, bpm_t tempo);
+
+private:
+	struct Segment
+	{
+		tick_t tick;
+		bpm_t tempo;
+		double framesPerTick;
+		double frame;
+	};
+
+	//! The segment in effect at @p tick
+	const Segment& segmentAt(double tick) const;
+
+	sample_rate_t m_sampleRate;
+
+	// Never empty, the first segment starts at tick 0
+	std::vector<Segment> m_segments;
+};
+
+} // namespace lmms
+
+#endif // LMMS_TEMPO_MAP_H
@@ -0,0 +1,114 @@
+/*
+ * UserWaveform.h - band-limited wavetables for user-drawn waves
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_USER_WAVEFORM_H
+#define LMMS_USER_WAVEFORM_H
+
+#include <memory>
+#include <vector>
+
+#ifdef __MINGW32__
+#include <mingw.mutex.h>
+#include <mingw.thread.h>
+#else
+#include <mutex>
+#include <thread>
+#endif
+
+#include "OscillatorConstants.h"
+#include "interpolation.h"
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+/**
+	A single-cycle wave drawn or loaded by the user, turned into a waveform like those Oscillator uses for its
+	built-in shapes: one wavetable per band, each keeping only the harmonics which stay below
+	OscillatorConstants::MAX_FREQ for notes of that band. Playing the table of a note's band is free of aliasing at any
+	pitch without oversampling.
+
+	update() generates the tables on a background thread. Edits coming in meanwhile are merged, only the latest wave is
+	generated next. Until the tables of the latest wave are done, waveform() returns nullptr rather than the tables of
+	an older wave, so voices play the wave itself instead. Voices take the current tables with waveform() when their
+	note starts and share them read-only.
+*/
+class LMMS_EXPORT UserWaveform
+{
+public:
+	using Waveform = OscillatorConstants::waveform_t;
+
+	UserWaveform();
+	//! Waits for a running generation
+	~UserWaveform();
+
+	UserWaveform(const UserWaveform&) = delete;
+	UserWaveform& operator=(const UserWaveform&) = delete;
+
+	//! Generates the tables of the given wave of @p length samples in the background
+	void update(const float* wave, int length);
+
+	//! Generates the tables of the given wave on the calling thread, e.g. when loading settings, and drops pending
+	//! updates
+	void updateNow(const float* wave, int length);
+
+	//! The tables of the latest wave, nullptr while they are being generated
+	std::shared_ptr<const Waveform> waveform() const
+	{
+		return std::atomic_load(&m_waveform);
+	}
+
+	//! Generates the tables of the given wave right away; may be called from any thread
+	static std::unique_ptr<Waveform> generate(const float* wave, int length);
+
+	//! Index of the table to play a note of @p freq Hz with
+	static int band(float freq);
+
+	//! Interpolated sample of the wave at @p phase, in periods, from the table of the given band
+	static sample_t sample(const Waveform& waveform, int band, float phase)
+	{
+		const float frame = absFraction(phase) * OscillatorConstants::WAVETABLE_LENGTH;
+		const auto f1 = static_cast<int>(frame) % OscillatorConstants::WAVETABLE_LENGTH;
+		const auto f2 = f1 < OscillatorConstants::WAVETABLE_LENGTH - 1 ? f1 + 1 : 0;
+		return linearInterpolate(waveform[band][f1], waveform[band][f2], fraction(frame));
+	}
+
+private:
+	void run();
+	//! Makes @p waveform current unless a newer wave came in while it was generated; needs m_mutex
+	void publish(std::unique_ptr<Waveform> waveform, unsigned int generation);
+
+	std::shared_ptr<const Waveform> m_waveform;
+
+	// Hand-over to the background thread, all guarded by m_mutex
+	std::mutex m_mutex;
+	std::vector<float> m_pendingWave;
+	//! Counts the waves passed in, so tables of an outdated wave are dropped
+	unsigned int m_generation = 0;
+	bool m_hasPendingWave = false;
+	bool m_running = false;
+	std::thread m_thread;
+};
+
+} // namespace lmms
+
+#endif // LMMS_USER_WAVEFORM_H
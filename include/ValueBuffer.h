@@ -55,6 +55,93 @@ public:
 };
 
 
+/**
+	Values of a model during one period, without necessarily having a buffer for them: either a linear ramp,
+	which is constant if it starts and ends at the same value, or a buffer of sample-exact values.
+
+	Consumers index it the same way in both cases, or check isConstant() to take a scalar path.
+*/
+class ValueSpan
+{
+public:
+	ValueSpan(float value, int length) :
+		ValueSpan(value, value, length)
+	{}
+
+	//! A ramp reaching `end` one frame after the end of the span, like ValueBuffer::interpolate()
+	ValueSpan(float start, float end, int length) :
+		m_start(start),
+		m_step(length > 0 ? (end - start) / length : 0.0f),
+		m_length(length)
+	{}
+
+	ValueSpan(const float* values, int length) :
+		m_values(values),
+		m_length(length)
+	{}
+
+	bool isConstant() const
+	{
+		return m_values == nullptr && m_step == 0.0f;
+	}
+
+	//! Sample-exact values, or nullptr for ramps
+	const float* values() const
+	{
+		return m_values;
+	}
+
+	int length() const
+	{
+		return m_length;
+	}
+
+	float operator[](int frame) const
+	{
+		return m_values ? m_values[frame] : m_start + m_step * frame;
+	}
+
+	//! The value at the start of the span, which is the only one for constant spans
+	float front() const
+	{
+		return m_values ? m_values[0] : m_start;
+	}
+
+	//! Writes all values to `dest` and returns it, or returns the sample-exact values without copying them
+	const float* data(float* dest) const
+	{
+		if (m_values) { return m_values; }
+		for (int f = 0; f < m_length; ++f)
+		{
+			dest[f] = m_start + m_step * f;
+		}
+		return dest;
+	}
+
+private:
+	const float* m_values = nullptr;
+	float m_start = 0.0f;
+	float m_step = 0.0f;
+	int m_length;
+};
+
+
+/**
+	Hands out value buffers which are valid for the rest of the current period, so models don't need to keep a
+	buffer of their own that is only used while they are automated. Acquiring a buffer is lock-free unless the pool
+	has to grow, which only happens when more buffers are needed in a period than ever before.
+*/
+class LMMS_EXPORT ValueBufferPool
+{
+public:
+	//! Returns a buffer of framesPerPeriod values with undefined contents
+	static ValueBuffer* acquire();
+
+	//! Makes all buffers available again; called by the audio engine between periods
+	static void reset();
+};
+
+
 } // namespace lmms
 
 #endif // LMMS_VALUE_BUFFER_H
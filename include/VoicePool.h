@@ -0,0 +1,164 @@
+/*
+ * VoicePool.h - preallocated storage for the per-note state of instruments
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_VOICE_POOL_H
+#define LMMS_VOICE_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "lmms_export.h"
+
+namespace lmms
+{
+
+//! Enough for dense chords and fast rolls whose notes are still releasing
+constexpr std::size_t DefaultVoicePoolCapacity = 32;
+
+/**
+	The capacity of the instruments' voice pools, from the "voicepoolsize" attribute of the "audioengine" section
+	of the configuration, or DefaultVoicePoolCapacity if it is not set. Raise it for projects which play many
+	notes per instrument at once, lower it to save memory with many instruments.
+*/
+LMMS_EXPORT std::size_t voicePoolCapacity();
+
+/**
+	Preallocated storage for the state an instrument keeps per note, usually in NotePlayHandle::m_pluginData.
+
+	Instruments create that state in playNote() and destroy it in deleteNotePluginData(), both on audio threads.
+	Taking it from a pool makes both O(1) and free of allocations as long as no more than `capacity` notes of the
+	instrument play at once. Further voices are allocated on the heap, so running out of voices never drops a note.
+
+	acquire() and release() are lock-free, as notes of the same instrument may start on several worker threads.
+*/
+template<typename T>
+class VoicePool
+{
+public:
+	explicit VoicePool(std::size_t capacity = voicePoolCapacity()) :
+		m_capacity(capacity < NoSlot ? capacity : NoSlot - 1),
+		m_slots(std::make_unique<Slot[]>(m_capacity)),
+		m_next(std::make_unique<std::atomic<std::uint32_t>[]>(m_capacity)),
+		m_head(m_capacity > 0 ? 0 : NoSlot)
+	{
+		for (std::size_t i = 0; i < m_capacity; ++i)
+		{
+			m_next[i].store(i + 1 < m_capacity ? static_cast<std::uint32_t>(i + 1) : NoSlot,
+				std::memory_order_relaxed);
+		}
+	}
+
+	VoicePool(const VoicePool&) = delete;
+	VoicePool& operator=(const VoicePool&) = delete;
+
+	//! Constructs a voice from the given arguments
+	template<typename... Args>
+	T* acquire(Args&&... args)
+	{
+		const auto index = pop();
+		if (index == NoSlot)
+		{
+			return new T(std::forward<Args>(args)...);
+		}
+		return ::new (static_cast<void*>(m_slots[index].storage)) T(std::forward<Args>(args)...);
+	}
+
+	//! Destroys a voice returned by acquire(); does nothing for nullptr
+	void release(T* voice)
+	{
+		if (voice == nullptr) { return; }
+
+		const auto address = reinterpret_cast<const unsigned char*>(voice);
+		const auto first = reinterpret_cast<const unsigned char*>(m_slots.get());
+		const auto end = reinterpret_cast<const unsigned char*>(m_slots.get() + m_capacity);
+		if (std::less<>{}(address, first) || !std::less<>{}(address, end))
+		{
+			delete voice;
+			return;
+		}
+
+		voice->~T();
+		push(static_cast<std::uint32_t>((address - first) / sizeof(Slot)));
+	}
+
+	std::size_t capacity() const
+	{
+		return m_capacity;
+	}
+
+private:
+	struct Slot
+	{
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	static constexpr std::uint32_t NoSlot = std::numeric_limits<std::uint32_t>::max();
+
+	// The head of the free list holds the index of the first free slot in its lower half and a counter in the
+	// upper half, which changes with every update, so a slot taken and returned meanwhile can't fool a CAS
+	static std::uint64_t makeHead(std::uint64_t oldHead, std::uint32_t index)
+	{
+		return (((oldHead >> 32) + 1) << 32) | index;
+	}
+
+	std::uint32_t pop()
+	{
+		auto head = m_head.load(std::memory_order_acquire);
+		while (static_cast<std::uint32_t>(head) != NoSlot)
+		{
+			const auto index = static_cast<std::uint32_t>(head);
+			const auto next = m_next[index].load(std::memory_order_relaxed);
+			if (m_head.compare_exchange_weak(head, makeHead(head, next),
+				std::memory_order_acquire, std::memory_order_acquire))
+			{
+				return index;
+			}
+		}
+		return NoSlot;
+	}
+
+	void push(std::uint32_t index)
+	{
+		auto head = m_head.load(std::memory_order_relaxed);
+		do
+		{
+			m_next[index].store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+		}
+		while (!m_head.compare_exchange_weak(head, makeHead(head, index),
+			std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	const std::size_t m_capacity;
+	std::unique_ptr<Slot[]> m_slots;
+	std::unique_ptr<std::atomic<std::uint32_t>[]> m_next;
+	std::atomic<std::uint64_t> m_head;
+};
+
+} // namespace lmms
+
+#endif // LMMS_VOICE_POOL_H
@@ -106,6 +106,28 @@ int LMMS_EXPORT compressbands(const float * _absspec_buffer, float * _compressed
 			int _num_old, int _num_new, int _bottom, int _top);
 
 
+/**	Get a shared FFTW plan for a real-to-complex transform of the given size.
+ *	Plans are created with FFTW_MEASURE on first use and cached for the
+ *	lifetime of the program, so every FFT user of the same size shares one.
+ *	Execute them with fftwf_execute_dft_r2c() on buffers from fftwf_malloc(),
+ *	the input holding size floats and the output size / 2 + 1 bins.
+ *	Creating a plan is thread safe, executing one is too. The FFTW planner
+ *	itself is not, so all code in LMMS plans through these functions instead
+ *	of calling fftwf_plan_*() directly.
+ *
+ *	@return nullptr on error
+ */
+fftwf_plan LMMS_EXPORT realToComplexPlan(unsigned int size);
+
+
+/**	Like realToComplexPlan(), but for the inverse transform. Execute with
+ *	fftwf_execute_dft_c2r(); note that it overwrites its input.
+ *
+ *	@return nullptr on error
+ */
+fftwf_plan LMMS_EXPORT complexToRealPlan(unsigned int size);
+
+
 } // namespace lmms
 
 #endif // LMMS_FFT_HELPERS_H
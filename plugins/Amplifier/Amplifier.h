@@ -39,6 +39,11 @@ public:
 	~AmplifierEffect() override = default;
 	bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override;
 
+	f_cnt_t tailLength() const override
+	{
+		return 0;
+	}
+
 	EffectControls* controls() override
 	{
 		return &m_ampControls;
@@ -69,40 +69,27 @@ Plugin::Descriptor PLUGIN_EXPORT bitinvader_plugin_descriptor =
 }
 
 
-BSynth::BSynth( float * _shape, NotePlayHandle * _nph, bool _interpolation,
-				float _factor, const sample_rate_t _sample_rate ) :
+BSynth::BSynth( std::shared_ptr<const BitInvaderWave> _shape,
+				std::shared_ptr<const UserWaveform::Waveform> _band_limited,
+				NotePlayHandle * _nph,
+				bool _interpolation, const sample_rate_t _sample_rate ) :
 	sample_index( 0 ),
 	sample_realindex( 0 ),
+	sample_shape( std::move( _shape ) ),
+	band_limited( std::move( _band_limited ) ),
+	band_freq( 0 ),
+	band( 0 ),
 	nph( _nph ),
 	sample_rate( _sample_rate ),
 	interpolation( _interpolation)
 {
-	sample_shape = new float[wavetableSize];
-	for (int i=0; i < wavetableSize; ++i)
-	{
-		float buf = _shape[i] * _factor;
-
-		/* Double check that normalization has been performed correctly,
-		i.e., the absolute value of all samples is <= 1.0 if _factor
-		is different to the default normalization factor. If there is
-		a value > 1.0, clip the sample to 1.0 to limit the range. */
-		if ((_factor != defaultNormalizationFactor) && (fabsf(buf) > 1.0f))
-		{
-			buf = (buf < 0) ? -1.0f : 1.0f;
-		}
-		sample_shape[i] = buf;
-	}
 }
 
 
-BSynth::~BSynth()
-{
-	delete[] sample_shape;
-}
-
-
-sample_t BSynth::nextStringSample( float sample_length )
+sample_t BSynth::nextStringSample()
 {
+	const auto & shape = *sample_shape;
+	const auto sample_length = static_cast<float>( shape.size() );
 	auto sample_step = static_cast<float>(sample_length / (sample_rate / nph->frequency()));
 
 	// check overflow
@@ -112,7 +99,16 @@ sample_t BSynth::nextStringSample( float sample_length )
 
 	sample_t sample;
 
-	if (interpolation) {
+	if (interpolation && band_limited) {
+
+		// only look up the band again when the pitch changed
+		if (nph->frequency() != band_freq) {
+			band_freq = nph->frequency();
+			band = UserWaveform::band(band_freq);
+		}
+		sample = UserWaveform::sample(*band_limited, band, sample_realindex / sample_length);
+
+	} else if (interpolation) {
 
 		// find position in shape 
 		int a = static_cast<int>(sample_realindex);	
@@ -126,12 +122,12 @@ sample_t BSynth::nextStringSample( float sample_length )
 		// Nachkommaanteil
 		const float frac = fraction( sample_realindex );
 		
-		sample = linearInterpolate( sample_shape[a], sample_shape[b], frac );
+		sample = linearInterpolate( shape[a], shape[b], frac );
 
 	} else {
 		// No interpolation
 		sample_index = static_cast<int>(sample_realindex);	
-		sample = sample_shape[sample_index];
+		sample = shape[sample_index];
 	}
 	
 	// progress in shape
@@ -164,6 +160,9 @@ BitInvader::BitInvader( InstrumentTrack * _instrument_track ) :
 
 	connect( &m_graph, SIGNAL( samplesChanged( int, int ) ),
 			this, SLOT( samplesChanged( int, int ) ) );
+
+	connect( &m_normalize, SIGNAL( dataChanged() ),
+			this, SLOT( updateWave() ), Qt::DirectConnection );
 }
 
 
@@ -223,6 +222,9 @@ void BitInvader::loadSettings( const QDomElement & _this )
 	// Load LED 
 	m_normalize.loadSettings( _this, "normalize" );
 
+	// Notes may start right after loading, give them the band-limited tables of the loaded wave
+	const auto wave = std::atomic_load( &m_wave );
+	m_bandLimitedWave.updateNow( wave->data(), static_cast<int>( wave->size() ) );
 }
 
 
@@ -233,6 +235,7 @@ void BitInvader::lengthChanged()
 	m_graph.setLength( (int) m_sampleLength.value() );
 
 	normalize();
+	updateWave();
 }
 
 
@@ -241,6 +244,7 @@ void BitInvader::lengthChanged()
 void BitInvader::samplesChanged( int _begin, int _end )
 {
 	normalize();
+	updateWave();
 	//engine::getSongEditor()->setModified();
 }
 
@@ -263,6 +267,37 @@ void BitInvader::normalize()
 
 
 
+void BitInvader::updateWave()
+{
+	const float factor = m_normalize.value() ?
+				m_normalizeFactor : defaultNormalizationFactor;
+	const float* samples = m_graph.samples();
+
+	auto wave = std::make_shared<BitInvaderWave>( m_graph.length() );
+	for( std::size_t i = 0; i < wave->size(); ++i )
+	{
+		float buf = samples[i] * factor;
+
+		/* Double check that normalization has been performed correctly,
+		i.e., the absolute value of all samples is <= 1.0 if factor
+		is different to the default normalization factor. If there is
+		a value > 1.0, clip the sample to 1.0 to limit the range. */
+		if ((factor != defaultNormalizationFactor) && (fabsf(buf) > 1.0f))
+		{
+			buf = (buf < 0) ? -1.0f : 1.0f;
+		}
+		(*wave)[i] = buf;
+	}
+
+	// the band-limited tables follow in the background
+	m_bandLimitedWave.update( wave->data(), static_cast<int>( wave->size() ) );
+
+	std::atomic_store( &m_wave, std::shared_ptr<const BitInvaderWave>( std::move( wave ) ) );
+}
+
+
+
+
 QString BitInvader::nodeName() const
 {
 	return( bitinvader_plugin_descriptor.name );
@@ -276,20 +311,11 @@ void BitInvader::playNote( NotePlayHandle * _n,
 {
 	if (!_n->m_pluginData)
 	{
-		float factor;
-		if( !m_normalize.value() )
-		{
-			factor = defaultNormalizationFactor;
-		}
-		else
-		{
-			factor = m_normalizeFactor;
-		}
-
-		_n->m_pluginData = new BSynth(
-					const_cast<float*>( m_graph.samples() ),
+		_n->m_pluginData = m_voices.acquire(
+					std::atomic_load( &m_wave ),
+					m_bandLimitedWave.waveform(),
 					_n,
-					m_interpolation.value(), factor,
+					m_interpolation.value(),
 				Engine::audioEngine()->processingSampleRate() );
 	}
 
@@ -299,7 +325,7 @@ void BitInvader::playNote( NotePlayHandle * _n,
 	auto ps = static_cast<BSynth*>(_n->m_pluginData);
 	for( fpp_t frame = offset; frame < frames + offset; ++frame )
 	{
-		const sample_t cur = ps->nextStringSample( m_graph.length() );
+		const sample_t cur = ps->nextStringSample();
 		for( ch_cnt_t chnl = 0; chnl < DEFAULT_CHANNELS; ++chnl )
 		{
 			_working_buffer[frame][chnl] = cur;
@@ -314,7 +340,7 @@ void BitInvader::playNote( NotePlayHandle * _n,
 
 void BitInvader::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<BSynth *>( _n->m_pluginData );
+	m_voices.release( static_cast<BSynth *>( _n->m_pluginData ) );
 }
 
 
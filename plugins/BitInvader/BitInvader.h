@@ -27,11 +27,16 @@
 #ifndef BIT_INVADER_H
 #define BIT_INVADER_H
 
+#include <memory>
+#include <vector>
+
 #include "AutomatableModel.h"
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Graph.h"
 #include "MemoryManager.h"
+#include "UserWaveform.h"
+#include "VoicePool.h"
 
 namespace lmms
 {
@@ -46,22 +51,32 @@ class PixmapButton;
 }
 
 
+//! The normalized samples of the graph, shared read-only by all voices
+//! which started while they were current
+using BitInvaderWave = std::vector<float>;
+
+
 class BSynth
 {
 	MM_OPERATORS
 public:
-	BSynth( float * sample, NotePlayHandle * _nph,
-			bool _interpolation, float factor, 
-			const sample_rate_t _sample_rate );
-	virtual ~BSynth();
+	BSynth( std::shared_ptr<const BitInvaderWave> _shape,
+			std::shared_ptr<const UserWaveform::Waveform> _band_limited,
+			NotePlayHandle * _nph,
+			bool _interpolation, const sample_rate_t _sample_rate );
+	virtual ~BSynth() = default;
 	
-	sample_t nextStringSample( float sample_length );
+	sample_t nextStringSample();
 
 
 private:
 	int sample_index;
 	float sample_realindex;
-	float* sample_shape;
+	std::shared_ptr<const BitInvaderWave> sample_shape;
+	// played instead of interpolating the shape once generated
+	std::shared_ptr<const UserWaveform::Waveform> band_limited;
+	float band_freq;
+	int band;
 	NotePlayHandle* nph;
 	const sample_rate_t sample_rate;
 
@@ -99,6 +114,7 @@ protected slots:
 	void samplesChanged( int, int );
 
 	void normalize();
+	void updateWave();
 
 
 private:
@@ -109,6 +125,13 @@ private:
 	BoolModel m_normalize;
 	
 	float m_normalizeFactor;
+
+	// replaced as a whole whenever the graph or the normalization changes,
+	// so voices never see a graph which is being edited
+	std::shared_ptr<const BitInvaderWave> m_wave;
+	UserWaveform m_bandLimitedWave;
+
+	VoicePool<BSynth> m_voices;
 	
 	friend class gui::BitInvaderView;
 } ;
@@ -0,0 +1,173 @@
+/*
+ * ConvolutionReverb.cpp - Reverb that convolves with a recorded impulse response
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ConvolutionReverb.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "AudioEngine.h"
+#include "AudioResampler.h"
+#include "Engine.h"
+#include "embed.h"
+#include "lmms_math.h"
+#include "plugin_export.h"
+
+namespace lmms
+{
+
+extern "C"
+{
+
+Plugin::Descriptor PLUGIN_EXPORT convolutionreverb_plugin_descriptor =
+{
+	LMMS_STRINGIFY(PLUGIN_NAME),
+	"Convolution Reverb",
+	QT_TRANSLATE_NOOP("PluginBrowser", "Reverb based on a recorded impulse response"),
+	"LMMS team",
+	0x0100,
+	Plugin::Type::Effect,
+	new PluginPixmapLoader("logo"),
+	nullptr,
+	nullptr,
+};
+
+}
+
+namespace
+{
+
+//! Converts the impulse response to the given sample rate and scales it to unit energy, so responses recorded at
+//! different levels sound about equally loud at the same gain
+std::vector<sampleFrame> prepareImpulseResponse(const SampleBuffer& buffer, sample_rate_t sampleRate)
+{
+	auto frames = std::vector<sampleFrame>(buffer.begin(), buffer.end());
+	if (frames.empty()) { return frames; }
+
+	if (buffer.sampleRate() != sampleRate)
+	{
+		const auto ratio = static_cast<double>(sampleRate) / buffer.sampleRate();
+		auto resampled = std::vector<sampleFrame>(static_cast<std::size_t>(std::ceil(frames.size() * ratio)));
+
+		auto resampler = AudioResampler{SRC_SINC_MEDIUM_QUALITY, DEFAULT_CHANNELS};
+		const auto result = resampler.resample(frames.front().data(), static_cast<long>(frames.size()),
+			resampled.front().data(), static_cast<long>(resampled.size()), ratio);
+		if (result.error != 0) { return {}; }
+
+		resampled.resize(result.outputFramesGenerated);
+		frames = std::move(resampled);
+	}
+
+	auto energy = 0.0;
+	for (const auto& frame : frames)
+	{
+		energy += frame[0] * frame[0] + frame[1] * frame[1];
+	}
+	if (energy > 0.0)
+	{
+		const auto scale = static_cast<float>(1.0 / std::sqrt(energy / DEFAULT_CHANNELS));
+		for (auto& frame : frames)
+		{
+			frame[0] *= scale;
+			frame[1] *= scale;
+		}
+	}
+
+	return frames;
+}
+
+} // namespace
+
+ConvolutionReverbEffect::ConvolutionReverbEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key) :
+	Effect(&convolutionreverb_plugin_descriptor, parent, key),
+	m_controls(this),
+	// Sized for the largest period, since the period size can change while the effect exists and the buffer must
+	// not be resized on the audio thread
+	m_wetBuffer(MAXIMUM_RENDER_BUFFER_SIZE)
+{
+}
+
+bool ConvolutionReverbEffect::processAudioBuffer(sampleFrame* buf, const fpp_t frames)
+{
+	if (!isEnabled() || !isRunning()) { return false; }
+	assert(static_cast<std::size_t>(frames) <= m_wetBuffer.size());
+
+	const float d = dryLevel();
+	const float w = wetLevel();
+
+	if (m_convolver) { m_convolver->process(buf, m_wetBuffer.data(), frames); }
+	else { std::fill_n(m_wetBuffer.begin(), frames, sampleFrame{}); }
+
+	const ValueBuffer* gainBuf = m_controls.m_gainModel.valueBuffer();
+
+	double outSum = 0.0;
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		const float gain = dbfsToAmp(gainBuf ? gainBuf->values()[f] : m_controls.m_gainModel.value());
+
+		buf[f][0] = d * buf[f][0] + w * gain * m_wetBuffer[f][0];
+		buf[f][1] = d * buf[f][1] + w * gain * m_wetBuffer[f][1];
+
+		outSum += buf[f][0] * buf[f][0] + buf[f][1] * buf[f][1];
+	}
+
+	checkGate(outSum / frames);
+
+	return isRunning();
+}
+
+void ConvolutionReverbEffect::setImpulseResponse(std::shared_ptr<const SampleBuffer> impulseResponse)
+{
+	m_impulseResponse = std::move(impulseResponse);
+	updateConvolver();
+}
+
+void ConvolutionReverbEffect::updateConvolver()
+{
+	const auto frames = prepareImpulseResponse(*m_impulseResponse, Engine::audioEngine()->processingSampleRate());
+
+	auto convolver = std::unique_ptr<PartitionedConvolver>{};
+	if (!frames.empty())
+	{
+		convolver = std::make_unique<PartitionedConvolver>();
+		convolver->setImpulseResponse(frames.data(), static_cast<f_cnt_t>(frames.size()));
+	}
+
+	// Only the swap happens with the audio engine held; the old convolver is destroyed after it is released
+	Engine::audioEngine()->requestChangeInModel();
+	std::swap(m_convolver, convolver);
+	Engine::audioEngine()->doneChangeInModel();
+}
+
+extern "C"
+{
+
+// necessary for getting instance out of shared lib
+PLUGIN_EXPORT Plugin* lmms_plugin_main(Model* parent, void* data)
+{
+	return new ConvolutionReverbEffect(parent, static_cast<const Plugin::Descriptor::SubPluginFeatures::Key*>(data));
+}
+
+}
+
+} // namespace lmms
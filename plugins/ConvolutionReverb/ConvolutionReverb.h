@@ -0,0 +1,79 @@
+/*
+ * ConvolutionReverb.h - Reverb that convolves with a recorded impulse response
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_CONVOLUTION_REVERB_H
+#define LMMS_CONVOLUTION_REVERB_H
+
+#include <memory>
+#include <vector>
+
+#include "ConvolutionReverbControls.h"
+#include "Effect.h"
+#include "PartitionedConvolver.h"
+#include "SampleBuffer.h"
+
+namespace lmms
+{
+
+class ConvolutionReverbEffect : public Effect
+{
+public:
+	ConvolutionReverbEffect(Model* parent, const Descriptor::SubPluginFeatures::Key* key);
+	~ConvolutionReverbEffect() override = default;
+
+	bool processAudioBuffer(sampleFrame* buf, const fpp_t frames) override;
+
+	//! The impulse response, plus the block the background thread works ahead
+	f_cnt_t tailLength() const override
+	{
+		return m_convolver ? m_convolver->length() + PartitionedConvolver::TailBlockSize : 0;
+	}
+
+	EffectControls* controls() override
+	{
+		return &m_controls;
+	}
+
+	//! Replaces the impulse response. Preparing it takes a while, so this is not done on the audio thread.
+	void setImpulseResponse(std::shared_ptr<const SampleBuffer> impulseResponse);
+
+	const std::shared_ptr<const SampleBuffer>& impulseResponse() const
+	{
+		return m_impulseResponse;
+	}
+
+	//! Prepares the impulse response again for the current processing sample rate
+	void updateConvolver();
+
+private:
+	ConvolutionReverbControls m_controls;
+
+	std::shared_ptr<const SampleBuffer> m_impulseResponse = SampleBuffer::emptyBuffer();
+	std::unique_ptr<PartitionedConvolver> m_convolver;
+	std::vector<sampleFrame> m_wetBuffer;
+
+	friend class ConvolutionReverbControls;
+};
+
+} // namespace lmms
+
+#endif // LMMS_CONVOLUTION_REVERB_H
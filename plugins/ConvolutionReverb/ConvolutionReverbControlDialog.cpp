@@ -0,0 +1,88 @@
+/*
+ * ConvolutionReverbControlDialog.cpp - Control dialog for the convolution reverb
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ConvolutionReverbControlDialog.h"
+
+#include <QFileInfo>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include "ConvolutionReverbControls.h"
+#include "Engine.h"
+#include "Knob.h"
+#include "SampleLoader.h"
+#include "Song.h"
+#include "embed.h"
+
+namespace lmms::gui
+{
+
+ConvolutionReverbControlDialog::ConvolutionReverbControlDialog(ConvolutionReverbControls* controls) :
+	EffectControlDialog(controls),
+	m_controls(controls)
+{
+	auto layout = new QHBoxLayout(this);
+
+	auto fileLayout = new QVBoxLayout;
+
+	auto openButton = new QPushButton(embed::getIconPixmap("project_open"), tr("Load"), this);
+	openButton->setToolTip(tr("Load impulse response"));
+	connect(openButton, SIGNAL(clicked()), this, SLOT(openImpulseResponse()));
+	fileLayout->addWidget(openButton);
+
+	m_fileLabel = new QLabel(this);
+	m_fileLabel->setFixedWidth(120);
+	fileLayout->addWidget(m_fileLabel);
+
+	layout->addLayout(fileLayout);
+
+	auto gainKnob = new Knob(KnobType::Bright26, this);
+	gainKnob->setModel(&controls->m_gainModel);
+	gainKnob->setLabel(tr("GAIN"));
+	gainKnob->setHintText(tr("Gain:"), "dB");
+	layout->addWidget(gainKnob);
+
+	connect(controls, SIGNAL(impulseResponseChanged()), this, SLOT(updateFileLabel()));
+	updateFileLabel();
+}
+
+void ConvolutionReverbControlDialog::openImpulseResponse()
+{
+	const auto file = SampleLoader::openAudioFile(m_controls->impulseResponseFile());
+	if (file.isEmpty()) { return; }
+
+	m_controls->loadImpulseResponse(file);
+	Engine::getSong()->setModified();
+}
+
+void ConvolutionReverbControlDialog::updateFileLabel()
+{
+	const auto file = m_controls->impulseResponseFile();
+	const auto name = file.isEmpty() ? tr("No impulse response") : QFileInfo(file).fileName();
+
+	m_fileLabel->setText(m_fileLabel->fontMetrics().elidedText(name, Qt::ElideMiddle, m_fileLabel->width()));
+	m_fileLabel->setToolTip(file);
+}
+
+} // namespace lmms::gui
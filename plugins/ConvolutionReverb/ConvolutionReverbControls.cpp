@@ -0,0 +1,82 @@
+/*
+ * ConvolutionReverbControls.cpp - Controls for the convolution reverb
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "ConvolutionReverbControls.h"
+
+#include <QDomElement>
+#include <QFileInfo>
+
+#include "ConvolutionReverb.h"
+#include "Engine.h"
+#include "PathUtil.h"
+#include "SampleLoader.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+ConvolutionReverbControls::ConvolutionReverbControls(ConvolutionReverbEffect* effect) :
+	EffectControls(effect),
+	m_effect(effect),
+	m_gainModel(0.0f, -60.0f, 15.0f, 0.1f, this, tr("Gain"))
+{
+	connect(Engine::audioEngine(), SIGNAL(sampleRateChanged()), this, SLOT(changeSampleRate()));
+}
+
+void ConvolutionReverbControls::loadImpulseResponse(const QString& file)
+{
+	m_effect->setImpulseResponse(gui::SampleLoader::createBufferFromFile(file));
+	emit impulseResponseChanged();
+}
+
+QString ConvolutionReverbControls::impulseResponseFile() const
+{
+	return m_effect->impulseResponse()->audioFile();
+}
+
+void ConvolutionReverbControls::loadSettings(const QDomElement& element)
+{
+	m_gainModel.loadSettings(element, "gain");
+
+	const auto file = element.attribute("src");
+	if (!file.isEmpty() && !QFileInfo(PathUtil::toAbsolute(file)).exists())
+	{
+		Engine::getSong()->collectError(tr("Impulse response not found: %1").arg(file));
+		loadImpulseResponse(QString{});
+		return;
+	}
+
+	loadImpulseResponse(file);
+}
+
+void ConvolutionReverbControls::saveSettings(QDomDocument& doc, QDomElement& element)
+{
+	m_gainModel.saveSettings(doc, element, "gain");
+	element.setAttribute("src", impulseResponseFile());
+}
+
+void ConvolutionReverbControls::changeSampleRate()
+{
+	m_effect->updateConvolver();
+}
+
+} // namespace lmms
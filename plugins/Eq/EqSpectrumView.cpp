@@ -44,8 +44,9 @@ EqAnalyser::EqAnalyser() :
 	m_active ( true )
 {
 	m_inProgress=false;
+	m_buffer = fftwf_alloc_real( FFT_BUFFER_SIZE * 2 );
 	m_specBuf = ( fftwf_complex * ) fftwf_malloc( ( FFT_BUFFER_SIZE + 1 ) * sizeof( fftwf_complex ) );
-	m_fftPlan = fftwf_plan_dft_r2c_1d( FFT_BUFFER_SIZE*2, m_buffer, m_specBuf, FFTW_MEASURE );
+	m_fftPlan = realToComplexPlan( FFT_BUFFER_SIZE * 2 );
 
 	//initialize Blackman-Harris window, constants taken from
 	//https://en.wikipedia.org/wiki/Window_function#A_list_of_window_functions
@@ -68,7 +69,7 @@ EqAnalyser::EqAnalyser() :
 
 EqAnalyser::~EqAnalyser()
 {
-	fftwf_destroy_plan( m_fftPlan );
+	fftwf_free( m_buffer );
 	fftwf_free( m_specBuf );
 }
 
@@ -112,7 +113,7 @@ void EqAnalyser::analyze( sampleFrame *buf, const fpp_t frames )
 			m_buffer[i] = m_buffer[i] * m_fftWindow[i];
 		}
 
-		fftwf_execute( m_fftPlan );
+		fftwf_execute_dft_r2c( m_fftPlan, m_buffer, m_specBuf );
 		absspec( m_specBuf, m_absSpecBuf, FFT_BUFFER_SIZE+1 );
 
 		compressbands( m_absSpecBuf, m_bands, FFT_BUFFER_SIZE+1,
@@ -174,7 +175,7 @@ void EqAnalyser::clear()
 {
 	m_framesFilledUp = 0;
 	m_energy = 0;
-	memset( m_buffer, 0, sizeof( m_buffer ) );
+	memset( m_buffer, 0, FFT_BUFFER_SIZE * 2 * sizeof( float ) );
 	memset( m_bands, 0, sizeof( m_bands ) );
 }
 
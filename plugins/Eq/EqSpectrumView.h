@@ -56,7 +56,7 @@ private:
 	fftwf_plan m_fftPlan;
 	fftwf_complex * m_specBuf;
 	float m_absSpecBuf[FFT_BUFFER_SIZE+1];
-	float m_buffer[FFT_BUFFER_SIZE*2];
+	float * m_buffer; // FFT_BUFFER_SIZE * 2 samples from fftwf_malloc()
 	int m_framesFilledUp;
 	float m_energy;
 	int m_sampleRate;
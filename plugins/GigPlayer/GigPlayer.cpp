@@ -41,6 +41,7 @@
 #include "endian_handling.h"
 #include "Engine.h"
 #include "FileDialog.h"
+#include "GuiApplication.h"
 #include "InstrumentTrack.h"
 #include "InstrumentPlayHandle.h"
 #include "Knob.h"
@@ -80,10 +81,134 @@ Plugin::Descriptor PLUGIN_EXPORT gigplayer_plugin_descriptor =
 
 
 
+QMutex GigInstance::s_poolMutex;
+QWaitCondition GigInstance::s_poolLoaded;
+std::map<QString, GigInstance::PoolEntry> GigInstance::s_pool;
+
+
+
+
+std::shared_ptr<GigInstance> GigInstance::acquire( const QString & filename )
+{
+	QMutexLocker locker( &s_poolMutex );
+
+	// If another instrument is loading the same file, wait for it instead of
+	// parsing the file twice
+	while( true )
+	{
+		const PoolEntry & entry = s_pool[filename];
+		if( auto instance = entry.instance.lock() )
+		{
+			return instance;
+		}
+		if( !entry.loading )
+		{
+			break;
+		}
+		s_poolLoaded.wait( &s_poolMutex );
+	}
+
+	// Parse without holding the pool, so loading one library doesn't block
+	// instruments opening other files
+	s_pool[filename].loading = true;
+	locker.unlock();
+
+	std::shared_ptr<GigInstance> instance;
+	try
+	{
+		instance = std::shared_ptr<GigInstance>( new GigInstance( filename ) );
+	}
+	catch( ... )
+	{
+		locker.relock();
+		s_pool[filename].loading = false;
+		s_poolLoaded.wakeAll();
+		throw;
+	}
+
+	locker.relock();
+	PoolEntry & entry = s_pool[filename];
+	entry.instance = instance;
+	entry.loading = false;
+	s_poolLoaded.wakeAll();
+
+	return instance;
+}
+
+
+
+
+GigInstance::GigInstance( QString filename ) :
+	riff( filename.toUtf8().constData() ),
+	gig( &riff )
+{
+	preloadSamples();
+}
+
+
+
+
+void GigInstance::preloadSamples()
+{
+	// Number of frames per sample kept in RAM, the rest is read from disk
+	// while playing. 0 preloads whole samples.
+	const auto preloadFrames = ConfigManager::inst()->value( "gigplayer", "preloadframes", "32768" ).toULong();
+
+	gig::Sample * pSample = gig.GetFirstSample();
+
+	while( pSample != nullptr )
+	{
+		if( preloadFrames == 0 || pSample->SamplesTotal <= preloadFrames )
+		{
+			pSample->LoadSampleData();
+		}
+		else
+		{
+			pSample->LoadSampleData( preloadFrames );
+		}
+
+		pSample = gig.GetNextSample();
+	}
+}
+
+
+
+
+unsigned long GigInstance::read( gig::Sample * sample, f_cnt_t pos, void * buffer, unsigned long frames )
+{
+	if( pos >= sample->SamplesTotal )
+	{
+		return 0;
+	}
+
+	frames = std::min<unsigned long>( frames, sample->SamplesTotal - pos );
+
+	// Preloaded data can be read by everybody at once
+	const gig::buffer_t cache = sample->GetCache();
+	const unsigned long cachedFrames = cache.Size / sample->FrameSize;
+
+	if( pos + frames <= cachedFrames )
+	{
+		std::memcpy( buffer, static_cast<int8_t*>( cache.pStart ) + pos * sample->FrameSize,
+				frames * sample->FrameSize );
+		return frames;
+	}
+
+	// The file position is shared, so only one reader may stream at a time
+	QMutexLocker locker( &m_mutex );
+	sample->SetPos( pos );
+
+	return sample->Read( buffer, frames );
+}
+
+
+
+
 GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	Instrument( _instrument_track, &gigplayer_plugin_descriptor ),
 	m_instance( nullptr ),
 	m_instrument( nullptr ),
+	m_loadGeneration( 0 ),
 	m_filename( "" ),
 	m_bankNum( 0, 0, 999, this, tr( "Bank" ) ),
 	m_patchNum( 0, 0, 127, this, tr( "Patch" ) ),
@@ -100,6 +225,7 @@ GigInstrument::GigInstrument( InstrumentTrack * _instrument_track ) :
 	connect( &m_bankNum, SIGNAL( dataChanged() ), this, SLOT( updatePatch() ) );
 	connect( &m_patchNum, SIGNAL( dataChanged() ), this, SLOT( updatePatch() ) );
 	connect( Engine::audioEngine(), SIGNAL( sampleRateChanged() ), this, SLOT( updateSampleRate() ) );
+	connect( this, SIGNAL( instanceLoaded( bool, int ) ), this, SLOT( fileLoaded( bool, int ) ) );
 }
 
 
@@ -110,6 +236,7 @@ GigInstrument::~GigInstrument()
 	Engine::audioEngine()->removePlayHandlesOfTypes( instrumentTrack(),
 				PlayHandle::Type::NotePlayHandle
 				| PlayHandle::Type::InstrumentPlayHandle );
+	joinLoader();
 	freeInstance();
 }
 
@@ -130,13 +257,13 @@ void GigInstrument::saveSettings( QDomDocument & _doc, QDomElement & _this )
 
 void GigInstrument::loadSettings( const QDomElement & _this )
 {
-	openFile( _this.attribute( "src" ), false );
+	// Load the models first, the patch is selected once the file is open
 	m_patchNum.loadSettings( _this, "patch" );
 	m_bankNum.loadSettings( _this, "bank" );
 
 	m_gain.loadSettings( _this, "gain" );
 
-	updatePatch();
+	openFile( _this.attribute( "src" ), false );
 }
 
 
@@ -189,7 +316,7 @@ void GigInstrument::freeInstance()
 
 	if( m_instance != nullptr )
 	{
-		delete m_instance;
+		// The file itself is only closed when no other instrument uses it
 		m_instance = nullptr;
 
 		// If we're changing instruments, we got to make sure that we
@@ -203,34 +330,98 @@ void GigInstrument::freeInstance()
 
 
 
+void GigInstrument::joinLoader()
+{
+	if( m_loader.joinable() )
+	{
+		m_loader.join();
+	}
+}
+
+
+
+
 void GigInstrument::openFile( const QString & _gigFile, bool updateTrackName )
 {
 	emit fileLoading();
 
 	// Remove the current instrument if one is selected
+	joinLoader();
 	freeInstance();
 
+	m_filename = PathUtil::toShortestRelative( _gigFile );
+	const int generation = ++m_loadGeneration;
+
+	// Large libraries take a while to parse and preload, so do it in the
+	// background when running interactively. The instrument stays silent
+	// until the file is ready. Headless renders need the samples before the
+	// first period, so load them right away.
+	if( gui::getGUI() != nullptr )
+	{
+		m_loader = std::thread( &GigInstrument::loadInstance, this, _gigFile, updateTrackName, generation );
+	}
+	else
+	{
+		loadInstance( _gigFile, updateTrackName, generation );
+	}
+}
+
+
+
+
+void GigInstrument::loadInstance( const QString & gigFile, bool updateTrackName, int generation )
+{
+	std::shared_ptr<GigInstance> instance;
+
+	try
+	{
+		instance = GigInstance::acquire( PathUtil::toAbsolute( gigFile ) );
+	}
+	catch( ... )
+	{
+		instance = nullptr;
+	}
+
 	{
 		QMutexLocker locker( &m_synthMutex );
+		m_instance = instance;
+	}
 
-		try
-		{
-			m_instance = new GigInstance( PathUtil::toAbsolute( _gigFile ) );
-			m_filename = PathUtil::toShortestRelative( _gigFile );
-		}
-		catch( ... )
-		{
-			m_instance = nullptr;
-			m_filename = "";
-		}
+	// Select the patch before we start playing again
+	updatePatch();
+
+	// Queued to the GUI thread if we're running on the loader thread
+	emit instanceLoaded( updateTrackName, generation );
+}
+
+
+
+
+void GigInstrument::fileLoaded( bool updateTrackName, int generation )
+{
+	// Another file was opened before this notification arrived, its own
+	// notification follows
+	if( generation != m_loadGeneration )
+	{
+		return;
+	}
+
+	bool loaded;
+	{
+		QMutexLocker locker( &m_synthMutex );
+		loaded = m_instance != nullptr;
+	}
+
+	if( !loaded )
+	{
+		m_filename = "";
 	}
 
 	emit fileChanged();
 
-	if( updateTrackName == true )
+	if( updateTrackName == true && loaded )
 	{
-		instrumentTrack()->setName(PathUtil::cleanName( _gigFile ) );
-		updatePatch();
+		instrumentTrack()->setName( PathUtil::cleanName( m_filename ) );
 	}
 }
 
@@ -260,6 +451,7 @@ QString GigInstrument::getCurrentPatchName()
 	int iBankSelected = m_bankNum.value();
 	int iProgSelected = m_patchNum.value();
 
+	QMutexLocker instanceLock( &m_instance->mutex() );
 	gig::Instrument * pInstrument = m_instance->gig.GetFirstInstrument();
 
 	while( pInstrument != nullptr )
@@ -333,6 +525,9 @@ void GigInstrument::play( sampleFrame * _working_buffer )
 
 	if( m_instance == nullptr || m_instrument == nullptr )
 	{
+		// Notes pressed while the file is still loading stay silent
+		m_notes.clear();
+
 		m_synthMutex.unlock();
 		m_notesMutex.unlock();
 		return;
@@ -543,8 +738,6 @@ void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cn
 			// TODO: also implement loop_type_backward support
 		}
 
-		sample.sample->SetPos( sample.pos );
-
 		// Load the samples (based on gig::Sample::ReadAndLoop) even around the end
 		// of a loop boundary wrapping to the beginning of the loop region
 		long samplestoread = samples;
@@ -552,27 +745,31 @@ void GigInstrument::loadSample( GigSample& sample, sampleFrame* sampleData, f_cn
 		long readsamples = 0;
 		long totalreadsamples = 0;
 		long loopEnd = loopStart + loopLength;
+		f_cnt_t readpos = sample.pos;
 
 		do
 		{
-			samplestoloopend = loopEnd - sample.sample->GetPos();
-			readsamples = sample.sample->Read( &buffer[totalreadsamples * sample.sample->FrameSize],
+			samplestoloopend = loopEnd - readpos;
+			readsamples = m_instance->read( sample.sample, readpos,
+					&buffer[totalreadsamples * sample.sample->FrameSize],
 					std::min( samplestoread, samplestoloopend ) );
 			samplestoread -= readsamples;
 			totalreadsamples += readsamples;
+			readpos += readsamples;
 
 			if( readsamples >= samplestoloopend )
 			{
-				sample.sample->SetPos( loopStart );
+				readpos = loopStart;
 			}
 		}
 		while( samplestoread > 0 && readsamples > 0 );
+
+		unsigned long size = totalreadsamples * sample.sample->FrameSize;
+		std::memset( (int8_t*) &buffer + size, 0, allocationsize - size );
 	}
 	else
 	{
-		sample.sample->SetPos( sample.pos );
-
-		unsigned long size = sample.sample->Read( &buffer, samples ) * sample.sample->FrameSize;
+		unsigned long size = m_instance->read( sample.sample, sample.pos, &buffer, samples ) * sample.sample->FrameSize;
 		std::memset( (int8_t*) &buffer + size, 0, allocationsize - size );
 	}
 
@@ -719,6 +916,8 @@ void GigInstrument::addSamples( GigNote & gignote, bool wantReleaseSample )
 					m_instrument->DimensionKeyRange.low + 1 );
 	}
 
+	// Region iteration state lives in the shared instrument object
+	QMutexLocker instanceLock( &m_instance->mutex() );
 	gig::Region* pRegion = m_instrument->GetFirstRegion();
 
 	while( pRegion != nullptr )
@@ -863,6 +1062,7 @@ void GigInstrument::getInstrument()
 
 	if( m_instance != nullptr )
 	{
+		QMutexLocker instanceLock( &m_instance->mutex() );
 		gig::Instrument * pInstrument = m_instance->gig.GetFirstInstrument();
 
 		while( pInstrument != nullptr )
@@ -1074,7 +1274,7 @@ void GigInstrumentView::showPatchDialog()
 {
 	auto k = castModel<GigInstrument>();
 	PatchesDialog pd( this );
-	pd.setup( k->m_instance, 1, k->instrumentTrack()->name(), &k->m_bankNum, &k->m_patchNum, m_patchLabel );
+	pd.setup( k->m_instance.get(), 1, k->instrumentTrack()->name(), &k->m_bankNum, &k->m_patchNum, m_patchLabel );
 	pd.exec();
 }
 
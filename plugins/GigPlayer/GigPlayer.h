@@ -27,9 +27,13 @@
 #ifndef GIG_PLAYER_H
 #define GIG_PLAYER_H
 
+#include <map>
+#include <memory>
+#include <thread>
 #include <QList>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QWaitCondition>
 #include <samplerate.h>
 
 #include "Instrument.h"
@@ -69,16 +73,51 @@ struct GIGPluginData
 
 
 // Load a GIG file using libgig
+//
+// Instances are shared between all GigInstruments that use the same file, so
+// a library used on several tracks is only parsed and preloaded once. The
+// start of every sample is cached in RAM, the rest is streamed from disk.
 class GigInstance
 {
 public:
-	GigInstance( QString filename ) :
-		riff( filename.toUtf8().constData() ),
-		gig( &riff )
-	{}
+	// Get the shared instance for a file, loading it if nobody uses it yet.
+	// Throws if the file can't be opened.
+	static std::shared_ptr<GigInstance> acquire( const QString & filename );
+
+	GigInstance( const GigInstance & ) = delete;
+	GigInstance & operator=( const GigInstance & ) = delete;
+
+	// Read frames of a sample starting at pos into buffer, either from the
+	// preloaded portion or from disk. Returns the number of frames read.
+	unsigned long read( gig::Sample * sample, f_cnt_t pos, void * buffer, unsigned long frames );
+
+	// libgig keeps iteration and file positions inside the file objects, so
+	// everybody sharing this instance must hold this while iterating
+	// instruments/regions or reading from disk
+	QMutex & mutex()
+	{
+		return m_mutex;
+	}
 
 private:
+	GigInstance( QString filename );
+
+	// Load the first frames of every sample into RAM
+	void preloadSamples();
+
 	RIFF::File riff;
+	QMutex m_mutex;
+
+	struct PoolEntry
+	{
+		std::weak_ptr<GigInstance> instance;
+		// Somebody is parsing the file with the pool unlocked
+		bool loading = false;
+	};
+
+	static QMutex s_poolMutex;
+	static QWaitCondition s_poolLoaded;
+	static std::map<QString, PoolEntry> s_pool;
 
 public:
 	gig::File gig;
@@ -285,11 +324,23 @@ public slots:
 	void updateSampleRate();
 
 
+private slots:
+	void fileLoaded( bool updateTrackName, int generation );
+
+
 private:
 	// The GIG file and instrument we're using
-	GigInstance * m_instance;
+	std::shared_ptr<GigInstance> m_instance;
 	gig::Instrument * m_instrument;
 
+	// Loads the file in the background, the instrument stays silent until
+	// m_instance is set
+	std::thread m_loader;
+
+	// Counts openFile() calls, so the queued notification of a load that
+	// was superseded in the meantime is ignored
+	int m_loadGeneration;
+
 	// Part of the UI
 	QString m_filename;
 
@@ -316,6 +367,12 @@ private:
 	// Delete the current GIG instance if one is open
 	void freeInstance();
 
+	// Wait for a background load to finish
+	void joinLoader();
+
+	// Acquire the shared instance for a file, run on the loader thread
+	void loadInstance( const QString & gigFile, bool updateTrackName, int generation );
+
 	// Open the instrument in the currently-open GIG file
 	void getInstrument();
 
@@ -338,6 +395,7 @@ signals:
 	void fileLoading();
 	void fileChanged();
 	void patchChanged();
+	void instanceLoaded( bool updateTrackName, int generation );
 
 } ;
 
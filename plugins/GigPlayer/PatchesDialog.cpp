@@ -143,6 +143,9 @@ void PatchesDialog::setup( GigInstance * pSynth, int iChan,
 	int iBankDefault = -1;
 	int iProgDefault = -1;
 
+	// The file may be shared with other instruments iterating it
+	QMutexLocker synthLock( &m_pSynth->mutex() );
+
 	gig::Instrument * pInstrument = m_pSynth->gig.GetFirstInstrument();
 
 	while( pInstrument )
@@ -169,6 +172,8 @@ void PatchesDialog::setup( GigInstance * pSynth, int iChan,
 		pInstrument = m_pSynth->gig.GetNextInstrument();
 	}
 
+	synthLock.unlock();
+
 	m_bankListView->setSortingEnabled( true );
 
 	// Set the selected bank.
@@ -341,6 +346,7 @@ void PatchesDialog::bankChanged()
 	m_progListView->clear();
 	QTreeWidgetItem * pProgItem = nullptr;
 
+	QMutexLocker synthLock( &m_pSynth->mutex() );
 	gig::Instrument * pInstrument = m_pSynth->gig.GetFirstInstrument();
 
 	while( pInstrument )
@@ -369,6 +375,8 @@ void PatchesDialog::bankChanged()
 		pInstrument = m_pSynth->gig.GetNextInstrument();
 	}
 
+	synthLock.unlock();
+
 	m_progListView->setSortingEnabled( true );
 
 	// Stabilize the form.
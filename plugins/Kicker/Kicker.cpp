@@ -33,7 +33,6 @@
 #include "Knob.h"
 #include "LedCheckBox.h"
 #include "NotePlayHandle.h"
-#include "KickerOsc.h"
 #include "TempoSyncKnob.h"
 
 #include "embed.h"
@@ -152,9 +151,6 @@ QString KickerInstrument::nodeName() const
 	return kicker_plugin_descriptor.name;
 }
 
-using DistFX = DspEffectLibrary::Distortion;
-using SweepOsc = KickerOsc<DspEffectLibrary::MonoToStereoAdaptor<DistFX>>;
-
 void KickerInstrument::playNote( NotePlayHandle * _n,
 						sampleFrame * _working_buffer )
 {
@@ -165,7 +161,7 @@ void KickerInstrument::playNote( NotePlayHandle * _n,
 
 	if (!_n->m_pluginData)
 	{
-		_n->m_pluginData = new SweepOsc(
+		_n->m_pluginData = m_voices.acquire(
 					DistFX( m_distModel.value(),
 							m_gainModel.value() ),
 					m_startNoteModel.value() ? _n->frequency() : m_startFreqModel.value(),
@@ -204,7 +200,7 @@ void KickerInstrument::playNote( NotePlayHandle * _n,
 
 void KickerInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<SweepOsc *>( _n->m_pluginData );
+	m_voices.release( static_cast<SweepOsc *>( _n->m_pluginData ) );
 }
 
 
@@ -29,7 +29,9 @@
 #include "AutomatableModel.h"
 #include "Instrument.h"
 #include "InstrumentView.h"
+#include "KickerOsc.h"
 #include "TempoSyncKnobModel.h"
+#include "VoicePool.h"
 
 
 namespace lmms
@@ -78,6 +80,11 @@ public:
 
 
 private:
+	using DistFX = DspEffectLibrary::Distortion;
+	using SweepOsc = KickerOsc<DspEffectLibrary::MonoToStereoAdaptor<DistFX>>;
+
+	VoicePool<SweepOsc> m_voices;
+
 	FloatModel m_startFreqModel;
 	FloatModel m_endFreqModel;
 	TempoSyncKnobModel m_decayModel;
@@ -1070,7 +1070,7 @@ void MonstroInstrument::playNote( NotePlayHandle * _n,
 
 	if (!_n->m_pluginData)
 	{
-		_n->m_pluginData = new MonstroSynth( this, _n );
+		_n->m_pluginData = m_voices.acquire( this, _n );
 	}
 
 	auto ms = static_cast<MonstroSynth*>(_n->m_pluginData);
@@ -1082,7 +1082,7 @@ void MonstroInstrument::playNote( NotePlayHandle * _n,
 
 void MonstroInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<MonstroSynth *>( _n->m_pluginData );
+	m_voices.release( static_cast<MonstroSynth *>( _n->m_pluginData ) );
 }
 
 
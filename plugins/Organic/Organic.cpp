@@ -228,73 +228,46 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 
 	if (!_n->m_pluginData)
 	{
-		auto oscs_l = std::array<Oscillator*, NUM_OSCILLATORS>{};
-		auto oscs_r = std::array<Oscillator*, NUM_OSCILLATORS>{};
-
-		_n->m_pluginData = new oscPtr;
+		auto voice = m_voices.acquire();
 
 		for( int i = m_numOscillators - 1; i >= 0; --i )
 		{
-			static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i]
-				= rand() / ( RAND_MAX + 1.0f );
-			static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i]
-				= rand() / ( RAND_MAX + 1.0f );
-
-			// initialise ocillators
-
-			if( i == m_numOscillators - 1 )
-			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i],
-						m_osc[i]->m_volumeLeft );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i],
-						m_osc[i]->m_volumeRight );
-			}
-			else
-			{
-				// create left oscillator
-				oscs_l[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningLeft,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetLeft[i],
-						m_osc[i]->m_volumeLeft,
-						oscs_l[i + 1] );
-				// create right oscillator
-				oscs_r[i] = new Oscillator(
-						&m_osc[i]->m_waveShape,
-						&m_modulationAlgo,
-						_n->frequency(),
-						m_osc[i]->m_detuningRight,
-						static_cast<oscPtr *>( _n->m_pluginData )->phaseOffsetRight[i],
-						m_osc[i]->m_volumeRight,
-						oscs_r[i + 1] );
-			}
-
-
+			voice->phaseOffsetLeft[i] = rand() / ( RAND_MAX + 1.0f );
+			voice->phaseOffsetRight[i] = rand() / ( RAND_MAX + 1.0f );
+
+			// initialise ocillators, the last ones need no sub-oscillators
+			Oscillator * sub_l = i < m_numOscillators - 1 ?
+						&*voice->left[i + 1] : nullptr;
+			Oscillator * sub_r = i < m_numOscillators - 1 ?
+						&*voice->right[i + 1] : nullptr;
+
+			// create left oscillator
+			voice->left[i].emplace(
+					&m_osc[i]->m_waveShape,
+					&m_modulationAlgo,
+					_n->frequency(),
+					m_osc[i]->m_detuningLeft,
+					voice->phaseOffsetLeft[i],
+					m_osc[i]->m_volumeLeft,
+					sub_l );
+			// create right oscillator
+			voice->right[i].emplace(
+					&m_osc[i]->m_waveShape,
+					&m_modulationAlgo,
+					_n->frequency(),
+					m_osc[i]->m_detuningRight,
+					voice->phaseOffsetRight[i],
+					m_osc[i]->m_volumeRight,
+					sub_r );
 		}
 
-		static_cast<oscPtr *>( _n->m_pluginData )->oscLeft = oscs_l[0];
-		static_cast<oscPtr *>( _n->m_pluginData )->oscRight = oscs_r[0];
+		_n->m_pluginData = voice;
 	}
 
-	Oscillator * osc_l = static_cast<oscPtr *>( _n->m_pluginData )->oscLeft;
-	Oscillator * osc_r = static_cast<oscPtr *>( _n->m_pluginData)->oscRight;
+	auto voice = static_cast<Voice *>( _n->m_pluginData );
 
-	osc_l->update( _working_buffer + offset, frames, 0 );
-	osc_r->update( _working_buffer + offset, frames, 1 );
+	voice->left[0]->update( _working_buffer + offset, frames, 0 );
+	voice->right[0]->update( _working_buffer + offset, frames, 1 );
 
 
 	// -- fx section --
@@ -318,12 +291,7 @@ void OrganicInstrument::playNote( NotePlayHandle * _n,
 
 void OrganicInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscLeft );
-	delete static_cast<Oscillator *>( static_cast<oscPtr *>(
-						_n->m_pluginData )->oscRight );
-
-	delete static_cast<oscPtr *>( _n->m_pluginData );
+	m_voices.release( static_cast<Voice *>( _n->m_pluginData ) );
 }
 
 /*float inline OrganicInstrument::foldback(float in, float threshold)
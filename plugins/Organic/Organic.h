@@ -26,10 +26,14 @@
 #define LMMS_ORGANIC_H
 
 #include <QString>
+#include <array>
+#include <optional>
 
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "AutomatableModel.h"
+#include "Oscillator.h"
+#include "VoicePool.h"
 
 class QPixmap;
 
@@ -38,7 +42,6 @@ namespace lmms
 
 
 class NotePlayHandle;
-class Oscillator;
 
 namespace gui
 {
@@ -157,15 +160,18 @@ private:
 
 	OscillatorObject ** m_osc;
 
-	struct oscPtr
+	//! The oscillators of one note; they refer to the phase offsets, which
+	//! therefore live in the same voice
+	struct Voice
 	{
-		MM_OPERATORS
-		Oscillator * oscLeft;
-		Oscillator * oscRight;
+		std::array<std::optional<Oscillator>, NUM_OSCILLATORS> left;
+		std::array<std::optional<Oscillator>, NUM_OSCILLATORS> right;
 		float phaseOffsetLeft[NUM_OSCILLATORS];
-		float phaseOffsetRight[NUM_OSCILLATORS];		
+		float phaseOffsetRight[NUM_OSCILLATORS];
 	} ;
 
+	VoicePool<Voice> m_voices;
+
 	const IntModel m_modulationAlgo;
 
 	FloatModel  m_fx1Model;
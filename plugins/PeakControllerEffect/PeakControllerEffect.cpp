@@ -24,6 +24,10 @@
  */
 
 
+#include <algorithm>
+#include <cmath>
+
+#include "AudioEngine.h"
 #include "Song.h"
 #include "PresetPreviewPlayHandle.h"
 #include "PeakController.h"
@@ -69,6 +73,9 @@ PeakControllerEffect::PeakControllerEffect(
 	m_effectId( rand() ),
 	m_peakControls( this ),
 	m_lastSample( 0 ),
+	m_meanSquare( 0 ),
+	m_envelope( Engine::audioEngine()->framesPerPeriod() ),
+	m_envelopePeriod( -1 ),
 	m_autoController( nullptr )
 {
 	m_autoController = new PeakController( Engine::getSong(), this );
@@ -76,7 +83,7 @@ PeakControllerEffect::PeakControllerEffect(
 	{
 		Engine::getSong()->addController( m_autoController );
 	}
-	PeakController::s_effects.push_back(this);
+	PeakController::addDetector( this );
 }
 
 
@@ -84,10 +91,8 @@ PeakControllerEffect::PeakControllerEffect(
 
 PeakControllerEffect::~PeakControllerEffect()
 {
-	auto it = std::find(PeakController::s_effects.begin(), PeakController::s_effects.end(), this);
-	if (it != PeakController::s_effects.end())
+	if( PeakController::removeDetector( this ) )
 	{
-		PeakController::s_effects.erase(it);
 		Engine::getSong()->removeController(m_autoController);
 	}
 }
@@ -105,27 +110,40 @@ bool PeakControllerEffect::processAudioBuffer( sampleFrame * _buf,
 		return false;
 	}
 
-	// RMS:
-	double sum = 0;
+	const float sampleRate = Engine::audioEngine()->processingSampleRate();
+	// The RMS is averaged over about as long as a period of the default
+	// size, which it used to be measured over, but follows the signal
+	// sample by sample whatever the period size
+	const float levelCoeff = 1.0f - std::exp( -44100.0f / ( DEFAULT_BUFFER_SIZE * sampleRate ) );
+	const float ratio = 44100.0f / sampleRate;
+	const float attackCoeff = 1.0f - std::pow( 2.0f, -0.3f * ( 1.0f - c.m_attackModel.value() ) * ratio );
+	const float decayCoeff = 1.0f - std::pow( 2.0f, -0.3f * ( 1.0f - c.m_decayModel.value() ) * ratio );
+
+	const bool absolute = c.m_absModel.value();
+	const float base = c.m_baseModel.value();
+	const float tres = c.m_tresholdModel.value();
+	const float amount = c.m_amountModel.value() * c.m_amountMultModel.value();
 
-	if( c.m_absModel.value() )
-	{
-		for( int i = 0; i < _frames; ++i )
-		{
-			// absolute value is achieved because the squares are > 0
-			sum += _buf[i][0]*_buf[i][0] + _buf[i][1]*_buf[i][1];
-		}
-	}
-	else
+	m_envelope.resize( _frames );
+	for( fpp_t f = 0; f < _frames; ++f )
 	{
-		for( int i = 0; i < _frames; ++i )
-		{
-			// the value is absolute because of squaring,
-			// so we need to correct it
-			sum += _buf[i][0] * _buf[i][0] * sign( _buf[i][0] )
-				+ _buf[i][1] * _buf[i][1] * sign( _buf[i][1] );
-		}
+		const float left = _buf[f][0];
+		const float right = _buf[f][1];
+		// the square is absolute, so correct its sign unless measuring
+		// the absolute value
+		const float power = absolute
+			? left * left + right * right
+			: left * left * sign( left ) + right * right * sign( right );
+		m_meanSquare += ( power - m_meanSquare ) * levelCoeff;
+
+		float curRMS = sqrt_neg( m_meanSquare );
+		curRMS = std::abs( curRMS ) < tres ? 0.0f : curRMS;
+		const float target = std::clamp( base + amount * curRMS, 0.0f, 1.0f );
+
+		m_lastSample += ( target - m_lastSample ) * ( m_lastSample < target ? attackCoeff : decayCoeff );
+		m_envelope[f] = m_lastSample;
 	}
+	m_envelopePeriod = Controller::runningPeriods();
 
 	// TODO: flipping this might cause clipping
 	// this will mute the output after the values were measured
@@ -137,12 +155,6 @@ bool PeakControllerEffect::processAudioBuffer( sampleFrame * _buf,
 		}
 	}
 
-	float curRMS = sqrt_neg( sum / _frames );
-	const float tres = c.m_tresholdModel.value();
-	const float amount = c.m_amountModel.value() * c.m_amountMultModel.value();
-	curRMS = qAbs( curRMS ) < tres ? 0.0f : curRMS;
-	m_lastSample = qBound( 0.0f, c.m_baseModel.value() + amount * curRMS, 1.0f );
-
 	return isRunning();
 }
 
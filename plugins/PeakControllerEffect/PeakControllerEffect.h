@@ -26,6 +26,8 @@
 #ifndef PEAK_CONTROLLER_EFFECT_H
 #define PEAK_CONTROLLER_EFFECT_H
 
+#include <vector>
+
 #include "Effect.h"
 #include "PeakControllerEffectControls.h"
 
@@ -54,6 +56,18 @@ public:
 		return m_lastSample;
 	}
 
+	//! The envelope measured in the last period the effect ran, one value per frame
+	const std::vector<float>& envelope() const
+	{
+		return m_envelope;
+	}
+
+	//! Controller::runningPeriods() of the period envelope() was measured in
+	long envelopePeriod() const
+	{
+		return m_envelopePeriod;
+	}
+
 	PeakController * controller()
 	{
 		return m_autoController;
@@ -75,6 +89,9 @@ private:
 	PeakControllerEffectControls m_peakControls;
 
 	float m_lastSample;
+	float m_meanSquare;
+	std::vector<float> m_envelope;
+	long m_envelopePeriod;
 
 	PeakController * m_autoController;
 
@@ -29,8 +29,6 @@
 #include <cmath>
 #include <cstdio>
 
-#include "sid.h"
-
 #include "SidInstrument.h"
 #include "AudioEngine.h"
 #include "Engine.h"
@@ -302,7 +300,7 @@ void SidInstrument::playNote( NotePlayHandle * _n,
 
 	if (!_n->m_pluginData)
 	{
-		auto sid = new reSID::SID();
+		auto sid = m_chips.acquire();
 		sid->set_sampling_parameters(clockrate, reSID::SAMPLE_FAST, samplerate);
 		sid->set_chip_model(reSID::MOS8580);
 		sid->enable_filter( true );
@@ -436,7 +434,7 @@ void SidInstrument::playNote( NotePlayHandle * _n,
 
 void SidInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<reSID::SID*>(_n->m_pluginData);
+	m_chips.release(static_cast<reSID::SID*>(_n->m_pluginData));
 }
 
 
@@ -27,9 +27,12 @@
 #ifndef _SID_H
 #define _SID_H
 
+#include "sid.h"
+
 #include "AutomatableModel.h"
 #include "Instrument.h"
 #include "InstrumentView.h"
+#include "VoicePool.h"
 
 namespace lmms
 {
@@ -130,6 +133,9 @@ private:
 	FloatModel m_filterResonanceModel;
 	IntModel m_filterModeModel;
 	
+	// one emulated chip per note
+	VoicePool<reSID::SID> m_chips;
+
 	// misc
 	BoolModel m_voice3OffModel;
 	FloatModel m_volumeModel;
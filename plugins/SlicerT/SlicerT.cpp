@@ -34,6 +34,7 @@
 #include "SampleLoader.h"
 #include "Song.h"
 #include "embed.h"
+#include "fft_helpers.h"
 #include "lmms_constants.h"
 #include "plugin_export.h"
 
@@ -53,6 +54,10 @@ Plugin::Descriptor PLUGIN_EXPORT slicert_plugin_descriptor = {
 };
 } // end extern
 
+namespace {
+constexpr int AnalysisWindowSize = 512;
+}
+
 // ################################# SlicerT ####################################
 
 SlicerT::SlicerT(InstrumentTrack* instrumentTrack)
@@ -73,6 +78,13 @@ SlicerT::SlicerT(InstrumentTrack* instrumentTrack)
 	m_sliceSnap.addItem("1/16");
 	m_sliceSnap.addItem("1/32");
 	m_sliceSnap.setValue(0);
+
+	connect(this, &SlicerT::analysisFinished, this, &SlicerT::applyAnalysis, Qt::QueuedConnection);
+}
+
+SlicerT::~SlicerT()
+{
+	cancelAnalysis();
 }
 
 void SlicerT::playNote(NotePlayHandle* handle, sampleFrame* workingBuffer)
@@ -156,25 +168,40 @@ void SlicerT::deleteNotePluginData(NotePlayHandle* handle)
 	delete static_cast<PlaybackState*>(handle->m_pluginData);
 }
 
+void SlicerT::startAnalysis()
+{
+	cancelAnalysis();
+
+	// create the shared plan here, the FFTW planner must not run on the worker
+	// while other FFT users plan on this thread
+	realToComplexPlan(AnalysisWindowSize);
+
+	m_cancelAnalysis = false;
+	m_analyzingBuffer = m_originalSample.buffer();
+	m_analysisThread = std::thread(&SlicerT::analyzeSample, this, m_analyzingBuffer);
+}
+
+void SlicerT::cancelAnalysis()
+{
+	m_cancelAnalysis = true;
+	if (m_analysisThread.joinable()) { m_analysisThread.join(); }
+	m_analysisDone = false;
+	m_analyzingBuffer = nullptr;
+}
+
 // uses the spectral flux to determine the change in magnitude
 // resources:
 // http://www.iro.umontreal.ca/~pift6080/H09/documents/papers/bello_onset_tutorial.pdf
-void SlicerT::findSlices()
+void SlicerT::analyzeSample(std::shared_ptr<const SampleBuffer> buffer)
 {
-	if (m_originalSample.sampleSize() <= 1) { return; }
-	m_slicePoints = {};
-
-	const int windowSize = 512;
-	const float minBeatLength = 0.05f; // in seconds, ~ 1/4 length at 220 bpm
-
-	int sampleRate = m_originalSample.sampleRate();
-	int minDist = sampleRate * minBeatLength;
+	const int windowSize = AnalysisWindowSize;
+	const sampleFrame* data = buffer->data();
 
 	float maxMag = -1;
-	std::vector<float> singleChannel(m_originalSample.sampleSize(), 0);
-	for (int i = 0; i < m_originalSample.sampleSize(); i++)
+	std::vector<float> singleChannel(buffer->size(), 0);
+	for (int i = 0; i < buffer->size(); i++)
 	{
-		singleChannel[i] = (m_originalSample.data()[i][0] + m_originalSample.data()[i][1]) / 2;
+		singleChannel[i] = (data[i][0] + data[i][1]) / 2;
 		maxMag = std::max(maxMag, singleChannel[i]);
 	}
 
@@ -192,27 +219,27 @@ void SlicerT::findSlices()
 	}
 
 	std::vector<float> prevMags(windowSize / 2, 0);
-	std::vector<float> fftIn(windowSize, 0);
-	std::array<fftwf_complex, windowSize> fftOut;
+	std::unique_ptr<float, void (*)(void*)> fftIn(fftwf_alloc_real(windowSize), fftwf_free);
+	std::unique_ptr<fftwf_complex, void (*)(void*)> fftOut(fftwf_alloc_complex(windowSize / 2 + 1), fftwf_free);
+	fftwf_plan fftPlan = realToComplexPlan(windowSize);
 
-	fftwf_plan fftPlan = fftwf_plan_dft_r2c_1d(windowSize, fftIn.data(), fftOut.data(), FFTW_MEASURE);
-
-	int lastPoint = -minDist - 1; // to always store 0 first
+	std::vector<float> spectralFluxes;
 	float spectralFlux = 0;
-	float prevFlux = 1E-10; // small value, no divison by zero
 	float real, imag, magnitude, diff;
 
-	for (int i = 0; i < singleChannel.size() - windowSize; i += windowSize)
+	for (int i = 0; i + windowSize < singleChannel.size(); i += windowSize)
 	{
+		if (m_cancelAnalysis) { return; }
+
 		// fft
-		std::copy_n(singleChannel.data() + i, windowSize, fftIn.data());
-		fftwf_execute(fftPlan);
+		std::copy_n(singleChannel.data() + i, windowSize, fftIn.get());
+		fftwf_execute_dft_r2c(fftPlan, fftIn.get(), fftOut.get());
 
 		// calculate spectral flux in regard to last window
 		for (int j = 0; j < windowSize / 2; j++) // only use niquistic frequencies
 		{
-			real = fftOut[j][0];
-			imag = fftOut[j][1];
+			real = fftOut.get()[j][0];
+			imag = fftOut.get()[j][1];
 			magnitude = std::sqrt(real * real + imag * imag);
 
 			// using L2-norm (euclidean distance)
@@ -222,6 +249,65 @@ void SlicerT::findSlices()
 			prevMags[j] = magnitude;
 		}
 
+		spectralFluxes.push_back(spectralFlux);
+		spectralFlux = 1E-10; // small value, no divison by zero
+	}
+
+	m_pendingBuffer = std::move(buffer);
+	m_pendingFlux = std::move(spectralFluxes);
+	m_pendingZeroCrossings = std::move(zeroCrossings);
+	m_analysisDone = true;
+
+	emit analysisFinished();
+}
+
+void SlicerT::applyAnalysis()
+{
+	// a newer analysis may have been started since this one finished
+	if (!m_analysisDone) { return; }
+	m_analysisThread.join();
+	m_analysisDone = false;
+	m_analyzingBuffer = nullptr;
+
+	if (m_pendingBuffer != m_originalSample.buffer()) { return; }
+
+	m_analyzedBuffer = std::move(m_pendingBuffer);
+	m_spectralFlux = std::move(m_pendingFlux);
+	m_zeroCrossings = std::move(m_pendingZeroCrossings);
+
+	findSlices();
+}
+
+// picks the slices from the spectral flux of the sample, analyzing it in the
+// background first if needed
+void SlicerT::findSlices()
+{
+	if (m_originalSample.sampleSize() <= 1) { return; }
+
+	if (m_analyzedBuffer != m_originalSample.buffer())
+	{
+		// Threshold and snap changes while the sample is being analyzed are
+		// picked up once the analysis is done, so don't restart it for them
+		if (m_analyzingBuffer != m_originalSample.buffer()) { startAnalysis(); }
+		return;
+	}
+
+	m_slicePoints = {};
+
+	const int windowSize = AnalysisWindowSize;
+	const float minBeatLength = 0.05f; // in seconds, ~ 1/4 length at 220 bpm
+
+	int sampleRate = m_originalSample.sampleRate();
+	int minDist = sampleRate * minBeatLength;
+
+	int lastPoint = -minDist - 1; // to always store 0 first
+	float prevFlux = 1E-10; // small value, no divison by zero
+
+	for (int window = 0; window < m_spectralFlux.size(); window++)
+	{
+		const int i = window * windowSize;
+		const float spectralFlux = m_spectralFlux[window];
+
 		if (spectralFlux / prevFlux > 1.0f + m_noteThreshold.value() && i - lastPoint > minDist)
 		{
 			m_slicePoints.push_back(i);
@@ -230,15 +316,15 @@ void SlicerT::findSlices()
 		}
 
 		prevFlux = spectralFlux;
-		spectralFlux = 1E-10; // again for no divison by zero
 	}
 
 	m_slicePoints.push_back(m_originalSample.sampleSize());
 
 	for (float& sliceValue : m_slicePoints)
 	{
-		int closestZeroCrossing = *std::lower_bound(zeroCrossings.begin(), zeroCrossings.end(), sliceValue);
-		if (std::abs(sliceValue - closestZeroCrossing) < windowSize) { sliceValue = closestZeroCrossing; }
+		auto closestZeroCrossing = std::lower_bound(m_zeroCrossings.begin(), m_zeroCrossings.end(), sliceValue);
+		if (closestZeroCrossing == m_zeroCrossings.end()) { continue; }
+		if (std::abs(sliceValue - *closestZeroCrossing) < windowSize) { sliceValue = *closestZeroCrossing; }
 	}
 
 	float beatsPerMin = m_originalBPM.value() / 60.0f;
@@ -26,8 +26,11 @@
 #define LMMS_SLICERT_H
 
 #include <algorithm>
+#include <atomic>
 #include <fftw3.h>
+#include <memory>
 #include <stdexcept>
+#include <thread>
 
 #include "AutomatableModel.h"
 #include "Instrument.h"
@@ -71,9 +74,11 @@ public slots:
 
 signals:
 	void isPlaying(float current, float start, float end);
+	void analysisFinished();
 
 public:
 	SlicerT(InstrumentTrack* instrumentTrack);
+	~SlicerT() override;
 
 	void playNote(NotePlayHandle* handle, sampleFrame* workingBuffer) override;
 	void deleteNotePluginData(NotePlayHandle* handle) override;
@@ -89,7 +94,15 @@ public:
 
 	std::vector<Note> getMidi();
 
+private slots:
+	void applyAnalysis();
+
 private:
+	// Onset analysis runs on a worker thread, so long samples don't block the UI
+	void startAnalysis();
+	void cancelAnalysis();
+	void analyzeSample(std::shared_ptr<const SampleBuffer> buffer);
+
 	FloatModel m_noteThreshold;
 	FloatModel m_fadeOutFrames;
 	IntModel m_originalBPM;
@@ -100,6 +113,23 @@ private:
 
 	std::vector<float> m_slicePoints;
 
+	// Spectral flux per analysis window and zero crossings of the sample in
+	// m_analyzedBuffer. Threshold and snap changes only re-run peak picking.
+	std::shared_ptr<const SampleBuffer> m_analyzedBuffer;
+	std::vector<float> m_spectralFlux;
+	std::vector<int> m_zeroCrossings;
+
+	// Results of the worker, only touched by the GUI thread after joining it
+	std::shared_ptr<const SampleBuffer> m_pendingBuffer;
+	std::vector<float> m_pendingFlux;
+	std::vector<int> m_pendingZeroCrossings;
+
+	// Sample the running analysis works on, GUI thread only
+	std::shared_ptr<const SampleBuffer> m_analyzingBuffer;
+	std::thread m_analysisThread;
+	std::atomic<bool> m_cancelAnalysis = false;
+	std::atomic<bool> m_analysisDone = false;
+
 	InstrumentTrack* m_parentTrack;
 
 	friend class gui::SlicerTView;
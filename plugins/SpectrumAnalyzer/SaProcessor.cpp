@@ -65,12 +65,13 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 
 	m_bufferL.resize(m_inBlockSize, 0);
 	m_bufferR.resize(m_inBlockSize, 0);
-	m_filteredBufferL.resize(m_fftBlockSize, 0);
-	m_filteredBufferR.resize(m_fftBlockSize, 0);
+	m_filteredBufferL = fftwf_alloc_real(m_fftBlockSize);
+	m_filteredBufferR = fftwf_alloc_real(m_fftBlockSize);
+	std::fill_n(m_filteredBufferL, m_fftBlockSize, 0);
+	std::fill_n(m_filteredBufferR, m_fftBlockSize, 0);
 	m_spectrumL = (fftwf_complex *) fftwf_malloc(binCount() * sizeof (fftwf_complex));
 	m_spectrumR = (fftwf_complex *) fftwf_malloc(binCount() * sizeof (fftwf_complex));
-	m_fftPlanL = fftwf_plan_dft_r2c_1d(m_fftBlockSize, m_filteredBufferL.data(), m_spectrumL, FFTW_MEASURE);
-	m_fftPlanR = fftwf_plan_dft_r2c_1d(m_fftBlockSize, m_filteredBufferR.data(), m_spectrumR, FFTW_MEASURE);
+	m_fftPlan = realToComplexPlan(m_fftBlockSize);
 
 	m_absSpectrumL.resize(binCount(), 0);
 	m_absSpectrumR.resize(binCount(), 0);
@@ -85,13 +86,14 @@ SaProcessor::SaProcessor(const SaControls *controls) :
 
 SaProcessor::~SaProcessor()
 {
-	if (m_fftPlanL != nullptr) {fftwf_destroy_plan(m_fftPlanL);}
-	if (m_fftPlanR != nullptr) {fftwf_destroy_plan(m_fftPlanR);}
+	if (m_filteredBufferL != nullptr) {fftwf_free(m_filteredBufferL);}
+	if (m_filteredBufferR != nullptr) {fftwf_free(m_filteredBufferR);}
 	if (m_spectrumL != nullptr) {fftwf_free(m_spectrumL);}
 	if (m_spectrumR != nullptr) {fftwf_free(m_spectrumR);}
 
-	m_fftPlanL = nullptr;
-	m_fftPlanR = nullptr;
+	m_fftPlan = nullptr;
+	m_filteredBufferL = nullptr;
+	m_filteredBufferR = nullptr;
 	m_spectrumL = nullptr;
 	m_spectrumR = nullptr;
 }
@@ -177,14 +179,14 @@ void SaProcessor::analyze(LocklessRingBuffer<sampleFrame> &ring_buffer)
 
 				// Run FFT on left channel, convert the result to absolute magnitude
 				// spectrum and normalize it.
-				fftwf_execute(m_fftPlanL);
+				fftwf_execute_dft_r2c(m_fftPlan, m_filteredBufferL, m_spectrumL);
 				absspec(m_spectrumL, m_absSpectrumL.data(), binCount());
 				normalize(m_absSpectrumL, m_normSpectrumL, m_inBlockSize);
 
 				// repeat analysis for right channel if stereo processing is enabled
 				if (stereo)
 				{
-					fftwf_execute(m_fftPlanR);
+					fftwf_execute_dft_r2c(m_fftPlan, m_filteredBufferR, m_spectrumR);
 					absspec(m_spectrumR, m_absSpectrumR.data(), binCount());
 					normalize(m_absSpectrumR, m_normSpectrumR, m_inBlockSize);
 				}
@@ -397,9 +399,9 @@ void SaProcessor::reallocateBuffers()
 	QMutexLocker reloc_lock(&m_reallocationAccess);
 	QMutexLocker data_lock(&m_dataAccess);
 
-	// destroy old FFT plan and free the result buffer
-	if (m_fftPlanL != nullptr) {fftwf_destroy_plan(m_fftPlanL);}
-	if (m_fftPlanR != nullptr) {fftwf_destroy_plan(m_fftPlanR);}
+	// free the old FFT buffers, the plans are shared and stay cached
+	if (m_filteredBufferL != nullptr) {fftwf_free(m_filteredBufferL);}
+	if (m_filteredBufferR != nullptr) {fftwf_free(m_filteredBufferR);}
 	if (m_spectrumL != nullptr) {fftwf_free(m_spectrumL);}
 	if (m_spectrumR != nullptr) {fftwf_free(m_spectrumR);}
 
@@ -408,14 +410,15 @@ void SaProcessor::reallocateBuffers()
 	precomputeWindow(m_fftWindow.data(), new_in_size, (FFTWindow) m_controls->m_windowModel.value());
 	m_bufferL.resize(new_in_size, 0);
 	m_bufferR.resize(new_in_size, 0);
-	m_filteredBufferL.resize(new_fft_size, 0);
-	m_filteredBufferR.resize(new_fft_size, 0);
+	m_filteredBufferL = fftwf_alloc_real(new_fft_size);
+	m_filteredBufferR = fftwf_alloc_real(new_fft_size);
+	std::fill_n(m_filteredBufferL, new_fft_size, 0);
+	std::fill_n(m_filteredBufferR, new_fft_size, 0);
 	m_spectrumL = (fftwf_complex *) fftwf_malloc(new_bins * sizeof (fftwf_complex));
 	m_spectrumR = (fftwf_complex *) fftwf_malloc(new_bins * sizeof (fftwf_complex));
-	m_fftPlanL = fftwf_plan_dft_r2c_1d(new_fft_size, m_filteredBufferL.data(), m_spectrumL, FFTW_MEASURE);
-	m_fftPlanR = fftwf_plan_dft_r2c_1d(new_fft_size, m_filteredBufferR.data(), m_spectrumR, FFTW_MEASURE);
+	m_fftPlan = realToComplexPlan(new_fft_size);
 
-	if (m_fftPlanL == nullptr || m_fftPlanR == nullptr)
+	if (m_fftPlan == nullptr)
 	{
 		#ifdef SA_DEBUG
 			std::cerr << "Analyzer: failed to create new FFT plan!" << std::endl;
@@ -467,8 +470,8 @@ void SaProcessor::clear()
 	m_framesFilledUp = m_inBlockSize - m_inBlockSize / overlaps;
 	std::fill(m_bufferL.begin(), m_bufferL.end(), 0);
 	std::fill(m_bufferR.begin(), m_bufferR.end(), 0);
-	std::fill(m_filteredBufferL.begin(), m_filteredBufferL.end(), 0);
-	std::fill(m_filteredBufferR.begin(), m_filteredBufferR.end(), 0);
+	std::fill_n(m_filteredBufferL, m_fftBlockSize, 0);
+	std::fill_n(m_filteredBufferR, m_fftBlockSize, 0);
 	std::fill(m_absSpectrumL.begin(), m_absSpectrumL.end(), 0);
 	std::fill(m_absSpectrumR.begin(), m_absSpectrumR.end(), 0);
 	std::fill(m_normSpectrumL.begin(), m_normSpectrumL.end(), 0);
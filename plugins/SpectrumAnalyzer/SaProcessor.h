@@ -129,10 +129,9 @@ private:
 	std::vector<float> m_bufferL;			//!< time domain samples (left)
 	std::vector<float> m_bufferR;			//!< time domain samples (right)
 	std::vector<float> m_fftWindow;			//!< precomputed window function coefficients
-	std::vector<float> m_filteredBufferL;	//!< time domain samples with window function applied (left)
-	std::vector<float> m_filteredBufferR;	//!< time domain samples with window function applied (right)
-	fftwf_plan m_fftPlanL;
-	fftwf_plan m_fftPlanR;
+	float *m_filteredBufferL;				//!< time domain samples with window function applied (left)
+	float *m_filteredBufferR;				//!< time domain samples with window function applied (right)
+	fftwf_plan m_fftPlan;					//!< shared plan, see realToComplexPlan()
 	fftwf_complex *m_spectrumL;				//!< frequency domain samples (complex) (left)
 	fftwf_complex *m_spectrumR;				//!< frequency domain samples (complex) (right)
 	std::vector<float> m_absSpectrumL;		//!< frequency domain samples (absolute) (left)
@@ -42,6 +42,11 @@ public:
 	bool processAudioBuffer( sampleFrame * _buf,
 		                                          const fpp_t _frames ) override;
 
+	f_cnt_t tailLength() const override
+	{
+		return 0;
+	}
+
 	EffectControls* controls() override
 	{
 		return( &m_smControls );
@@ -26,13 +26,17 @@
 #ifndef _TRIPLE_OSCILLATOR_H
 #define _TRIPLE_OSCILLATOR_H
 
+#include <array>
 #include <memory>
+#include <optional>
 
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "AutomatableModel.h"
+#include "Oscillator.h"
 #include "OscillatorConstants.h"
 #include "SampleBuffer.h"
+#include "VoicePool.h"
 
 namespace lmms
 {
@@ -137,13 +141,15 @@ protected slots:
 private:
 	OscillatorObject * m_osc[NUM_OF_OSCILLATORS];
 
-	struct oscPtr
+	//! The oscillators of one note, each one modulating or mixing with the next one of its channel
+	struct Voice
 	{
-		MM_OPERATORS
-		Oscillator * oscLeft;
-		Oscillator * oscRight;
+		std::array<std::optional<Oscillator>, NUM_OF_OSCILLATORS> left;
+		std::array<std::optional<Oscillator>, NUM_OF_OSCILLATORS> right;
 	} ;
 
+	VoicePool<Voice> m_voices;
+
 
 	friend class gui::TripleOscillatorView;
 
@@ -23,6 +23,7 @@
  */
 
 #include <QDomElement>
+#include <algorithm>
 
 #include "Watsyn.h"
 #include "base64.h"
@@ -63,20 +64,17 @@ Plugin::Descriptor PLUGIN_EXPORT watsyn_plugin_descriptor =
 
 
 
-WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
-					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
+WatsynObject::WatsynObject( WatsynWaves _waves, WatsynBandLimitedWaves _bandLimited,
+					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph,
 					WatsynInstrument * _w ) :
 				m_amod( _amod ),
 				m_bmod( _bmod ),
 				m_samplerate( _samplerate ),
 				m_nph( _nph ),
-				m_fpp( _frames ),
-				m_parent( _w )
+				m_parent( _w ),
+				m_waves( std::move( _waves ) ),
+				m_bandLimited( std::move( _bandLimited ) )
 {
-	m_abuf = new sampleFrame[_frames];
-	m_bbuf = new sampleFrame[_frames];
-
 	m_lphase[A1_OSC] = 0.0f;
 	m_lphase[A2_OSC] = 0.0f;
 	m_lphase[B1_OSC] = 0.0f;
@@ -86,30 +84,20 @@ WatsynObject::WatsynObject( float * _A1wave, float * _A2wave,
 	m_rphase[A2_OSC] = 0.0f;
 	m_rphase[B1_OSC] = 0.0f;
 	m_rphase[B2_OSC] = 0.0f;
-
-	// copy wavegraphs to the synth object to prevent race conditions
-
-	memcpy( &m_A1wave, _A1wave, sizeof( m_A1wave ) );
-	memcpy( &m_A2wave, _A2wave, sizeof( m_A2wave ) );
-	memcpy( &m_B1wave, _B1wave, sizeof( m_B1wave ) );
-	memcpy( &m_B2wave, _B2wave, sizeof( m_B2wave ) );
 }
 
 
 
-WatsynObject::~WatsynObject()
-{
-	delete[] m_abuf;
-	delete[] m_bbuf;
-}
-
-
 void WatsynObject::renderOutput( fpp_t _frames )
 {
-	if( m_abuf == nullptr )
-		m_abuf = new sampleFrame[m_fpp];
-	if( m_bbuf == nullptr )
-		m_bbuf = new sampleFrame[m_fpp];
+	// pick the band-limited tables for the current pitch of each oscillator
+	int lband [NUM_OSCS];
+	int rband [NUM_OSCS];
+	for( int i = 0; i < NUM_OSCS; ++i )
+	{
+		lband[i] = UserWaveform::band( m_nph->frequency() * m_parent->m_lfreq[i] );
+		rband[i] = UserWaveform::band( m_nph->frequency() * m_parent->m_rfreq[i] );
+	}
 
 	for( fpp_t frame = 0; frame < _frames; frame++ )
 	{
@@ -122,12 +110,8 @@ void WatsynObject::renderOutput( fpp_t _frames )
 		/////////////   A-series   /////////////////
 
 		// A2
-		sample_t A2_L = linearInterpolate( m_A2wave[ static_cast<int>( m_lphase[A2_OSC] ) ],
-							m_A2wave[ static_cast<int>( m_lphase[A2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_lphase[A2_OSC] ) ) * m_parent->m_lvol[A2_OSC];
-		sample_t A2_R = linearInterpolate( m_A2wave[ static_cast<int>( m_rphase[A2_OSC] ) ],
-							m_A2wave[ static_cast<int>( m_rphase[A2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_rphase[A2_OSC] ) ) * m_parent->m_rvol[A2_OSC];
+		sample_t A2_L = waveSample( A2_OSC, m_lphase[A2_OSC], lband[A2_OSC] ) * m_parent->m_lvol[A2_OSC];
+		sample_t A2_R = waveSample( A2_OSC, m_rphase[A2_OSC], rband[A2_OSC] ) * m_parent->m_rvol[A2_OSC];
 
 		// if phase mod, add to phases
 		if( m_amod == MOD_PM )
@@ -138,22 +122,14 @@ void WatsynObject::renderOutput( fpp_t _frames )
 			if( A1_rphase < 0 ) A1_rphase += WAVELEN;
 		}
 		// A1
-		sample_t A1_L = linearInterpolate( m_A1wave[ static_cast<int>( A1_lphase ) ],
-							m_A1wave[ static_cast<int>( A1_lphase + 1 ) % WAVELEN ],
-							fraction( A1_lphase ) ) * m_parent->m_lvol[A1_OSC];
-		sample_t A1_R = linearInterpolate( m_A1wave[ static_cast<int>( A1_rphase ) ],
-							m_A1wave[ static_cast<int>( A1_rphase + 1 ) % WAVELEN ],
-							fraction( A1_rphase ) ) * m_parent->m_rvol[A1_OSC];
+		sample_t A1_L = waveSample( A1_OSC, A1_lphase, lband[A1_OSC] ) * m_parent->m_lvol[A1_OSC];
+		sample_t A1_R = waveSample( A1_OSC, A1_rphase, rband[A1_OSC] ) * m_parent->m_rvol[A1_OSC];
 
 		/////////////   B-series   /////////////////
 
 		// B2
-		sample_t B2_L = linearInterpolate( m_B2wave[ static_cast<int>( m_lphase[B2_OSC] ) ],
-							m_B2wave[ static_cast<int>( m_lphase[B2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_lphase[B2_OSC] ) ) * m_parent->m_lvol[B2_OSC];
-		sample_t B2_R = linearInterpolate( m_B2wave[ static_cast<int>( m_rphase[B2_OSC] ) ],
-							m_B2wave[ static_cast<int>( m_rphase[B2_OSC] + 1 ) % WAVELEN ],
-							fraction( m_rphase[B2_OSC] ) ) * m_parent->m_rvol[B2_OSC];
+		sample_t B2_L = waveSample( B2_OSC, m_lphase[B2_OSC], lband[B2_OSC] ) * m_parent->m_lvol[B2_OSC];
+		sample_t B2_R = waveSample( B2_OSC, m_rphase[B2_OSC], rband[B2_OSC] ) * m_parent->m_rvol[B2_OSC];
 
 		// if crosstalk active, add a1
 		const float xt = m_parent->m_xtalk.value();
@@ -172,12 +148,8 @@ void WatsynObject::renderOutput( fpp_t _frames )
 			if( B1_rphase < 0 ) B1_rphase += WAVELEN;
 		}
 		// B1
-		sample_t B1_L = linearInterpolate( m_B1wave[ static_cast<int>( B1_lphase ) % WAVELEN ],
-							m_B1wave[ static_cast<int>( B1_lphase + 1 ) % WAVELEN ],
-							fraction( B1_lphase ) ) * m_parent->m_lvol[B1_OSC];
-		sample_t B1_R = linearInterpolate( m_B1wave[ static_cast<int>( B1_rphase ) % WAVELEN ],
-							m_B1wave[ static_cast<int>( B1_rphase + 1 ) % WAVELEN ],
-							fraction( B1_rphase ) ) * m_parent->m_rvol[B1_OSC];
+		sample_t B1_L = waveSample( B1_OSC, B1_lphase, lband[B1_OSC] ) * m_parent->m_lvol[B1_OSC];
+		sample_t B1_R = waveSample( B1_OSC, B1_rphase, rband[B1_OSC] ) * m_parent->m_rvol[B1_OSC];
 
 
 		// A-series modulation)
@@ -331,22 +303,27 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 {
 	if (!_n->m_pluginData)
 	{
-		auto w = new WatsynObject(&A1_wave[0], &A2_wave[0], &B1_wave[0], &B2_wave[0], m_amod.value(), m_bmod.value(),
-			Engine::audioEngine()->processingSampleRate(), _n, Engine::audioEngine()->framesPerPeriod(), this);
+		auto waves = WatsynWaves{};
+		auto bandLimited = WatsynBandLimitedWaves{};
+		for( int i = 0; i < NUM_OSCS; ++i )
+		{
+			waves[i] = std::atomic_load( &m_waves[i] );
+			bandLimited[i] = m_userWaveforms[i].waveform();
+		}
+
+		auto w = m_voices.acquire(std::move(waves), std::move(bandLimited), m_amod.value(), m_bmod.value(),
+			Engine::audioEngine()->processingSampleRate(), _n, this);
 
 		_n->m_pluginData = w;
 	}
 
-	const fpp_t frames = _n->framesLeftForCurrentPeriod();
+	const fpp_t framesLeft = _n->framesLeftForCurrentPeriod();
 	const f_cnt_t offset = _n->noteOffset();
-	sampleFrame * buffer = _working_buffer + offset;
 
 	auto w = static_cast<WatsynObject*>(_n->m_pluginData);
 
-	sampleFrame * abuf = w->abuf();
-	sampleFrame * bbuf = w->bbuf();
-
-	w-> renderOutput( frames );
+	const sampleFrame * abuf = w->abuf();
+	const sampleFrame * bbuf = w->bbuf();
 
 	// envelope parameters
 	const float envAmt = m_envAmt.value();
@@ -354,19 +331,63 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 	const float envHold = ( m_envHold.value() * w->samplerate() ) / 1000.0f;
 	const float envDec = ( m_envDec.value() * w->samplerate() ) / 1000.0f;
 	const float envLen = envAtt + envDec + envHold;
-	const auto tfp_ = static_cast<float>(_n->totalFramesPlayed());
 
-	// if sample-exact is enabled, use sample-exact calculations...
-	// disabled pending proper implementation of sample-exactness
-/*	if( engine::audioEngine()->currentQualitySettings().sampleExactControllers )
+	// the voice's buffers hold MaxFrames, so render longer periods in parts
+	for( fpp_t rendered = 0; rendered < framesLeft; rendered += WatsynObject::MaxFrames )
 	{
-		for( fpp_t f=0; f < frames; f++ )
+		const fpp_t frames = std::min<fpp_t>( framesLeft - rendered, WatsynObject::MaxFrames );
+		sampleFrame * buffer = _working_buffer + offset + rendered;
+		const auto tfp_ = static_cast<float>( _n->totalFramesPlayed() + rendered );
+
+		w-> renderOutput( frames );
+
+		// if sample-exact is enabled, use sample-exact calculations...
+		// disabled pending proper implementation of sample-exactness
+	/*	if( engine::audioEngine()->currentQualitySettings().sampleExactControllers )
 		{
-			const float tfp = tfp_ + f;
-			// handle mixing envelope
-			float mixvalue = m_abmix.value( f );
-			if( envAmt != 0.0f && tfp < envLen )
+			for( fpp_t f=0; f < frames; f++ )
 			{
+				const float tfp = tfp_ + f;
+				// handle mixing envelope
+				float mixvalue = m_abmix.value( f );
+				if( envAmt != 0.0f && tfp < envLen )
+				{
+					if( tfp < envAtt )
+					{
+						mixvalue = qBound( -100.0f, mixvalue + ( tfp / envAtt * envAmt ), 100.0f );
+					}
+					else if ( tfp >= envAtt && tfp < envAtt + envHold )
+					{
+						mixvalue = qBound( -100.0f, mixvalue + envAmt, 100.0f );
+					}
+					else
+					{
+						mixvalue = qBound( -100.0f, mixvalue + envAmt - ( ( tfp - ( envAtt + envHold ) ) / envDec * envAmt ), 100.0f );
+					}
+				}
+				// get knob values in sample-exact way
+				const float bmix = ( ( mixvalue + 100.0 ) / 200.0 );
+				const float amix = 1.0 - bmix;
+
+				// mix a/b streams according to mixing knob
+				_working_buffer[f][0] = ( abuf[f][0] * amix ) +
+										( bbuf[f][0] * bmix );
+				_working_buffer[f][1] = ( abuf[f][1] * amix ) +
+										( bbuf[f][1] * bmix );
+			}
+		}
+		else*/ 
+	
+		// if sample-exact is not enabled, use simpler calculations:
+		// if mix envelope is active, and we haven't gone past the envelope end, use envelope-aware calculation...
+		if( envAmt != 0.0f && tfp_ < envLen )
+		{
+			const float mixvalue_ = m_abmix.value();
+			for( fpp_t f=0; f < frames; f++ )
+			{
+				float mixvalue = mixvalue_;
+				const float tfp = tfp_ + f;
+				// handle mixing envelope
 				if( tfp < envAtt )
 				{
 					mixvalue = qBound( -100.0f, mixvalue + ( tfp / envAtt * envAmt ), 100.0f );
@@ -379,68 +400,33 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 				{
 					mixvalue = qBound( -100.0f, mixvalue + envAmt - ( ( tfp - ( envAtt + envHold ) ) / envDec * envAmt ), 100.0f );
 				}
-			}
-			// get knob values in sample-exact way
-			const float bmix = ( ( mixvalue + 100.0 ) / 200.0 );
-			const float amix = 1.0 - bmix;
 
-			// mix a/b streams according to mixing knob
-			_working_buffer[f][0] = ( abuf[f][0] * amix ) +
-									( bbuf[f][0] * bmix );
-			_working_buffer[f][1] = ( abuf[f][1] * amix ) +
-									( bbuf[f][1] * bmix );
-		}
-	}
-	else*/ 
-	
-	// if sample-exact is not enabled, use simpler calculations:
-	// if mix envelope is active, and we haven't gone past the envelope end, use envelope-aware calculation...
-	if( envAmt != 0.0f && tfp_ < envLen )
-	{
-		const float mixvalue_ = m_abmix.value();
-		for( fpp_t f=0; f < frames; f++ )
-		{
-			float mixvalue = mixvalue_;
-			const float tfp = tfp_ + f;
-			// handle mixing envelope
-			if( tfp < envAtt )
-			{
-				mixvalue = qBound( -100.0f, mixvalue + ( tfp / envAtt * envAmt ), 100.0f );
-			}
-			else if ( tfp >= envAtt && tfp < envAtt + envHold )
-			{
-				mixvalue = qBound( -100.0f, mixvalue + envAmt, 100.0f );
-			}
-			else
-			{
-				mixvalue = qBound( -100.0f, mixvalue + envAmt - ( ( tfp - ( envAtt + envHold ) ) / envDec * envAmt ), 100.0f );
-			}
-
-			// get knob values
-			const float bmix = ( ( mixvalue + 100.0 ) / 200.0 );
-			const float amix = 1.0 - bmix;
+				// get knob values
+				const float bmix = ( ( mixvalue + 100.0 ) / 200.0 );
+				const float amix = 1.0 - bmix;
 
-			// mix a/b streams according to mixing knob
-			buffer[f][0] = ( abuf[f][0] * amix ) +
-									( bbuf[f][0] * bmix );
-			buffer[f][1] = ( abuf[f][1] * amix ) +
-									( bbuf[f][1] * bmix );
+				// mix a/b streams according to mixing knob
+				buffer[f][0] = ( abuf[f][0] * amix ) +
+										( bbuf[f][0] * bmix );
+				buffer[f][1] = ( abuf[f][1] * amix ) +
+										( bbuf[f][1] * bmix );
+			}
 		}
-	}
 
-	// ... mix envelope is inactive or we've past the end of envelope, so use a faster calculation to save cpu
-	else
-	{
-		// get knob values
-		const float bmix = ( ( m_abmix.value() + 100.0 ) / 200.0 );
-		const float amix = 1.0 - bmix;
-		for( fpp_t f=0; f < frames; f++ )
+		// ... mix envelope is inactive or we've past the end of envelope, so use a faster calculation to save cpu
+		else
 		{
-			// mix a/b streams according to mixing knob
-			buffer[f][0] = ( abuf[f][0] * amix ) +
-									( bbuf[f][0] * bmix );
-			buffer[f][1] = ( abuf[f][1] * amix ) +
-									( bbuf[f][1] * bmix );
+			// get knob values
+			const float bmix = ( ( m_abmix.value() + 100.0 ) / 200.0 );
+			const float amix = 1.0 - bmix;
+			for( fpp_t f=0; f < frames; f++ )
+			{
+				// mix a/b streams according to mixing knob
+				buffer[f][0] = ( abuf[f][0] * amix ) +
+										( bbuf[f][0] * bmix );
+				buffer[f][1] = ( abuf[f][1] * amix ) +
+										( bbuf[f][1] * bmix );
+			}
 		}
 	}
 
@@ -450,7 +436,7 @@ void WatsynInstrument::playNote( NotePlayHandle * _n,
 
 void WatsynInstrument::deleteNotePluginData( NotePlayHandle * _n )
 {
-	delete static_cast<WatsynObject *>( _n->m_pluginData );
+	m_voices.release( static_cast<WatsynObject *>( _n->m_pluginData ) );
 }
 
 
@@ -562,6 +548,12 @@ void WatsynInstrument::loadSettings( const QDomElement & _this )
 	m_amod.loadSettings( _this, "amod" );
 	m_bmod.loadSettings( _this, "bmod" );
 /*	m_selectedGraph.loadSettings( _this, "selgraph" );*/
+
+	// notes may start right after loading, give them the band-limited tables of the loaded waves
+	for( int i = 0; i < NUM_OSCS; ++i )
+	{
+		m_userWaveforms[i].updateNow( std::atomic_load( &m_waves[i] )->data(), WAVELEN );
+	}
 }
 
 
@@ -625,31 +617,42 @@ void WatsynInstrument::updateFreqB2()
 }
 
 
-void WatsynInstrument::updateWaveA1()
+void WatsynInstrument::updateWave( int _osc, const graphModel & _graph )
 {
 	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A1_wave[0], const_cast<float*>( a1_graph.samples() ) );
+	auto wave = std::make_shared<WatsynWave>();
+	srccpy( wave->data(), const_cast<float*>( _graph.samples() ) );
+
+	const auto oversampled = std::shared_ptr<const WatsynWave>( std::move( wave ) );
+	std::atomic_store( &m_waves[_osc], oversampled );
+
+	// the oversampled wave is played until the band-limited tables are ready, which
+	// are made from it as well, so both sound the same apart from the aliasing
+	m_userWaveforms[_osc].update( oversampled->data(), WAVELEN );
+}
+
+
+void WatsynInstrument::updateWaveA1()
+{
+	updateWave( A1_OSC, a1_graph );
 }
 
 
 void WatsynInstrument::updateWaveA2()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &A2_wave[0], const_cast<float*>( a2_graph.samples() ) );
+	updateWave( A2_OSC, a2_graph );
 }
 
 
 void WatsynInstrument::updateWaveB1()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B1_wave[0], const_cast<float*>( b1_graph.samples() ) );
+	updateWave( B1_OSC, b1_graph );
 }
 
 
 void WatsynInstrument::updateWaveB2()
 {
-	// do sinc+oversampling on the wavetables to improve quality
-	srccpy( &B2_wave[0], const_cast<float*>( b2_graph.samples() ) );
+	updateWave( B2_OSC, b2_graph );
 }
 
 
@@ -26,6 +26,9 @@
 #ifndef WATSYN_H
 #define WATSYN_H
 
+#include <array>
+#include <memory>
+
 #include "Instrument.h"
 #include "InstrumentView.h"
 #include "Graph.h"
@@ -33,6 +36,8 @@
 #include "TempoSyncKnob.h"
 #include <samplerate.h>
 #include "MemoryManager.h"
+#include "UserWaveform.h"
+#include "VoicePool.h"
 
 namespace lmms
 {
@@ -77,6 +82,11 @@ const int	B1_OSC = 2;
 const int	B2_OSC = 3;
 const int	NUM_OSCS = 4;
 
+//! An oversampled graph, shared read-only by all voices which started while it was current
+using WatsynWave = std::array<float, WAVELEN>;
+using WatsynWaves = std::array<std::shared_ptr<const WatsynWave>, NUM_OSCS>;
+using WatsynBandLimitedWaves = std::array<std::shared_ptr<const UserWaveform::Waveform>, NUM_OSCS>;
+
 class WatsynInstrument;
 
 namespace gui
@@ -90,21 +100,23 @@ class WatsynObject
 {
 	MM_OPERATORS
 public:
-	WatsynObject( 	float * _A1wave, float * _A2wave,
-					float * _B1wave, float * _B2wave,
-					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph, fpp_t _frames,
+	//! The most frames renderOutput() renders at once, longer periods are rendered in several parts
+	static constexpr fpp_t MaxFrames = 256;
+
+	WatsynObject( 	WatsynWaves _waves, WatsynBandLimitedWaves _bandLimited,
+					int _amod, int _bmod, const sample_rate_t _samplerate, NotePlayHandle * _nph,
 					WatsynInstrument * _w );
-	virtual ~WatsynObject();
+	virtual ~WatsynObject() = default;
 
 	void renderOutput( fpp_t _frames );
 
-	inline sampleFrame * abuf() const
+	inline const sampleFrame * abuf() const
 	{
-		return m_abuf;
+		return m_abuf.data();
 	}
-	inline sampleFrame * bbuf() const
+	inline const sampleFrame * bbuf() const
 	{
-		return m_bbuf;
+		return m_bbuf.data();
 	}
 	inline sample_rate_t samplerate() const
 	{
@@ -112,26 +124,36 @@ public:
 	}
 
 private:
+	// the band-limited tables once they are generated, the oversampled graph before
+	inline sample_t waveSample( int _osc, float _phase, int _band ) const
+	{
+		if( m_bandLimited[_osc] )
+		{
+			return UserWaveform::sample( *m_bandLimited[_osc], _band, _phase / WAVELEN );
+		}
+		const WatsynWave & wave = *m_waves[_osc];
+		return linearInterpolate( wave[ static_cast<int>( _phase ) % WAVELEN ],
+						wave[ static_cast<int>( _phase + 1 ) % WAVELEN ],
+						fraction( _phase ) );
+	}
+
 	int m_amod;
 	int m_bmod;
 
 	const sample_rate_t m_samplerate;
 	NotePlayHandle * m_nph;
 
-	fpp_t m_fpp;
-
 	WatsynInstrument * m_parent;
 
-	sampleFrame * m_abuf;
-	sampleFrame * m_bbuf;
+	// part of the voice, so the pool keeps notes from allocating them
+	std::array<sampleFrame, MaxFrames> m_abuf;
+	std::array<sampleFrame, MaxFrames> m_bbuf;
 
 	float m_lphase [NUM_OSCS];
 	float m_rphase [NUM_OSCS];
 
-	float m_A1wave [WAVELEN];
-	float m_A2wave [WAVELEN];
-	float m_B1wave [WAVELEN];
-	float m_B2wave [WAVELEN];
+	WatsynWaves m_waves;
+	WatsynBandLimitedWaves m_bandLimited;
 };
 
 class WatsynInstrument : public Instrument
@@ -188,6 +210,8 @@ private:
 		return ( _pan >= 0 ? 1.0 : 1.0 + ( _pan / 100.0 ) ) * _vol / 100.0;
 	}
 
+	void updateWave( int _osc, const graphModel & _graph );
+
 	// memcpy utilizing libsamplerate (src) for sinc interpolation
 	inline void srccpy( float * _dst, float * _src )
 	{
@@ -290,10 +314,12 @@ private:
 
 	IntModel m_selectedGraph;
 	
-	float A1_wave [WAVELEN];
-	float A2_wave [WAVELEN];
-	float B1_wave [WAVELEN];
-	float B2_wave [WAVELEN];
+	// replaced as a whole whenever a graph changes, so voices never see a
+	// wave which is being rewritten
+	WatsynWaves m_waves;
+	UserWaveform m_userWaveforms [NUM_OSCS];
+
+	VoicePool<WatsynObject> m_voices;
 
 	friend class WatsynObject;
 	friend class gui::WatsynView;
@@ -94,58 +94,79 @@ bool WaveShaperEffect::processAudioBuffer( sampleFrame * _buf,
 	const float *inputPtr = inputBuffer ? &( inputBuffer->values()[ 0 ] ) : &input;
 	const float *outputPtr = outputBufer ? &( outputBufer->values()[ 0 ] ) : &output;
 
+	const int stages = m_wsControls.m_oversamplingModel.value();
+	if( stages != m_oversampler.stages() )
+	{
+		m_oversampler.setStages( stages );
+	}
+	const int factor = m_oversampler.factor();
+
+	// The dry signal is mixed in at the higher rate too, so that it goes
+	// through the same filters as the wet one
+	sampleFrame * oversampled = m_oversampler.upsample( _buf, _frames );
+
 	for( fpp_t f = 0; f < _frames; ++f )
 	{
-		auto s = std::array{_buf[f][0], _buf[f][1]};
+		for( int o = 0; o < factor; ++o )
+		{
+			sampleFrame & frame = oversampled[f * factor + o];
+			auto s = std::array{frame[0], frame[1]};
 
 // apply input gain
-		s[0] *= *inputPtr;
-		s[1] *= *inputPtr;
+			s[0] *= *inputPtr;
+			s[1] *= *inputPtr;
 
 // clip if clip enabled
-		if( clip )
-		{
-			s[0] = qBound( -1.0f, s[0], 1.0f );
-			s[1] = qBound( -1.0f, s[1], 1.0f );
-		}
+			if( clip )
+			{
+				s[0] = qBound( -1.0f, s[0], 1.0f );
+				s[1] = qBound( -1.0f, s[1], 1.0f );
+			}
 
 // start effect
 
-		for( i=0; i <= 1; ++i )
-		{
-			const int lookup = static_cast<int>( qAbs( s[i] ) * 200.0f );
-			const float frac = fraction( qAbs( s[i] ) * 200.0f );
-			const float posneg = s[i] < 0 ? -1.0f : 1.0f;
-
-			if( lookup < 1 )
-			{
-				s[i] = frac * samples[0] * posneg;
-			}
-			else if( lookup < 200 )
-			{
-				s[i] = linearInterpolate( samples[ lookup - 1 ],
-						samples[ lookup ], frac )
-						* posneg;
-			}
-			else
+			for( i=0; i <= 1; ++i )
 			{
-				s[i] *= samples[199];
+				const int lookup = static_cast<int>( qAbs( s[i] ) * 200.0f );
+				const float frac = fraction( qAbs( s[i] ) * 200.0f );
+				const float posneg = s[i] < 0 ? -1.0f : 1.0f;
+
+				if( lookup < 1 )
+				{
+					s[i] = frac * samples[0] * posneg;
+				}
+				else if( lookup < 200 )
+				{
+					s[i] = linearInterpolate( samples[ lookup - 1 ],
+							samples[ lookup ], frac )
+							* posneg;
+				}
+				else
+				{
+					s[i] *= samples[199];
+				}
 			}
-		}
 
 // apply output gain
-		s[0] *= *outputPtr;
-		s[1] *= *outputPtr;
+			s[0] *= *outputPtr;
+			s[1] *= *outputPtr;
 
 // mix wet/dry signals
-		_buf[f][0] = d * _buf[f][0] + w * s[0];
-		_buf[f][1] = d * _buf[f][1] + w * s[1];
-		out_sum += _buf[f][0] * _buf[f][0] + _buf[f][1] * _buf[f][1];
+			frame[0] = d * frame[0] + w * s[0];
+			frame[1] = d * frame[1] + w * s[1];
+		}
 
 		outputPtr += outputInc;
 		inputPtr += inputInc;
 	}
 
+	m_oversampler.downsample( _buf, _frames );
+
+	for( fpp_t f = 0; f < _frames; ++f )
+	{
+		out_sum += _buf[f][0] * _buf[f][0] + _buf[f][1] * _buf[f][1];
+	}
+
 	checkGate( out_sum / _frames );
 
 	return( isRunning() );
@@ -28,6 +28,7 @@
 #define _WAVESHAPER_H
 
 #include "Effect.h"
+#include "Oversampler.h"
 #include "WaveShaperControls.h"
 
 namespace lmms
@@ -52,6 +53,7 @@ public:
 private:
 
 	WaveShaperControls m_wsControls;
+	Oversampler m_oversampler;
 
 	friend class WaveShaperControls;
 
@@ -27,8 +27,10 @@
 
 #include "WaveShaperControlDialog.h"
 #include "WaveShaperControls.h"
+#include "ComboBox.h"
 #include "embed.h"
 #include "Graph.h"
+#include "gui_templates.h"
 #include "Knob.h"
 #include "PixmapButton.h"
 #include "LedCheckBox.h"
@@ -42,11 +44,15 @@ WaveShaperControlDialog::WaveShaperControlDialog(
 	EffectControlDialog( _controls )
 {
 	setAutoFillBackground( true );
+	const QPixmap artwork = PLUGIN_NAME::getIconPixmap( "artwork" );
 	QPalette pal;
-	pal.setBrush( backgroundRole(),
-				PLUGIN_NAME::getIconPixmap( "artwork" ) );
+	pal.setBrush( backgroundRole(), artwork );
 	setPalette( pal );
-	setFixedSize( 224, 274 );
+	// the oversampling selector goes below the artwork, with the same
+	// margin as between the artwork's control panel and its bottom edge
+	const int selectorMargin = 8;
+	setFixedSize( artwork.width(),
+			artwork.height() + ComboBox::DEFAULT_HEIGHT + selectorMargin );
 
 	auto waveGraph = new Graph(this, Graph::Style::LinearNonCyclic, 204, 205);
 	waveGraph -> move( 10, 6 );
@@ -108,6 +114,12 @@ WaveShaperControlDialog::WaveShaperControlDialog(
 	clipInputToggle -> setModel( &_controls -> m_clipModel );
 	clipInputToggle->setToolTip(tr("Clip input signal to 0 dB"));
 
+	auto oversamplingComboBox = new ComboBox(this);
+	oversamplingComboBox->setGeometry( 10, artwork.height(), artwork.width() - 20, ComboBox::DEFAULT_HEIGHT );
+	oversamplingComboBox->setFont( pointSize<8>( oversamplingComboBox->font() ) );
+	oversamplingComboBox->setModel( &_controls->m_oversamplingModel );
+	oversamplingComboBox->setToolTip(tr("Run the waveshaper at a higher rate to reduce aliasing"));
+
 	connect( resetButton, SIGNAL (clicked () ),
 			_controls, SLOT ( resetClicked() ) );
 	connect( smoothButton, SIGNAL (clicked () ),
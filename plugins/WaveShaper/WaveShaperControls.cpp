@@ -31,6 +31,7 @@
 #include "base64.h"
 #include "Graph.h"
 #include "Engine.h"
+#include "Oversampler.h"
 #include "Song.h"
 
 namespace lmms
@@ -45,8 +46,15 @@ WaveShaperControls::WaveShaperControls( WaveShaperEffect * _eff ) :
 	m_inputModel( 1.0f, 0.0f, 5.0f, 0.01f, this, tr( "Input gain" ) ),
 	m_outputModel( 1.0f, 0.0f, 5.0f, 0.01f, this, tr( "Output gain" ) ),
 	m_wavegraphModel( 0.0f, 1.0f, 200, this ),
-	m_clipModel( false, this )
+	m_clipModel( false, this ),
+	m_oversamplingModel( this, tr( "Oversampling" ) )
 {
+	m_oversamplingModel.addItem( tr( "No oversampling" ) );
+	for( int stages = 1; stages <= Oversampler::MaxStages; ++stages )
+	{
+		m_oversamplingModel.addItem( tr( "%1x oversampling" ).arg( 1 << stages ) );
+	}
+
 	connect( &m_wavegraphModel, SIGNAL( samplesChanged( int, int ) ),
 			this, SLOT( samplesChanged( int, int ) ) );
 
@@ -71,6 +79,7 @@ void WaveShaperControls::loadSettings( const QDomElement & _this )
 	m_outputModel.loadSettings( _this, "outputGain" );
 
 	m_clipModel.loadSettings( _this, "clipInput" );
+	m_oversamplingModel.loadSettings( _this, "oversampling" );
 
 //load waveshape
 	int size = 0;
@@ -93,6 +102,7 @@ void WaveShaperControls::saveSettings( QDomDocument & _doc,
 	m_outputModel.saveSettings( _doc, _this, "outputGain" );
 
 	m_clipModel.saveSettings( _doc, _this, "clipInput" );
+	m_oversamplingModel.saveSettings( _doc, _this, "oversampling" );
 
 //save waveshape
 	QString sampleString;
@@ -28,6 +28,7 @@
 
 #include "EffectControls.h"
 #include "WaveShaperControlDialog.h"
+#include "ComboBoxModel.h"
 #include "Graph.h"
 
 namespace lmms
@@ -55,7 +56,7 @@ public:
 
 	int controlCount() override
 	{
-		return( 4 );
+		return( 5 );
 	}
 
 	gui::EffectControlDialog* createView() override
@@ -79,6 +80,7 @@ private:
 	FloatModel m_outputModel;
 	graphModel m_wavegraphModel;
 	BoolModel  m_clipModel;
+	ComboBoxModel m_oversamplingModel;
 
 	friend class gui::WaveShaperControlDialog;
 	friend class WaveShaperEffect;
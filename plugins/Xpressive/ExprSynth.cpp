@@ -25,6 +25,11 @@
 
 #include "ExprSynth.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 #include <cmath>
@@ -367,6 +372,117 @@ namespace SimpleRandom {
 
 static freefunc0<float,SimpleRandom::float_random_with_engine,false> simple_rand;
 
+// Translates an expression into a flat list of operations that are evaluated
+// over whole blocks of frames instead of walking the exprtk tree per frame.
+// Constant subexpressions are folded at compile time, and subexpressions that
+// only depend on constants and per-block variables are evaluated once per
+// block. Everything else runs as tight loops over the block.
+//
+// Only a subset of the exprtk syntax is understood; compile() fails on
+// anything else (e.g. last(), implicit multiplication) and the caller falls
+// back to the exprtk evaluator.
+class ExprBlockProgram
+{
+public:
+	struct Variable
+	{
+		const float* ref;
+		const float* block;
+	};
+	struct Cyclic
+	{
+		const float* data;
+		std::size_t length;
+		bool interpolate;
+	};
+	struct Symbols
+	{
+		// keys are lower case, exprtk symbols are case insensitive
+		std::map<std::string, float> constants;
+		std::map<std::string, Variable> variables;
+		std::map<std::string, Cyclic> cyclics;
+		unsigned int rand_seed;
+		unsigned int integrate_rate;
+	};
+
+	bool compile(const std::string& expr, const Symbols& symbols);
+	void evaluate(float* out, int frames);
+
+private:
+	static constexpr int BlockSize = ExprFront::BlockSize;
+
+	enum class Kind
+	{
+		Constant,
+		Uniform,
+		Varying
+	};
+	enum class Op
+	{
+		Constant,
+		Variable,
+		Func1,
+		Func2,
+		Clamp,
+		Wave,
+		WaveInterpolate,
+		RandV,
+		RandSV,
+		Rand,
+		Integrate
+	};
+	using func1_t = float (*)(float);
+	using func2_t = float (*)(float, float);
+	using kernel1_t = void (*)(const float*, float*, int);
+	using kernel2_t = void (*)(const float*, const float*, float*, int);
+
+	struct Node
+	{
+		Op op;
+		Kind kind;
+		int args[3];
+		// Value of constant and uniform nodes
+		float value;
+		// Per-frame values of varying nodes, points into m_buffers or to a block variable
+		float* result;
+		// Uniform nodes used by varying ones are broadcast into result every block
+		bool broadcast;
+		const Variable* variable;
+		func1_t func1;
+		func2_t func2;
+		kernel1_t kernel1;
+		kernel2_t kernel2;
+		Cyclic cyclic;
+		double accumulator;
+	};
+
+	// Recursive descent parser, each returns a node index or -1 on failure
+	int parseComparison();
+	int parseAdditive();
+	int parseMultiplicative();
+	int parseUnary();
+	int parsePower();
+	int parsePrimary();
+	int parseCall(const std::string& name);
+	bool parseArguments(std::vector<int>& args);
+	void skipSpaces();
+	bool accept(char c);
+
+	int addNode(Node node);
+	int addFunc1(func1_t func, kernel1_t kernel, int arg);
+	int addFunc2(func2_t func, kernel2_t kernel, int arg0, int arg1);
+	float evaluateScalar(Node& node);
+	void evaluateVarying(Node& node, int frames);
+
+	std::vector<Node> m_nodes;
+	std::vector<float> m_buffers;
+	int m_root;
+
+	// Parser state
+	const Symbols* m_symbols;
+	const char* m_pos;
+};
+
 class ExprFrontData
 {
 public:
@@ -374,7 +490,10 @@ public:
 	m_rand_vec(SimpleRandom::generator()),
 	m_integ_func(nullptr),
 	m_last_func(last_func_samples)
-	{}
+	{
+		m_block_symbols.rand_seed = m_rand_vec.m_rseed;
+		m_block_symbols.integrate_rate = 0;
+	}
 	~ExprFrontData()
 	{
 		for (const auto& cyclic : m_cyclics)
@@ -399,6 +518,8 @@ public:
 	RandomVectorFunction m_rand_vec;
 	IntegrateFunction<float> *m_integ_func;
 	LastSampleFunction<float> m_last_func;
+	ExprBlockProgram::Symbols m_block_symbols;
+	std::unique_ptr<ExprBlockProgram> m_block_program;
 
 };
 
@@ -520,6 +641,638 @@ struct harmonic_semitone
 static freefunc1<float,harmonic_semitone,true> harmonic_semitone_func;
 
 
+namespace BlockOps
+{
+	inline float add(float a, float b) { return a + b; }
+	inline float sub(float a, float b) { return a - b; }
+	inline float mul(float a, float b) { return a * b; }
+	inline float div(float a, float b) { return a / b; }
+	inline float mod(float a, float b) { return std::fmod(a, b); }
+	inline float pow(float a, float b) { return std::pow(a, b); }
+	inline float less(float a, float b) { return a < b ? 1.0f : 0.0f; }
+	inline float lessEqual(float a, float b) { return a <= b ? 1.0f : 0.0f; }
+	inline float greater(float a, float b) { return a > b ? 1.0f : 0.0f; }
+	inline float greaterEqual(float a, float b) { return a >= b ? 1.0f : 0.0f; }
+	inline float min(float a, float b) { return std::min(a, b); }
+	inline float max(float a, float b) { return std::max(a, b); }
+	inline float atan2(float a, float b) { return std::atan2(a, b); }
+	inline float hypot(float a, float b) { return std::hypot(a, b); }
+
+	inline float neg(float x) { return -x; }
+	inline float abs(float x) { return std::fabs(x); }
+	inline float sin(float x) { return std::sin(x); }
+	inline float cos(float x) { return std::cos(x); }
+	inline float tan(float x) { return std::tan(x); }
+	inline float asin(float x) { return std::asin(x); }
+	inline float acos(float x) { return std::acos(x); }
+	inline float atan(float x) { return std::atan(x); }
+	inline float sinh(float x) { return std::sinh(x); }
+	inline float cosh(float x) { return std::cosh(x); }
+	inline float tanh(float x) { return std::tanh(x); }
+	inline float exp(float x) { return std::exp(x); }
+	inline float log(float x) { return std::log(x); }
+	inline float log10(float x) { return std::log10(x); }
+	inline float log2(float x) { return std::log2(x); }
+	inline float sqrt(float x) { return std::sqrt(x); }
+	inline float floor(float x) { return std::floor(x); }
+	inline float ceil(float x) { return std::ceil(x); }
+	inline float round(float x) { return std::round(x); }
+	inline float trunc(float x) { return std::trunc(x); }
+	inline float frac(float x) { return x - static_cast<long long>(x); }
+	inline float sgn(float x) { return x > 0 ? 1.0f : (x < 0 ? -1.0f : 0.0f); }
+
+	// The loops below get inlined and vectorized per function
+	template <float (*F)(float)>
+	void kernel1(const float* a, float* out, int frames)
+	{
+		for (int i = 0; i < frames; ++i) { out[i] = F(a[i]); }
+	}
+	template <float (*F)(float, float)>
+	void kernel2(const float* a, const float* b, float* out, int frames)
+	{
+		for (int i = 0; i < frames; ++i) { out[i] = F(a[i], b[i]); }
+	}
+
+	struct Function1
+	{
+		const char* name;
+		float (*func)(float);
+		void (*kernel)(const float*, float*, int);
+	};
+#define BLOCK_FUNC1(name, func) { name, func, kernel1<func> }
+	const Function1 functions1[] = {
+		BLOCK_FUNC1("abs", abs),
+		BLOCK_FUNC1("sin", sin),
+		BLOCK_FUNC1("cos", cos),
+		BLOCK_FUNC1("tan", tan),
+		BLOCK_FUNC1("asin", asin),
+		BLOCK_FUNC1("acos", acos),
+		BLOCK_FUNC1("atan", atan),
+		BLOCK_FUNC1("sinh", sinh),
+		BLOCK_FUNC1("cosh", cosh),
+		BLOCK_FUNC1("tanh", tanh),
+		BLOCK_FUNC1("exp", exp),
+		BLOCK_FUNC1("log", log),
+		BLOCK_FUNC1("log10", log10),
+		BLOCK_FUNC1("log2", log2),
+		BLOCK_FUNC1("sqrt", sqrt),
+		BLOCK_FUNC1("floor", floor),
+		BLOCK_FUNC1("ceil", ceil),
+		BLOCK_FUNC1("round", round),
+		BLOCK_FUNC1("trunc", trunc),
+		BLOCK_FUNC1("frac", frac),
+		BLOCK_FUNC1("sgn", sgn),
+		BLOCK_FUNC1("sinew", sin_wave::process),
+		BLOCK_FUNC1("squarew", square_wave::process),
+		BLOCK_FUNC1("trianglew", triangle_wave::process),
+		BLOCK_FUNC1("saww", saw_wave::process),
+		BLOCK_FUNC1("moogsaww", moogsaw_wave::process),
+		BLOCK_FUNC1("moogw", moog_wave::process),
+		BLOCK_FUNC1("expw", exp_wave::process),
+		BLOCK_FUNC1("expnw", exp2_wave::process),
+		BLOCK_FUNC1("cent", harmonic_cent::process),
+		BLOCK_FUNC1("semitone", harmonic_semitone::process),
+	};
+#undef BLOCK_FUNC1
+} // namespace BlockOps
+
+
+bool ExprBlockProgram::compile(const std::string& expr, const Symbols& symbols)
+{
+	m_nodes.clear();
+	m_symbols = &symbols;
+	m_pos = expr.c_str();
+
+	m_root = parseComparison();
+	skipSpaces();
+	if (m_root < 0 || *m_pos != '\0')
+	{
+		m_nodes.clear();
+		return false;
+	}
+
+	// Give every varying node its own block buffer and mark the uniform
+	// nodes varying ones read from
+	int buffers = 0;
+	for (const auto& node : m_nodes)
+	{
+		if (node.kind != Kind::Varying || node.op != Op::Variable) { ++buffers; }
+	}
+	m_buffers.assign(buffers * BlockSize, 0.0f);
+	int buffer = 0;
+	for (auto& node : m_nodes)
+	{
+		if (node.kind == Kind::Varying && node.op == Op::Variable)
+		{
+			node.result = const_cast<float*>(node.variable->block);
+			continue;
+		}
+		node.result = &m_buffers[buffer * BlockSize];
+		++buffer;
+		if (node.kind == Kind::Varying)
+		{
+			for (int arg : node.args)
+			{
+				if (arg >= 0 && m_nodes[arg].kind != Kind::Varying) { m_nodes[arg].broadcast = true; }
+			}
+		}
+	}
+	// Constants never change, fill their blocks once
+	for (auto& node : m_nodes)
+	{
+		if (node.kind == Kind::Constant && node.broadcast)
+		{
+			std::fill(node.result, node.result + BlockSize, node.value);
+			node.broadcast = false;
+		}
+	}
+	return true;
+}
+
+
+void ExprBlockProgram::evaluate(float* out, int frames)
+{
+	for (auto& node : m_nodes)
+	{
+		if (node.kind == Kind::Uniform)
+		{
+			node.value = evaluateScalar(node);
+			if (node.broadcast) { std::fill(node.result, node.result + frames, node.value); }
+		}
+		else if (node.kind == Kind::Varying)
+		{
+			evaluateVarying(node, frames);
+		}
+	}
+
+	const Node& root = m_nodes[m_root];
+	if (root.kind == Kind::Varying)
+	{
+		std::copy(root.result, root.result + frames, out);
+	}
+	else
+	{
+		std::fill(out, out + frames, root.value);
+	}
+}
+
+
+float ExprBlockProgram::evaluateScalar(Node& node)
+{
+	const float a = node.args[0] >= 0 ? m_nodes[node.args[0]].value : 0;
+	const float b = node.args[1] >= 0 ? m_nodes[node.args[1]].value : 0;
+	switch (node.op)
+	{
+		case Op::Constant:
+			return node.value;
+		case Op::Variable:
+			return *node.variable->ref;
+		case Op::Func1:
+			return node.func1(a);
+		case Op::Func2:
+			return node.func2(a, b);
+		case Op::Clamp:
+		{
+			const float x = m_nodes[node.args[1]].value;
+			const float upper = m_nodes[node.args[2]].value;
+			return x < a ? a : (x > upper ? upper : x);
+		}
+		case Op::Wave:
+			return node.cyclic.data[static_cast<int>(positiveFraction(a) * node.cyclic.length)];
+		case Op::WaveInterpolate:
+		{
+			const float x = positiveFraction(a) * node.cyclic.length;
+			const int ix = static_cast<int>(x);
+			return linearInterpolate(node.cyclic.data[ix], node.cyclic.data[(ix + 1) % node.cyclic.length], fraction(x));
+		}
+		case Op::RandV:
+			return RandomVectorSeedFunction::randv(a, m_symbols->rand_seed);
+		case Op::RandSV:
+			return randsv_func(a, b);
+		case Op::Rand:
+		case Op::Integrate:
+			break;
+	}
+	return 0;
+}
+
+
+void ExprBlockProgram::evaluateVarying(Node& node, int frames)
+{
+	const float* a = node.args[0] >= 0 ? m_nodes[node.args[0]].result : nullptr;
+	const float* b = node.args[1] >= 0 ? m_nodes[node.args[1]].result : nullptr;
+	float* out = node.result;
+	switch (node.op)
+	{
+		case Op::Constant:
+		case Op::Variable:
+			break;
+		case Op::Func1:
+			node.kernel1(a, out, frames);
+			break;
+		case Op::Func2:
+			node.kernel2(a, b, out, frames);
+			break;
+		case Op::Clamp:
+		{
+			const float* upper = m_nodes[node.args[2]].result;
+			for (int i = 0; i < frames; ++i)
+			{
+				out[i] = b[i] < a[i] ? a[i] : (b[i] > upper[i] ? upper[i] : b[i]);
+			}
+			break;
+		}
+		case Op::Wave:
+			for (int i = 0; i < frames; ++i)
+			{
+				out[i] = node.cyclic.data[static_cast<int>(positiveFraction(a[i]) * node.cyclic.length)];
+			}
+			break;
+		case Op::WaveInterpolate:
+			for (int i = 0; i < frames; ++i)
+			{
+				const float x = positiveFraction(a[i]) * node.cyclic.length;
+				const int ix = static_cast<int>(x);
+				out[i] = linearInterpolate(node.cyclic.data[ix],
+					node.cyclic.data[(ix + 1) % node.cyclic.length], fraction(x));
+			}
+			break;
+		case Op::RandV:
+			for (int i = 0; i < frames; ++i)
+			{
+				out[i] = RandomVectorSeedFunction::randv(a[i], m_symbols->rand_seed);
+			}
+			break;
+		case Op::RandSV:
+			for (int i = 0; i < frames; ++i) { out[i] = randsv_func(a[i], b[i]); }
+			break;
+		case Op::Rand:
+			for (int i = 0; i < frames; ++i) { out[i] = SimpleRandom::float_random_with_engine::process(); }
+			break;
+		case Op::Integrate:
+			for (int i = 0; i < frames; ++i)
+			{
+				out[i] = node.accumulator / m_symbols->integrate_rate;
+				node.accumulator += a[i];
+			}
+			break;
+	}
+}
+
+
+int ExprBlockProgram::addNode(Node node)
+{
+	bool varying = node.op == Op::Rand || node.op == Op::Integrate;
+	// The wave tables may be edited while the note plays
+	bool constant = !varying && node.op != Op::Variable
+		&& node.op != Op::Wave && node.op != Op::WaveInterpolate;
+	for (int arg : node.args)
+	{
+		if (arg < 0) { continue; }
+		varying = varying || m_nodes[arg].kind == Kind::Varying;
+		constant = constant && m_nodes[arg].kind == Kind::Constant;
+	}
+
+	if (node.op == Op::Variable)
+	{
+		node.kind = node.variable->block ? Kind::Varying : Kind::Uniform;
+	}
+	else if (varying)
+	{
+		node.kind = Kind::Varying;
+	}
+	else if (constant)
+	{
+		// Fold the node now and replace it by its value
+		node.value = evaluateScalar(node);
+		node.op = Op::Constant;
+		node.kind = Kind::Constant;
+		node.args[0] = node.args[1] = node.args[2] = -1;
+	}
+	else
+	{
+		node.kind = Kind::Uniform;
+	}
+
+	m_nodes.push_back(node);
+	return static_cast<int>(m_nodes.size()) - 1;
+}
+
+
+int ExprBlockProgram::addFunc1(func1_t func, kernel1_t kernel, int arg)
+{
+	if (arg < 0) { return -1; }
+	Node node{};
+	node.op = Op::Func1;
+	node.args[0] = arg;
+	node.args[1] = node.args[2] = -1;
+	node.func1 = func;
+	node.kernel1 = kernel;
+	return addNode(node);
+}
+
+
+int ExprBlockProgram::addFunc2(func2_t func, kernel2_t kernel, int arg0, int arg1)
+{
+	if (arg0 < 0 || arg1 < 0) { return -1; }
+	Node node{};
+	node.op = Op::Func2;
+	node.args[0] = arg0;
+	node.args[1] = arg1;
+	node.args[2] = -1;
+	node.func2 = func;
+	node.kernel2 = kernel;
+	return addNode(node);
+}
+
+
+void ExprBlockProgram::skipSpaces()
+{
+	while (std::isspace(static_cast<unsigned char>(*m_pos))) { ++m_pos; }
+}
+
+
+bool ExprBlockProgram::accept(char c)
+{
+	skipSpaces();
+	if (*m_pos != c) { return false; }
+	++m_pos;
+	return true;
+}
+
+
+int ExprBlockProgram::parseComparison()
+{
+	const int left = parseAdditive();
+	if (left < 0) { return -1; }
+	skipSpaces();
+
+	func2_t func = nullptr;
+	kernel2_t kernel = nullptr;
+	if (m_pos[0] == '<' && m_pos[1] == '=')
+	{
+		func = BlockOps::lessEqual;
+		kernel = BlockOps::kernel2<BlockOps::lessEqual>;
+		m_pos += 2;
+	}
+	else if (m_pos[0] == '>' && m_pos[1] == '=')
+	{
+		func = BlockOps::greaterEqual;
+		kernel = BlockOps::kernel2<BlockOps::greaterEqual>;
+		m_pos += 2;
+	}
+	else if (m_pos[0] == '<' && m_pos[1] != '>')
+	{
+		func = BlockOps::less;
+		kernel = BlockOps::kernel2<BlockOps::less>;
+		m_pos += 1;
+	}
+	else if (m_pos[0] == '>')
+	{
+		func = BlockOps::greater;
+		kernel = BlockOps::kernel2<BlockOps::greater>;
+		m_pos += 1;
+	}
+	else
+	{
+		// exprtk compares for equality with a tolerance, leave that to it
+		return left;
+	}
+
+	const int right = parseAdditive();
+	skipSpaces();
+	if (*m_pos == '<' || *m_pos == '>' || *m_pos == '=' || *m_pos == '!') { return -1; }
+	return addFunc2(func, kernel, left, right);
+}
+
+
+int ExprBlockProgram::parseAdditive()
+{
+	int left = parseMultiplicative();
+	while (left >= 0)
+	{
+		if (accept('+'))
+		{
+			left = addFunc2(BlockOps::add, BlockOps::kernel2<BlockOps::add>, left, parseMultiplicative());
+		}
+		else if (accept('-'))
+		{
+			left = addFunc2(BlockOps::sub, BlockOps::kernel2<BlockOps::sub>, left, parseMultiplicative());
+		}
+		else { break; }
+	}
+	return left;
+}
+
+
+int ExprBlockProgram::parseMultiplicative()
+{
+	int left = parseUnary();
+	while (left >= 0)
+	{
+		if (accept('*'))
+		{
+			left = addFunc2(BlockOps::mul, BlockOps::kernel2<BlockOps::mul>, left, parseUnary());
+		}
+		else if (accept('/'))
+		{
+			left = addFunc2(BlockOps::div, BlockOps::kernel2<BlockOps::div>, left, parseUnary());
+		}
+		else if (accept('%'))
+		{
+			left = addFunc2(BlockOps::mod, BlockOps::kernel2<BlockOps::mod>, left, parseUnary());
+		}
+		else { break; }
+	}
+	return left;
+}
+
+
+int ExprBlockProgram::parseUnary()
+{
+	// Like in exprtk, -x^2 is -(x^2)
+	if (accept('-')) { return addFunc1(BlockOps::neg, BlockOps::kernel1<BlockOps::neg>, parseUnary()); }
+	if (accept('+')) { return parseUnary(); }
+	return parsePower();
+}
+
+
+int ExprBlockProgram::parsePower()
+{
+	const int base = parsePrimary();
+	if (base < 0 || !accept('^')) { return base; }
+
+	int exponent = -1;
+	if (accept('-'))
+	{
+		exponent = addFunc1(BlockOps::neg, BlockOps::kernel1<BlockOps::neg>, parsePrimary());
+	}
+	else
+	{
+		exponent = parsePrimary();
+	}
+	// Don't guess the associativity of chained powers
+	if (accept('^')) { return -1; }
+	return addFunc2(BlockOps::pow, BlockOps::kernel2<BlockOps::pow>, base, exponent);
+}
+
+
+int ExprBlockProgram::parsePrimary()
+{
+	skipSpaces();
+	if (accept('('))
+	{
+		const int inner = parseComparison();
+		return accept(')') ? inner : -1;
+	}
+
+	if (std::isdigit(static_cast<unsigned char>(*m_pos)) || *m_pos == '.')
+	{
+		char* end = nullptr;
+		const float value = std::strtof(m_pos, &end);
+		if (end == m_pos || std::find_if(m_pos, static_cast<const char*>(end), [](char c) {
+				return !std::isdigit(static_cast<unsigned char>(c)) && c != '.' && c != 'e' && c != 'E' && c != '+' && c != '-';
+			}) != end)
+		{
+			return -1;
+		}
+		m_pos = end;
+		// Implicit multiplication like 2t is left to exprtk
+		if (std::isalpha(static_cast<unsigned char>(*m_pos)) || *m_pos == '_' || *m_pos == '(') { return -1; }
+		Node node{};
+		node.op = Op::Constant;
+		node.args[0] = node.args[1] = node.args[2] = -1;
+		node.value = value;
+		return addNode(node);
+	}
+
+	if (!std::isalpha(static_cast<unsigned char>(*m_pos)) && *m_pos != '_') { return -1; }
+
+	std::string name;
+	while (std::isalnum(static_cast<unsigned char>(*m_pos)) || *m_pos == '_')
+	{
+		name += static_cast<char>(std::tolower(static_cast<unsigned char>(*m_pos)));
+		++m_pos;
+	}
+
+	skipSpaces();
+	if (*m_pos == '(') { return parseCall(name); }
+
+	Node node{};
+	node.args[0] = node.args[1] = node.args[2] = -1;
+	const auto constant = m_symbols->constants.find(name);
+	if (constant != m_symbols->constants.end())
+	{
+		node.op = Op::Constant;
+		node.value = constant->second;
+		return addNode(node);
+	}
+	const auto variable = m_symbols->variables.find(name);
+	if (variable != m_symbols->variables.end())
+	{
+		node.op = Op::Variable;
+		node.variable = &variable->second;
+		return addNode(node);
+	}
+	return -1;
+}
+
+
+bool ExprBlockProgram::parseArguments(std::vector<int>& args)
+{
+	if (!accept('(')) { return false; }
+	if (accept(')')) { return true; }
+	do
+	{
+		const int arg = parseComparison();
+		if (arg < 0) { return false; }
+		args.push_back(arg);
+	}
+	while (accept(','));
+	return accept(')');
+}
+
+
+int ExprBlockProgram::parseCall(const std::string& name)
+{
+	std::vector<int> args;
+	if (!parseArguments(args)) { return -1; }
+
+	Node node{};
+	node.args[0] = node.args[1] = node.args[2] = -1;
+
+	if (args.size() == 1)
+	{
+		for (const auto& function : BlockOps::functions1)
+		{
+			if (name == function.name) { return addFunc1(function.func, function.kernel, args[0]); }
+		}
+
+		const auto cyclic = m_symbols->cyclics.find(name);
+		if (cyclic != m_symbols->cyclics.end())
+		{
+			node.op = cyclic->second.interpolate ? Op::WaveInterpolate : Op::Wave;
+			node.cyclic = cyclic->second;
+			node.args[0] = args[0];
+			return addNode(node);
+		}
+		if (name == "randv")
+		{
+			node.op = Op::RandV;
+			node.args[0] = args[0];
+			return addNode(node);
+		}
+		if (name == "integrate" && m_symbols->integrate_rate > 0)
+		{
+			node.op = Op::Integrate;
+			node.args[0] = args[0];
+			node.accumulator = 0;
+			return addNode(node);
+		}
+	}
+	else if (args.size() == 2)
+	{
+		if (name == "pow") { return addFunc2(BlockOps::pow, BlockOps::kernel2<BlockOps::pow>, args[0], args[1]); }
+		if (name == "atan2") { return addFunc2(BlockOps::atan2, BlockOps::kernel2<BlockOps::atan2>, args[0], args[1]); }
+		if (name == "hypot") { return addFunc2(BlockOps::hypot, BlockOps::kernel2<BlockOps::hypot>, args[0], args[1]); }
+		if (name == "randsv")
+		{
+			node.op = Op::RandSV;
+			node.args[0] = args[0];
+			node.args[1] = args[1];
+			return addNode(node);
+		}
+	}
+	else if (args.size() == 3 && name == "clamp")
+	{
+		node.op = Op::Clamp;
+		std::copy(args.begin(), args.end(), node.args);
+		return addNode(node);
+	}
+	else if (args.empty() && name == "rand")
+	{
+		node.op = Op::Rand;
+		return addNode(node);
+	}
+
+	if (!args.empty() && (name == "min" || name == "max"))
+	{
+		const bool isMin = name == "min";
+		int result = args[0];
+		for (std::size_t i = 1; i < args.size(); ++i)
+		{
+			result = isMin
+				? addFunc2(BlockOps::min, BlockOps::kernel2<BlockOps::min>, result, args[i])
+				: addFunc2(BlockOps::max, BlockOps::kernel2<BlockOps::max>, result, args[i]);
+		}
+		return result;
+	}
+
+	// Anything else, e.g. last(), is evaluated by exprtk
+	return -1;
+}
+
+
 ExprFront::ExprFront(const char * expr, int last_func_samples)
 {
 	m_valid = false;
@@ -529,10 +1282,11 @@ ExprFront::ExprFront(const char * expr, int last_func_samples)
 
 		m_data->m_expression_string = expr;
 		m_data->m_symbol_table.add_pi();
+		m_data->m_block_symbols.constants["pi"] = F_PI;
 
-		m_data->m_symbol_table.add_constant("e", F_E);
+		add_constant("e", F_E);
 
-		m_data->m_symbol_table.add_constant("seed", SimpleRandom::generator() & max_float_integer_mask);
+		add_constant("seed", SimpleRandom::generator() & max_float_integer_mask);
 
 		m_data->m_symbol_table.add_function("sinew", sin_wave_func);
 		m_data->m_symbol_table.add_function("squarew", square_wave_func);
@@ -579,6 +1333,16 @@ bool ExprFront::compile()
 		parser_t parser(sstore);
 
 		m_valid=parser.compile(m_data->m_expression_string, m_data->m_expression);
+
+		m_data->m_block_program.reset();
+		if (m_valid)
+		{
+			auto program = std::make_unique<ExprBlockProgram>();
+			if (program->compile(m_data->m_expression_string, m_data->m_block_symbols))
+			{
+				m_data->m_block_program = std::move(program);
+			}
+		}
 	}
 	catch(...)
 	{
@@ -602,10 +1366,26 @@ float ExprFront::evaluate()
 	return 0;
 
 }
-bool ExprFront::add_variable(const char* name, float& ref)
+bool ExprFront::isBlockCompiled() const
+{
+	return m_valid && m_data->m_block_program;
+}
+void ExprFront::evaluateBlock(float* out, int frames)
+{
+	m_data->m_block_program->evaluate(out, frames);
+}
+static std::string lowerCase(const char* name)
+{
+	std::string lower = name;
+	std::transform(lower.begin(), lower.end(), lower.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	return lower;
+}
+bool ExprFront::add_variable(const char* name, float& ref, const float* block)
 {
 	try
 	{
+		m_data->m_block_symbols.variables[lowerCase(name)] = {&ref, block};
 		return m_data->m_symbol_table.add_variable(name, ref);
 	}
 	catch(...)
@@ -619,6 +1399,7 @@ bool ExprFront::add_constant(const char* name, float ref)
 {
 	try
 	{
+		m_data->m_block_symbols.constants[lowerCase(name)] = ref;
 		return m_data->m_symbol_table.add_constant(name, ref);
 	}
 	catch(...)
@@ -632,6 +1413,7 @@ bool ExprFront::add_cyclic_vector(const char* name, const float* data, size_t le
 {
 	try
 	{
+		m_data->m_block_symbols.cyclics[lowerCase(name)] = {data, length, interp};
 		if (interp)
 		{
 			auto wvf = new WaveValueFunctionInterpolate<float>(data, length);
@@ -678,6 +1460,7 @@ void ExprFront::setIntegrate(const unsigned int* const frameCounter, const unsig
 		if ( ointeg > 0 )
 		{
 			m_data->m_integ_func = new IntegrateFunction<float>(frameCounter,sample_rate,ointeg);
+			m_data->m_block_symbols.integrate_rate = sample_rate;
 			try
 			{
 				m_data->m_symbol_table.add_function("integrate",*m_data->m_integ_func);
@@ -717,16 +1500,22 @@ ExprSynth::ExprSynth(const WaveSample *gW1, const WaveSample *gW2, const WaveSam
 		e->add_cyclic_vector("W1", m_W1->m_samples,m_W1->m_length, m_W1->m_interpolate);
 		e->add_cyclic_vector("W2", m_W2->m_samples,m_W2->m_length, m_W2->m_interpolate);
 		e->add_cyclic_vector("W3", m_W3->m_samples,m_W3->m_length, m_W3->m_interpolate);
-		e->add_variable("t", m_note_sample_sec);
-		e->add_variable("f", m_frequency);
-		e->add_variable("rel",m_released);
-		e->add_variable("trel",m_note_rel_sec);
+		e->add_variable("t", m_note_sample_sec, m_block_t);
+		e->add_variable("f", m_frequency, m_block_f);
+		e->add_variable("rel",m_released, m_block_rel);
+		e->add_variable("trel",m_note_rel_sec, m_block_trel);
 		e->setIntegrate(&m_note_sample,m_sample_rate);
 		e->compile();
 	};
 	init_expression_step2(m_exprO1);
 	init_expression_step2(m_exprO2);
 
+	// Only use block evaluation if neither output needs the exprtk evaluator,
+	// which expects its variables to be updated every frame
+	m_block_mode = (m_exprO1->isValid() || m_exprO2->isValid())
+		&& (!m_exprO1->isValid() || m_exprO1->isBlockCompiled())
+		&& (!m_exprO2->isValid() || m_exprO2->isBlockCompiled());
+
 }
 
 ExprSynth::~ExprSynth()
@@ -766,7 +1555,11 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 		{
 			m_note_rel_sample = m_note_sample;
 		}
-		if (o1_valid && o2_valid)
+		if (m_block_mode)
+		{
+			renderBlocks(frames, buf, is_released);
+		}
+		else if (o1_valid && o2_valid)
 		{
 			for (fpp_t frame = 0; frame < frames ; ++frame)
 			{
@@ -825,5 +1618,64 @@ void ExprSynth::renderOutput(fpp_t frames, sampleFrame *buf)
 	}
 }
 
+void ExprSynth::renderBlocks(fpp_t frames, sampleFrame *buf, bool is_released)
+{
+	const bool o1_valid = m_exprO1->isValid();
+	const bool o2_valid = m_exprO2->isValid();
+	const float pn1 = m_pan1->value() * 0.5;
+	const float pn2 = m_pan2->value() * 0.5;
+	const float freq_inc = (m_nph->frequency() - m_frequency) / frames;
+
+	for (fpp_t offset = 0; offset < frames; offset += ExprFront::BlockSize)
+	{
+		const int block_frames = std::min<int>(frames - offset, ExprFront::BlockSize);
+
+		// Advance the per-frame variables the same way the frame-wise loop does
+		for (int frame = 0; frame < block_frames; ++frame)
+		{
+			if (is_released && m_released < 1)
+			{
+				m_released = fmin(m_released+m_rel_inc, 1);
+			}
+			m_block_t[frame] = m_note_sample_sec;
+			m_block_f[frame] = m_frequency;
+			m_block_rel[frame] = m_released;
+			m_block_trel[frame] = m_note_rel_sec;
+			m_note_sample++;
+			m_note_sample_sec = m_note_sample / (float)m_sample_rate;
+			if (is_released)
+			{
+				m_note_rel_sec = (m_note_sample - m_note_rel_sample) / (float)m_sample_rate;
+			}
+			m_frequency += freq_inc;
+		}
+
+		sampleFrame* out = buf + offset;
+		if (o1_valid)
+		{
+			m_exprO1->evaluateBlock(m_block_o1, block_frames);
+		}
+		else
+		{
+			std::fill(m_block_o1, m_block_o1 + block_frames, 0.0f);
+		}
+		if (o2_valid)
+		{
+			m_exprO2->evaluateBlock(m_block_o2, block_frames);
+		}
+		else
+		{
+			std::fill(m_block_o2, m_block_o2 + block_frames, 0.0f);
+		}
+		for (int frame = 0; frame < block_frames; ++frame)
+		{
+			const float o1 = m_block_o1[frame];
+			const float o2 = m_block_o2[frame];
+			out[frame][0] = (-pn1 + 0.5) * o1 + (-pn2 + 0.5) * o2;
+			out[frame][1] = ( pn1 + 0.5) * o1 + ( pn2 + 0.5) * o2;
+		}
+	}
+}
+
 
 } // namespace lmms
\ No newline at end of file
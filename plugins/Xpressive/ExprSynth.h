@@ -52,12 +52,19 @@ class ExprFront
 {
 public:
 	using ff1data_functor = float (*)(void*, float);
+	//! Maximum number of frames evaluated at once by evaluateBlock()
+	static constexpr int BlockSize = 64;
 	ExprFront(const char* expr, int last_func_samples);
 	~ExprFront();
 	bool compile();
 	inline bool isValid() { return m_valid; }
+	//! Whether compile() could also translate the expression for evaluateBlock()
+	bool isBlockCompiled() const;
 	float evaluate();
-	bool add_variable(const char* name, float & ref);
+	//! Evaluate up to BlockSize frames at once, reading per-frame variables from their block arrays
+	void evaluateBlock(float* out, int frames);
+	//! block, if given, holds the per-frame values of the variable for evaluateBlock()
+	bool add_variable(const char* name, float & ref, const float* block = nullptr);
 	bool add_constant(const char* name, float  ref);
 	bool add_cyclic_vector(const char* name, const float* data, size_t length, bool interp = false);
 	void setIntegrate(const unsigned int* frameCounter, unsigned int sample_rate);
@@ -112,6 +119,8 @@ public:
 
 
 private:
+	void renderBlocks(fpp_t frames, sampleFrame* buf, bool is_released);
+
 	ExprFront *m_exprO1, *m_exprO2;
 	const WaveSample *m_W1, *m_W2, *m_W3;
 	unsigned int m_note_sample;
@@ -126,6 +135,15 @@ private:
 	float m_rel_transition;
 	float m_rel_inc;
 
+	// Both outputs can be evaluated a block at a time
+	bool m_block_mode;
+	float m_block_t[ExprFront::BlockSize];
+	float m_block_f[ExprFront::BlockSize];
+	float m_block_rel[ExprFront::BlockSize];
+	float m_block_trel[ExprFront::BlockSize];
+	float m_block_o1[ExprFront::BlockSize];
+	float m_block_o2[ExprFront::BlockSize];
+
 } ;
 
 
@@ -24,6 +24,8 @@
 
 #include "AudioEngine.h"
 
+#include <algorithm>
+
 #include "denormals.h"
 
 #include "lmmsconfig.h"
@@ -31,9 +33,11 @@
 #include "AudioEngineWorkerThread.h"
 #include "AudioPort.h"
 #include "Mixer.h"
+#include "MidiPort.h"
 #include "Song.h"
 #include "EnvelopeAndLfoParameters.h"
 #include "NotePlayHandle.h"
+#include "PeakController.h"
 #include "ConfigManager.h"
 #include "SamplePlayHandle.h"
 #include "MemoryHelper.h"
@@ -67,12 +71,13 @@ namespace lmms
 using LocklessListElement = LocklessList<PlayHandle*>::Element;
 
 static thread_local bool s_renderingThread;
-static thread_local bool s_runningChange;
+// Nesting depth of the changes the thread is running, only the outermost one locks
+static thread_local int s_runningChanges;
 
 
 
 
-AudioEngine::AudioEngine( bool renderOnly ) :
+AudioEngine::AudioEngine( bool renderOnly, fpp_t renderFramesPerPeriod ) :
 	m_renderOnly( renderOnly ),
 	m_framesPerPeriod( DEFAULT_BUFFER_SIZE ),
 	m_inputBufferRead( 0 ),
@@ -129,6 +134,14 @@ AudioEngine::AudioEngine( bool renderOnly ) :
 			m_framesPerPeriod = DEFAULT_BUFFER_SIZE;
 		}
 	}
+	else
+	{
+		// nothing has been created yet, so plugins and buffers all get
+		// set up for the period asked for; only lmms-bench asks for more
+		// than the default, exports keep it
+		m_framesPerPeriod = std::clamp( renderFramesPerPeriod,
+					MINIMUM_BUFFER_SIZE, MAXIMUM_RENDER_BUFFER_SIZE );
+	}
 
 	// allocte the FIFO from the determined size
 	m_fifo = new Fifo( fifoSize );
@@ -213,7 +226,7 @@ void AudioEngine::initDevices()
 
 void AudioEngine::startProcessing(bool needsFifo)
 {
-	if (needsFifo)
+	if (needsFifo && m_audioDev->needsFifo())
 	{
 		m_fifoWriter = new fifoWriter( this, m_fifo );
 		m_fifoWriter->start( QThread::HighPriority );
@@ -364,6 +377,9 @@ void AudioEngine::renderStageNoteSetup()
 
 	handleMetronome();
 
+	// play the notes and controls of live MIDI input, where they arrived within the last period
+	MidiPort::processQueuedInEvents(m_framesPerPeriod, processingSampleRate());
+
 	// create play-handles for new notes, samples etc.
 	Engine::getSong()->processNextBuffer();
 
@@ -379,6 +395,17 @@ void AudioEngine::renderStageNoteSetup()
 
 
 
+void AudioEngine::renderStageControllers()
+{
+	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Controllers);
+
+	// After song automation has been applied, before play handles and effects read the controllers from
+	// worker threads
+	Controller::evaluateControllers();
+}
+
+
+
 void AudioEngine::renderStageInstruments()
 {
 	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Instruments);
@@ -393,9 +420,37 @@ void AudioEngine::renderStageEffects()
 {
 	AudioEngineProfiler::Probe profilerProbe(m_profiler, AudioEngineProfiler::DetailType::Effects);
 
-	// STAGE 2: process effects of all instrument- and sampletracks
-	AudioEngineWorkerThread::fillJobQueue(m_audioPorts);
-	AudioEngineWorkerThread::startAndWaitForJobs();
+	// STAGE 3: process effects of all instrument- and sampletracks
+	// Tracks running the detector of a peak controller go first, so the
+	// volume, panning and effects of the other tracks and the mixer
+	// channels get the envelopes measured in this period. Instruments
+	// already played and get them next period, as do detector tracks
+	// driven by other detectors.
+	m_detectorPorts.clear();
+	m_dependentPorts.clear();
+	if (!PeakController::s_effects.empty())
+	{
+		for (AudioPort* port : m_audioPorts)
+		{
+			(PeakController::hasDetectorIn(port->effects()) ? m_detectorPorts : m_dependentPorts).push_back(port);
+		}
+	}
+
+	if (m_detectorPorts.empty())
+	{
+		AudioEngineWorkerThread::fillJobQueue(m_audioPorts);
+		AudioEngineWorkerThread::startAndWaitForJobs();
+		PeakController::publishEnvelopes();
+	}
+	else
+	{
+		AudioEngineWorkerThread::fillJobQueue(m_detectorPorts);
+		AudioEngineWorkerThread::startAndWaitForJobs();
+		PeakController::publishEnvelopes();
+
+		AudioEngineWorkerThread::fillJobQueue(m_dependentPorts);
+		AudioEngineWorkerThread::startAndWaitForJobs();
+	}
 
 	// removed all play handles which are done
 	for( PlayHandleList::Iterator it = m_playHandles.begin();
@@ -439,6 +494,8 @@ void AudioEngine::renderStageMix()
 	EnvelopeAndLfoParameters::instances()->trigger();
 	Controller::triggerFrameCounter();
 	AutomatableModel::incrementPeriodCounter();
+	// model values are computed anew in the next period, so their buffers can be reused
+	ValueBufferPool::reset();
 }
 
 
@@ -451,9 +508,10 @@ const surroundSampleFrame *AudioEngine::renderNextBuffer()
 	s_renderingThread = true;
 
 	renderStageNoteSetup();     // STAGE 0: clear old play handles and buffers, setup new play handles
-	renderStageInstruments();   // STAGE 1: run and render all play handles
-	renderStageEffects();       // STAGE 2: process effects of all instrument- and sampletracks
-	renderStageMix();           // STAGE 3: do master mix in mixer
+	renderStageControllers();   // STAGE 1: evaluate all controllers in use for this period
+	renderStageInstruments();   // STAGE 2: run and render all play handles
+	renderStageEffects();       // STAGE 3: process effects of all instrument- and sampletracks
+	renderStageMix();           // STAGE 4: do master mix in mixer
 
 	s_renderingThread = false;
 	m_profiler.finishPeriod(processingSampleRate(), m_framesPerPeriod);
@@ -799,16 +857,14 @@ void AudioEngine::removePlayHandlesOfTypes(Track * track, PlayHandle::Types type
 
 void AudioEngine::requestChangeInModel()
 {
-	if (s_renderingThread || s_runningChange) { return; }
-	m_changeMutex.lock();
-	s_runningChange = true;
+	if (s_renderingThread) { return; }
+	if (s_runningChanges++ == 0) { m_changeMutex.lock(); }
 }
 
 void AudioEngine::doneChangeInModel()
 {
-	if (s_renderingThread || !s_runningChange) { return; }
-	m_changeMutex.unlock();
-	s_runningChange = false;
+	if (s_renderingThread || s_runningChanges == 0) { return; }
+	if (--s_runningChanges == 0) { m_changeMutex.unlock(); }
 }
 
 bool AudioEngine::isAudioDevNameValid(QString name)
@@ -24,12 +24,21 @@
 
 #include "AutomatableModel.h"
 
+#include <algorithm>
+
+#ifdef __MINGW32__
+#include <mingw.thread.h>
+#else
+#include <thread>
+#endif
+
 #include "lmms_math.h"
 
 #include "AudioEngine.h"
 #include "AutomationClip.h"
 #include "ControllerConnection.h"
 #include "LocaleHelper.h"
+#include "Mixer.h"
 #include "ProjectJournal.h"
 #include "Song.h"
 
@@ -54,9 +63,14 @@ AutomatableModel::AutomatableModel(
 	m_setValueDepth( 0 ),
 	m_hasStrictStepSize( false ),
 	m_controllerConnection( nullptr ),
-	m_valueBuffer( static_cast<int>( Engine::audioEngine()->framesPerPeriod() ) ),
 	m_lastUpdatedPeriod( -1 ),
-	m_hasSampleExactData(false),
+	m_rampStart( 0.0f ),
+	m_rampEnd( 0.0f ),
+	m_periodBuffer( nullptr ),
+	m_automationPeriod( -1 ),
+	m_automationBuffer( nullptr ),
+	m_automationFrame( 0 ),
+	m_automationValue( 0.0f ),
 	m_useControllerValue(true)
 
 {
@@ -80,8 +94,6 @@ AutomatableModel::~AutomatableModel()
 		delete m_controllerConnection;
 	}
 
-	m_valueBuffer.clear();
-
 	emit destroyed( id() );
 }
 
@@ -373,7 +385,7 @@ void AutomatableModel::roundAt( T& value, const T& where ) const
 
 
 
-void AutomatableModel::setAutomatedValue( const float value )
+void AutomatableModel::setAutomatedValue( const float value, const f_cnt_t frameOffset )
 {
 	setUseControllerValue(false);
 
@@ -387,13 +399,18 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 	if( oldValue != m_value )
 	{
+		if( frameOffset > 0 )
+		{
+			addAutomationPoint( oldValue, m_value, frameOffset );
+		}
+
 		// notify linked models
 		for (const auto& linkedModel : m_linkedModels)
 		{
 			if (!(linkedModel->controllerConnection()) && linkedModel->m_setValueDepth < 1 &&
 					linkedModel->fittedValue(m_value) != linkedModel->m_value)
 			{
-				linkedModel->setAutomatedValue(value);
+				linkedModel->setAutomatedValue(value, frameOffset);
 			}
 		}
 		m_valueChanged = true;
@@ -405,6 +422,34 @@ void AutomatableModel::setAutomatedValue( const float value )
 
 
 
+void AutomatableModel::addAutomationPoint( float oldValue, float value, f_cnt_t frameOffset )
+{
+	const auto fpp = static_cast<f_cnt_t>( Engine::audioEngine()->framesPerPeriod() );
+	frameOffset = std::min( frameOffset, fpp );
+
+	if( m_automationPeriod != s_periodCounter )
+	{
+		// first change in this period, which started with the value the model had until now
+		m_automationPeriod = s_periodCounter;
+		m_automationBuffer = ValueBufferPool::acquire();
+		m_automationFrame = 0;
+		m_automationValue = oldValue;
+	}
+
+	float * values = m_automationBuffer->values();
+	const f_cnt_t length = frameOffset - m_automationFrame;
+	for( f_cnt_t f = 0; f < length; ++f )
+	{
+		values[m_automationFrame + f] = m_automationValue + ( value - m_automationValue ) * f / length;
+	}
+
+	m_automationFrame = frameOffset;
+	m_automationValue = value;
+}
+
+
+
+
 void AutomatableModel::setRange( const float min, const float max,
 							const float step )
 {
@@ -510,12 +555,6 @@ void AutomatableModel::linkModels( AutomatableModel* model1, AutomatableModel* m
 	{
 		// copy data
 		model1->m_value = model2->m_value;
-		if (model1->valueBuffer() && model2->valueBuffer())
-		{
-			std::copy_n(model2->valueBuffer()->data(),
-				model1->valueBuffer()->length(),
-				model1->valueBuffer()->data());
-		}
 		// send dataChanged() before linking (because linking will
 		// connect the two dataChanged() signals)
 		emit model1->dataChanged();
@@ -551,6 +590,8 @@ void AutomatableModel::unlinkAllModels()
 void AutomatableModel::setControllerConnection( ControllerConnection* c )
 {
 	m_controllerConnection = c;
+	// mixer channels driven by peak controllers wait for their detectors
+	if( Engine::mixer() ) { Engine::mixer()->invalidateSidechains(); }
 	if( c )
 	{
 		QObject::connect( m_controllerConnection, SIGNAL(valueChanged()),
@@ -602,87 +643,142 @@ float AutomatableModel::controllerValue( int frameOffset ) const
 
 ValueBuffer * AutomatableModel::valueBuffer()
 {
-	QMutexLocker m( &m_valueBufferMutex );
-	// if we've already calculated the valuebuffer this period, return the cached buffer
-	if( m_lastUpdatedPeriod == s_periodCounter )
+	updatePeriodValues();
+
+	ValueBuffer* vb = m_periodBuffer.load(std::memory_order_acquire);
+	if( vb || m_rampStart == m_rampEnd )
+	{
+		// if we have no sample-exact source for a ValueBuffer, return NULL to signify that no data is available at the moment
+		// in which case the recipient knows to use the static value() instead
+		return vb;
+	}
+
+	// write the ramp to a buffer; if another thread does the same, the first one wins
+	// and the other buffer remains unused until the next period
+	vb = ValueBufferPool::acquire();
+	vb->interpolate( m_rampStart, m_rampEnd );
+	ValueBuffer* expected = nullptr;
+	if( !m_periodBuffer.compare_exchange_strong(expected, vb, std::memory_order_acq_rel) )
 	{
-		return m_hasSampleExactData
-			? &m_valueBuffer
-			: nullptr;
+		return expected;
 	}
+	return vb;
+}
+
+
+
 
-	float val = m_value; // make sure our m_value doesn't change midway
+ValueSpan AutomatableModel::valueSpan()
+{
+	updatePeriodValues();
 
-	ValueBuffer * vb;
-	if (m_controllerConnection && m_useControllerValue && m_controllerConnection->getController()->isSampleExact())
+	const auto fpp = static_cast<int>(Engine::audioEngine()->framesPerPeriod());
+	if (const ValueBuffer* vb = m_periodBuffer.load(std::memory_order_acquire))
+	{
+		return ValueSpan(vb->values(), fpp);
+	}
+	if (m_rampStart == m_rampEnd)
 	{
-		vb = m_controllerConnection->valueBuffer();
-		if( vb )
+		// like consumers of valueBuffer() do, take the value a controller which is not sample-exact provides
+		return ValueSpan(value<float>(), fpp);
+	}
+	return ValueSpan(m_rampStart, m_rampEnd, fpp);
+}
+
+
+
+
+void AutomatableModel::updatePeriodValues()
+{
+	const long period = s_periodCounter;
+	long last = m_lastUpdatedPeriod.load(std::memory_order_acquire);
+	while (last != period)
+	{
+		if (last == UpdatingPeriod)
+		{
+			// another thread is computing the values, which doesn't take long
+			std::this_thread::yield();
+			last = m_lastUpdatedPeriod.load(std::memory_order_acquire);
+			continue;
+		}
+		if (!m_lastUpdatedPeriod.compare_exchange_weak(last, UpdatingPeriod, std::memory_order_acquire))
+		{
+			continue;
+		}
+
+		float val = m_value; // make sure our m_value doesn't change midway
+		ValueBuffer* buffer = nullptr;
+
+		ValueBuffer * vb;
+		if (m_controllerConnection && m_useControllerValue && m_controllerConnection->getController()->isSampleExact())
 		{
-			float * values = vb->values();
-			float * nvalues = m_valueBuffer.values();
-			switch( m_scaleType )
+			vb = m_controllerConnection->valueBuffer();
+			if( vb )
 			{
-			case ScaleType::Linear:
-				for( int i = 0; i < m_valueBuffer.length(); i++ )
-				{
-					nvalues[i] = minValue<float>() + ( range() * values[i] );
-				}
-				break;
-			case ScaleType::Logarithmic:
-				for( int i = 0; i < m_valueBuffer.length(); i++ )
+				buffer = ValueBufferPool::acquire();
+				float * values = vb->values();
+				float * nvalues = buffer->values();
+				switch( m_scaleType )
 				{
-					nvalues[i] = logToLinearScale( values[i] );
+				case ScaleType::Linear:
+					for( int i = 0; i < buffer->length(); i++ )
+					{
+						nvalues[i] = minValue<float>() + ( range() * values[i] );
+					}
+					break;
+				case ScaleType::Logarithmic:
+					for( int i = 0; i < buffer->length(); i++ )
+					{
+						nvalues[i] = logToLinearScale( values[i] );
+					}
+					break;
+				default:
+					qFatal("AutomatableModel::valueBuffer() "
+						"lacks implementation for a scale type");
+					break;
 				}
-				break;
-			default:
-				qFatal("AutomatableModel::valueBuffer() "
-					"lacks implementation for a scale type");
-				break;
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
 		}
-	}
 
-	if (!m_controllerConnection)
-	{
-		AutomatableModel* lm = nullptr;
-		if (hasLinkedModels())
+		if (!buffer && !m_controllerConnection)
 		{
-			lm = m_linkedModels.front();
-		}
-		if (lm && lm->controllerConnection() && lm->useControllerValue() &&
-				lm->controllerConnection()->getController()->isSampleExact())
-		{
-			vb = lm->valueBuffer();
-			float * values = vb->values();
-			float * nvalues = m_valueBuffer.values();
-			for (int i = 0; i < vb->length(); i++)
+			AutomatableModel* lm = nullptr;
+			if (hasLinkedModels())
+			{
+				lm = m_linkedModels.front();
+			}
+			if (lm && lm->controllerConnection() && lm->useControllerValue() &&
+					lm->controllerConnection()->getController()->isSampleExact())
 			{
-				nvalues[i] = fittedValue(values[i]);
+				vb = lm->valueBuffer();
+				if (vb)
+				{
+					buffer = ValueBufferPool::acquire();
+					float * values = vb->values();
+					float * nvalues = buffer->values();
+					for (int i = 0; i < vb->length(); i++)
+					{
+						nvalues[i] = fittedValue(values[i]);
+					}
+				}
 			}
-			m_lastUpdatedPeriod = s_periodCounter;
-			m_hasSampleExactData = true;
-			return &m_valueBuffer;
 		}
-	}
 
-	if( m_oldValue != val )
-	{
-		m_valueBuffer.interpolate( m_oldValue, val );
+		if (!buffer && m_automationPeriod == period)
+		{
+			// automation changed the model within this period, keep its last value until the period ends
+			buffer = m_automationBuffer;
+			std::fill(buffer->values() + m_automationFrame, buffer->values() + buffer->length(), m_automationValue);
+		}
+
+		// without sample-exact data, ramp from the value of the last period to the current one
+		m_rampStart = m_oldValue;
+		m_rampEnd = val;
 		m_oldValue = val;
-		m_lastUpdatedPeriod = s_periodCounter;
-		m_hasSampleExactData = true;
-		return &m_valueBuffer;
+		m_periodBuffer.store(buffer, std::memory_order_relaxed);
+		m_lastUpdatedPeriod.store(period, std::memory_order_release);
+		return;
 	}
-
-	// if we have no sample-exact source for a ValueBuffer, return NULL to signify that no data is available at the moment
-	// in which case the recipient knows to use the static value() instead
-	m_lastUpdatedPeriod = s_periodCounter;
-	m_hasSampleExactData = false;
-	return nullptr;
 }
 
 
@@ -694,6 +790,7 @@ void AutomatableModel::unlinkControllerConnection()
 	}
 
 	m_controllerConnection = nullptr;
+	if( Engine::mixer() ) { Engine::mixer()->invalidateSidechains(); }
 }
 
 
@@ -59,6 +59,12 @@ AutomationClip::AutomationClip( AutomationTrack * _auto_track ) :
 	m_lastRecordedValue( 0 )
 {
 	changeLength( TimePos( 1, 0 ) );
+
+	// Tempo automation decides when each tick plays, which the song keeps a map of
+	connect(this, &Model::dataChanged, this, [this] { invalidateTempoMap(startPosition().getTicks()); });
+	connect(this, &Clip::lengthChanged, this, [this] { invalidateTempoMap(startPosition().getTicks()); });
+	connect(this, &Clip::positionChanged, this, [this] { invalidateTempoMap(0); });
+
 	if( getTrack() )
 	{
 		switch( getTrack()->trackContainer()->type() )
@@ -101,6 +107,10 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 		// Sets the node's clip to this one
 		m_timeMap[POS(it)].setClip(this);
 	}
+	connect(this, &Model::dataChanged, this, [this] { invalidateTempoMap(startPosition().getTicks()); });
+	connect(this, &Clip::lengthChanged, this, [this] { invalidateTempoMap(startPosition().getTicks()); });
+	connect(this, &Clip::positionChanged, this, [this] { invalidateTempoMap(0); });
+
 	if (!getTrack()){ return; }
 	switch( getTrack()->trackContainer()->type() )
 	{
@@ -116,6 +126,14 @@ AutomationClip::AutomationClip( const AutomationClip & _clip_to_copy ) :
 	}
 }
 
+AutomationClip::~AutomationClip()
+{
+	invalidateTempoMap(startPosition().getTicks());
+}
+
+
+
+
 bool AutomationClip::addObject( AutomatableModel * _obj, bool _search_dup )
 {
 	QMutexLocker m(&m_clipMutex);
@@ -203,6 +221,16 @@ const AutomationClip::objectVector& AutomationClip::objects() const
 
 
 
+bool AutomationClip::automates(const AutomatableModel* model) const
+{
+	QMutexLocker m(&m_clipMutex);
+
+	return std::find(m_objects.begin(), m_objects.end(), model) != m_objects.end();
+}
+
+
+
+
 TimePos AutomationClip::timeMapLength() const
 {
 	QMutexLocker m(&m_clipMutex);
@@ -1174,6 +1202,19 @@ void AutomationClip::cleanObjects()
 
 
 
+void AutomationClip::invalidateTempoMap(tick_t tick) const
+{
+	// The song is gone already while it deletes its remaining tracks
+	const auto song = Engine::getSong();
+	if (song && automates(&song->tempoModel()))
+	{
+		song->invalidateTempoMap(tick);
+	}
+}
+
+
+
+
 void AutomationClip::generateTangents()
 {
 	generateTangents(m_timeMap.begin(), m_timeMap.size());
@@ -32,6 +32,7 @@
 #include "ControllerConnection.h"
 #include "ControllerDialog.h"
 #include "LfoController.h"
+#include "MicroTimer.h"
 #include "MidiController.h"
 #include "PeakController.h"
 
@@ -41,6 +42,7 @@ namespace lmms
 
 long Controller::s_periods = 0;
 std::vector<Controller*> Controller::s_controllers;
+std::vector<Controller*> Controller::s_evaluatedControllers;
 
 
 
@@ -53,6 +55,13 @@ Controller::Controller( ControllerType _type, Model * _parent,
 	m_connectionCount( 0 ),
 	m_type( _type )
 {
+	// The rendering thread walks both lists every period
+	auto guard = Engine::audioEngine()->requestChangesGuard();
+
+	if( _type != ControllerType::Dummy )
+	{
+		s_evaluatedControllers.push_back(this);
+	}
 	if( _type != ControllerType::Dummy && _type != ControllerType::Midi )
 	{
 		s_controllers.push_back(this);
@@ -86,11 +95,21 @@ Controller::Controller( ControllerType _type, Model * _parent,
 
 Controller::~Controller()
 {
+	// The audio engine is gone when the song deletes its last controllers at exit
+	auto guard = Engine::audioEngine()
+		? Engine::audioEngine()->requestChangesGuard()
+		: AudioEngine::RequestChangesGuard{};
+
 	auto it = std::find(s_controllers.begin(), s_controllers.end(), this);
 	if (it != s_controllers.end())
 	{
 		s_controllers.erase(it);
 	}
+	it = std::find(s_evaluatedControllers.begin(), s_evaluatedControllers.end(), this);
+	if (it != s_evaluatedControllers.end())
+	{
+		s_evaluatedControllers.erase(it);
+	}
 
 	m_valueBuffer.clear();
 	// Remove connections by destroyed signal
@@ -171,6 +190,58 @@ void Controller::triggerFrameCounter()
 
 
 
+void Controller::evaluateControllers()
+{
+	for (Controller* controller : s_evaluatedControllers)
+	{
+		// Nothing reads controllers without connections
+		if (controller->connectionCount() > 0)
+		{
+			controller->evaluate();
+		}
+	}
+
+	const auto engine = Engine::audioEngine();
+	const float timeLimit = 1000000.0f * engine->framesPerPeriod() / engine->processingSampleRate();
+	for (Controller* controller : s_evaluatedControllers)
+	{
+		const auto newLoad = 100.0f * controller->m_evaluationTime / timeLimit;
+		const auto oldLoad = controller->m_evaluationLoad.load(std::memory_order_relaxed);
+		controller->m_evaluationLoad.store(newLoad * 0.05f + oldLoad * 0.95f, std::memory_order_relaxed);
+		controller->m_evaluationTime = 0;
+	}
+}
+
+
+
+void Controller::evaluate()
+{
+	// Already done as the input of another controller. The flag guards
+	// against connection cycles, which hasModel() keeps the GUI from making.
+	if (m_bufferLastUpdated == s_periods || m_evaluating) { return; }
+	m_evaluating = true;
+
+	// Controllers driving our own models go first, so their time isn't
+	// counted as ours
+	for (QObject* child : children())
+	{
+		const auto model = qobject_cast<AutomatableModel*>(child);
+		const auto connection = model != nullptr ? model->controllerConnection() : nullptr;
+		if (connection != nullptr)
+		{
+			connection->getController()->evaluate();
+		}
+	}
+
+	const auto timer = MicroTimer{};
+	updateValueBuffer();
+	m_evaluationTime = timer.elapsed();
+
+	m_evaluating = false;
+}
+
+
+
 void Controller::resetFrameCounter()
 {
 	for (Controller * controller : s_controllers)
@@ -28,6 +28,8 @@
 #include <QObject>
 
 
+#include "Engine.h"
+#include "Mixer.h"
 #include "Song.h"
 #include "ControllerConnection.h"
 
@@ -129,6 +131,9 @@ void ControllerConnection::setController( Controller * _controller )
 	m_ownsController =
 		(_controller->type() == Controller::ControllerType::Midi);
 
+	// mixer channels driven by peak controllers wait for their detectors
+	if( Engine::mixer() ) { Engine::mixer()->invalidateSidechains(); }
+
 	// If we don't own the controller, allow deletion of controller
 	// to delete the connection
 	if( !m_ownsController ) {
@@ -30,6 +30,7 @@
 #include "EffectChain.h"
 #include "Effect.h"
 #include "DummyEffect.h"
+#include "Mixer.h"
 #include "MixHelpers.h"
 
 namespace lmms
@@ -123,6 +124,8 @@ void EffectChain::appendEffect( Effect * _effect )
 {
 	Engine::audioEngine()->requestChangeInModel();
 	m_effects.push_back(_effect);
+	// the effect may be a detector or have models driven by one
+	if( Engine::mixer() ) { Engine::mixer()->invalidateSidechains(); }
 	Engine::audioEngine()->doneChangeInModel();
 
 	m_enabledModel.setValue( true );
@@ -144,6 +147,7 @@ void EffectChain::removeEffect( Effect * _effect )
 		return;
 	}
 	m_effects.erase( found );
+	if( Engine::mixer() ) { Engine::mixer()->invalidateSidechains(); }
 
 	Engine::audioEngine()->doneChangeInModel();
 
@@ -193,12 +197,32 @@ bool EffectChain::processAudioBuffer( sampleFrame * _buf, const fpp_t _frames, b
 
 	MixHelpers::sanitize( _buf, _frames );
 
+	// whether the signal reaching the current effect is known to be silent
+	bool silent = !hasInputNoise;
 	bool moreEffects = false;
 	for (const auto& effect : m_effects)
 	{
+		if (!silent)
+		{
+			effect->m_silentInputFrames = 0;
+		}
+		else if (effect->isRunning())
+		{
+			// once the whole tail has been played there is nothing left to process
+			const f_cnt_t tail = effect->tailLength();
+			if (tail >= 0 && effect->m_silentInputFrames >= tail && !effect->m_autoQuitDisabled)
+			{
+				effect->stopRunning();
+			}
+			effect->m_silentInputFrames += _frames;
+		}
+
 		if (hasInputNoise || effect->isRunning())
 		{
-			moreEffects |= effect->processAudioBuffer(_buf, _frames);
+			const bool running = effect->processAudioBuffer(_buf, _frames);
+			moreEffects |= running;
+			// an effect which is still running may add its tail to silent input
+			silent = silent && !running;
 			MixHelpers::sanitize(_buf, _frames);
 		}
 	}
@@ -237,6 +261,7 @@ void EffectChain::clear()
 		m_effects.pop_back();
 		delete e;
 	}
+	if( Engine::mixer() ) { Engine::mixer()->invalidateSidechains(); }
 
 	Engine::audioEngine()->doneChangeInModel();
 
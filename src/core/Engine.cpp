@@ -55,7 +55,7 @@ void* Engine::s_dndPluginKey = nullptr;
 
 
 
-void Engine::init( bool renderOnly )
+void Engine::init( bool renderOnly, fpp_t renderFramesPerPeriod )
 {
 	Engine *engine = inst();
 
@@ -67,7 +67,9 @@ void Engine::init( bool renderOnly )
 
 	emit engine->initProgress(tr("Initializing data structures"));
 	s_projectJournal = new ProjectJournal;
-	s_audioEngine = new AudioEngine( renderOnly );
+	s_audioEngine = renderFramesPerPeriod > 0
+		? new AudioEngine( renderOnly, renderFramesPerPeriod )
+		: new AudioEngine( renderOnly );
 	s_song = new Song;
 	s_mixer = new Mixer;
 	s_patternStore = new PatternStore;
@@ -69,6 +69,9 @@ void InstrumentPlayHandle::play(sampleFrame * working_buffer)
 	// Process the audio buffer that the instrument has just worked on...
 	const fpp_t frames = Engine::audioEngine()->framesPerPeriod();
 	instrumentTrack->processAudioBuffer(working_buffer, frames, nullptr);
+
+	// The track has already tested the buffer for silence
+	setBufferSilent(instrumentTrack->lastBufferSilent());
 }
 
 bool InstrumentPlayHandle::isFromTrack(const Track* track) const
@@ -25,9 +25,13 @@
  */
 
 #include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
 #include <QDebug>
 #include <QDir>
 #include <QLibrary>
+#include <QSaveFile>
+#include <QStandardPaths>
 
 #include <cmath>
 
@@ -39,6 +43,14 @@
 namespace lmms
 {
 
+namespace
+{
+
+constexpr quint32 CacheMagic = 0x4c4c4443; // "LLDC"
+constexpr quint32 CacheVersion = 1;
+
+} // namespace
+
 
 LadspaManager::LadspaManager()
 {
@@ -59,6 +71,10 @@ LadspaManager::LadspaManager()
 	ladspaDirectories.push_back( "/Library/Audio/Plug-Ins/LADSPA" );
 #endif
 
+	const LibraryCache cache = readCache();
+	LibraryCache libraries;
+	bool cacheChanged = false;
+
 	for (const auto& ladspaDirectory : ladspaDirectories)
 	{
 		// Skip empty entries as QDir will interpret it as the working directory
@@ -78,24 +94,37 @@ LadspaManager::LadspaManager()
 				continue;
 			}
 
-			QLibrary plugin_lib( f.absoluteFilePath() );
-
-			if( plugin_lib.load() == true )
+			const QString path = f.absoluteFilePath();
+			if (!libraries.contains(path))
 			{
-				auto descriptorFunction = (LADSPA_Descriptor_Function)plugin_lib.resolve("ladspa_descriptor");
-				if( descriptorFunction != nullptr )
+				CachedLibrary library;
+				library.modified = f.lastModified().toMSecsSinceEpoch();
+				library.size = f.size();
+
+				// Only libraries that are new or changed need to be loaded
+				const auto cached = cache.find(path);
+				if (cached != cache.end() && cached->modified == library.modified
+					&& cached->size == library.size)
 				{
-					addPlugins( descriptorFunction,
-							f.fileName() );
+					library.plugins = cached->plugins;
 				}
+				else
+				{
+					library.plugins = scanLibrary(path);
+					cacheChanged = true;
+				}
+				libraries.insert(path, library);
 			}
-			else
-			{
-				qWarning() << plugin_lib.errorString();
-			}
+
+			addPlugins( libraries[path].plugins, f.fileName() );
 		}
 	}
-	
+
+	if (cacheChanged || libraries.size() != cache.size())
+	{
+		writeCache(libraries);
+	}
+
 	l_ladspa_key_t keys = m_ladspaManagerMap.keys();
 	for (const auto& key : keys)
 	{
@@ -135,27 +164,177 @@ LadspaManagerDescription * LadspaManager::getDescription(
 
 
 
-void LadspaManager::addPlugins(
-		LADSPA_Descriptor_Function _descriptor_func,
-						const QString & _file )
+QString LadspaManager::cacheFile()
 {
-	const LADSPA_Descriptor * descriptor;
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/ladspa.cache";
+}
+
+
+
 
+LadspaManager::LibraryPlugins LadspaManager::scanLibrary( const QString & _file )
+{
+	LibraryPlugins plugins;
+
+	QLibrary plugin_lib( _file );
+	if( plugin_lib.load() == false )
+	{
+		qWarning() << plugin_lib.errorString();
+		return plugins;
+	}
+
+	auto descriptorFunction = (LADSPA_Descriptor_Function)plugin_lib.resolve("ladspa_descriptor");
+	if( descriptorFunction == nullptr )
+	{
+		return plugins;
+	}
+
+	const LADSPA_Descriptor * descriptor;
 	for( long pluginIndex = 0;
-		( descriptor = _descriptor_func( pluginIndex ) ) != nullptr;
+		( descriptor = descriptorFunction( pluginIndex ) ) != nullptr;
 								++pluginIndex )
 	{
-		ladspa_key_t key( _file, QString( descriptor->Label ) );
+		LadspaManagerDescription plugIn;
+		// The library is loaded now anyway
+		plugIn.descriptorFunction = descriptorFunction;
+		plugIn.index = pluginIndex;
+		plugIn.file = _file;
+		plugIn.label = descriptor->Label;
+		plugIn.name = descriptor->Name;
+		plugIn.maker = descriptor->Maker;
+		plugIn.copyright = descriptor->Copyright;
+		plugIn.properties = descriptor->Properties;
+		for( unsigned long port = 0; port < descriptor->PortCount; ++port )
+		{
+			plugIn.portDescriptors.push_back( descriptor->PortDescriptors[port] );
+			plugIn.portRangeHints.push_back( descriptor->PortRangeHints[port] );
+			plugIn.portNames.append( descriptor->PortNames[port] );
+		}
+		plugins.append( plugIn );
+	}
+
+	return plugins;
+}
+
+
+
+
+LadspaManager::LibraryCache LadspaManager::readCache()
+{
+	LibraryCache cache;
+
+	QFile file( cacheFile() );
+	if( !file.open( QIODevice::ReadOnly ) )
+	{
+		return cache;
+	}
+
+	QDataStream stream( &file );
+	stream.setVersion( QDataStream::Qt_5_6 );
+
+	quint32 magic = 0;
+	quint32 version = 0;
+	quint32 libraryCount = 0;
+	stream >> magic >> version >> libraryCount;
+	if( magic != CacheMagic || version != CacheVersion )
+	{
+		return cache;
+	}
+
+	for( quint32 i = 0; i < libraryCount && stream.status() == QDataStream::Ok; ++i )
+	{
+		QString path;
+		CachedLibrary library;
+		quint32 pluginCount = 0;
+		stream >> path >> library.modified >> library.size >> pluginCount;
+
+		for( quint32 j = 0; j < pluginCount && stream.status() == QDataStream::Ok; ++j )
+		{
+			LadspaManagerDescription plugIn;
+			plugIn.file = path;
+			quint32 portCount = 0;
+			stream >> plugIn.index >> plugIn.label >> plugIn.name >> plugIn.maker
+				>> plugIn.copyright >> plugIn.properties >> portCount;
+
+			for( quint32 port = 0; port < portCount && stream.status() == QDataStream::Ok; ++port )
+			{
+				LADSPA_PortDescriptor portDescriptor = 0;
+				LADSPA_PortRangeHint hint = {};
+				QString portName;
+				stream >> portDescriptor >> hint.HintDescriptor >> hint.LowerBound
+					>> hint.UpperBound >> portName;
+				plugIn.portDescriptors.push_back( portDescriptor );
+				plugIn.portRangeHints.push_back( hint );
+				plugIn.portNames.append( portName );
+			}
+			library.plugins.append( plugIn );
+		}
+		cache.insert( path, library );
+	}
+
+	// A damaged cache is as good as none
+	return stream.status() == QDataStream::Ok ? cache : LibraryCache();
+}
+
+
+
+
+void LadspaManager::writeCache( const LibraryCache & _cache )
+{
+	const QString fileName = cacheFile();
+	QDir().mkpath( QFileInfo( fileName ).absolutePath() );
+
+	QSaveFile file( fileName );
+	if( !file.open( QIODevice::WriteOnly ) )
+	{
+		return;
+	}
+
+	QDataStream stream( &file );
+	stream.setVersion( QDataStream::Qt_5_6 );
+	stream << CacheMagic << CacheVersion << static_cast<quint32>( _cache.size() );
+
+	for( auto it = _cache.begin(); it != _cache.end(); ++it )
+	{
+		stream << it.key() << it->modified << it->size
+			<< static_cast<quint32>( it->plugins.size() );
+		for( const auto& plugIn : it->plugins )
+		{
+			stream << plugIn.index << plugIn.label << plugIn.name << plugIn.maker
+				<< plugIn.copyright << plugIn.properties
+				<< static_cast<quint32>( plugIn.portDescriptors.size() );
+			for( std::size_t port = 0; port < plugIn.portDescriptors.size(); ++port )
+			{
+				const LADSPA_PortRangeHint & hint = plugIn.portRangeHints[port];
+				stream << plugIn.portDescriptors[port] << hint.HintDescriptor
+					<< hint.LowerBound << hint.UpperBound << plugIn.portNames[port];
+			}
+		}
+	}
+
+	if( stream.status() == QDataStream::Ok )
+	{
+		file.commit();
+	}
+}
+
+
+
+
+void LadspaManager::addPlugins( const LibraryPlugins & _plugins,
+						const QString & _file )
+{
+	for( const auto& plugin : _plugins )
+	{
+		ladspa_key_t key( _file, plugin.label );
 		if( m_ladspaManagerMap.contains( key ) )
 		{
 			continue;
 		}
 
-		auto plugIn = new LadspaManagerDescription;
-		plugIn->descriptorFunction = _descriptor_func;
-		plugIn->index = pluginIndex;
-		plugIn->inputChannels = getPluginInputs( descriptor );
-		plugIn->outputChannels = getPluginOutputs( descriptor );
+		auto plugIn = new LadspaManagerDescription( plugin );
+		plugIn->inputChannels = getPluginInputs( *plugIn );
+		plugIn->outputChannels = getPluginOutputs( *plugIn );
 
 		if( plugIn->inputChannels == 0 && plugIn->outputChannels > 0 )
 		{
@@ -184,20 +363,18 @@ void LadspaManager::addPlugins(
 
 
 uint16_t LadspaManager::getPluginInputs(
-		const LADSPA_Descriptor * _descriptor )
+		const LadspaManagerDescription & _description )
 {
 	uint16_t inputs = 0;
 	
-	for( uint16_t port = 0; port < _descriptor->PortCount; port++ )
+	for( std::size_t port = 0; port < _description.portDescriptors.size(); port++ )
 	{
 		if( LADSPA_IS_PORT_INPUT( 
-				_descriptor->PortDescriptors[port] ) &&
+				_description.portDescriptors[port] ) &&
 			LADSPA_IS_PORT_AUDIO( 
-				_descriptor->PortDescriptors[port] ) )
+				_description.portDescriptors[port] ) )
 		{
-			QString name = QString( 
-					_descriptor->PortNames[port] );
-			if( name.toUpper().contains( "IN" ) )
+			if( _description.portNames[port].toUpper().contains( "IN" ) )
 			{
 				inputs++;
 			}
@@ -210,20 +387,18 @@ uint16_t LadspaManager::getPluginInputs(
 
 
 uint16_t LadspaManager::getPluginOutputs(
-		const LADSPA_Descriptor * _descriptor )
+		const LadspaManagerDescription & _description )
 {
 	uint16_t outputs = 0;
 	
-	for( uint16_t port = 0; port < _descriptor->PortCount; port++ )
+	for( std::size_t port = 0; port < _description.portDescriptors.size(); port++ )
 	{
 		if( LADSPA_IS_PORT_OUTPUT( 
-				_descriptor->PortDescriptors[port] ) &&
+				_description.portDescriptors[port] ) &&
 			LADSPA_IS_PORT_AUDIO( 
-				_descriptor->PortDescriptors[port] ) )
+				_description.portDescriptors[port] ) )
 		{
-			QString name = QString( 
-					_descriptor->PortNames[port] );
-			if( name.toUpper().contains( "OUT" ) )
+			if( _description.portNames[port].toUpper().contains( "OUT" ) )
 			{
 				outputs++;
 			}
@@ -234,20 +409,20 @@ uint16_t LadspaManager::getPluginOutputs(
 
 const LADSPA_PortDescriptor* LadspaManager::getPortDescriptor(const ladspa_key_t &_plugin, uint32_t _port)
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	if( descriptor && _port < getPortCount( _plugin ) )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	if( description && _port < description->portDescriptors.size() )
 	{
-		return( & descriptor->PortDescriptors[_port] );
+		return( & description->portDescriptors[_port] );
 	}
 	return( nullptr );
 }
 
 const LADSPA_PortRangeHint *LadspaManager::getPortRangeHint(const ladspa_key_t &_plugin, uint32_t _port)
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	if( descriptor && _port < getPortCount( _plugin ) )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	if( description && _port < description->portRangeHints.size() )
 	{
-		return( & descriptor->PortRangeHints[_port] );
+		return( & description->portRangeHints[_port] );
 	}
 	return( nullptr );
 }
@@ -265,8 +440,8 @@ l_sortable_plugin_t LadspaManager::getSortedPlugins()
 
 QString LadspaManager::getLabel( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->Label : "" );
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? description->label : "" );
 }
 
 
@@ -275,8 +450,8 @@ QString LadspaManager::getLabel( const ladspa_key_t & _plugin )
 bool LadspaManager::hasRealTimeDependency(
 					const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_REALTIME( descriptor->Properties )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? LADSPA_IS_REALTIME( description->properties )
 					   : false );
 }
 
@@ -285,8 +460,8 @@ bool LadspaManager::hasRealTimeDependency(
 
 bool LadspaManager::isInplaceBroken( const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_INPLACE_BROKEN( descriptor->Properties )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? LADSPA_IS_INPLACE_BROKEN( description->properties )
 					   : false );
 }
 
@@ -296,8 +471,8 @@ bool LadspaManager::isInplaceBroken( const ladspa_key_t &  _plugin )
 bool LadspaManager::isRealTimeCapable(
 					const ladspa_key_t &  _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? LADSPA_IS_HARD_RT_CAPABLE( descriptor->Properties )
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? LADSPA_IS_HARD_RT_CAPABLE( description->properties )
 					   : false );
 }
 
@@ -306,8 +481,8 @@ bool LadspaManager::isRealTimeCapable(
 
 QString LadspaManager::getName( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->Name : "" );
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? description->name : "" );
 }
 
 
@@ -315,8 +490,8 @@ QString LadspaManager::getName( const ladspa_key_t & _plugin )
 
 QString LadspaManager::getMaker( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->Maker : "" );
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? description->maker : "" );
 }
 
 
@@ -324,8 +499,8 @@ QString LadspaManager::getMaker( const ladspa_key_t & _plugin )
 
 QString LadspaManager::getCopyright( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->Copyright : "" );
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? description->copyright : "" );
 }
 
 
@@ -333,8 +508,8 @@ QString LadspaManager::getCopyright( const ladspa_key_t & _plugin )
 
 uint32_t LadspaManager::getPortCount( const ladspa_key_t & _plugin )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->PortCount : 0 );
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? static_cast<uint32_t>( description->portDescriptors.size() ) : 0 );
 }
 
 
@@ -523,24 +698,10 @@ bool LadspaManager::isInteger( const ladspa_key_t & _plugin,
 
 bool LadspaManager::isEnum( const ladspa_key_t & _plugin, uint32_t _port )
 {
-	if( m_ladspaManagerMap.contains( _plugin )
-		   && _port < getPortCount( _plugin ) )
-	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		LADSPA_PortRangeHintDescriptor hintDescriptor =
-			descriptor->PortRangeHints[_port].HintDescriptor;
-		// This is an LMMS extension to ladspa
-		return( LADSPA_IS_HINT_INTEGER( hintDescriptor ) &&
-			LADSPA_IS_HINT_TOGGLED( hintDescriptor ) );
-	}
-	else
-	{
-		return( false );
-	}
+	const auto* portRangeHint = getPortRangeHint( _plugin, _port );
+	// This is an LMMS extension to ladspa
+	return( portRangeHint && LADSPA_IS_HINT_INTEGER( portRangeHint->HintDescriptor ) &&
+		LADSPA_IS_HINT_TOGGLED( portRangeHint->HintDescriptor ) );
 }
 
 
@@ -549,8 +710,8 @@ bool LadspaManager::isEnum( const ladspa_key_t & _plugin, uint32_t _port )
 QString LadspaManager::getPortName( const ladspa_key_t & _plugin,
 								uint32_t _port )
 {
-	const LADSPA_Descriptor * descriptor = getDescriptor( _plugin );
-	return( descriptor ? descriptor->PortNames[_port] : QString( "" ) );
+	const LadspaManagerDescription * description = getDescription( _plugin );
+	return( description ? description->portNames.value( _port ) : QString( "" ) );
 }
 
 
@@ -569,19 +730,39 @@ const void * LadspaManager::getImplementationData(
 const LADSPA_Descriptor * LadspaManager::getDescriptor(
 						const ladspa_key_t & _plugin )
 {
-	if( m_ladspaManagerMap.contains( _plugin ) )
+	LadspaManagerDescription * description = getDescription( _plugin );
+	if( description == nullptr )
 	{
-		LADSPA_Descriptor_Function descriptorFunction =
-			m_ladspaManagerMap[_plugin]->descriptorFunction;
-		const LADSPA_Descriptor * descriptor =
-				descriptorFunction(
-					m_ladspaManagerMap[_plugin]->index );
-		return( descriptor );
+		return( nullptr );
 	}
-	else
+
+	LADSPA_Descriptor_Function descriptorFunction = nullptr;
+	{
+		QMutexLocker lock( &m_libraryMutex );
+		if( description->descriptorFunction == nullptr )
+		{
+			// The metadata came from the cache, so the library was not loaded yet
+			QLibrary plugin_lib( description->file );
+			if( plugin_lib.load() == false )
+			{
+				qWarning() << plugin_lib.errorString();
+				return( nullptr );
+			}
+			description->descriptorFunction =
+				(LADSPA_Descriptor_Function)plugin_lib.resolve( "ladspa_descriptor" );
+		}
+		descriptorFunction = description->descriptorFunction;
+	}
+
+	const LADSPA_Descriptor * descriptor = descriptorFunction ?
+			descriptorFunction( description->index ) : nullptr;
+
+	// Guard against the library having changed since it was cached
+	if( descriptor == nullptr || description->label != descriptor->Label )
 	{
 		return( nullptr );
 	}
+	return( descriptor );
 }
 
 
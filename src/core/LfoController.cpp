@@ -36,6 +36,20 @@
 namespace lmms
 {
 
+namespace
+{
+
+template<sample_t (*Shape)(const float)>
+void generateWave(float* values, int frames, float phase, float phaseInc)
+{
+	for (int f = 0; f < frames; ++f)
+	{
+		values[f] = Shape(phase + f * phaseInc);
+	}
+}
+
+} // namespace
+
 
 LfoController::LfoController( Model * _parent ) :
 	Controller( ControllerType::Lfo, _parent, tr( "LFO Controller" ) ),
@@ -49,12 +63,9 @@ LfoController::LfoController( Model * _parent ) :
 	m_duration( 1000 ),
 	m_phaseOffset( 0 ),
 	m_currentPhase( 0 ),
-	m_sampleFunction( &Oscillator::sinSample ),
 	m_userDefSampleBuffer(std::make_shared<SampleBuffer>())
 {
 	setSampleExact( true );
-	connect( &m_waveModel, SIGNAL(dataChanged()),
-			this, SLOT(updateSampleFunction()), Qt::DirectConnection );
 
 	connect( &m_speedModel, SIGNAL(dataChanged()),
 			this, SLOT(updateDuration()), Qt::DirectConnection );
@@ -89,7 +100,6 @@ void LfoController::updateValueBuffer()
 {
 	m_phaseOffset = m_phaseModel.value() / 360.0;
 	float phase = m_currentPhase + m_phaseOffset;
-	float phasePrev = 0.0f;
 
 	// roll phase up until we're in sync with period counter
 	m_bufferLastUpdated++;
@@ -100,49 +110,77 @@ void LfoController::updateValueBuffer()
 		m_bufferLastUpdated += diff;
 	}
 
-	float amount = m_amountModel.value();
-	ValueBuffer *amountBuffer = m_amountModel.valueBuffer();
-	int amountInc = amountBuffer ? 1 : 0;
-	float *amountPtr = amountBuffer ? &(amountBuffer->values()[ 0 ] ) : &amount;
-	Oscillator::WaveShape waveshape = static_cast<Oscillator::WaveShape>(m_waveModel.value());
+	const int frames = m_valueBuffer.length();
+	const float phaseInc = 1.0f / m_duration;
+	float* values = m_valueBuffer.values();
 
-	for( float& f : m_valueBuffer )
+	// First the bare wave, with one loop per shape so the shape gets
+	// inlined and the loop vectorised
+	switch (static_cast<Oscillator::WaveShape>(m_waveModel.value()))
 	{
-		float currentSample = 0;
-		switch (waveshape)
-		{
-		case Oscillator::WaveShape::WhiteNoise:
+	case Oscillator::WaveShape::Sine:
+	default:
+		generateWave<&Oscillator::sinSample>(values, frames, phase, phaseInc);
+		break;
+	case Oscillator::WaveShape::Triangle:
+		generateWave<&Oscillator::triangleSample>(values, frames, phase, phaseInc);
+		break;
+	case Oscillator::WaveShape::Saw:
+		generateWave<&Oscillator::sawSample>(values, frames, phase, phaseInc);
+		break;
+	case Oscillator::WaveShape::Square:
+		generateWave<&Oscillator::squareSample>(values, frames, phase, phaseInc);
+		break;
+	case Oscillator::WaveShape::MoogSaw:
+		generateWave<&Oscillator::moogSawSample>(values, frames, phase, phaseInc);
+		break;
+	case Oscillator::WaveShape::Exponential:
+		generateWave<&Oscillator::expSample>(values, frames, phase, phaseInc);
+		break;
+	case Oscillator::WaveShape::WhiteNoise:
+	{
+		float phasePrev = 0.0f;
+		for (int f = 0; f < frames; ++f)
 		{
-			if (absFraction(phase) < absFraction(phasePrev))
+			const float currentPhase = phase + f * phaseInc;
+			if (absFraction(currentPhase) < absFraction(phasePrev))
 			{
 				// Resample when phase period has completed
-				m_heldSample = m_sampleFunction(phase);
+				m_heldSample = Oscillator::noiseSample(currentPhase);
 			}
-			currentSample = m_heldSample;
-			break;
+			values[f] = m_heldSample;
+			phasePrev = currentPhase;
 		}
-		case Oscillator::WaveShape::UserDefined:
+		break;
+	}
+	case Oscillator::WaveShape::UserDefined:
+		for (int f = 0; f < frames; ++f)
 		{
-			currentSample = Oscillator::userWaveSample(m_userDefSampleBuffer.get(), phase);
-			break;
+			values[f] = Oscillator::userWaveSample(m_userDefSampleBuffer.get(), phase + f * phaseInc);
 		}
-		default:
+		break;
+	}
+
+	// Then scale it around the base value
+	const float base = m_baseModel.value();
+	const ValueSpan amount = m_amountModel.valueSpan();
+	if (amount.isConstant())
+	{
+		const float halfAmount = amount.front() / 2.0f;
+		for (int f = 0; f < frames; ++f)
 		{
-			if (m_sampleFunction != nullptr)
-			{
-				currentSample = m_sampleFunction(phase);
-			}
+			values[f] = std::clamp(base + halfAmount * values[f], 0.0f, 1.0f);
 		}
 	}
-
-		f = std::clamp(m_baseModel.value() + (*amountPtr * currentSample / 2.0f), 0.0f, 1.0f);
-
-		phasePrev = phase;
-		phase += 1.0 / m_duration;
-		amountPtr += amountInc;
+	else
+	{
+		for (int f = 0; f < frames; ++f)
+		{
+			values[f] = std::clamp(base + amount[f] * values[f] / 2.0f, 0.0f, 1.0f);
+		}
 	}
 
-	m_currentPhase = absFraction(phase - m_phaseOffset);
+	m_currentPhase = absFraction(phase + frames * phaseInc - m_phaseOffset);
 	m_bufferLastUpdated = s_periods;
 }
 
@@ -174,45 +212,6 @@ void LfoController::updateDuration()
 	m_duration = newDurationF;
 }
 
-void LfoController::updateSampleFunction()
-{
-	switch( static_cast<Oscillator::WaveShape>(m_waveModel.value()) )
-	{
-		case Oscillator::WaveShape::Sine:
-		default:
-			m_sampleFunction = &Oscillator::sinSample;
-			break;
-		case Oscillator::WaveShape::Triangle:
-			m_sampleFunction = &Oscillator::triangleSample;
-			break;
-		case Oscillator::WaveShape::Saw:
-			m_sampleFunction = &Oscillator::sawSample;
-			break;
-		case Oscillator::WaveShape::Square:
-			m_sampleFunction = &Oscillator::squareSample;
-			break;
-		case Oscillator::WaveShape::MoogSaw:
-			m_sampleFunction = &Oscillator::moogSawSample;
-			break;
-		case Oscillator::WaveShape::Exponential:
-			m_sampleFunction = &Oscillator::expSample;
-			break;
-		case Oscillator::WaveShape::WhiteNoise:
-			m_sampleFunction = &Oscillator::noiseSample;
-			break;
-		case Oscillator::WaveShape::UserDefined:
-			m_sampleFunction = nullptr;
-			/*TODO: If C++11 is allowed, should change the type of
-			 m_sampleFunction be std::function<sample_t(const float)>
-			 and use the line below:
-			*/
-			//m_sampleFunction = &(m_userDefSampleBuffer->userWaveSample)
-			break;
-	}
-}
-
-
-
 void LfoController::saveSettings( QDomDocument & _doc, QDomElement & _this )
 {
 	Controller::saveSettings( _doc, _this );
@@ -247,8 +246,6 @@ void LfoController::loadSettings( const QDomElement & _this )
 		}
 		else { Engine::getSong()->collectError(QString("%1: %2").arg(tr("Sample not found"), userWaveFile)); }
 	}
-
-	updateSampleFunction();
 }
 
 
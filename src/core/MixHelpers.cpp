@@ -22,15 +22,27 @@
  *
  */
 
+
 #include "MixHelpers.h"
 
 #ifdef LMMS_DEBUG
 #include <cstdio>
 #endif
 
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <QtGlobal>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LMMS_MIX_HELPERS_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define LMMS_MIX_HELPERS_NEON
+#endif
+
 #include "ValueBuffer.h"
 
 
@@ -41,42 +53,192 @@ static bool s_NaNHandler;
 namespace lmms::MixHelpers
 {
 
-/*! \brief Function for applying MIXOP on all sample frames */
+/*
+	The kernels below work on two stereo frames, i.e. four samples, at a time. Vec holds them in an SSE2 or NEON
+	register, or in a plain array the compiler may vectorize on its own if neither is available. SSE2 is part of
+	every x86-64 CPU and NEON of every AArch64 one, so there is nothing to detect at runtime.
+*/
+namespace
+{
+
+constexpr std::uint32_t ExponentMask = 0x7f800000;
+
+#if defined(LMMS_MIX_HELPERS_SSE2)
+
+using Vec = __m128;
+
+inline Vec load(const sampleFrame* f) { return _mm_loadu_ps(f->data()); }
+inline void store(sampleFrame* f, Vec v) { _mm_storeu_ps(f->data(), v); }
+inline Vec splat(float x) { return _mm_set1_ps(x); }
+inline Vec make(float left0, float right0, float left1, float right1)
+{
+	return _mm_setr_ps(left0, right0, left1, right1);
+}
+inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+inline Vec clamp(Vec x, float low, float high) { return _mm_min_ps(_mm_max_ps(x, splat(low)), splat(high)); }
+inline Vec swapChannels(Vec x) { return _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1)); }
+
+// inf and NaN are the values with all exponent bits set; testing the bits keeps working with -ffinite-math-only
+inline __m128i nonFinite(Vec x)
+{
+	const __m128i exponent = _mm_set1_epi32(static_cast<int>(ExponentMask));
+	return _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(x), exponent), exponent);
+}
+inline bool anyNonFinite(Vec x) { return _mm_movemask_epi8(nonFinite(x)) != 0; }
+//! Zeroes the lanes of `value` where `of` is inf or NaN
+inline Vec finiteOnly(Vec value, Vec of) { return _mm_andnot_ps(_mm_castsi128_ps(nonFinite(of)), value); }
+inline bool anyAudible(Vec x)
+{
+	const Vec magnitude = _mm_andnot_ps(splat(-0.0f), x);
+	return _mm_movemask_ps(_mm_cmpge_ps(magnitude, splat(SilenceThreshold))) != 0;
+}
+
+#elif defined(LMMS_MIX_HELPERS_NEON)
+
+using Vec = float32x4_t;
+
+inline Vec load(const sampleFrame* f) { return vld1q_f32(f->data()); }
+inline void store(sampleFrame* f, Vec v) { vst1q_f32(f->data(), v); }
+inline Vec splat(float x) { return vdupq_n_f32(x); }
+inline Vec make(float left0, float right0, float left1, float right1)
+{
+	const float values[4] = {left0, right0, left1, right1};
+	return vld1q_f32(values);
+}
+inline Vec add(Vec a, Vec b) { return vaddq_f32(a, b); }
+inline Vec mul(Vec a, Vec b) { return vmulq_f32(a, b); }
+inline Vec clamp(Vec x, float low, float high) { return vminq_f32(vmaxq_f32(x, splat(low)), splat(high)); }
+inline Vec swapChannels(Vec x) { return vrev64q_f32(x); }
+
+inline bool any(uint32x4_t mask)
+{
+	const uint32x2_t halves = vorr_u32(vget_low_u32(mask), vget_high_u32(mask));
+	return (vget_lane_u32(halves, 0) | vget_lane_u32(halves, 1)) != 0;
+}
+inline uint32x4_t nonFinite(Vec x)
+{
+	const uint32x4_t exponent = vdupq_n_u32(ExponentMask);
+	return vceqq_u32(vandq_u32(vreinterpretq_u32_f32(x), exponent), exponent);
+}
+inline bool anyNonFinite(Vec x) { return any(nonFinite(x)); }
+inline Vec finiteOnly(Vec value, Vec of)
+{
+	return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(value), nonFinite(of)));
+}
+inline bool anyAudible(Vec x) { return any(vcgeq_f32(vabsq_f32(x), splat(SilenceThreshold))); }
+
+#else
+
+struct Vec
+{
+	float v[4];
+};
+
+inline Vec load(const sampleFrame* f) { return {f[0][0], f[0][1], f[1][0], f[1][1]}; }
+inline void store(sampleFrame* f, Vec x) { f[0] = {x.v[0], x.v[1]}; f[1] = {x.v[2], x.v[3]}; }
+inline Vec splat(float x) { return {x, x, x, x}; }
+inline Vec make(float left0, float right0, float left1, float right1) { return {left0, right0, left1, right1}; }
+inline Vec add(Vec a, Vec b) { return {a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3]}; }
+inline Vec mul(Vec a, Vec b) { return {a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3]}; }
+inline Vec clamp(Vec x, float low, float high)
+{
+	for (auto& s : x.v) { s = std::clamp(s, low, high); }
+	return x;
+}
+inline Vec swapChannels(Vec x) { return {x.v[1], x.v[0], x.v[3], x.v[2]}; }
+
+inline bool isNonFinite(float x)
+{
+	std::uint32_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	return (bits & ExponentMask) == ExponentMask;
+}
+inline bool anyNonFinite(Vec x) { return std::any_of(x.v, x.v + 4, isNonFinite); }
+inline Vec finiteOnly(Vec value, Vec of)
+{
+	for (int i = 0; i < 4; ++i) { if (isNonFinite(of.v[i])) { value.v[i] = 0.0f; } }
+	return value;
+}
+inline bool anyAudible(Vec x)
+{
+	return std::any_of(x.v, x.v + 4, [](float s) { return std::abs(s) >= SilenceThreshold; });
+}
+
+#endif
+
+//! The same coefficients for the left and the right channel of both frames
+inline Vec stereo(float left, float right) { return make(left, right, left, right); }
+//! One coefficient per frame, for both channels
+inline Vec perFrame(float first, float second) { return make(first, first, second, second); }
+inline Vec joined(const sample_t* left, const sample_t* right, int f, int g)
+{
+	return make(left[f], right[f], left[g], right[g]);
+}
+
+
+/*! \brief Applies OP to all sample frames, two at a time
+
+	OP gets the destination and source frames and the indices of both frames, for reading per-frame coefficients.
+	An odd last frame is processed together with a silent one, passing its index twice. */
 template<typename MIXOP>
-static inline void run( sampleFrame* dst, const sampleFrame* src, int frames, const MIXOP& OP )
+inline void run( sampleFrame* dst, const sampleFrame* src, int frames, const MIXOP& OP )
 {
-	for( int i = 0; i < frames; ++i )
+	int f = 0;
+	for( ; f + 2 <= frames; f += 2 )
+	{
+		store( dst + f, OP( load( dst + f ), load( src + f ), f, f + 1 ) );
+	}
+	if( f < frames )
 	{
-		OP( dst[i], src[i] );
+		sampleFrame d[2] = { dst[f], {} };
+		const sampleFrame s[2] = { src[f], {} };
+		store( d, OP( load( d ), load( s ), f, f ) );
+		dst[f] = d[0];
 	}
 }
 
 /*! \brief Function for applying MIXOP on all sample frames - split source */
 template<typename MIXOP>
-static inline void run( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, int frames, const MIXOP& OP )
+inline void run( sampleFrame* dst, const sample_t* srcLeft, const sample_t* srcRight, int frames, const MIXOP& OP )
 {
-	for( int i = 0; i < frames; ++i )
+	int f = 0;
+	for( ; f + 2 <= frames; f += 2 )
 	{
-		const sampleFrame src = { srcLeft[i], srcRight[i] };
-		OP( dst[i], src );
+		store( dst + f, OP( load( dst + f ), joined( srcLeft, srcRight, f, f + 1 ), f, f + 1 ) );
 	}
+	if( f < frames )
+	{
+		sampleFrame d[2] = { dst[f], {} };
+		const sampleFrame s[2] = { { srcLeft[f], srcRight[f] }, {} };
+		store( d, OP( load( d ), load( s ), f, f ) );
+		dst[f] = d[0];
+	}
+}
+
+//! Reads per-frame coefficients of two frames from a span
+inline Vec coefficients( const ValueSpan& span, int f, int g )
+{
+	return perFrame( span[f], span[g] );
 }
 
+} // namespace
+
 
 
 bool isSilent( const sampleFrame* src, int frames )
 {
-	const float silenceThreshold = 0.0000001f;
-
-	for( int i = 0; i < frames; ++i )
+	int f = 0;
+	for( ; f + 2 <= frames; f += 2 )
 	{
-		if( fabsf( src[i][0] ) >= silenceThreshold || fabsf( src[i][1] ) >= silenceThreshold )
+		if( anyAudible( load( src + f ) ) )
 		{
 			return false;
 		}
 	}
 
-	return true;
+	return f == frames
+		|| ( std::abs( src[f][0] ) < SilenceThreshold && std::abs( src[f][1] ) < SilenceThreshold );
 }
 
 bool useNaNHandler()
@@ -97,110 +259,71 @@ bool sanitize( sampleFrame * src, int frames )
 		return false;
 	}
 
-	bool found = false;
-	for( int f = 0; f < frames; ++f )
+	for( int f = 0; f < frames; f += 2 )
 	{
-		for( int c = 0; c < 2; ++c )
+		// an odd last frame is tested together with a silent one
+		sampleFrame last[2] = { src[f], {} };
+		sampleFrame* frame = f + 1 < frames ? src + f : last;
+
+		const Vec v = load( frame );
+		if( anyNonFinite( v ) )
+		{
+			#ifdef LMMS_DEBUG
+				// TODO don't use printf here
+				printf("Bad data, clearing buffer. frame: ");
+				printf("%d\n", f);
+			#endif
+			std::fill_n( src, frames, sampleFrame{} );
+			return true;
+		}
+		store( frame, clamp( v, -1000.0f, 1000.0f ) );
+		if( frame == last )
 		{
-			if( std::isinf( src[f][c] ) || std::isnan( src[f][c] ) )
-			{
-				#ifdef LMMS_DEBUG
-					// TODO don't use printf here
-					printf("Bad data, clearing buffer. frame: ");
-					printf("%d: value %f\n", f, src[f][c]);
-				#endif
-				for( int f = 0; f < frames; ++f )
-				{
-					for( int c = 0; c < 2; ++c )
-					{
-						src[f][c] = 0.0f;
-					}
-				}
-				found = true;
-				return found;
-			}
-			else
-			{
-				src[f][c] = std::clamp(src[f][c], -1000.0f, 1000.0f);
-			}
+			src[f] = last[0];
 		}
 	}
-	return found;
+	return false;
 }
 
 
-struct AddOp
-{
-	void operator()( sampleFrame& dst, const sampleFrame& src ) const
-	{
-		dst[0] += src[0];
-		dst[1] += src[1];
-	}
-} ;
-
 void add( sampleFrame* dst, const sampleFrame* src, int frames )
 {
-	run<>( dst, src, frames, AddOp() );
+	run<>( dst, src, frames, []( Vec d, Vec s, int, int ) { return add( d, s ); } );
 }
 
 
-
-struct AddMultipliedOp
-{
-	AddMultipliedOp( float coeff ) : m_coeff( coeff ) { }
-
-	void operator()( sampleFrame& dst, const sampleFrame& src ) const
-	{
-		dst[0] += src[0] * m_coeff;
-		dst[1] += src[1] * m_coeff;
-	}
-
-	const float m_coeff;
-} ;
-
-
 void addMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
-	run<>( dst, src, frames, AddMultipliedOp(coeffSrc) );
+	const Vec coeff = splat( coeffSrc );
+	run<>( dst, src, frames, [coeff]( Vec d, Vec s, int, int ) { return add( d, mul( s, coeff ) ); } );
 }
 
 
-struct AddSwappedMultipliedOp
-{
-	AddSwappedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
-
-	void operator()( sampleFrame& dst, const sampleFrame& src ) const
-	{
-		dst[0] += src[1] * m_coeff;
-		dst[1] += src[0] * m_coeff;
-	}
-
-	const float m_coeff;
-};
-
 void addSwappedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
-	run<>( dst, src, frames, AddSwappedMultipliedOp(coeffSrc) );
+	const Vec coeff = splat( coeffSrc );
+	run<>( dst, src, frames, [coeff]( Vec d, Vec s, int, int ) { return add( d, mul( swapChannels( s ), coeff ) ); } );
 }
 
 
 void addMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
 {
-	for( int f = 0; f < frames; ++f )
+	const Vec coeff = splat( coeffSrc );
+	const float* values = coeffSrcBuf->values();
+	run<>( dst, src, frames, [coeff, values]( Vec d, Vec s, int f, int g )
 	{
-		dst[f][0] += src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
-	}
+		return add( d, mul( mul( s, coeff ), perFrame( values[f], values[g] ) ) );
+	} );
 }
 
 void addMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
 {
-	for( int f = 0; f < frames; ++f )
+	const float* values1 = coeffSrcBuf1->values();
+	const float* values2 = coeffSrcBuf2->values();
+	run<>( dst, src, frames, [values1, values2]( Vec d, Vec s, int f, int g )
 	{
-		dst[f][0] += src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-	}
-
+		return add( d, mul( mul( s, perFrame( values1[f], values1[g] ) ), perFrame( values2[f], values2[g] ) ) );
+	} );
 }
 
 void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, float coeffSrc, ValueBuffer * coeffSrcBuf, int frames )
@@ -212,11 +335,12 @@ void addSanitizedMultipliedByBuffer( sampleFrame* dst, const sampleFrame* src, f
 		return;
 	}
 
-	for( int f = 0; f < frames; ++f )
+	const Vec coeff = splat( coeffSrc );
+	const float* values = coeffSrcBuf->values();
+	run<>( dst, src, frames, [coeff, values]( Vec d, Vec s, int f, int g )
 	{
-		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) ) ? 0.0f : src[f][0] * coeffSrc * coeffSrcBuf->values()[f];
-		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) ) ? 0.0f : src[f][1] * coeffSrc * coeffSrcBuf->values()[f];
-	}
+		return add( d, finiteOnly( mul( mul( s, coeff ), perFrame( values[f], values[g] ) ), s ) );
+	} );
 }
 
 void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src, ValueBuffer * coeffSrcBuf1, ValueBuffer * coeffSrcBuf2, int frames )
@@ -228,32 +352,16 @@ void addSanitizedMultipliedByBuffers( sampleFrame* dst, const sampleFrame* src,
 		return;
 	}
 
-	for( int f = 0; f < frames; ++f )
+	const float* values1 = coeffSrcBuf1->values();
+	const float* values2 = coeffSrcBuf2->values();
+	run<>( dst, src, frames, [values1, values2]( Vec d, Vec s, int f, int g )
 	{
-		dst[f][0] += ( std::isinf( src[f][0] ) || std::isnan( src[f][0] ) )
-			? 0.0f
-			: src[f][0] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-		dst[f][1] += ( std::isinf( src[f][1] ) || std::isnan( src[f][1] ) )
-			? 0.0f
-			: src[f][1] * coeffSrcBuf1->values()[f] * coeffSrcBuf2->values()[f];
-	}
-
+		return add( d, finiteOnly( mul( mul( s, perFrame( values1[f], values1[g] ) ),
+										perFrame( values2[f], values2[g] ) ), s ) );
+	} );
 }
 
 
-struct AddSanitizedMultipliedOp
-{
-	AddSanitizedMultipliedOp( float coeff ) : m_coeff( coeff ) { }
-
-	void operator()( sampleFrame& dst, const sampleFrame& src ) const
-	{
-		dst[0] += ( std::isinf( src[0] ) || std::isnan( src[0] ) ) ? 0.0f : src[0] * m_coeff;
-		dst[1] += ( std::isinf( src[1] ) || std::isnan( src[1] ) ) ? 0.0f : src[1] * m_coeff;
-	}
-
-	const float m_coeff;
-};
-
 void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffSrc, int frames )
 {
 	if ( !useNaNHandler() )
@@ -262,60 +370,73 @@ void addSanitizedMultiplied( sampleFrame* dst, const sampleFrame* src, float coe
 		return;
 	}
 
-	run<>( dst, src, frames, AddSanitizedMultipliedOp(coeffSrc) );
+	const Vec coeff = splat( coeffSrc );
+	run<>( dst, src, frames, [coeff]( Vec d, Vec s, int, int ) { return add( d, finiteOnly( mul( s, coeff ), s ) ); } );
 }
 
 
-
-struct AddMultipliedStereoOp
+void addSanitizedMultipliedBySpans( sampleFrame* dst, const sampleFrame* src, const ValueSpan& coeffSrc1, const ValueSpan& coeffSrc2, int frames )
 {
-	AddMultipliedStereoOp( float coeffLeft, float coeffRight )
+	if( coeffSrc1.isConstant() && coeffSrc2.isConstant() )
 	{
-		m_coeffs[0] = coeffLeft;
-		m_coeffs[1] = coeffRight;
+		addSanitizedMultiplied( dst, src, coeffSrc1.front() * coeffSrc2.front(), frames );
+		return;
 	}
 
-	void operator()( sampleFrame& dst, const sampleFrame& src ) const
+	const bool sanitizeSrc = useNaNHandler();
+	run<>( dst, src, frames, [&coeffSrc1, &coeffSrc2, sanitizeSrc]( Vec d, Vec s, int f, int g )
 	{
-		dst[0] += src[0] * m_coeffs[0];
-		dst[1] += src[1] * m_coeffs[1];
-	}
-
-	std::array<float, 2> m_coeffs;
-} ;
+		const Vec mixed = mul( mul( s, coefficients( coeffSrc1, f, g ) ), coefficients( coeffSrc2, f, g ) );
+		return add( d, sanitizeSrc ? finiteOnly( mixed, s ) : mixed );
+	} );
+}
 
 
 void addMultipliedStereo( sampleFrame* dst, const sampleFrame* src, float coeffSrcLeft, float coeffSrcRight, int frames )
 {
-
-	run<>( dst, src, frames, AddMultipliedStereoOp(coeffSrcLeft, coeffSrcRight) );
+	const Vec coeffs = stereo( coeffSrcLeft, coeffSrcRight );
+	run<>( dst, src, frames, [coeffs]( Vec d, Vec s, int, int ) { return add( d, mul( s, coeffs ) ); } );
 }
 
 
-
-
-
-struct MultiplyAndAddMultipliedOp
+void multiplyByVolumeAndPanning( sampleFrame* dst, const ValueSpan& volume, const ValueSpan& panning, int frames )
 {
-	MultiplyAndAddMultipliedOp( float coeffDst, float coeffSrc )
+	// panning only attenuates the opposite channel
+	const auto gains = []( float v, float p, float& left, float& right )
 	{
-		m_coeffs[0] = coeffDst;
-		m_coeffs[1] = coeffSrc;
-	}
+		v *= 0.01f;
+		p *= 0.01f;
+		left = ( p <= 0 ? 1.0f : 1.0f - p ) * v;
+		right = ( p >= 0 ? 1.0f : 1.0f + p ) * v;
+	};
 
-	void operator()( sampleFrame& dst, const sampleFrame& src ) const
+	if( volume.isConstant() && panning.isConstant() )
 	{
-		dst[0] = dst[0]*m_coeffs[0] + src[0]*m_coeffs[1];
-		dst[1] = dst[1]*m_coeffs[0] + src[1]*m_coeffs[1];
+		float left, right;
+		gains( volume.front(), panning.front(), left, right );
+		const Vec coeffs = stereo( left, right );
+		run<>( dst, dst, frames, [coeffs]( Vec d, Vec, int, int ) { return mul( d, coeffs ); } );
+		return;
 	}
 
-	std::array<float, 2> m_coeffs;
-} ;
+	run<>( dst, dst, frames, [&volume, &panning, &gains]( Vec d, Vec, int f, int g )
+	{
+		float left[2], right[2];
+		gains( volume[f], panning[f], left[0], right[0] );
+		gains( volume[g], panning[g], left[1], right[1] );
+		return mul( d, make( left[0], right[0], left[1], right[1] ) );
+	} );
+}
 
 
 void multiplyAndAddMultiplied( sampleFrame* dst, const sampleFrame* src, float coeffDst, float coeffSrc, int frames )
 {
-	run<>( dst, src, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
+	const Vec dstCoeff = splat( coeffDst );
+	const Vec srcCoeff = splat( coeffSrc );
+	run<>( dst, src, frames, [dstCoeff, srcCoeff]( Vec d, Vec s, int, int )
+	{
+		return add( mul( d, dstCoeff ), mul( s, srcCoeff ) );
+	} );
 }
 
 
@@ -325,8 +446,12 @@ void multiplyAndAddMultipliedJoined( sampleFrame* dst,
 										const sample_t* srcRight,
 										float coeffDst, float coeffSrc, int frames )
 {
-	run<>( dst, srcLeft, srcRight, frames, MultiplyAndAddMultipliedOp(coeffDst, coeffSrc) );
+	const Vec dstCoeff = splat( coeffDst );
+	const Vec srcCoeff = splat( coeffSrc );
+	run<>( dst, srcLeft, srcRight, frames, [dstCoeff, srcCoeff]( Vec d, Vec s, int, int )
+	{
+		return add( mul( d, dstCoeff ), mul( s, srcCoeff ) );
+	} );
 }
 
 } // namespace lmms::MixHelpers
-
@@ -24,11 +24,17 @@
 
 #include <QDomElement>
 
+#include <algorithm>
+
+#include "AudioDevice.h"
 #include "AudioEngine.h"
 #include "AudioEngineWorkerThread.h"
 #include "BufferManager.h"
+#include "ControllerConnection.h"
+#include "Effect.h"
 #include "Mixer.h"
 #include "MixHelpers.h"
+#include "PeakController.h"
 #include "Song.h"
 
 #include "InstrumentTrack.h"
@@ -62,6 +68,7 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_fxChain( nullptr ),
 	m_hasInput( false ),
 	m_stillRunning( false ),
+	m_hasOutput( false ),
 	m_peakLeft( 0.0f ),
 	m_peakRight( 0.0f ),
 	m_buffer( new sampleFrame[Engine::audioEngine()->framesPerPeriod()] ),
@@ -72,6 +79,7 @@ MixerChannel::MixerChannel( int idx, Model * _parent ) :
 	m_lock(),
 	m_channelIndex( idx ),
 	m_queued( false ),
+	m_sidechainSources( 0 ),
 	m_dependenciesMet(0)
 {
 	BufferManager::clear( m_buffer, Engine::audioEngine()->framesPerPeriod() );
@@ -95,12 +103,19 @@ inline void MixerChannel::processed()
 			receiverRoute->receiver()->incrementDeps();
 		}
 	}
+	for( MixerChannel * target : m_sidechainTargets )
+	{
+		if( target->m_muted == false )
+		{
+			target->incrementDeps();
+		}
+	}
 }
 
 void MixerChannel::incrementDeps()
 {
 	int i = m_dependenciesMet++ + 1;
-	if( i >= m_receives.size() && ! m_queued )
+	if( i >= m_receives.size() + m_sidechainSources && ! m_queued )
 	{
 		m_queued = true;
 		AudioEngineWorkerThread::addJob( this );
@@ -127,35 +142,11 @@ void MixerChannel::doProcessing()
 			FloatModel * sendModel = senderRoute->amount();
 			if( ! sendModel ) qFatal( "Error: no send model found from %d to %d", senderRoute->senderIndex(), m_channelIndex );
 
-			if( sender->m_hasInput || sender->m_stillRunning )
+			if( sender->m_hasOutput )
 			{
-				// figure out if we're getting sample-exact input
-				ValueBuffer * sendBuf = sendModel->valueBuffer();
-				ValueBuffer * volBuf = sender->m_volumeModel.valueBuffer();
-
-				// mix it's output with this one's output
-				sampleFrame * ch_buf = sender->m_buffer;
-
-				// use sample-exact mixing if sample-exact values are available
-				if( ! volBuf && ! sendBuf ) // neither volume nor send has sample-exact data...
-				{
-					const float v = sender->m_volumeModel.value() * sendModel->value();
-					MixHelpers::addSanitizedMultiplied( m_buffer, ch_buf, v, fpp );
-				}
-				else if( volBuf && sendBuf ) // both volume and send have sample-exact data
-				{
-					MixHelpers::addSanitizedMultipliedByBuffers( m_buffer, ch_buf, volBuf, sendBuf, fpp );
-				}
-				else if( volBuf ) // volume has sample-exact data but send does not
-				{
-					const float v = sendModel->value();
-					MixHelpers::addSanitizedMultipliedByBuffer( m_buffer, ch_buf, v, volBuf, fpp );
-				}
-				else // vice versa
-				{
-					const float v = sender->m_volumeModel.value();
-					MixHelpers::addSanitizedMultipliedByBuffer( m_buffer, ch_buf, v, sendBuf, fpp );
-				}
+				// mix it's output with this one's output, sample-exact if volume or send change
+				MixHelpers::addSanitizedMultipliedBySpans( m_buffer, sender->m_buffer,
+					sender->m_volumeModel.valueSpan(), sendModel->valueSpan(), fpp );
 				m_hasInput = true;
 			}
 		}
@@ -169,11 +160,25 @@ void MixerChannel::doProcessing()
 			m_fxChain.startRunning();
 		}
 
-		m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+		// without input and without effects still sounding, the buffer is
+		// silent and neither the effects nor the peak meters need to see it
+		if( m_hasInput || m_stillRunning )
+		{
+			m_stillRunning = m_fxChain.processAudioBuffer( m_buffer, fpp, m_hasInput );
+			// channels waiting for our detectors get their envelopes right away
+			PeakController::publishEnvelopes( &m_fxChain );
+
+			AudioEngine::StereoSample peakSamples = Engine::audioEngine()->getPeakValues(m_buffer, fpp);
+			m_peakLeft = std::max(m_peakLeft, peakSamples.left * v);
+			m_peakRight = std::max(m_peakRight, peakSamples.right * v);
 
-		AudioEngine::StereoSample peakSamples = Engine::audioEngine()->getPeakValues(m_buffer, fpp);
-		m_peakLeft = std::max(m_peakLeft, peakSamples.left * v);
-		m_peakRight = std::max(m_peakRight, peakSamples.right * v);
+			m_hasOutput = std::max(peakSamples.left, peakSamples.right) >= MixHelpers::SilenceThreshold;
+			if( !m_hasOutput )
+			{
+				// drop whatever is left below the threshold
+				BufferManager::clear( m_buffer, fpp );
+			}
+		}
 	}
 	else
 	{
@@ -190,7 +195,8 @@ Mixer::Mixer() :
 	Model( nullptr ),
 	JournallingObject(),
 	m_mixerChannels(),
-	m_lastSoloed(-1)
+	m_lastSoloed(-1),
+	m_sidechainsValid(false)
 {
 	// create master channel
 	createChannel();
@@ -373,6 +379,9 @@ void Mixer::deleteChannel( int index )
 		}
 	}
 
+	// the deleted channel may have been the source or target of a sidechain
+	invalidateSidechains();
+
 	Engine::audioEngine()->doneChangeInModel();
 }
 
@@ -486,6 +495,7 @@ MixerRoute * Mixer::createRoute( MixerChannel * from, MixerChannel * to, float a
 
 	// add us to mixer's list
 	Engine::mixer()->m_mixerRoutes.push_back(route);
+	invalidateSidechains();
 	Engine::audioEngine()->doneChangeInModel();
 
 	return route;
@@ -531,6 +541,7 @@ void Mixer::deleteChannelSend( MixerRoute * route )
 	removeFromMixerRoute(Engine::mixer()->m_mixerRoutes);
 
 	delete route;
+	invalidateSidechains();
 	Engine::audioEngine()->doneChangeInModel();
 }
 
@@ -596,6 +607,98 @@ FloatModel * Mixer::channelSendModel( mix_ch_t fromChannel, mix_ch_t toChannel )
 
 
 
+void Mixer::updateSidechains()
+{
+	// Runs on the rendering thread, the channels, their effects and the
+	// detectors only change while it waits for the change lock
+	if (m_sidechainsValid.exchange(true)) { return; }
+
+	for (MixerChannel* ch : m_mixerChannels)
+	{
+		ch->m_sidechainTargets.clear();
+		ch->m_sidechainSources = 0;
+	}
+
+	// Walking the models of all channels is only worth it while a detector
+	// runs in a mixer channel, which is rare
+	const auto detectorInMixer = std::any_of(m_mixerChannels.begin(), m_mixerChannels.end(),
+		[](const MixerChannel* ch) { return PeakController::hasDetectorIn(&ch->m_fxChain); });
+	if (!detectorInMixer) { return; }
+
+	for (MixerChannel* ch : m_mixerChannels)
+	{
+		addSidechains(ch, &ch->m_volumeModel);
+		for (MixerRoute* route : ch->m_receives)
+		{
+			addSidechains(ch, route->amount());
+		}
+		for (Effect* effect : ch->m_fxChain.effects())
+		{
+			addSidechains(ch, effect);
+		}
+	}
+}
+
+
+
+
+void Mixer::addSidechains(MixerChannel* target, const QObject* models)
+{
+	const auto model = qobject_cast<const AutomatableModel*>(models);
+	const auto connection = model != nullptr ? model->controllerConnection() : nullptr;
+	if (connection != nullptr && connection->getController()->type() == Controller::ControllerType::Peak)
+	{
+		const auto controller = static_cast<const PeakController*>(connection->getController());
+		MixerChannel* source = channelOf(controller->detectorChain());
+
+		// A target which feeds the detector's channel runs before it anyway
+		// and keeps reading the envelope of the last period
+		if (source != nullptr && !reaches(target, source)
+			&& std::find(source->m_sidechainTargets.begin(), source->m_sidechainTargets.end(), target)
+				== source->m_sidechainTargets.end())
+		{
+			source->m_sidechainTargets.push_back(target);
+			++target->m_sidechainSources;
+		}
+	}
+
+	for (const QObject* child : models->children())
+	{
+		addSidechains(target, child);
+	}
+}
+
+
+
+
+MixerChannel* Mixer::channelOf(const EffectChain* chain) const
+{
+	for (MixerChannel* ch : m_mixerChannels)
+	{
+		if (&ch->m_fxChain == chain) { return ch; }
+	}
+	return nullptr;
+}
+
+
+
+
+bool Mixer::reaches(const MixerChannel* from, const MixerChannel* to) const
+{
+	if (from == to) { return true; }
+	for (const MixerRoute* send : from->m_sends)
+	{
+		if (reaches(send->receiver(), to)) { return true; }
+	}
+	for (const MixerChannel* target : from->m_sidechainTargets)
+	{
+		if (reaches(target, to)) { return true; }
+	}
+	return false;
+}
+
+
+
 void Mixer::mixToChannel( const sampleFrame * _buf, mix_ch_t _ch )
 {
 	if( m_mixerChannels[_ch]->m_muteModel.value() == false )
@@ -629,6 +732,10 @@ void Mixer::masterMix( sampleFrame * _buf )
 	// also instantly add all muted channels as they don't need to care
 	// about their senders, and can just increment the deps of their
 	// recipients right away.
+	// channels driven by peak controllers also wait for the channels
+	// running their detectors.
+	updateSidechains();
+
 	AudioEngineWorkerThread::resetJobQueue( AudioEngineWorkerThread::JobQueue::OperationMode::Dynamic );
 	for( MixerChannel * ch : m_mixerChannels )
 	{
@@ -638,7 +745,7 @@ void Mixer::masterMix( sampleFrame * _buf )
 			ch->processed();
 			ch->done();
 		}
-		else if( ch->m_receives.size() == 0 )
+		else if( ch->m_receives.size() == 0 && ch->m_sidechainSources == 0 )
 		{
 			ch->m_queued = true;
 			AudioEngineWorkerThread::addJob( ch );
@@ -681,16 +788,28 @@ void Mixer::masterMix( sampleFrame * _buf )
 		: m_mixerChannels[0]->m_volumeModel.value();
 	MixHelpers::addSanitizedMultiplied( _buf, m_mixerChannels[0]->m_buffer, v, fpp );
 
-	// clear all channel buffers and
+	// let the audio device route channels to outputs of their own; the
+	// master channel already goes to the regular output
+	AudioDevice * dev = Engine::audioEngine()->audioDev();
+	for( mix_ch_t i = 1; i < numChannels(); ++i )
+	{
+		dev->writeMixerChannel( i, m_mixerChannels[i], fpp );
+	}
+
+	// clear all channel buffers which have been written to and
 	// reset channel process state
 	for( int i = 0; i < numChannels(); ++i)
 	{
-		BufferManager::clear( m_mixerChannels[i]->m_buffer,
-				Engine::audioEngine()->framesPerPeriod() );
+		if( m_mixerChannels[i]->m_hasInput || m_mixerChannels[i]->m_hasOutput )
+		{
+			BufferManager::clear( m_mixerChannels[i]->m_buffer,
+					Engine::audioEngine()->framesPerPeriod() );
+		}
 		m_mixerChannels[i]->reset();
 		m_mixerChannels[i]->m_queued = false;
-		// also reset hasInput
+		// also reset hasInput and hasOutput
 		m_mixerChannels[i]->m_hasInput = false;
+		m_mixerChannels[i]->m_hasOutput = false;
 		m_mixerChannels[i]->m_dependenciesMet = 0;
 	}
 }
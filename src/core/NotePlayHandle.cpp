@@ -71,7 +71,6 @@ NotePlayHandle::NotePlayHandle( InstrumentTrack* instrumentTrack,
 	m_hadChildren( false ),
 	m_muted( false ),
 	m_patternTrack( nullptr ),
-	m_origTempo( Engine::getSong()->getTempo() ),
 	m_origBaseNote( instrumentTrack->baseNote() ),
 	m_frequency( 0 ),
 	m_unpitchedFrequency( 0 ),
@@ -426,7 +425,6 @@ void NotePlayHandle::setFrames( const f_cnt_t _frames )
 	{
 		m_frames = m_instrumentTrack->beatLen( this );
 	}
-	m_origFrames = m_frames;
 }
 
 
@@ -579,7 +577,7 @@ void NotePlayHandle::processTimePos(const TimePos& time, float pitchValue, bool
 
 
 
-void NotePlayHandle::resize( const bpm_t _new_tempo )
+void NotePlayHandle::resize( const float oldFramesPerTick, const float newFramesPerTick )
 {
 	if (origin() == Origin::MidiInput ||
 		(origin() == Origin::NoteStacking && m_parent->origin() == Origin::MidiInput))
@@ -590,14 +588,17 @@ void NotePlayHandle::resize( const bpm_t _new_tempo )
 		return;
 	}
 
-	double completed = m_totalFramesPlayed / (double) m_frames;
-	double new_frames = m_origFrames * m_origTempo / (double) _new_tempo;
-	m_frames = (f_cnt_t)new_frames;
-	m_totalFramesPlayed = (f_cnt_t)( completed * new_frames );
+	// The frames played so far stay as they were, notes of the song may have
+	// been sized across several tempos of the tempo map before
+	if( m_frames > m_totalFramesPlayed )
+	{
+		const double framesLeft = m_frames - m_totalFramesPlayed;
+		m_frames = m_totalFramesPlayed + static_cast<f_cnt_t>( framesLeft * newFramesPerTick / oldFramesPerTick );
+	}
 
 	for (const auto& subNote : m_subNotes)
 	{
-		subNote->resize(_new_tempo);
+		subNote->resize(oldFramesPerTick, newFramesPerTick);
 	}
 }
 
@@ -35,6 +35,7 @@
 #include "AudioEngine.h"
 #include "AutomatableModel.h"
 #include "fftw3.h"
+#include "UserWaveform.h"
 #include "fft_helpers.h"
 
 
@@ -177,28 +178,19 @@ void Oscillator::generateFromFFT(int bands, sample_t* table)
 		s_specBuf[i][1] = 0.0f;
 	}
 	//ifft
-	fftwf_execute(s_ifftPlan);
+	fftwf_execute_dft_c2r(s_ifftPlan, s_specBuf, s_sampleBuffer.data());
 	//normalize and copy to result buffer
 	normalize(s_sampleBuffer.data(), table, OscillatorConstants::WAVETABLE_LENGTH, 2*OscillatorConstants::WAVETABLE_LENGTH + 1);
 }
 
 std::unique_ptr<OscillatorConstants::waveform_t> Oscillator::generateAntiAliasUserWaveTable(const SampleBuffer* sampleBuffer)
 {
-	auto userAntiAliasWaveTable = std::make_unique<OscillatorConstants::waveform_t>();
-	for (int i = 0; i < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++i)
+	auto wave = std::array<float, OscillatorConstants::WAVETABLE_LENGTH>{};
+	for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH; ++i)
 	{
-		// TODO: This loop seems to be doing the same thing for each iteration of the outer loop,
-		// and could probably be moved out of it
-		for (int j = 0; j < OscillatorConstants::WAVETABLE_LENGTH; ++j)
-		{
-			s_sampleBuffer[j] = Oscillator::userWaveSample(
-				sampleBuffer, static_cast<float>(j) / OscillatorConstants::WAVETABLE_LENGTH);
-		}
-		fftwf_execute(s_fftPlan);
-		Oscillator::generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), (*userAntiAliasWaveTable)[i].data());
+		wave[i] = userWaveSample(sampleBuffer, static_cast<float>(i) / OscillatorConstants::WAVETABLE_LENGTH);
 	}
-
-	return userAntiAliasWaveTable;
+	return UserWaveform::generate(wave.data(), OscillatorConstants::WAVETABLE_LENGTH);
 }
 
 
@@ -210,15 +202,16 @@ sample_t Oscillator::s_waveTables
 fftwf_plan Oscillator::s_fftPlan;
 fftwf_plan Oscillator::s_ifftPlan;
 fftwf_complex * Oscillator::s_specBuf;
-std::array<float, OscillatorConstants::WAVETABLE_LENGTH> Oscillator::s_sampleBuffer;
+alignas(64) std::array<float, OscillatorConstants::WAVETABLE_LENGTH> Oscillator::s_sampleBuffer;
 
 
 
 void Oscillator::createFFTPlans()
 {
 	Oscillator::s_specBuf = ( fftwf_complex * ) fftwf_malloc( ( OscillatorConstants::WAVETABLE_LENGTH * 2 + 1 ) * sizeof( fftwf_complex ) );
-	Oscillator::s_fftPlan = fftwf_plan_dft_r2c_1d(OscillatorConstants::WAVETABLE_LENGTH, s_sampleBuffer.data(), s_specBuf, FFTW_MEASURE );
-	Oscillator::s_ifftPlan = fftwf_plan_dft_c2r_1d(OscillatorConstants::WAVETABLE_LENGTH, s_specBuf, s_sampleBuffer.data(), FFTW_MEASURE);
+	// Shared plans, so planning stays serialized with the other FFT users
+	Oscillator::s_fftPlan = realToComplexPlan(OscillatorConstants::WAVETABLE_LENGTH);
+	Oscillator::s_ifftPlan = complexToRealPlan(OscillatorConstants::WAVETABLE_LENGTH);
 	// initialize s_specBuf content to zero, since the values are used in a condition inside generateFromFFT()
 	for (int i = 0; i < OscillatorConstants::WAVETABLE_LENGTH * 2 + 1; i++)
 	{
@@ -229,8 +222,7 @@ void Oscillator::createFFTPlans()
 
 void Oscillator::destroyFFTPlans()
 {
-	fftwf_destroy_plan(s_fftPlan);
-	fftwf_destroy_plan(s_ifftPlan);
+	// The plans themselves belong to the plan cache
 	fftwf_free(s_specBuf);
 }
 
@@ -277,7 +269,7 @@ void Oscillator::generateWaveTables()
 			{
 				Oscillator::s_sampleBuffer[i] = moogSawSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
 			}
-			fftwf_execute(s_fftPlan);
+			fftwf_execute_dft_r2c(s_fftPlan, s_sampleBuffer.data(), s_specBuf);
 			generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), s_waveTables[static_cast<std::size_t>(WaveShape::MoogSaw) - FirstWaveShapeTable][i]);
 		}
 
@@ -288,7 +280,7 @@ void Oscillator::generateWaveTables()
 			{
 				s_sampleBuffer[i] = expSample((float)i / (float)OscillatorConstants::WAVETABLE_LENGTH);
 			}
-			fftwf_execute(s_fftPlan);
+			fftwf_execute_dft_r2c(s_fftPlan, s_sampleBuffer.data(), s_specBuf);
 			generateFromFFT(OscillatorConstants::MAX_FREQ / freqFromWaveTableBand(i), s_waveTables[static_cast<std::size_t>(WaveShape::Exponential) - FirstWaveShapeTable][i]);
 		}
 	};
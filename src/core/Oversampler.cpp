@@ -0,0 +1,232 @@
+/*
+ * Oversampler.cpp - polyphase IIR oversampling for nonlinear processing
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "Oversampler.h"
+
+#include <algorithm>
+#include <array>
+
+#include "hiir/Downsampler2xFpu.h"
+#include "hiir/PolyphaseIir2Designer.h"
+#include "hiir/Upsampler2xFpu.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+//! Up- and downsampling half-band filters of one stage, for all channels
+template<int Coefs>
+class HalfBand
+{
+public:
+	//! \p transition is the width of the transition band relative to the
+	//! higher of the two rates
+	explicit HalfBand(double transition)
+	{
+		double coefs[Coefs];
+		hiir::PolyphaseIir2Designer::compute_coefs_spec_order_tbw(coefs, Coefs, transition);
+		for (auto& up : m_up) { up.set_coefs(coefs); }
+		for (auto& down : m_down) { down.set_coefs(coefs); }
+	}
+
+	void clear()
+	{
+		for (auto& up : m_up) { up.clear_buffers(); }
+		for (auto& down : m_down) { down.clear_buffers(); }
+	}
+
+	//! Writes 2 * \p frames samples to \p out
+	void upsample(int channel, float* out, const float* in, long frames)
+	{
+		m_up[channel].process_block(out, in, frames);
+	}
+
+	//! Reads 2 * \p frames samples from \p in
+	void downsample(int channel, float* out, const float* in, long frames)
+	{
+		m_down[channel].process_block(out, in, frames);
+	}
+
+private:
+	std::array<hiir::Upsampler2xFpu<Coefs>, DEFAULT_CHANNELS> m_up;
+	std::array<hiir::Downsampler2xFpu<Coefs>, DEFAULT_CHANNELS> m_down;
+};
+
+} // namespace
+
+
+
+
+class Oversampler::Filters
+{
+public:
+	void upsample(int stage, int channel, float* out, const float* in, long frames)
+	{
+		switch (stage)
+		{
+			case 0: m_first.upsample(channel, out, in, frames); break;
+			case 1: m_second.upsample(channel, out, in, frames); break;
+			default: m_third.upsample(channel, out, in, frames); break;
+		}
+	}
+
+	void downsample(int stage, int channel, float* out, const float* in, long frames)
+	{
+		switch (stage)
+		{
+			case 0: m_first.downsample(channel, out, in, frames); break;
+			case 1: m_second.downsample(channel, out, in, frames); break;
+			default: m_third.downsample(channel, out, in, frames); break;
+		}
+	}
+
+	void clear()
+	{
+		m_first.clear();
+		m_second.clear();
+		m_third.clear();
+	}
+
+private:
+	// The first stage has to keep everything up to about 20 kHz at 44.1 kHz.
+	// After it, the images start above the original Nyquist frequency, which
+	// leaves a wide transition band to the following stages.
+	HalfBand<12> m_first{0.025};
+	HalfBand<6> m_second{0.125};
+	HalfBand<4> m_third{0.1875};
+};
+
+
+
+
+Oversampler::Oversampler(int stages) :
+	m_filters(std::make_unique<Filters>())
+{
+	setStages(stages);
+}
+
+
+
+
+Oversampler::~Oversampler() = default;
+
+
+
+
+void Oversampler::setStages(int stages)
+{
+	m_stages = std::clamp(stages, 0, MaxStages);
+	reset();
+}
+
+
+
+
+void Oversampler::reset()
+{
+	m_filters->clear();
+}
+
+
+
+
+sampleFrame* Oversampler::upsample(const sampleFrame* in, fpp_t frames)
+{
+	reserve(frames);
+
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		float* src = m_scratch[0].data();
+		float* dst = m_scratch[1].data();
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			src[f] = in[f][ch];
+		}
+
+		long length = frames;
+		for (int stage = 0; stage < m_stages; ++stage)
+		{
+			m_filters->upsample(stage, ch, dst, src, length);
+			std::swap(src, dst);
+			length *= 2;
+		}
+
+		for (long i = 0; i < length; ++i)
+		{
+			m_buffer[i][ch] = src[i];
+		}
+	}
+
+	return m_buffer.data();
+}
+
+
+
+
+void Oversampler::downsample(sampleFrame* out, fpp_t frames)
+{
+	const long total = static_cast<long>(frames) * factor();
+
+	for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		float* src = m_scratch[0].data();
+		float* dst = m_scratch[1].data();
+		for (long i = 0; i < total; ++i)
+		{
+			src[i] = m_buffer[i][ch];
+		}
+
+		long length = total;
+		for (int stage = m_stages - 1; stage >= 0; --stage)
+		{
+			length /= 2;
+			m_filters->downsample(stage, ch, dst, src, length);
+			std::swap(src, dst);
+		}
+
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			out[f][ch] = src[f];
+		}
+	}
+}
+
+
+
+
+void Oversampler::reserve(fpp_t frames)
+{
+	// Only grows when the period size grows, so this does not allocate in
+	// the steady state
+	const auto size = static_cast<std::size_t>(frames) * factor();
+	if (m_buffer.size() < size)
+	{
+		m_buffer.resize(size);
+		m_scratch[0].resize(size);
+		m_scratch[1].resize(size);
+	}
+}
+
+
+} // namespace lmms
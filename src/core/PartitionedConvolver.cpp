@@ -0,0 +1,396 @@
+/*
+ * PartitionedConvolver.cpp - Zero-latency partitioned FFT convolution
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "PartitionedConvolver.h"
+
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+#include "denormals.h"
+#include "fft_helpers.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+struct FftwFree
+{
+	void operator()(float* buffer) const { fftwf_free(buffer); }
+};
+
+using FftwBuffer = std::unique_ptr<float[], FftwFree>;
+
+FftwBuffer allocateZeroed(std::size_t size)
+{
+	auto buffer = FftwBuffer{fftwf_alloc_real(size)};
+	if (!buffer) { throw std::bad_alloc{}; }
+	std::fill_n(buffer.get(), size, 0.f);
+	return buffer;
+}
+
+fftwf_complex* asComplex(float* buffer)
+{
+	return reinterpret_cast<fftwf_complex*>(buffer);
+}
+
+//! acc += x * h for interleaved complex spectra of the given number of bins
+void multiplyAccumulate(const float* x, const float* h, float* acc, int bins)
+{
+	for (int k = 0; k < 2 * bins; k += 2)
+	{
+		acc[k] += x[k] * h[k] - x[k + 1] * h[k + 1];
+		acc[k + 1] += x[k] * h[k + 1] + x[k + 1] * h[k];
+	}
+}
+
+} // namespace
+
+
+
+
+//! Uniformly partitioned overlap-save convolution of one segment of the impulse response.
+//! Each call to process() consumes one block of input and produces the matching block of output.
+class PartitionedConvolver::Stage
+{
+public:
+	explicit Stage(f_cnt_t blockSize) :
+		m_blockSize(blockSize),
+		m_fftSize(2 * blockSize),
+		m_bins(blockSize + 1),
+		// Keep every partition as aligned as the buffers the cached plans were made for
+		m_stride((2 * m_bins + 15) / 16 * 16),
+		m_forward(realToComplexPlan(m_fftSize)),
+		m_inverse(complexToRealPlan(m_fftSize)),
+		m_accumulator(allocateZeroed(m_stride)),
+		m_time(allocateZeroed(m_fftSize))
+	{
+		if (!m_forward || !m_inverse) { throw std::runtime_error{"Failed to create FFT plans for convolution"}; }
+	}
+
+	bool empty() const { return m_partitions == 0; }
+
+	void setImpulseResponse(const sampleFrame* ir, f_cnt_t frames)
+	{
+		m_partitions = (frames + m_blockSize - 1) / m_blockSize;
+		m_delayLinePos = 0;
+
+		if (m_partitions == 0)
+		{
+			for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				m_filter[ch].reset();
+				m_delayLine[ch].reset();
+				m_window[ch].reset();
+			}
+			return;
+		}
+
+		// FFTW does not normalize, so the scaling of the round trip is folded into the filter
+		const float scale = 1.f / m_fftSize;
+
+		for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			m_filter[ch] = allocateZeroed(m_partitions * m_stride);
+			m_delayLine[ch] = allocateZeroed(m_partitions * m_stride);
+			m_window[ch] = allocateZeroed(m_fftSize);
+
+			for (f_cnt_t p = 0; p < m_partitions; ++p)
+			{
+				const auto offset = p * m_blockSize;
+				const auto count = std::min(m_blockSize, frames - offset);
+
+				std::fill_n(m_time.get(), m_fftSize, 0.f);
+				for (f_cnt_t f = 0; f < count; ++f)
+				{
+					m_time[f] = ir[offset + f][ch] * scale;
+				}
+				fftwf_execute_dft_r2c(m_forward, m_time.get(), asComplex(&m_filter[ch][p * m_stride]));
+			}
+		}
+	}
+
+	void reset()
+	{
+		for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			if (!m_window[ch]) { continue; }
+			std::fill_n(m_delayLine[ch].get(), m_partitions * m_stride, 0.f);
+			std::fill_n(m_window[ch].get(), m_fftSize, 0.f);
+		}
+		m_delayLinePos = 0;
+	}
+
+	void process(const sampleFrame* in, sampleFrame* out)
+	{
+		for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			// Slide the window by one block and transform it into the newest slot of the delay line
+			float* window = m_window[ch].get();
+			std::copy(window + m_blockSize, window + m_fftSize, window);
+			for (f_cnt_t f = 0; f < m_blockSize; ++f)
+			{
+				window[m_blockSize + f] = in[f][ch];
+			}
+			fftwf_execute_dft_r2c(m_forward, window, asComplex(&m_delayLine[ch][m_delayLinePos * m_stride]));
+
+			// Partition p of the filter meets the spectrum of the input block from p blocks ago
+			std::fill_n(m_accumulator.get(), 2 * m_bins, 0.f);
+			for (f_cnt_t p = 0; p < m_partitions; ++p)
+			{
+				const auto slot = (m_delayLinePos + m_partitions - p) % m_partitions;
+				multiplyAccumulate(&m_delayLine[ch][slot * m_stride], &m_filter[ch][p * m_stride],
+					m_accumulator.get(), m_bins);
+			}
+
+			// The first half of the result is circular aliasing, the second half is the output
+			fftwf_execute_dft_c2r(m_inverse, asComplex(m_accumulator.get()), m_time.get());
+			for (f_cnt_t f = 0; f < m_blockSize; ++f)
+			{
+				out[f][ch] = m_time[m_blockSize + f];
+			}
+		}
+
+		m_delayLinePos = (m_delayLinePos + 1) % m_partitions;
+	}
+
+private:
+	const f_cnt_t m_blockSize;
+	const f_cnt_t m_fftSize;
+	const int m_bins;
+	const f_cnt_t m_stride; //!< Floats per spectrum
+
+	fftwf_plan m_forward;
+	fftwf_plan m_inverse;
+
+	f_cnt_t m_partitions = 0;
+	f_cnt_t m_delayLinePos = 0;
+
+	std::array<FftwBuffer, DEFAULT_CHANNELS> m_filter;
+	std::array<FftwBuffer, DEFAULT_CHANNELS> m_delayLine;
+	std::array<FftwBuffer, DEFAULT_CHANNELS> m_window;
+	FftwBuffer m_accumulator;
+	FftwBuffer m_time;
+};
+
+
+
+
+PartitionedConvolver::PartitionedConvolver() :
+	m_directTaps(HeadBlockSize),
+	m_directHistory(2 * HeadBlockSize),
+	m_head(std::make_unique<Stage>(HeadBlockSize)),
+	m_headInput(HeadBlockSize),
+	m_headOutput(HeadBlockSize),
+	m_tail(std::make_unique<Stage>(TailBlockSize)),
+	m_tailInput(TailBlockSize),
+	m_tailOutput(TailBlockSize),
+	m_tailJobInput(TailBlockSize),
+	m_tailJobOutput(TailBlockSize)
+{
+}
+
+
+
+
+PartitionedConvolver::~PartitionedConvolver()
+{
+	stopTail();
+}
+
+
+
+
+void PartitionedConvolver::setImpulseResponse(const sampleFrame* ir, f_cnt_t frames)
+{
+	stopTail();
+
+	m_length = frames;
+
+	const auto segment = [frames](f_cnt_t begin, f_cnt_t end) -> f_cnt_t
+	{
+		return std::max<f_cnt_t>(std::min(frames, end), begin) - begin;
+	};
+
+	std::fill(m_directTaps.begin(), m_directTaps.end(), sampleFrame{});
+	for (f_cnt_t f = 0; f < segment(0, HeadBlockSize); ++f)
+	{
+		m_directTaps[HeadBlockSize - 1 - f] = ir[f];
+	}
+
+	const auto headFrames = segment(HeadBlockSize, TailOffset);
+	m_head->setImpulseResponse(headFrames > 0 ? ir + HeadBlockSize : nullptr, headFrames);
+
+	const auto tailFrames = segment(TailOffset, frames);
+	m_tail->setImpulseResponse(tailFrames > 0 ? ir + TailOffset : nullptr, tailFrames);
+
+	reset();
+
+	if (!m_tail->empty()) { startTail(); }
+}
+
+
+
+
+void PartitionedConvolver::reset()
+{
+	std::unique_lock<std::mutex> lock(m_tailMutex);
+	m_tailCondition.wait(lock, [this] { return !m_tailPending; });
+
+	const auto clear = [](std::vector<sampleFrame>& buffer)
+	{
+		std::fill(buffer.begin(), buffer.end(), sampleFrame{});
+	};
+
+	clear(m_directHistory);
+	clear(m_headInput);
+	clear(m_headOutput);
+	clear(m_tailInput);
+	clear(m_tailOutput);
+	clear(m_tailJobInput);
+	clear(m_tailJobOutput);
+	m_directPos = 0;
+	m_headPos = 0;
+	m_tailPos = 0;
+
+	m_head->reset();
+	m_tail->reset();
+}
+
+
+
+
+void PartitionedConvolver::process(const sampleFrame* in, sampleFrame* out, fpp_t frames)
+{
+	const bool hasHead = !m_head->empty();
+	const bool hasTail = m_tailThread.joinable();
+
+	for (fpp_t f = 0; f < frames; ++f)
+	{
+		const auto input = in[f];
+
+		m_directHistory[m_directPos] = input;
+		m_directHistory[m_directPos + HeadBlockSize] = input;
+		const sampleFrame* window = &m_directHistory[m_directPos + 1];
+
+		auto output = sampleFrame{};
+		for (f_cnt_t tap = 0; tap < HeadBlockSize; ++tap)
+		{
+			output[0] += m_directTaps[tap][0] * window[tap][0];
+			output[1] += m_directTaps[tap][1] * window[tap][1];
+		}
+		m_directPos = (m_directPos + 1) % HeadBlockSize;
+
+		output[0] += m_headOutput[m_headPos][0] + m_tailOutput[m_tailPos][0];
+		output[1] += m_headOutput[m_headPos][1] + m_tailOutput[m_tailPos][1];
+		out[f] = output;
+
+		m_headInput[m_headPos] = input;
+		m_tailInput[m_tailPos] = input;
+
+		// A finished input block is convolved with the segment that starts one block later, so its result is
+		// complete before the first output frame it contributes to
+		if (++m_headPos == HeadBlockSize)
+		{
+			if (hasHead) { m_head->process(m_headInput.data(), m_headOutput.data()); }
+			m_headPos = 0;
+		}
+
+		if (++m_tailPos == TailBlockSize)
+		{
+			if (hasTail) { exchangeTailBlock(); }
+			m_tailPos = 0;
+		}
+	}
+}
+
+
+
+
+void PartitionedConvolver::exchangeTailBlock()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_tailMutex);
+		m_tailCondition.wait(lock, [this] { return !m_tailPending; });
+
+		// The finished job holds the tail for the next block; the block that just ended is due one block later
+		std::swap(m_tailOutput, m_tailJobOutput);
+		std::swap(m_tailInput, m_tailJobInput);
+		m_tailPending = true;
+	}
+	m_tailCondition.notify_all();
+}
+
+
+
+
+void PartitionedConvolver::startTail()
+{
+	m_tailQuit = false;
+	m_tailPending = false;
+	m_tailThread = std::thread(&PartitionedConvolver::runTail, this);
+}
+
+
+
+
+void PartitionedConvolver::stopTail()
+{
+	if (!m_tailThread.joinable()) { return; }
+
+	{
+		std::lock_guard<std::mutex> lock(m_tailMutex);
+		m_tailQuit = true;
+	}
+	m_tailCondition.notify_all();
+	m_tailThread.join();
+
+	m_tailPending = false;
+}
+
+
+
+
+void PartitionedConvolver::runTail()
+{
+	disable_denormals();
+
+	std::unique_lock<std::mutex> lock(m_tailMutex);
+	while (true)
+	{
+		m_tailCondition.wait(lock, [this] { return m_tailPending || m_tailQuit; });
+		if (m_tailQuit) { return; }
+
+		// The job buffers belong to this thread until m_tailPending is cleared
+		lock.unlock();
+		m_tail->process(m_tailJobInput.data(), m_tailJobOutput.data());
+		lock.lock();
+
+		m_tailPending = false;
+		m_tailCondition.notify_all();
+	}
+}
+
+
+} // namespace lmms
@@ -25,13 +25,14 @@
 
 #include "PeakController.h"
 
-#include <cmath>
+#include <algorithm>
 
 #include <QDomElement>
 #include <QMessageBox>
 
 #include "AudioEngine.h"
 #include "EffectChain.h"
+#include "Mixer.h"
 #include "plugins/PeakControllerEffect/PeakControllerEffect.h"
 
 namespace lmms
@@ -48,7 +49,7 @@ PeakController::PeakController( Model * _parent,
 		PeakControllerEffect * _peak_effect ) :
 	Controller( ControllerType::Peak, _parent, tr( "Peak Controller" ) ),
 	m_peakEffect( _peak_effect ),
-	m_currentSample( 0.0f )
+	m_publishedPeriod( -1 )
 {
 	setSampleExact( true );
 	if( m_peakEffect )
@@ -56,12 +57,6 @@ PeakController::PeakController( Model * _parent,
 		connect( m_peakEffect, SIGNAL(destroyed()),
 			this, SLOT(handleDestroyedEffect()));
 	}
-	connect( Engine::audioEngine(), SIGNAL(sampleRateChanged()), this, SLOT(updateCoeffs()));
-	connect( m_peakEffect->attackModel(), SIGNAL(dataChanged()),
-			this, SLOT(updateCoeffs()), Qt::DirectConnection );
-	connect( m_peakEffect->decayModel(), SIGNAL(dataChanged()),
-			this, SLOT(updateCoeffs()), Qt::DirectConnection );
-	m_coeffNeedsUpdate = true;
 }
 
 
@@ -78,52 +73,73 @@ PeakController::~PeakController()
 
 void PeakController::updateValueBuffer()
 {
-	if( m_coeffNeedsUpdate )
+	// The detector measures the envelope while the audio graph runs and
+	// hands it over in publishEnvelopes(), until then models get the one of
+	// the last period. Without a new one, hold the last value.
+	if( m_publishedPeriod != s_periods - 1 )
 	{
-		const float ratio = 44100.0f / Engine::audioEngine()->processingSampleRate();
-		m_attackCoeff = 1.0f - powf( 2.0f, -0.3f * ( 1.0f - m_peakEffect->attackModel()->value() ) * ratio );
-		m_decayCoeff = 1.0f -  powf( 2.0f, -0.3f * ( 1.0f - m_peakEffect->decayModel()->value()  ) * ratio );
-		m_coeffNeedsUpdate = false;
+		m_valueBuffer.fill( m_peakEffect ? m_peakEffect->lastSample() : 0.0f );
 	}
+	m_bufferLastUpdated = s_periods;
+}
 
-	if( m_peakEffect )
-	{
-		float targetSample = m_peakEffect->lastSample();
-		if( m_currentSample != targetSample )
-		{
-			const f_cnt_t frames = Engine::audioEngine()->framesPerPeriod();
-			float * values = m_valueBuffer.values();
 
-			for( f_cnt_t f = 0; f < frames; ++f )
-			{
-				const float diff = ( targetSample - m_currentSample );
-				if( m_currentSample < targetSample ) // going up...
-				{
-					m_currentSample += diff * m_attackCoeff;
-				}
-				else if( m_currentSample > targetSample ) // going down
-				{
-					m_currentSample += diff * m_decayCoeff;
-				}
-				values[f] = m_currentSample;
-			}
-		}
-		else
+
+const EffectChain* PeakController::detectorChain() const
+{
+	return m_peakEffect ? m_peakEffect->effectChain() : nullptr;
+}
+
+
+
+void PeakController::publishEnvelopes(const EffectChain* chain)
+{
+	for (PeakControllerEffect* effect : s_effects)
+	{
+		PeakController* controller = effect->controller();
+		if ((chain != nullptr && effect->effectChain() != chain)
+			|| effect->envelopePeriod() != s_periods || controller->m_publishedPeriod == s_periods)
 		{
-			m_valueBuffer.fill( m_currentSample );
+			continue;
 		}
+
+		const auto& envelope = effect->envelope();
+		std::copy_n(envelope.begin(), std::min<std::size_t>(envelope.size(), controller->m_valueBuffer.size()),
+			controller->m_valueBuffer.begin());
+		controller->m_publishedPeriod = s_periods;
+		controller->m_bufferLastUpdated = s_periods;
 	}
-	else
-	{
-		m_valueBuffer.fill( 0 );
-	}
-	m_bufferLastUpdated = s_periods;
 }
 
 
-void PeakController::updateCoeffs()
+bool PeakController::hasDetectorIn(const EffectChain* chain)
+{
+	return chain != nullptr && std::any_of(s_effects.begin(), s_effects.end(),
+		[chain](const PeakControllerEffect* effect) { return effect->effectChain() == chain; });
+}
+
+
+
+void PeakController::addDetector(PeakControllerEffect* effect)
+{
+	const auto guard = Engine::audioEngine()->requestChangesGuard();
+	s_effects.push_back(effect);
+	if (Engine::mixer()) { Engine::mixer()->invalidateSidechains(); }
+}
+
+
+
+bool PeakController::removeDetector(PeakControllerEffect* effect)
 {
-	m_coeffNeedsUpdate = true;
+	const auto guard = Engine::audioEngine()
+		? Engine::audioEngine()->requestChangesGuard()
+		: AudioEngine::RequestChangesGuard{};
+	const auto it = std::find(s_effects.begin(), s_effects.end(), effect);
+	if (it == s_effects.end()) { return false; }
+
+	s_effects.erase(it);
+	if (Engine::mixer()) { Engine::mixer()->invalidateSidechains(); }
+	return true;
 }
 
 
@@ -25,6 +25,8 @@
 
 #include <QFile>
 
+#include <algorithm>
+
 #include "ProjectRenderer.h"
 #include "Song.h"
 #include "PerfLog.h"
@@ -82,27 +84,58 @@ ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySe
 					const OutputSettings & outputSettings,
 					ExportFileFormat exportFileFormat,
 					const QString & outputFilename ) :
+	ProjectRenderer( qualitySettings, { Output{ exportFileFormat, outputSettings, outputFilename } } )
+{
+}
+
+
+
+
+ProjectRenderer::ProjectRenderer( const AudioEngine::qualitySettings & qualitySettings,
+					const std::vector<Output> & outputs ) :
 	QThread( Engine::audioEngine() ),
 	m_fileDev( nullptr ),
 	m_qualitySettings( qualitySettings ),
 	m_progress( 0 ),
 	m_abort( false )
 {
-	AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(exportFileFormat)].m_getDevInst;
-
-	if (audioEncoderFactory)
+	std::vector<std::unique_ptr<AudioFileDevice>> fileDevs;
+	for( const auto & output : outputs )
 	{
-		bool successful = false;
+		AudioFileDeviceInstantiaton audioEncoderFactory = fileEncodeDevices[static_cast<std::size_t>(output.format)].m_getDevInst;
 
-		m_fileDev = audioEncoderFactory(
-					outputFilename, outputSettings, DEFAULT_CHANNELS,
-					Engine::audioEngine(), successful );
+		bool successful = false;
+		auto fileDev = std::unique_ptr<AudioFileDevice>( audioEncoderFactory ?
+			audioEncoderFactory( output.file, output.settings, DEFAULT_CHANNELS,
+						Engine::audioEngine(), successful ) : nullptr );
 		if( !successful )
 		{
-			delete m_fileDev;
-			m_fileDev = nullptr;
+			// export all files or none, don't leave the others behind
+			for( auto & created : fileDevs )
+			{
+				const QString f = created->outputFile();
+				created.reset();
+				QFile( f ).remove();
+			}
+			return;
 		}
+		fileDevs.push_back( std::move( fileDev ) );
 	}
+
+	if( fileDevs.empty() )
+	{
+		return;
+	}
+
+	// render at the highest sample rate, the other outputs resample down
+	const auto primary = std::max_element( fileDevs.begin(), fileDevs.end(),
+		[]( const std::unique_ptr<AudioFileDevice> & a, const std::unique_ptr<AudioFileDevice> & b )
+		{
+			return a->sampleRate() < b->sampleRate();
+		} );
+	m_fileDev = primary->release();
+	fileDevs.erase( primary );
+	m_extraFileDevs = std::move( fileDevs );
 }
 
 
@@ -174,6 +207,10 @@ void ProjectRenderer::run()
 	PerfLogTimer perfLog("Project Render");
 
 	Engine::getSong()->startExport();
+
+	// The audio engine hands out each period while rendering the next one,
+	// so remember where the period being rendered starts
+	f_cnt_t framesLeft = Engine::getSong()->exportFramesLeft();
 	// Skip first empty buffer.
 	Engine::audioEngine()->nextBuffer();
 
@@ -181,11 +218,36 @@ void ProjectRenderer::run()
 
 	// Now start processing
 	Engine::audioEngine()->startProcessing(false);
+	for( const auto & fileDev : m_extraFileDevs )
+	{
+		fileDev->startProcessing();
+	}
+
+	const auto encodeNextBuffer = [this, &framesLeft]()
+	{
+		const f_cnt_t nextFramesLeft = Engine::getSong()->exportFramesLeft();
+		const surroundSampleFrame * buffer = Engine::audioEngine()->nextBuffer();
+		if( buffer )
+		{
+			// the last period mostly reaches beyond the end, which adds up
+			// with large periods and would lengthen exported loops
+			const fpp_t frames = static_cast<fpp_t>( std::min<f_cnt_t>(
+					Engine::audioEngine()->framesPerPeriod(), framesLeft ) );
+			// encoding runs on the thread of the device meanwhile
+			const float masterGain = Engine::audioEngine()->masterGain();
+			m_fileDev->enqueue( buffer, frames, masterGain );
+			for( const auto & fileDev : m_extraFileDevs )
+			{
+				fileDev->enqueue( buffer, frames, masterGain );
+			}
+		}
+		framesLeft = nextFramesLeft;
+	};
 
 	// Continually track and emit progress percentage to listeners.
 	while (!Engine::getSong()->isExportDone() && !m_abort)
 	{
-		m_fileDev->processNextBuffer();
+		encodeNextBuffer();
 		const int nprog = Engine::getSong()->getExportProgress();
 		if (m_progress != nprog)
 		{
@@ -194,18 +256,31 @@ void ProjectRenderer::run()
 		}
 	}
 
+	// The period reaching the end has been rendered, but not handed out yet
+	if( !m_abort )
+	{
+		encodeNextBuffer();
+	}
+
 	// Notify the audio engine of the end of processing.
 	Engine::audioEngine()->stopProcessing();
+	for( const auto & fileDev : m_extraFileDevs )
+	{
+		fileDev->stopProcessing();
+	}
 
 	Engine::getSong()->stopExport();
 
 	perfLog.end();
 
-	// If the user aborted export-process, the file has to be deleted.
-	const QString f = m_fileDev->outputFile();
+	// If the user aborted export-process, the files have to be deleted.
 	if( m_abort )
 	{
-		QFile( f ).remove();
+		QFile( m_fileDev->outputFile() ).remove();
+		for( const auto & fileDev : m_extraFileDevs )
+		{
+			QFile( fileDev->outputFile() ).remove();
+		}
 	}
 }
 
@@ -39,11 +39,16 @@ RenderManager::RenderManager(
 		const OutputSettings & outputSettings,
 		ProjectRenderer::ExportFileFormat fmt,
 		QString outputPath) :
+	RenderManager(qualitySettings, {ProjectRenderer::Output{fmt, outputSettings, outputPath}})
+{
+}
+
+RenderManager::RenderManager(
+		const AudioEngine::qualitySettings & qualitySettings,
+		std::vector<ProjectRenderer::Output> outputs) :
 	m_qualitySettings(qualitySettings),
 	m_oldQualitySettings( Engine::audioEngine()->currentQualitySettings() ),
-	m_outputSettings(outputSettings),
-	m_format(fmt),
-	m_outputPath(outputPath)
+	m_outputs(std::move(outputs))
 {
 	Engine::audioEngine()->storeAudioDevice();
 }
@@ -90,7 +95,12 @@ void RenderManager::renderNextTrack()
 		// for multi-render, prefix each output file with a different number
 		int trackNum = m_tracksToRender.size() + 1;
 
-		render( pathForTrack(renderTrack, trackNum) );
+		auto outputs = m_outputs;
+		for (auto& output : outputs)
+		{
+			output.file = pathForTrack(output, renderTrack, trackNum);
+		}
+		render(outputs);
 	}
 }
 
@@ -135,16 +145,14 @@ void RenderManager::renderTracks()
 // Render the song into a single track
 void RenderManager::renderProject()
 {
-	render( m_outputPath );
+	render( m_outputs );
 }
 
-void RenderManager::render(QString outputPath)
+void RenderManager::render(const std::vector<ProjectRenderer::Output>& outputs)
 {
 	m_activeRenderer = std::make_unique<ProjectRenderer>(
 			m_qualitySettings,
-			m_outputSettings,
-			m_format,
-			outputPath);
+			outputs);
 
 	if( m_activeRenderer->isReady() )
 	{
@@ -178,13 +186,13 @@ void RenderManager::restoreMutedState()
 }
 
 // Determine the output path for a track when rendering tracks individually
-QString RenderManager::pathForTrack(const Track *track, int num)
+QString RenderManager::pathForTrack(const ProjectRenderer::Output& output, const Track *track, int num)
 {
-	QString extension = ProjectRenderer::getFileExtensionFromFormat( m_format );
+	QString extension = ProjectRenderer::getFileExtensionFromFormat( output.format );
 	QString name = track->name();
 	name = name.remove(QRegExp(FILENAME_FILTER));
 	name = QString( "%1_%2%3" ).arg( num ).arg( name ).arg( extension );
-	return QDir(m_outputPath).filePath(name);
+	return QDir(output.file).filePath(name);
 }
 
 void RenderManager::updateConsoleProgress()
@@ -92,6 +92,7 @@ void SamplePlayHandle::play( sampleFrame * buffer )
 	if( framesDone() >= totalFrames() )
 	{
 		memset( buffer, 0, sizeof( sampleFrame ) * fpp );
+		setBufferSilent( true );
 		return;
 	}
 
@@ -117,8 +118,14 @@ void SamplePlayHandle::play( sampleFrame * buffer )
 		if (!m_sample->play(workingBuffer, &m_state, frames, DefaultBaseFreq))
 		{
 			memset(workingBuffer, 0, frames * sizeof(sampleFrame));
+			setBufferSilent(true);
 		}
 	}
+	else
+	{
+		// the buffer has been cleared before playing
+		setBufferSilent(true);
+	}
 
 	m_frame += frames;
 }
@@ -31,7 +31,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <limits>
 
+#include "AutomationClip.h"
 #include "AutomationTrack.h"
 #include "AutomationEditor.h"
 #include "ConfigManager.h"
@@ -97,7 +99,12 @@ Song::Song() :
 	m_elapsedBars( 0 ),
 	m_loopRenderCount(1),
 	m_loopRenderRemaining(1),
-	m_oldAutomatedValues()
+	m_oldAutomatedValues(),
+	m_tempoMap(std::make_shared<TempoMap>(Engine::audioEngine()->processingSampleRate(), DefaultTempo)),
+	m_tempoMapOutdatedFrom(std::numeric_limits<tick_t>::max()),
+	m_tempoMapUpdatePending(false),
+	m_tempoAutomated(false),
+	m_playbackTempoMap(m_tempoMap)
 {
 	for (double& millisecondsElapsed : m_elapsedMilliSeconds) { millisecondsElapsed = 0; }
 	connect( &m_tempoModel, SIGNAL(dataChanged()),
@@ -145,31 +152,137 @@ void Song::masterVolumeChanged()
 
 void Song::setTempo()
 {
-	Engine::audioEngine()->requestChangeInModel();
 	const auto tempo = (bpm_t)m_tempoModel.value();
-	PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
-	for (const auto& playHandle : playHandles)
-	{
-		auto nph = dynamic_cast<NotePlayHandle*>(playHandle);
-		if( nph && !nph->isReleased() )
+
+	// Notes started while playing the song are sized along the tempo map already, only tempo changes it didn't
+	// see coming have to resize them
+	const bool mapped = m_playing && m_playMode == PlayMode::Song
+		&& tempoMap()->tempoAt(getPlayPos(PlayMode::Song).getTicks()) == tempo;
+	if (!mapped)
+	{
+		// Engine::framesPerTick() still follows the old tempo
+		const auto oldFramesPerTick = Engine::framesPerTick();
+		const auto newFramesPerTick = Engine::framesPerTick(Engine::audioEngine()->processingSampleRate());
+		Engine::audioEngine()->requestChangeInModel();
+		PlayHandleList & playHandles = Engine::audioEngine()->playHandles();
+		for (const auto& playHandle : playHandles)
 		{
-			nph->lock();
-			nph->resize( tempo );
-			nph->unlock();
+			auto nph = dynamic_cast<NotePlayHandle*>(playHandle);
+			if( nph && !nph->isReleased() )
+			{
+				nph->lock();
+				nph->resize( oldFramesPerTick, newFramesPerTick );
+				nph->unlock();
+			}
 		}
+		Engine::audioEngine()->doneChangeInModel();
 	}
-	Engine::audioEngine()->doneChangeInModel();
 
 	Engine::updateFramesPerTick();
 
 	m_vstSyncController.setTempo( tempo );
 
+	// While playing, tempo automation overrides other changes at its next value already
+	if (!m_playing || !m_tempoAutomated) { invalidateTempoMap(); }
+
 	emit tempoChanged( tempo );
 }
 
 
 
 
+void Song::invalidateTempoMap(tick_t tick)
+{
+	auto outdatedFrom = m_tempoMapOutdatedFrom.load();
+	while (tick < outdatedFrom && !m_tempoMapOutdatedFrom.compare_exchange_weak(outdatedFrom, tick)) {}
+
+	// Edits come in bursts, e.g. while drawing automation, so they are merged into one update
+	if (!m_tempoMapUpdatePending.exchange(true))
+	{
+		QMetaObject::invokeMethod(this, "updateTempoMap", Qt::QueuedConnection);
+	}
+}
+
+
+
+
+void Song::updateTempoMap()
+{
+	m_tempoMapUpdatePending = false;
+
+	// Projects are mapped once they are loaded completely
+	if (m_loadingProject) { return; }
+
+	const auto outdatedFrom = m_tempoMapOutdatedFrom.exchange(std::numeric_limits<tick_t>::max());
+	if (outdatedFrom == std::numeric_limits<tick_t>::max()) { return; }
+	const auto from = std::max(outdatedFrom, 0);
+
+	// The tempo clips in the order automatedValuesAt() lets them take over: by position, and by track for clips
+	// starting together
+	auto clips = std::vector<const AutomationClip*>{};
+	auto end = from;
+	const auto addClips = [&](const Track* track)
+	{
+		if (track->isMuted()) { return; }
+		for (const auto clip : track->getClips())
+		{
+			const auto automationClip = dynamic_cast<const AutomationClip*>(clip);
+			if (automationClip && !clip->isMuted() && automationClip->hasAutomation()
+				&& automationClip->automates(&m_tempoModel))
+			{
+				clips.push_back(automationClip);
+				end = std::max(end, clip->endPosition().getTicks());
+			}
+		}
+	};
+	addClips(m_globalAutomationTrack);
+	for (const auto track : tracks())
+	{
+		if (track->type() == Track::Type::Automation || track->type() == Track::Type::HiddenAutomation)
+		{
+			addClips(track);
+		}
+	}
+	std::stable_sort(clips.begin(), clips.end(), Clip::comparePosition);
+
+	const auto tempoOf = [this](const AutomationClip* clip, tick_t tick)
+	{
+		auto relTime = TimePos{tick - clip->startPosition().getTicks()};
+		if (!clip->getAutoResize()) { relTime = std::min(relTime, clip->length()); }
+		return static_cast<bpm_t>(std::clamp(clip->valueAt(relTime),
+			m_tempoModel.minValue<float>(), m_tempoModel.maxValue<float>()));
+	};
+
+	auto map = std::make_shared<TempoMap>(*tempoMap());
+
+	// Before the first tempo clip, the song plays at the tempo it had when playback started
+	const auto baseTempo = m_playing && m_tempoAutomated ? map->tempoAt(0) : getTempo();
+
+	// Automation is applied once per tick, and the values of the clips hold until the next clip starts
+	auto next = clips.begin();
+	const AutomationClip* current = nullptr;
+	for (auto tick = from; tick <= end; ++tick)
+	{
+		for (; next != clips.end() && (*next)->startPosition() <= tick; ++next) { current = *next; }
+		map->setTempo(tick, current ? tempoOf(current, tick) : baseTempo);
+	}
+
+	m_tempoAutomated = !clips.empty();
+	std::atomic_store(&m_tempoMap, std::shared_ptr<const TempoMap>{std::move(map)});
+}
+
+
+
+
+void Song::rebuildTempoMap()
+{
+	m_tempoMapOutdatedFrom = 0;
+	updateTempoMap();
+}
+
+
+
+
 void Song::setTimeSignature()
 {
 	TimePos::setTicksPerBar( ticksPerBar() );
@@ -199,6 +312,8 @@ void Song::processNextBuffer()
 	// If nothing is playing, there is nothing to do
 	if (!m_playing) { return; }
 
+	m_playbackTempoMap = tempoMap();
+
 	// At the beginning of the song, we have to reset the LFOs
 	if (m_playMode == PlayMode::Song && getPlayPos() == 0)
 	{
@@ -267,13 +382,14 @@ void Song::processNextBuffer()
 		getPlayPos().setJumped(false);
 	}
 
-	const auto framesPerTick = Engine::framesPerTick();
 	const auto framesPerPeriod = Engine::audioEngine()->framesPerPeriod();
 
 	f_cnt_t frameOffsetInPeriod = 0;
 
 	while (frameOffsetInPeriod < framesPerPeriod)
 	{
+		// Ticks last as long as the tempo at their start makes them last, like in the tempo map
+		auto framesPerTick = Engine::framesPerTick();
 		auto frameOffsetInTick = getPlayPos().currentFrame();
 
 		// If a whole tick has elapsed, update the frame and tick count, and check any loops
@@ -316,6 +432,14 @@ void Song::processNextBuffer()
 		}
 
 		const f_cnt_t framesUntilNextPeriod = framesPerPeriod - frameOffsetInPeriod;
+		const bool tickStarts = static_cast<f_cnt_t>(frameOffsetInTick) == 0;
+		if (tickStarts)
+		{
+			// First frame of tick: process automation, which may change the tempo of this tick already
+			processAutomations(trackList, getPlayPos(), framesUntilNextPeriod, frameOffsetInPeriod);
+			framesPerTick = Engine::framesPerTick();
+		}
+
 		const auto framesUntilNextTick = static_cast<f_cnt_t>(std::ceil(framesPerTick - frameOffsetInTick));
 
 		// We want to proceed to the next buffer or tick, whichever is closer
@@ -331,10 +455,8 @@ void Song::processNextBuffer()
 			m_vstSyncController.update();
 		}
 
-		if (static_cast<f_cnt_t>(frameOffsetInTick) == 0)
+		if (tickStarts)
 		{
-			// First frame of tick: process automation and play tracks
-			processAutomations(trackList, getPlayPos(), framesToPlay);
 			for (const auto track : trackList)
 			{
 				track->play(getPlayPos(), framesToPlay, frameOffsetInPeriod, clipNum);
@@ -352,7 +474,7 @@ void Song::processNextBuffer()
 }
 
 
-void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp_t)
+void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp_t, f_cnt_t frameOffset)
 {
 	AutomatedValueMap values;
 
@@ -420,7 +542,7 @@ void Song::processAutomations(const TrackList &tracklist, TimePos timeStart, fpp
 	{
 		if (! recordedModels.contains(it.key()))
 		{
-			it.key()->setAutomatedValue(it.value());
+			it.key()->setAutomatedValue(it.value(), frameOffset);
 		}
 		else if (!it.key()->useControllerValue())
 		{
@@ -443,10 +565,20 @@ bool Song::isExportDone() const
 	return !isExporting() || getPlayPos() >= m_exportSongEnd;
 }
 
+f_cnt_t Song::exportFramesLeft() const
+{
+	if (!isExporting() || m_loopRenderRemaining > 1) { return std::numeric_limits<f_cnt_t>::max(); }
+
+	const auto map = tempoMap();
+	const auto framesLeft = std::ceil(map->frames(m_exportSongEnd.getTicks()) - map->frames(getPlayPos().getTicks())
+		- getPlayPos().currentFrame());
+	return static_cast<f_cnt_t>(std::clamp(framesLeft, 0.0, static_cast<double>(std::numeric_limits<f_cnt_t>::max())));
+}
+
 int Song::getExportProgress() const
 {
 	TimePos pos = getPlayPos();
-    
+
 	if (pos >= m_exportSongEnd)
 	{
 		return 100;
@@ -455,22 +587,32 @@ int Song::getExportProgress() const
 	{
 		return 0;
 	}
-	else if (pos >= m_exportLoopEnd)
+
+	// Progress in frames, bars of a faster tempo take less time to render
+	const auto map = tempoMap();
+	const auto songBegin = map->frames(m_exportSongBegin.getTicks());
+	const auto loopBegin = map->frames(m_exportLoopBegin.getTicks());
+	const auto loopEnd = map->frames(m_exportLoopEnd.getTicks());
+	const auto songEnd = map->frames(m_exportSongEnd.getTicks());
+	const auto position = map->frames(pos.getTicks());
+
+	double done;
+	if (pos >= m_exportLoopEnd)
 	{
-		pos = (m_exportLoopBegin-m_exportSongBegin) + (m_exportLoopEnd - m_exportLoopBegin) *
-			m_loopRenderCount + (pos - m_exportLoopEnd);
+		done = (loopBegin - songBegin) + (loopEnd - loopBegin) * m_loopRenderCount + (position - loopEnd);
 	}
-	else if ( pos >= m_exportLoopBegin )
+	else if (pos >= m_exportLoopBegin)
 	{
-		pos = (m_exportLoopBegin-m_exportSongBegin) + ((m_exportLoopEnd - m_exportLoopBegin) *
-			(m_loopRenderCount - m_loopRenderRemaining)) + (pos - m_exportLoopBegin);
+		done = (loopBegin - songBegin) + (loopEnd - loopBegin) * (m_loopRenderCount - m_loopRenderRemaining)
+			+ (position - loopBegin);
 	}
 	else
 	{
-		pos = (pos - m_exportSongBegin);
+		done = position - songBegin;
 	}
 
-	return (float)pos/(float)m_exportEffectiveLength*100.0f;
+	const auto length = (loopBegin - songBegin) + (loopEnd - loopBegin) * m_loopRenderCount + (songEnd - loopEnd);
+	return static_cast<int>(done / length * 100.0);
 }
 
 void Song::playSong()
@@ -482,6 +624,9 @@ void Song::playSong()
 		stop();
 	}
 
+	// Muting tracks doesn't update the tempo map
+	rebuildTempoMap();
+
 	m_playMode = PlayMode::Song;
 	m_playing = true;
 	m_paused = false;
@@ -740,8 +885,6 @@ void Song::startExport()
 		getPlayPos(PlayMode::Song).setTicks( 0 );
 	}
 
-	m_exportEffectiveLength = (m_exportLoopBegin - m_exportSongBegin) + (m_exportLoopEnd - m_exportLoopBegin) 
-		* m_loopRenderCount + (m_exportSongEnd - m_exportLoopEnd);
 	m_loopRenderRemaining = m_loopRenderCount;
 
 	playSong();
@@ -964,6 +1107,7 @@ void Song::createNewProject()
 	QCoreApplication::instance()->processEvents();
 
 	m_loadingProject = false;
+	rebuildTempoMap();
 
 	Engine::patternStore()->updateAfterTrackAdd();
 
@@ -1207,6 +1351,7 @@ void Song::loadProject( const QString & fileName )
 	}
 
 	m_loadingProject = false;
+	rebuildTempoMap();
 	setModified(false);
 	m_loadOnLaunch = false;
 }
@@ -1404,6 +1549,10 @@ void Song::exportProjectMidi(QString const & exportFileName) const
 void Song::updateFramesPerTick()
 {
 	Engine::updateFramesPerTick();
+
+	auto map = std::make_shared<TempoMap>(*tempoMap());
+	map->setSampleRate(Engine::audioEngine()->processingSampleRate());
+	std::atomic_store(&m_tempoMap, std::shared_ptr<const TempoMap>{std::move(map)});
 }
 
 
@@ -0,0 +1,137 @@
+/*
+ * TempoMap.cpp - conversion between ticks and frames across tempo changes
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "TempoMap.h"
+
+#include <algorithm>
+
+#include "TimePos.h"
+
+namespace lmms
+{
+
+
+TempoMap::TempoMap(sample_rate_t sampleRate, bpm_t tempo) :
+	m_sampleRate(sampleRate),
+	m_segments{{0, tempo, framesPerTick(sampleRate, tempo), 0.0}}
+{
+}
+
+
+
+
+void TempoMap::setTempo(tick_t tick, bpm_t tempo)
+{
+	tick = std::max(tick, 0);
+	while (m_segments.size() > 1 && m_segments.back().tick >= tick)
+	{
+		m_segments.pop_back();
+	}
+
+	auto& last = m_segments.back();
+	if (last.tick == tick)
+	{
+		// Only the first segment is left at this point
+		last.tempo = tempo;
+		last.framesPerTick = framesPerTick(m_sampleRate, tempo);
+		return;
+	}
+	if (last.tempo == tempo) { return; }
+
+	const auto frame = last.frame + (tick - last.tick) * last.framesPerTick;
+	m_segments.push_back({tick, tempo, framesPerTick(m_sampleRate, tempo), frame});
+}
+
+
+
+
+void TempoMap::setSampleRate(sample_rate_t sampleRate)
+{
+	m_sampleRate = sampleRate;
+	for (auto it = m_segments.begin(); it != m_segments.end(); ++it)
+	{
+		it->framesPerTick = framesPerTick(sampleRate, it->tempo);
+		if (it != m_segments.begin())
+		{
+			const auto& previous = *(it - 1);
+			it->frame = previous.frame + (it->tick - previous.tick) * previous.framesPerTick;
+		}
+	}
+}
+
+
+
+
+bpm_t TempoMap::tempoAt(tick_t tick) const
+{
+	return segmentAt(tick).tempo;
+}
+
+
+
+
+double TempoMap::framesPerTickAt(tick_t tick) const
+{
+	return segmentAt(tick).framesPerTick;
+}
+
+
+
+
+double TempoMap::frames(double ticks) const
+{
+	const auto& segment = segmentAt(ticks);
+	return segment.frame + (ticks - segment.tick) * segment.framesPerTick;
+}
+
+
+
+
+double TempoMap::ticks(double frames) const
+{
+	// Frames grow with the ticks, so the segments are sorted by both
+	const auto it = std::upper_bound(m_segments.begin() + 1, m_segments.end(), frames,
+		[](double frame, const Segment& segment) { return frame < segment.frame; });
+	const auto& segment = *(it - 1);
+	return segment.tick + (frames - segment.frame) / segment.framesPerTick;
+}
+
+
+
+
+double TempoMap::framesPerTick(sample_rate_t sampleRate, bpm_t tempo)
+{
+	return sampleRate * 60.0f * 4 / DefaultTicksPerBar / tempo;
+}
+
+
+
+
+const TempoMap::Segment& TempoMap::segmentAt(double tick) const
+{
+	const auto it = std::upper_bound(m_segments.begin() + 1, m_segments.end(), tick,
+		[](double tick, const Segment& segment) { return tick < segment.tick; });
+	return *(it - 1);
+}
+
+
+} // namespace lmms
@@ -0,0 +1,211 @@
+/*
+ * UserWaveform.cpp - band-limited wavetables for user-drawn waves
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "UserWaveform.h"
+
+#include <algorithm>
+#include <fftw3.h>
+
+#include "Oscillator.h"
+#include "fft_helpers.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+constexpr int Length = OscillatorConstants::WAVETABLE_LENGTH;
+constexpr int Bins = Length / 2 + 1;
+
+// The shared plans are executed on other buffers than they were made for, which must be aligned like fftwf_malloc's
+template<typename T>
+struct FftwBuffer
+{
+	explicit FftwBuffer(std::size_t size) : data(static_cast<T*>(fftwf_malloc(size * sizeof(T)))) {}
+	~FftwBuffer() { fftwf_free(data); }
+	FftwBuffer(const FftwBuffer&) = delete;
+	FftwBuffer& operator=(const FftwBuffer&) = delete;
+
+	T* data;
+};
+
+} // namespace
+
+
+
+
+UserWaveform::UserWaveform()
+{
+	// Measuring the plans takes a while, better when creating the instrument than when generating the first tables
+	realToComplexPlan(Length);
+	complexToRealPlan(Length);
+}
+
+
+
+
+UserWaveform::~UserWaveform()
+{
+	auto lock = std::unique_lock{m_mutex};
+	m_hasPendingWave = false;
+	lock.unlock();
+
+	if (m_thread.joinable()) { m_thread.join(); }
+}
+
+
+
+
+void UserWaveform::update(const float* wave, int length)
+{
+	auto lock = std::lock_guard{m_mutex};
+	m_pendingWave.assign(wave, wave + std::max(length, 0));
+	m_hasPendingWave = true;
+	++m_generation;
+	// Notes starting from now on must not get the tables of the previous wave
+	std::atomic_store(&m_waveform, std::shared_ptr<const Waveform>{});
+
+	if (!m_running)
+	{
+		// A thread which isn't running any more has already left run(), joining it doesn't need the lock
+		if (m_thread.joinable()) { m_thread.join(); }
+		m_running = true;
+		m_thread = std::thread{&UserWaveform::run, this};
+	}
+}
+
+
+
+
+void UserWaveform::updateNow(const float* wave, int length)
+{
+	auto lock = std::unique_lock{m_mutex};
+	m_hasPendingWave = false;
+	const auto generation = ++m_generation;
+	std::atomic_store(&m_waveform, std::shared_ptr<const Waveform>{});
+	lock.unlock();
+
+	auto waveform = generate(wave, length);
+
+	lock.lock();
+	publish(std::move(waveform), generation);
+}
+
+
+
+
+void UserWaveform::run()
+{
+	auto wave = std::vector<float>{};
+	auto lock = std::unique_lock{m_mutex};
+	while (m_hasPendingWave)
+	{
+		wave.swap(m_pendingWave);
+		m_hasPendingWave = false;
+		const auto generation = m_generation;
+		lock.unlock();
+
+		auto waveform = generate(wave.data(), static_cast<int>(wave.size()));
+
+		lock.lock();
+		publish(std::move(waveform), generation);
+	}
+	m_running = false;
+}
+
+
+
+
+void UserWaveform::publish(std::unique_ptr<Waveform> waveform, unsigned int generation)
+{
+	if (generation != m_generation) { return; }
+	std::atomic_store(&m_waveform, std::shared_ptr<const Waveform>{std::move(waveform)});
+}
+
+
+
+
+std::unique_ptr<UserWaveform::Waveform> UserWaveform::generate(const float* wave, int length)
+{
+	const auto forward = realToComplexPlan(Length);
+	const auto inverse = complexToRealPlan(Length);
+
+	auto waveform = std::make_unique<Waveform>();
+	if (length <= 0 || !forward || !inverse)
+	{
+		for (auto& table : *waveform) { table.fill(0.f); }
+		return waveform;
+	}
+
+	auto samples = FftwBuffer<float>{Length};
+	auto spectrum = FftwBuffer<fftwf_complex>{Bins};
+	auto bandSpectrum = FftwBuffer<fftwf_complex>{Bins};
+
+	// Stretch the wave over a whole table, interpolating cyclically
+	for (int i = 0; i < Length; ++i)
+	{
+		const float frame = static_cast<float>(i) * length / Length;
+		const auto f1 = static_cast<int>(frame) % length;
+		const auto f2 = (f1 + 1) % length;
+		samples.data[i] = linearInterpolate(wave[f1], wave[f2], fraction(frame));
+	}
+	fftwf_execute_dft_r2c(forward, samples.data, spectrum.data);
+
+	// Keep the harmonics of each band which stay audible, starting with the lowest band. Low bands keep the whole
+	// spectrum, so their tables are the same and only computed once.
+	int lastHarmonics = -1;
+	for (int band = 0; band < OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT; ++band)
+	{
+		const auto harmonics = std::min(Bins - 1,
+			static_cast<int>(OscillatorConstants::MAX_FREQ / Oscillator::freqFromWaveTableBand(band)));
+		auto& table = (*waveform)[band];
+		if (harmonics == lastHarmonics)
+		{
+			table = (*waveform)[band - 1];
+			continue;
+		}
+		lastHarmonics = harmonics;
+
+		// The inverse transform overwrites its input, so work on a copy
+		std::copy(&spectrum.data[0][0], &spectrum.data[harmonics + 1][0], &bandSpectrum.data[0][0]);
+		std::fill(&bandSpectrum.data[harmonics + 1][0], &bandSpectrum.data[Bins][0], 0.f);
+		fftwf_execute_dft_c2r(inverse, bandSpectrum.data, samples.data);
+
+		// fftw doesn't scale its transforms, a round trip multiplies by the length
+		std::transform(samples.data, samples.data + Length, table.begin(),
+			[](float sample) { return sample / Length; });
+	}
+
+	return waveform;
+}
+
+
+
+
+int UserWaveform::band(float freq)
+{
+	return Oscillator::waveTableBandFromFreq(freq);
+}
+
+
+} // namespace lmms
@@ -1,5 +1,16 @@
 #include "ValueBuffer.h"
 
+#include <array>
+#include <atomic>
+
+#ifdef __MINGW32__
+#include <mingw.mutex.h>
+#else
+#include <mutex>
+#endif
+
+#include "AudioEngine.h"
+#include "Engine.h"
 #include "interpolation.h"
 
 namespace lmms
@@ -44,4 +55,65 @@ void ValueBuffer::interpolate(float start, float end_)
 }
 
 
+
+
+namespace
+{
+
+// Chunk k holds FirstChunkSize << k buffers, so the pool can grow without moving buffers that are in use.
+// Chunks are never freed: the pool only grows to what the busiest period needed.
+constexpr std::size_t FirstChunkSize = 64;
+constexpr std::size_t MaxChunks = 24;
+
+struct Pool
+{
+	std::array<std::atomic<ValueBuffer*>, MaxChunks> chunks{};
+	std::atomic<std::size_t> used{0};
+	std::mutex growMutex;
+};
+
+Pool s_pool;
+
+} // namespace
+
+
+ValueBuffer* ValueBufferPool::acquire()
+{
+	const auto fpp = static_cast<std::size_t>(Engine::audioEngine()->framesPerPeriod());
+
+	auto index = s_pool.used.fetch_add(1, std::memory_order_relaxed);
+	std::size_t chunkIndex = 0;
+	std::size_t chunkSize = FirstChunkSize;
+	while (index >= chunkSize)
+	{
+		index -= chunkSize;
+		chunkSize *= 2;
+		++chunkIndex;
+	}
+
+	ValueBuffer* chunk = s_pool.chunks[chunkIndex].load(std::memory_order_acquire);
+	if (!chunk)
+	{
+		const auto lock = std::lock_guard{s_pool.growMutex};
+		chunk = s_pool.chunks[chunkIndex].load(std::memory_order_relaxed);
+		if (!chunk)
+		{
+			chunk = new ValueBuffer[chunkSize];
+			s_pool.chunks[chunkIndex].store(chunk, std::memory_order_release);
+		}
+	}
+
+	// only allocates if the period size grew since the buffer was last used
+	ValueBuffer* buffer = chunk + index;
+	if (buffer->size() != fpp) { buffer->resize(fpp); }
+	return buffer;
+}
+
+
+void ValueBufferPool::reset()
+{
+	s_pool.used.store(0, std::memory_order_relaxed);
+}
+
+
 } // namespace lmms
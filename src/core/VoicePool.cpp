@@ -0,0 +1,44 @@
+/*
+ * VoicePool.cpp - capacity of the instruments' voice pools
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "VoicePool.h"
+
+#include "ConfigManager.h"
+
+namespace lmms
+{
+
+
+std::size_t voicePoolCapacity()
+{
+	// Read once, pools of instruments created later keep the capacity of the earlier ones
+	static const auto capacity = []
+	{
+		bool ok = false;
+		const auto configured = ConfigManager::inst()->value("audioengine", "voicepoolsize").toInt(&ok);
+		return ok && configured > 0 ? static_cast<std::size_t>(configured) : DefaultVoicePoolCapacity;
+	}();
+	return capacity;
+}
+
+
+} // namespace lmms
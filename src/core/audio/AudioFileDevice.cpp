@@ -25,9 +25,14 @@
 
 #include <QMessageBox>
 
+#include <algorithm>
+#include <cassert>
+
 #include "AudioFileDevice.h"
+#include "AudioEngine.h"
 #include "ExportProjectDialog.h"
 #include "GuiApplication.h"
+#include "MemoryManager.h"
 
 namespace lmms
 {
@@ -75,12 +80,183 @@ AudioFileDevice::AudioFileDevice( OutputSettings const & outputSettings,
 
 AudioFileDevice::~AudioFileDevice()
 {
+	// subclasses have already closed their encoders, so it's too late to
+	// encode anything; just don't leave the thread running
+	assert( !m_encoderThread.joinable() );
+	if( m_encoderThread.joinable() )
+	{
+		{
+			const auto lock = std::lock_guard<std::mutex>( m_queueMutex );
+			m_queuedBlocks = 0;
+			m_finishing = true;
+		}
+		m_blockQueued.notify_one();
+		m_encoderThread.join();
+	}
+
 	m_outputFile.close();
 }
 
 
 
 
+void AudioFileDevice::startProcessing()
+{
+	AudioDevice::startProcessing();
+
+	if( m_encoderThread.joinable() )
+	{
+		return;
+	}
+
+	const fpp_t period = audioEngine()->framesPerPeriod();
+	const fpp_t blockFrames = std::max<fpp_t>( 1, ( MinBlockFrames + period - 1 ) / period ) * period;
+
+	m_blocks.resize( RingBlocks );
+	for( auto & block : m_blocks )
+	{
+		block.frames.resize( blockFrames );
+	}
+	// the processing sample rate is never below the one of the file, so
+	// resampling only ever shrinks a block
+	m_resampleBuffer.resize( blockFrames );
+
+	m_fillBlock = 0;
+	m_fillFrames = 0;
+	m_encodeBlock = 0;
+	m_queuedBlocks = 0;
+	m_finishing = false;
+
+	m_encoderThread = std::thread( &AudioFileDevice::encodeBlocks, this );
+}
+
+
+
+
+void AudioFileDevice::stopProcessing()
+{
+	AudioDevice::stopProcessing();
+
+	if( !m_encoderThread.joinable() )
+	{
+		return;
+	}
+
+	if( m_fillFrames > 0 )
+	{
+		submitBlock();
+	}
+
+	{
+		const auto lock = std::lock_guard<std::mutex>( m_queueMutex );
+		m_finishing = true;
+	}
+	m_blockQueued.notify_one();
+
+	m_encoderThread.join();
+}
+
+
+
+
+void AudioFileDevice::enqueue( const surroundSampleFrame * _ab,
+					const fpp_t _frames, const float _master_gain )
+{
+	assert( m_encoderThread.joinable() );
+
+	const auto blockFrames = static_cast<fpp_t>( m_blocks[m_fillBlock].frames.size() );
+	assert( _frames <= blockFrames );
+
+	if( m_fillFrames > 0 && ( m_fillFrames + _frames > blockFrames || m_fillGain != _master_gain ) )
+	{
+		submitBlock();
+	}
+
+	if( m_fillFrames == 0 )
+	{
+		// while all blocks are queued, the next one to fill is the one
+		// the encoder works on, wait for it to be done with one of them
+		auto lock = std::unique_lock<std::mutex>( m_queueMutex );
+		m_blockEncoded.wait( lock, [this] { return m_queuedBlocks < RingBlocks; } );
+		m_fillGain = _master_gain;
+	}
+
+	Block & block = m_blocks[m_fillBlock];
+	std::copy( _ab, _ab + _frames, block.frames.begin() + m_fillFrames );
+	m_fillFrames += _frames;
+
+	if( m_fillFrames == blockFrames )
+	{
+		submitBlock();
+	}
+}
+
+
+
+
+void AudioFileDevice::submitBlock()
+{
+	{
+		const auto lock = std::lock_guard<std::mutex>( m_queueMutex );
+		// only a block filled after waiting for a free one is submitted
+		assert( m_fillFrames > 0 && m_queuedBlocks < RingBlocks );
+		Block & block = m_blocks[m_fillBlock];
+		block.used = m_fillFrames;
+		block.masterGain = m_fillGain;
+		++m_queuedBlocks;
+	}
+	m_blockQueued.notify_one();
+
+	m_fillBlock = ( m_fillBlock + 1 ) % RingBlocks;
+	m_fillFrames = 0;
+}
+
+
+
+
+void AudioFileDevice::encodeBlocks()
+{
+	MemoryManager::ThreadGuard mmThreadGuard; Q_UNUSED(mmThreadGuard);
+
+	while( true )
+	{
+		Block * block;
+		{
+			auto lock = std::unique_lock<std::mutex>( m_queueMutex );
+			m_blockQueued.wait( lock, [this] { return m_queuedBlocks > 0 || m_finishing; } );
+			if( m_queuedBlocks == 0 )
+			{
+				return;
+			}
+			block = &m_blocks[m_encodeBlock];
+		}
+
+		const sample_rate_t processingRate = audioEngine()->processingSampleRate();
+		if( processingRate != sampleRate() )
+		{
+			lock();
+			const fpp_t frames = resample( block->frames.data(), block->used,
+					m_resampleBuffer.data(), processingRate, sampleRate() );
+			unlock();
+			writeBuffer( m_resampleBuffer.data(), frames, block->masterGain );
+		}
+		else
+		{
+			writeBuffer( block->frames.data(), block->used, block->masterGain );
+		}
+
+		{
+			const auto lock = std::lock_guard<std::mutex>( m_queueMutex );
+			m_encodeBlock = ( m_encodeBlock + 1 ) % RingBlocks;
+			--m_queuedBlocks;
+		}
+		m_blockEncoded.notify_one();
+	}
+}
+
+
+
+
 int AudioFileDevice::writeData( const void* data, int len )
 {
 	if( m_outputFile.isOpen() )
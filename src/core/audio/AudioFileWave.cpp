@@ -104,26 +104,24 @@ void AudioFileWave::writeBuffer( const surroundSampleFrame * _ab,
 
 	if( bitDepth == OutputSettings::BitDepth::Depth32Bit || bitDepth == OutputSettings::BitDepth::Depth24Bit )
 	{
-		auto buf = new float[_frames * channels()];
+		m_floatBuffer.resize( _frames * channels() );
 		for( fpp_t frame = 0; frame < _frames; ++frame )
 		{
 			for( ch_cnt_t chnl = 0; chnl < channels(); ++chnl )
 			{
-				buf[frame*channels()+chnl] = _ab[frame][chnl] *
+				m_floatBuffer[frame*channels()+chnl] = _ab[frame][chnl] *
 								_master_gain;
 			}
 		}
-		sf_writef_float( m_sf, buf, _frames );
-		delete[] buf;
+		sf_writef_float( m_sf, m_floatBuffer.data(), _frames );
 	}
 	else
 	{
-		auto buf = new int_sample_t[_frames * channels()];
-		convertToS16( _ab, _frames, _master_gain, buf,
+		m_intBuffer.resize( _frames * channels() );
+		convertToS16( _ab, _frames, _master_gain, m_intBuffer.data(),
 							!isLittleEndian() );
 
-		sf_writef_short( m_sf, buf, _frames );
-		delete[] buf;
+		sf_writef_short( m_sf, m_intBuffer.data(), _frames );
 	}
 }
 
@@ -26,9 +26,14 @@
 
 #ifdef LMMS_HAVE_JACK
 
+#include <algorithm>
+#include <iterator>
+
+#include <QCheckBox>
 #include <QFormLayout>
 #include <QLineEdit>
 #include <QMessageBox>
+#include <QTimer>
 
 #include "AudioEngine.h"
 #include "ConfigManager.h"
@@ -37,6 +42,7 @@
 #include "LcdSpinBox.h"
 #include "MainWindow.h"
 #include "MidiJack.h"
+#include "Mixer.h"
 #include "gui_templates.h"
 
 namespace lmms
@@ -60,6 +66,10 @@ AudioJack::AudioJack(bool& successful, AudioEngine* audioEngineParam)
 	, m_outBuf(new surroundSampleFrame[audioEngine()->framesPerPeriod()])
 	, m_framesDoneInCurBuf(0)
 	, m_framesToDoInCurBuf(0)
+	, m_mixerChannelOutputs(ConfigManager::inst()->value("audiojack", "mixerchanneloutputs").toInt())
+	, m_mixerChannelsActive(false)
+	, m_renderDirectly(false)
+	, m_mixerChannelTimer(nullptr)
 {
 	m_stopped = true;
 
@@ -67,6 +77,14 @@ AudioJack::AudioJack(bool& successful, AudioEngine* audioEngineParam)
 	if (successful) {
 		connect(this, SIGNAL(zombified()), this, SLOT(restartAfterZombified()), Qt::QueuedConnection);
 	}
+
+	if (successful && m_mixerChannelOutputs)
+	{
+		// Mixer channels are added, removed and renamed from the GUI, which doesn't tell anybody about it
+		m_mixerChannelTimer = new QTimer(this);
+		connect(m_mixerChannelTimer, SIGNAL(timeout()), this, SLOT(updateMixerChannelPorts()));
+		m_mixerChannelTimer->start(1000);
+	}
 }
 
 
@@ -98,6 +116,12 @@ AudioJack::~AudioJack()
 
 void AudioJack::restartAfterZombified()
 {
+	{
+		// The ports went away with the old client
+		const auto lock = std::lock_guard<std::mutex>{m_mixerChannelMutex};
+		m_mixerChannelPorts.clear();
+	}
+
 	if (initJackClient())
 	{
 		m_active = false;
@@ -233,6 +257,120 @@ void AudioJack::stopProcessing()
 
 
 
+bool AudioJack::needsFifo()
+{
+	// Rendering in the callback is what JACK expects, but when the periods differ some callbacks have to render
+	// more than others. The mixer channel outputs have to be rendered in the callback regardless.
+	if (m_mixerChannelOutputs) { return false; }
+	return m_client == nullptr || jack_get_buffer_size(m_client) != audioEngine()->framesPerPeriod();
+}
+
+
+
+
+void AudioJack::updateMixerChannelPorts()
+{
+	if (m_client == nullptr) { return; }
+
+	const auto mixer = Engine::mixer();
+	const auto count = static_cast<std::size_t>(mixer->numChannels() - 1);
+	const auto portName = [mixer](std::size_t entry, ch_cnt_t ch)
+	{
+		const auto index = static_cast<int>(entry + 1);
+		return QString("mixer %1 (%2) %3").arg(index).arg(mixer->mixerChannel(index)->m_name).arg(ch ? "R" : "L");
+	};
+
+	// Renaming doesn't touch anything the callback uses
+	for (std::size_t entry = 0; entry < std::min(count, m_mixerChannelPorts.size()); ++entry)
+	{
+		auto& channelPorts = m_mixerChannelPorts[entry];
+		if (channelPorts.name == mixer->mixerChannel(entry + 1)->m_name) { continue; }
+
+		channelPorts.name = mixer->mixerChannel(entry + 1)->m_name;
+		for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+		{
+			if (channelPorts.ports[ch] == nullptr) { continue; }
+#ifdef LMMS_HAVE_JACK_PRENAME
+			jack_port_rename(m_client, channelPorts.ports[ch], portName(entry, ch).toLatin1().constData());
+#else
+			jack_port_set_name(channelPorts.ports[ch], portName(entry, ch).toLatin1().constData());
+#endif
+		}
+	}
+
+	// Ports are registered and unregistered outside of the lock, so the callback misses as few cycles as possible
+	if (count > m_mixerChannelPorts.size())
+	{
+		auto added = std::vector<MixerChannelPorts>{};
+		for (auto entry = m_mixerChannelPorts.size(); entry < count; ++entry)
+		{
+			auto channelPorts = MixerChannelPorts{};
+			channelPorts.name = mixer->mixerChannel(entry + 1)->m_name;
+			for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				channelPorts.ports[ch] = jack_port_register(m_client, portName(entry, ch).toLatin1().constData(),
+					JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+				channelPorts.buffers[ch] = nullptr;
+				channelPorts.staging[ch].resize(audioEngine()->framesPerPeriod());
+			}
+			added.push_back(std::move(channelPorts));
+		}
+
+		const auto lock = std::lock_guard<std::mutex>{m_mixerChannelMutex};
+		std::move(added.begin(), added.end(), std::back_inserter(m_mixerChannelPorts));
+	}
+	else if (count < m_mixerChannelPorts.size())
+	{
+		auto removed = std::vector<MixerChannelPorts>{};
+		{
+			const auto lock = std::lock_guard<std::mutex>{m_mixerChannelMutex};
+			std::move(m_mixerChannelPorts.begin() + count, m_mixerChannelPorts.end(), std::back_inserter(removed));
+			m_mixerChannelPorts.resize(count);
+		}
+
+		for (const auto& channelPorts : removed)
+		{
+			for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				if (channelPorts.ports[ch] != nullptr) { jack_port_unregister(m_client, channelPorts.ports[ch]); }
+			}
+		}
+	}
+}
+
+
+
+
+void AudioJack::writeMixerChannel(mix_ch_t index, MixerChannel* channel, const fpp_t frames)
+{
+	// Only called while rendering, which for this driver happens inside the callback
+	if (!m_mixerChannelsActive || index == 0 || index > m_mixerChannelPorts.size()) { return; }
+
+	auto& channelPorts = m_mixerChannelPorts[index - 1];
+	const ValueBuffer* volumeBuffer = channel->m_volumeModel.valueBuffer();
+	const float volume = channel->m_volumeModel.value();
+
+	for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+	{
+		jack_default_audio_sample_t* out = m_renderDirectly ? channelPorts.buffers[ch] : channelPorts.staging[ch].data();
+		if (out == nullptr) { continue; }
+
+		if (channel->m_muted)
+		{
+			std::fill_n(out, frames, 0.f);
+			continue;
+		}
+
+		for (fpp_t frame = 0; frame < frames; ++frame)
+		{
+			out[frame] = channel->m_buffer[frame][ch] * (volumeBuffer ? volumeBuffer->values()[frame] : volume);
+		}
+	}
+}
+
+
+
+
 void AudioJack::applyQualitySettings()
 {
 	if (hqAudio())
@@ -340,7 +478,54 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 	}
 #endif
 
+	// If the GUI is just adding or removing mixer channel ports, they are left alone for this cycle. Their contents
+	// are only valid if the mixer rendered them for this callback, without resampling.
+	const auto mixerChannelLock = std::unique_lock<std::mutex>{m_mixerChannelMutex, std::try_to_lock};
+	const bool sameRate = audioEngine()->processingSampleRate() == sampleRate();
+	m_mixerChannelsActive = mixerChannelLock.owns_lock() && !audioEngine()->hasFifoWriter() && sameRate;
+	if (mixerChannelLock.owns_lock())
+	{
+		for (auto& channelPorts : m_mixerChannelPorts)
+		{
+			for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				auto buffer = static_cast<jack_default_audio_sample_t*>(
+					channelPorts.ports[ch] ? jack_port_get_buffer(channelPorts.ports[ch], nframes) : nullptr);
+				channelPorts.buffers[ch] = buffer;
+				if (buffer && !m_mixerChannelsActive) { std::fill_n(buffer, nframes, 0.f); }
+			}
+		}
+	}
+
 	jack_nframes_t done = 0;
+
+	// When JACK's period matches the engine's, the engine renders straight into the port buffers
+	if (!m_stopped && !audioEngine()->hasFifoWriter() && sameRate && m_framesDoneInCurBuf == m_framesToDoInCurBuf
+		&& nframes == static_cast<jack_nframes_t>(audioEngine()->framesPerPeriod()))
+	{
+		m_renderDirectly = true;
+		const surroundSampleFrame* b = audioEngine()->nextBuffer();
+		m_renderDirectly = false;
+
+		if (b)
+		{
+			const float gain = audioEngine()->masterGain();
+			for (int c = 0; c < channels(); ++c)
+			{
+				jack_default_audio_sample_t* o = m_tempOutBufs[c];
+				for (jack_nframes_t frame = 0; frame < nframes; ++frame)
+				{
+					o[frame] = b[frame][c] * gain;
+				}
+			}
+			done = nframes;
+		}
+		else
+		{
+			m_stopped = true;
+		}
+	}
+
 	while (done < nframes && !m_stopped)
 	{
 		jack_nframes_t todo = std::min<jack_nframes_t>(nframes - done, m_framesToDoInCurBuf - m_framesDoneInCurBuf);
@@ -353,6 +538,18 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 				o[done + frame] = m_outBuf[m_framesDoneInCurBuf + frame][c] * gain;
 			}
 		}
+		if (m_mixerChannelsActive)
+		{
+			for (const auto& channelPorts : m_mixerChannelPorts)
+			{
+				for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+				{
+					if (channelPorts.buffers[ch] == nullptr) { continue; }
+					std::copy_n(channelPorts.staging[ch].begin() + m_framesDoneInCurBuf, todo,
+						channelPorts.buffers[ch] + done);
+				}
+			}
+		}
 		done += todo;
 		m_framesDoneInCurBuf += todo;
 		if (m_framesDoneInCurBuf == m_framesToDoInCurBuf)
@@ -374,8 +571,20 @@ int AudioJack::processCallback(jack_nframes_t nframes)
 			jack_default_audio_sample_t* b = m_tempOutBufs[c] + done;
 			memset(b, 0, sizeof(*b) * (nframes - done));
 		}
+		if (m_mixerChannelsActive)
+		{
+			for (const auto& channelPorts : m_mixerChannelPorts)
+			{
+				for (ch_cnt_t ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+				{
+					if (channelPorts.buffers[ch]) { std::fill_n(channelPorts.buffers[ch] + done, nframes - done, 0.f); }
+				}
+			}
+		}
 	}
 
+	m_mixerChannelsActive = false;
+
 	return 0;
 }
 
@@ -420,6 +629,13 @@ AudioJack::setupWidget::setupWidget(QWidget* parent)
 	m_channels->setModel(m);
 
 	form->addRow(tr("Channels"), m_channels);
+
+	m_mixerChannelOutputs = new QCheckBox(tr("Separate outputs for mixer channels"), this);
+	m_mixerChannelOutputs->setChecked(ConfigManager::inst()->value("audiojack", "mixerchanneloutputs").toInt());
+	m_mixerChannelOutputs->setToolTip(
+		tr("Exposes every mixer channel as a stereo pair of JACK ports. Takes effect after a restart."));
+
+	form->addRow(m_mixerChannelOutputs);
 }
 
 
@@ -437,6 +653,8 @@ void AudioJack::setupWidget::saveSettings()
 {
 	ConfigManager::inst()->setValue("audiojack", "clientname", m_clientName->text());
 	ConfigManager::inst()->setValue("audiojack", "channels", QString::number(m_channels->value<int>()));
+	ConfigManager::inst()->setValue(
+		"audiojack", "mixerchanneloutputs", QString::number(m_mixerChannelOutputs->isChecked()));
 }
 
 
@@ -27,6 +27,8 @@
 #include "fft_helpers.h"
 
 #include <cmath>
+#include <map>
+#include <mutex>
 #include "lmms_constants.h"
 
 namespace lmms
@@ -218,4 +220,57 @@ int compressbands(const float *absspec_buffer, float *compressedband, int num_ol
 }
 
 
+namespace
+{
+	// The FFTW planner isn't thread safe, so all cached plans are made under one lock
+	std::mutex s_planMutex;
+	std::map<unsigned int, fftwf_plan> s_realToComplexPlans;
+	std::map<unsigned int, fftwf_plan> s_complexToRealPlans;
+
+	fftwf_plan cachedPlan(std::map<unsigned int, fftwf_plan> &plans, unsigned int size, bool forward)
+	{
+		if (size == 0) {return nullptr;}
+
+		std::lock_guard<std::mutex> lock(s_planMutex);
+
+		fftwf_plan &plan = plans[size];
+		if (plan == nullptr)
+		{
+			// Plan on scratch buffers with fftwf_malloc() alignment, callers
+			// execute it on their own buffers with the same alignment
+			float *real = fftwf_alloc_real(size);
+			fftwf_complex *complex = fftwf_alloc_complex(size / 2 + 1);
+
+			plan = forward
+				? fftwf_plan_dft_r2c_1d(size, real, complex, FFTW_MEASURE)
+				: fftwf_plan_dft_c2r_1d(size, complex, real, FFTW_MEASURE);
+
+			fftwf_free(real);
+			fftwf_free(complex);
+		}
+		return plan;
+	}
+}
+
+
+/* Get a cached real-to-complex plan, creating it on first use.
+ *
+ * return nullptr on error
+ */
+fftwf_plan realToComplexPlan(unsigned int size)
+{
+	return cachedPlan(s_realToComplexPlans, size, true);
+}
+
+
+/* Get a cached complex-to-real plan, creating it on first use.
+ *
+ * return nullptr on error
+ */
+fftwf_plan complexToRealPlan(unsigned int size)
+{
+	return cachedPlan(s_complexToRealPlans, size, false);
+}
+
+
 } // namespace lmms
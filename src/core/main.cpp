@@ -184,11 +184,17 @@ void printHelp()
 		"      --import <in> [-e]         Import MIDI or Hydrogen file <in>.\n"
 		"          If -e is specified lmms exits after importing the file.\n"
 		"\nOptions for \"render\" and \"rendertracks\":\n"
+		"  Options following -f or -o only apply to that output, the others\n"
+		"  apply to all outputs.\n"
 		"  -a, --float                    Use 32bit float bit depth\n"
 		"  -b, --bitrate <bitrate>        Specify output bitrate in KBit/s\n"
 		"          Default: 160.\n"
 		"  -f, --format <format>         Specify format of render-output where\n"
 		"          Format is either 'wav', 'flac', 'ogg' or 'mp3'.\n"
+		"          Can be repeated together with -o to write several\n"
+		"          formats from a single render, e.g.\n"
+		"          -f wav -o song.wav -f mp3 -o song.mp3 -b 192\n"
+		"          Outputs without -o are named after the first one.\n"
 		"  -i, --interpolation <method>   Specify interpolation method\n"
 		"          Possible values:\n"
 		"            - linear\n"
@@ -365,7 +371,14 @@ int main( int argc, char * * argv )
 
 	AudioEngine::qualitySettings qs( AudioEngine::qualitySettings::Mode::HighQuality );
 	OutputSettings os( 44100, OutputSettings::BitRateSettings(160, false), OutputSettings::BitDepth::Depth16Bit, OutputSettings::StereoMode::JointStereo );
-	ProjectRenderer::ExportFileFormat eff = ProjectRenderer::ExportFileFormat::Wave;
+	// outputs of --format and --output, the format is Count until given
+	std::vector<ProjectRenderer::Output> renderOutputs;
+	// the settings of the output being specified, or of all outputs
+	// before the first one
+	auto outputSettings = [&]() -> OutputSettings &
+	{
+		return renderOutputs.empty() ? os : renderOutputs.back().settings;
+	};
 
 	// second of two command-line parsing stages
 	for( int i = 1; i < argc; ++i )
@@ -502,6 +515,14 @@ int main( int argc, char * * argv )
 
 
 			renderOut = QString::fromLocal8Bit( argv[i] );
+
+			// each --output starts a new output unless it pairs up with
+			// the preceding --format
+			if( renderOutputs.empty() || !renderOutputs.back().file.isEmpty() )
+			{
+				renderOutputs.push_back( { ProjectRenderer::ExportFileFormat::Count, os, QString() } );
+			}
+			renderOutputs.back().file = renderOut;
 		}
 		else if( arg == "--format" || arg == "-f" )
 		{
@@ -515,6 +536,15 @@ int main( int argc, char * * argv )
 
 			const QString ext = QString( argv[i] );
 
+			// each --format starts a new output unless it pairs up with
+			// the preceding --output
+			if( renderOutputs.empty() ||
+				renderOutputs.back().format != ProjectRenderer::ExportFileFormat::Count )
+			{
+				renderOutputs.push_back( { ProjectRenderer::ExportFileFormat::Count, os, QString() } );
+			}
+			ProjectRenderer::ExportFileFormat & eff = renderOutputs.back().format;
+
 			if( ext == "wav" )
 			{
 				eff = ProjectRenderer::ExportFileFormat::Wave;
@@ -553,7 +583,7 @@ int main( int argc, char * * argv )
 			sample_rate_t sr = QString( argv[i] ).toUInt();
 			if( sr >= 44100 && sr <= 192000 )
 			{
-				os.setSampleRate(sr);
+				outputSettings().setSampleRate(sr);
 			}
 			else
 			{
@@ -574,9 +604,9 @@ int main( int argc, char * * argv )
 
 			if( br >= 64 && br <= 384 )
 			{
-				OutputSettings::BitRateSettings bitRateSettings = os.getBitRateSettings();
+				OutputSettings::BitRateSettings bitRateSettings = outputSettings().getBitRateSettings();
 				bitRateSettings.setBitRate(br);
-				os.setBitRateSettings(bitRateSettings);
+				outputSettings().setBitRateSettings(bitRateSettings);
 			}
 			else
 			{
@@ -596,15 +626,15 @@ int main( int argc, char * * argv )
 
 			if( mode == "s" )
 			{
-				os.setStereoMode(OutputSettings::StereoMode::Stereo);
+				outputSettings().setStereoMode(OutputSettings::StereoMode::Stereo);
 			}
 			else if( mode == "j" )
 			{
-				os.setStereoMode(OutputSettings::StereoMode::JointStereo);
+				outputSettings().setStereoMode(OutputSettings::StereoMode::JointStereo);
 			}
 			else if( mode == "m" )
 			{
-				os.setStereoMode(OutputSettings::StereoMode::Mono);
+				outputSettings().setStereoMode(OutputSettings::StereoMode::Mono);
 			}
 			else
 			{
@@ -613,7 +643,7 @@ int main( int argc, char * * argv )
 		}
 		else if( arg =="--float" || arg == "-a" )
 		{
-			os.setBitDepth(OutputSettings::BitDepth::Depth32Bit);
+			outputSettings().setBitDepth(OutputSettings::BitDepth::Depth32Bit);
 		}
 		else if( arg == "--interpolation" || arg == "-i" )
 		{
@@ -820,16 +850,56 @@ int main( int argc, char * * argv )
 
 		Engine::getSong()->setExportLoop( renderLoop );
 
-		// when rendering multiple tracks, renderOut is a directory
-		// otherwise, it is a file, so we need to append the file extension
-		if ( !renderTracks )
+		if( renderOutputs.empty() )
 		{
-			renderOut = baseName( renderOut ) +
-				ProjectRenderer::getFileExtensionFromFormat(eff);
+			renderOutputs.push_back( { ProjectRenderer::ExportFileFormat::Wave, os, renderOut } );
+		}
+
+		// outputs without a path go next to the first one given
+		QString defaultOut = fileToLoad;
+		for( const auto & output : renderOutputs )
+		{
+			if( !output.file.isEmpty() )
+			{
+				defaultOut = output.file;
+				break;
+			}
+		}
+
+		QStringList renderFiles;
+		for( auto & output : renderOutputs )
+		{
+			if( output.format == ProjectRenderer::ExportFileFormat::Count )
+			{
+				output.format = ProjectRenderer::ExportFileFormat::Wave;
+			}
+			if( output.file.isEmpty() )
+			{
+				output.file = defaultOut;
+			}
+
+			// when rendering multiple tracks, the output is a directory
+			// otherwise, it is a file, so we need to append the file extension
+			if ( !renderTracks )
+			{
+				output.file = baseName( output.file ) +
+					ProjectRenderer::getFileExtensionFromFormat( output.format );
+			}
+
+			// rendering tracks into one directory in the same format
+			// would overwrite the files as well
+			const QString renderFile = output.file + ( renderTracks ?
+				ProjectRenderer::getFileExtensionFromFormat( output.format ) : QString() );
+			if( renderFiles.contains( renderFile ) )
+			{
+				printf( "%s is given as output twice, aborting!\n", output.file.toUtf8().constData() );
+				exit( EXIT_FAILURE );
+			}
+			renderFiles << renderFile;
 		}
 
 		// create renderer
-		auto r = new RenderManager(qs, os, eff, renderOut);
+		auto r = new RenderManager( qs, renderOutputs );
 		QCoreApplication::instance()->connect( r,
 				SIGNAL(finished()), SLOT(quit()));
 
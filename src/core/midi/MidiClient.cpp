@@ -98,7 +98,7 @@ void MidiClient::subscribeWritablePort( MidiPort* , const QString& , bool )
 
 
 
-void MidiClientRaw::parseData( const unsigned char c )
+void MidiClientRaw::parseData(const unsigned char c, std::chrono::steady_clock::time_point timestamp)
 {
 	/*********************************************************************/
 	/* 'Process' system real-time messages                               */
@@ -114,7 +114,7 @@ void MidiClientRaw::parseData( const unsigned char c )
 		{
 			m_midiParseData.m_midiEvent.setType( MidiSystemReset );
 			m_midiParseData.m_status = 0;
-			processParsedEvent();
+			processParsedEvent(timestamp);
 		}
 		return;
 	}
@@ -228,17 +228,17 @@ void MidiClientRaw::parseData( const unsigned char c )
 			return;
 	}
 
-	processParsedEvent();
+	processParsedEvent(timestamp);
 }
 
 
 
 
-void MidiClientRaw::processParsedEvent()
+void MidiClientRaw::processParsedEvent(std::chrono::steady_clock::time_point timestamp)
 {
 	for (const auto& midiPort : m_midiPorts)
 	{
-		midiPort->processInEvent(m_midiParseData.m_midiEvent);
+		midiPort->processInEvent(m_midiParseData.m_midiEvent, TimePos(), timestamp);
 	}
 }
 
@@ -185,6 +185,10 @@ void MidiJack::JackMidiRead(jack_nframes_t nframes)
 	jack_nframes_t event_index = 0;
 	jack_nframes_t event_count = jack_midi_get_event_count(port_buf);
 
+	// The events arrived during the last cycle, spread over it by their frames
+	const auto cycleEnd = std::chrono::steady_clock::now();
+	const double sampleRate = jack_get_sample_rate(jackClient());
+
 	int rval = jack_midi_event_get(&in_event, port_buf, 0);
 	if (rval == 0 /* 0 = success */)
 	{
@@ -192,10 +196,13 @@ void MidiJack::JackMidiRead(jack_nframes_t nframes)
 		{
 			while((in_event.time == i) && (event_index < event_count))
 			{
+				const auto timestamp = cycleEnd - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+					std::chrono::duration<double>{(nframes - in_event.time) / sampleRate});
+
 				// lmms is setup to parse bytes coming from a device
 				// parse it byte by byte as it expects
 				for(b=0;b<in_event.size;b++)
-					parseData( *(in_event.buffer + b) );
+					parseData( *(in_event.buffer + b), timestamp );
 
 				event_index++;
 				if(event_index < event_count)
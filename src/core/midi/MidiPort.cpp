@@ -25,7 +25,12 @@
 
 #include <QDomElement>
 
+#include <algorithm>
+#include <cmath>
+
 #include "MidiPort.h"
+#include "AudioEngine.h"
+#include "Engine.h"
 #include "MidiClient.h"
 #include "MidiDummy.h"
 #include "MidiEventProcessor.h"
@@ -40,6 +45,9 @@ namespace lmms
 
 static MidiDummy s_dummyClient;
 
+std::vector<MidiPort*> MidiPort::s_queuedPorts;
+std::mutex MidiPort::s_queuedPortsMutex;
+
 
 
 MidiPort::MidiPort( const QString& name,
@@ -63,8 +71,15 @@ MidiPort::MidiPort( const QString& name,
 	m_outputProgramModel( 1, 1, MidiProgramCount, this, tr( "Output MIDI program" ) ),
 	m_baseVelocityModel( MidiMaxVelocity/2, 1, MidiMaxVelocity, this, tr( "Base velocity" ) ),
 	m_readableModel( false, this, tr( "Receive MIDI-events" ) ),
-	m_writableModel( false, this, tr( "Send MIDI-events" ) )
+	m_writableModel( false, this, tr( "Send MIDI-events" ) ),
+	m_inputQueued(false),
+	m_inputQueue(inputQueueSize(Engine::audioEngine()->framesPerPeriod(), Engine::audioEngine()->processingSampleRate())),
+	m_inputQueueReader(m_inputQueue),
+	m_inputOverflowed(false)
 {
+	// Other than note offs, the overflow doesn't take more events than the queue
+	m_inputOverflow.reserve(m_inputQueue.capacity());
+
 	m_midiClient->addPort( this );
 
 	m_readableModel.setValue( m_mode == Mode::Input || m_mode == Mode::Duplex );
@@ -98,6 +113,8 @@ MidiPort::MidiPort( const QString& name,
 
 MidiPort::~MidiPort()
 {
+	setInputQueued(false);
+
 	// unsubscribe ports
 	m_readableModel.setValue( false );
 	m_writableModel.setValue( false );
@@ -127,7 +144,128 @@ void MidiPort::setMode( Mode mode )
 
 
 
-void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time )
+void MidiPort::setInputQueued(bool queued)
+{
+	const auto lock = std::lock_guard{s_queuedPortsMutex};
+	if (queued == m_inputQueued) { return; }
+
+	if (queued)
+	{
+		s_queuedPorts.push_back(this);
+	}
+	else
+	{
+		s_queuedPorts.erase(std::find(s_queuedPorts.begin(), s_queuedPorts.end(), this));
+	}
+	m_inputQueued = queued;
+}
+
+
+
+
+void MidiPort::processQueuedInEvents(f_cnt_t frames, sample_rate_t sampleRate)
+{
+	// Rather than waiting for a port being added on the GUI thread, leave the events queued for the next period
+	auto lock = std::unique_lock{s_queuedPortsMutex, std::try_to_lock};
+	if (!lock.owns_lock()) { return; }
+
+	const auto periodLength = std::chrono::duration<double>{static_cast<double>(frames) / sampleRate};
+	const auto periodStart = Clock::now() - std::chrono::duration_cast<Clock::duration>(periodLength);
+	for (const auto port : s_queuedPorts)
+	{
+		port->processQueuedInEvents(periodStart, frames, sampleRate);
+	}
+}
+
+
+
+
+void MidiPort::processQueuedInEvents(Clock::time_point periodStart, f_cnt_t frames, sample_rate_t sampleRate)
+{
+	auto queued = QueuedEvent{};
+	while (m_inputQueueReader.read_space() > 0)
+	{
+		m_inputQueueReader.read(1).copy(&queued, 1);
+		m_midiEventProcessor->processInEvent(queued.event, queued.time,
+			inputFrameOffset(queued.timestamp, periodStart, frames, sampleRate));
+	}
+
+	// The overflowed events arrived after those in the queue. If the MIDI thread is adding one right now, they
+	// wait for the next period.
+	if (!m_inputOverflowed) { return; }
+	auto lock = std::unique_lock{m_inputOverflowMutex, std::try_to_lock};
+	if (!lock.owns_lock()) { return; }
+
+	for (const auto& overflowed : m_inputOverflow)
+	{
+		m_midiEventProcessor->processInEvent(overflowed.event, overflowed.time,
+			inputFrameOffset(overflowed.timestamp, periodStart, frames, sampleRate));
+	}
+	m_inputOverflow.clear();
+	m_inputOverflowed = false;
+}
+
+
+
+
+f_cnt_t MidiPort::inputFrameOffset(Clock::time_point timestamp, Clock::time_point periodStart, f_cnt_t frames,
+	sample_rate_t sampleRate)
+{
+	// Events which arrived before the last period, e.g. while the engine was busy, start right away
+	const auto delay = std::chrono::duration<double>{timestamp - periodStart}.count();
+	return static_cast<f_cnt_t>(std::clamp(delay * sampleRate, 0.0, frames - 1.0));
+}
+
+
+
+
+std::size_t MidiPort::inputQueueSize(fpp_t framesPerPeriod, sample_rate_t sampleRate)
+{
+	const auto events = static_cast<double>(InputQueuePeriods) * framesPerPeriod * MaxInputEventsPerSecond / sampleRate;
+	return std::max(MinInputQueueSize, static_cast<std::size_t>(std::ceil(events)));
+}
+
+
+
+
+bool MidiPort::releasesNotes(const MidiEvent& event)
+{
+	switch (event.type())
+	{
+		case MidiNoteOff:
+			return true;
+		case MidiNoteOn:
+			return event.velocity() == 0;
+		case MidiControlChange:
+			return event.controllerNumber() == MidiControllerAllNotesOff
+				|| event.controllerNumber() == MidiControllerAllSoundOff
+				|| (event.controllerNumber() == MidiControllerSustain && event.controllerValue() < 64);
+		default:
+			return false;
+	}
+}
+
+
+
+
+void MidiPort::queueInEvent(const QueuedEvent& queued)
+{
+	// The MIDI thread never waits for the audio engine unless the queue is full
+	if (!m_inputOverflowed && m_inputQueue.write(&queued, 1) == 1) { return; }
+
+	const auto lock = std::lock_guard{m_inputOverflowMutex};
+	m_inputOverflowed = true;
+	// Notes mustn't hang however busy the input is, other events are dropped once the overflow is full as well
+	if (releasesNotes(queued.event) || m_inputOverflow.size() < m_inputOverflow.capacity())
+	{
+		m_inputOverflow.push_back(queued);
+	}
+}
+
+
+
+
+void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time, Clock::time_point timestamp )
 {
 	// mask event
 	if( isInputEnabled() &&
@@ -149,6 +287,12 @@ void MidiPort::processInEvent( const MidiEvent& event, const TimePos& time )
 			}
 		}
 
+		if (m_inputQueued)
+		{
+			queueInEvent(QueuedEvent{inEvent, time, timestamp});
+			return;
+		}
+
 		m_midiEventProcessor->processInEvent( inEvent, time );
 	}
 }
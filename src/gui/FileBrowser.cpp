@@ -33,11 +33,14 @@
 #include <QLineEdit>
 #include <QMenu>
 #include <QPushButton>
+#include <QRunnable>
 #include <QMdiArea>
 #include <QMdiSubWindow>
 #include <QMessageBox>
 #include <QShortcut>
 #include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
 
 #include <queue>
 
@@ -69,6 +72,67 @@
 namespace lmms::gui
 {
 
+//! Shared between a Directory item, its tree widget and the worker thread
+//! listing the directory.
+struct DirectoryListing
+{
+	//! Only accessed from the GUI thread. Reset when the item is deleted.
+	Directory* directory;
+	QStringList paths;
+	QStringList nameFilters;
+	//! Whether each path is a factory directory, which gets a separator
+	std::vector<bool> factory;
+
+	std::mutex mutex;
+	std::vector<QFileInfoList> listed; //!< Entries of each path, in order
+	std::atomic<bool> finished = false;
+	std::atomic<bool> cancelled = false;
+
+	// Progress of the GUI thread
+	std::size_t path = 0;
+	int entry = 0;
+	int filesBeforeAdd = 0;
+};
+
+
+namespace
+{
+
+//! Lists the paths of a directory on the global thread pool. Listings of
+//! directories deleted while waiting in the pool's queue never touch the disk.
+class DirectoryLister : public QRunnable
+{
+public:
+	explicit DirectoryLister(std::shared_ptr<DirectoryListing> listing) :
+		m_listing(std::move(listing))
+	{
+	}
+
+	void run() override
+	{
+		for (const auto& path : m_listing->paths)
+		{
+			if (m_listing->cancelled) { break; }
+
+			auto entries = QFileInfoList{};
+			const auto dir = QDir{path};
+			if (!FileBrowser::directoryBlacklist().contains(path) && dir.isReadable())
+			{
+				entries = dir.entryInfoList(m_listing->nameFilters, FileBrowser::dirFilters(), FileBrowser::sortFlags());
+			}
+
+			const auto lock = std::lock_guard{m_listing->mutex};
+			m_listing->listed.push_back(std::move(entries));
+		}
+		m_listing->finished = true;
+	}
+
+private:
+	std::shared_ptr<DirectoryListing> m_listing;
+};
+
+} // namespace
+
 
 enum TreeWidgetItemTypes
 {
@@ -147,6 +211,8 @@ FileBrowser::FileBrowser(const QString & directories, const QString & filter,
 
 	m_fileBrowserTreeWidget = new FileBrowserTreeWidget( contentParent() );
 	addContentWidget( m_fileBrowserTreeWidget );
+	connect(m_fileBrowserTreeWidget, &FileBrowserTreeWidget::directoryPopulated,
+		this, &FileBrowser::restoreDirectoryState);
 
 	m_searchTreeWidget = new FileBrowserTreeWidget(contentParent());
 	m_searchTreeWidget->hide();
@@ -167,6 +233,8 @@ FileBrowser::FileBrowser(const QString & directories, const QString & filter,
 
 	m_previousFilterValue = "";
 
+	FileBrowserSearcher::instance()->prepare(m_directories.split('*'));
+
 	reloadTree();
 	show();
 }
@@ -178,6 +246,7 @@ void FileBrowser::saveDirectoriesStates()
 	
 void FileBrowser::restoreDirectoriesStates()
 {
+	if (m_savedExpandedDirs.isEmpty()) { return; }
 	expandItems(m_savedExpandedDirs);
 }
 
@@ -338,10 +407,8 @@ void FileBrowser::reloadTree()
 
 
 
-void FileBrowser::expandItems(const QList<QString>& expandedDirs, QTreeWidgetItem* item)
+void FileBrowser::expandItems(QList<QString>& expandedDirs, QTreeWidgetItem* item)
 {
-	if (expandedDirs.isEmpty()) { return; }
-
 	int numChildren = item ? item->childCount() : m_fileBrowserTreeWidget->topLevelItemCount();
 	for (int i = 0; i < numChildren; ++i)
 	{
@@ -349,7 +416,8 @@ void FileBrowser::expandItems(const QList<QString>& expandedDirs, QTreeWidgetIte
 		auto d = dynamic_cast<Directory*>(it);
 		if (d)
 		{
-			d->setExpanded(expandedDirs.contains(d->fullName()));
+			// once applied, an entry must not expand the directory again when the user reopens it later
+			d->setExpanded(expandedDirs.removeAll(d->fullName()) > 0);
 			if (it->childCount() > 0)
 			{
 				expandItems(expandedDirs, it);
@@ -362,6 +430,16 @@ void FileBrowser::expandItems(const QList<QString>& expandedDirs, QTreeWidgetIte
 
 
 
+void FileBrowser::restoreDirectoryState(QTreeWidgetItem* item)
+{
+	// Subdirectories only exist once their parent was populated, so the saved
+	// state is restored one level at a time until all of it was applied
+	if (m_savedExpandedDirs.isEmpty()) { return; }
+	expandItems(m_savedExpandedDirs, item);
+}
+
+
+
 void FileBrowser::giveFocusToFilter()
 {
 	if (!m_filterEdit->hasFocus())
@@ -479,6 +557,12 @@ FileBrowserTreeWidget::FileBrowserTreeWidget(QWidget * parent ) :
 	setColumnCount( 1 );
 	headerItem()->setHidden( true );
 	setSortingEnabled( false );
+	// All rows have the same height, which lets the view lay out only the visible ones
+	setUniformRowHeights( true );
+
+	m_listingTimer = new QTimer( this );
+	m_listingTimer->setInterval( 10 );
+	connect( m_listingTimer, SIGNAL(timeout()), SLOT(addListedEntries()));
 
 	connect( this, SIGNAL(itemDoubleClicked(QTreeWidgetItem*,int)),
 			SLOT(activateListItem(QTreeWidgetItem*,int)));
@@ -1013,6 +1097,52 @@ void FileBrowserTreeWidget::updateDirectory(QTreeWidgetItem * item )
 	}
 }
 
+
+
+
+void FileBrowserTreeWidget::listDirectory(std::shared_ptr<DirectoryListing> listing)
+{
+	QThreadPool::globalInstance()->start(new DirectoryLister{listing});
+
+	m_listings.push_back(std::move(listing));
+	m_listingTimer->start();
+}
+
+
+
+
+void FileBrowserTreeWidget::addListedEntries()
+{
+	auto budget = EntriesPerBatch;
+	auto populated = std::vector<Directory*>{};
+	auto it = m_listings.begin();
+	while (it != m_listings.end() && budget > 0)
+	{
+		const auto listing = *it;
+		if (!listing->directory)
+		{
+			it = m_listings.erase(it);
+			continue;
+		}
+
+		if (listing->directory->addListedEntries(*listing, budget))
+		{
+			populated.push_back(listing->directory);
+			it = m_listings.erase(it);
+			continue;
+		}
+		++it;
+	}
+
+	if (m_listings.empty()) { m_listingTimer->stop(); }
+
+	// Receivers may expand the new subdirectories, which starts new listings
+	for (const auto dir : populated)
+	{
+		emit directoryPopulated(dir);
+	}
+}
+
 Directory::Directory(const QString& filename, const QString& path, const QString& filter, bool disableEntryPopulation)
 	: QTreeWidgetItem(QStringList(filename), TypeDirectoryItem)
 	, m_directories(path)
@@ -1024,6 +1154,15 @@ Directory::Directory(const QString& filename, const QString& path, const QString
 	setChildIndicatorPolicy( QTreeWidgetItem::ShowIndicator );
 }
 
+Directory::~Directory()
+{
+	if (m_listing)
+	{
+		m_listing->directory = nullptr;
+		m_listing->cancelled = true;
+	}
+}
+
 void Directory::update()
 {
 	if( !isExpanded() )
@@ -1033,70 +1172,91 @@ void Directory::update()
 	}
 
 	setIcon(0, m_folderOpenedPixmap);
-	if (!m_disableEntryPopulation && !childCount())
+	if (!m_disableEntryPopulation && !childCount() && !m_listing)
 	{
+		auto tree = dynamic_cast<FileBrowserTreeWidget*>(treeWidget());
+		if (!tree) { return; }
+
 		m_dirCount = 0;
 		// for all paths leading here, add their items
+		m_listing = std::make_shared<DirectoryListing>();
+		m_listing->directory = this;
+		m_listing->nameFilters = m_filter.split(' ');
 		for (const auto& directory : m_directories)
 		{
-			int filesBeforeAdd = childCount() - m_dirCount;
-			if(addItems(fullName(directory)) && directory.contains(ConfigManager::inst()->dataDir()))
-			{
-				// factory file directory is added
-				// note: those are always added last
-				int filesNow = childCount() - m_dirCount;
-				if(filesNow > filesBeforeAdd) // any file appended?
-				{
-					auto sep = new QTreeWidgetItem;
-					sep->setText( 0,
-						FileBrowserTreeWidget::tr(
-							"--- Factory files ---" ) );
-					sep->setIcon( 0, embed::getIconPixmap(
-								"factory_files" ) );
-					// add delimeter after last file before appending our files
-					insertChild( filesBeforeAdd + m_dirCount, sep );
-				}
-			}
+			m_listing->paths.append(fullName(directory));
+			m_listing->factory.push_back(directory.contains(ConfigManager::inst()->dataDir()));
 		}
+		tree->listDirectory(m_listing);
 	}
 }
 
 
 
 
-bool Directory::addItems(const QString& path)
+bool Directory::addListedEntries(DirectoryListing& listing, int& budget)
 {
-	if (FileBrowser::directoryBlacklist().contains(path)) { return false; }
-
-	QDir thisDir(path);
-	if (!thisDir.isReadable()) { return false; }
+	while (budget > 0)
+	{
+		const bool finished = listing.finished;
+		auto entries = QFileInfoList{};
+		{
+			const auto lock = std::lock_guard{listing.mutex};
+			if (listing.path >= listing.listed.size())
+			{
+				if (!finished) { return false; }
 
-	treeWidget()->setUpdatesEnabled(false);
+				m_listing = nullptr;
+				return true;
+			}
+			entries = listing.listed[listing.path];
+		}
 
-	QFileInfoList entries
-		= thisDir.entryInfoList(m_filter.split(' '), FileBrowser::dirFilters(), FileBrowser::sortFlags());
-	for (const auto& entry : entries)
-	{
-		if (FileBrowser::directoryBlacklist().contains(entry.absoluteFilePath())) { continue; }
+		if (listing.entry == 0) { listing.filesBeforeAdd = childCount() - m_dirCount; }
 
-		QString fileName = entry.fileName();
-		if (entry.isDir())
+		const auto& path = listing.paths[listing.path];
+		auto items = QList<QTreeWidgetItem*>{};
+		for (; listing.entry < entries.size() && budget > 0; ++listing.entry, --budget)
 		{
-			auto dir = new Directory(fileName, path, m_filter);
-			addChild(dir);
-			m_dirCount++;
+			const auto& entry = entries[listing.entry];
+			if (FileBrowser::directoryBlacklist().contains(entry.absoluteFilePath())) { continue; }
+
+			QString fileName = entry.fileName();
+			if (entry.isDir())
+			{
+				items.append(new Directory(fileName, path, m_filter));
+				m_dirCount++;
+			}
+			else if (entry.isFile())
+			{
+				items.append(new FileItem(fileName, path));
+			}
 		}
-		else if (entry.isFile())
+		addChildren(items);
+
+		if (listing.entry < entries.size()) { return false; }
+
+		// This path is done
+		if (childCount() > 0 && listing.factory[listing.path])
 		{
-			auto fileItem = new FileItem(fileName, path);
-			addChild(fileItem);
+			// factory file directory is added
+			// note: those are always added last
+			int filesNow = childCount() - m_dirCount;
+			if (filesNow > listing.filesBeforeAdd) // any file appended?
+			{
+				auto sep = new QTreeWidgetItem;
+				sep->setText(0, FileBrowserTreeWidget::tr("--- Factory files ---"));
+				sep->setIcon(0, embed::getIconPixmap("factory_files"));
+				// add delimeter after last file before appending our files
+				insertChild(listing.filesBeforeAdd + m_dirCount, sep);
+			}
 		}
+
+		++listing.path;
+		listing.entry = 0;
 	}
-	
-	treeWidget()->setUpdatesEnabled(true);
-	
-	// return true if we added any child items
-	return childCount() > 0;
+
+	return false;
 }
 
 
@@ -1127,38 +1287,39 @@ FileItem::FileItem(const QString & name, const QString & path ) :
 
 void FileItem::initPixmaps()
 {
-	static auto s_projectFilePixmap = embed::getIconPixmap("project_file", 16, 16);
-	static auto s_presetFilePixmap = embed::getIconPixmap("preset_file", 16, 16);
-	static auto s_sampleFilePixmap = embed::getIconPixmap("sample_file", 16, 16);
-	static auto s_soundfontFilePixmap = embed::getIconPixmap("soundfont_file", 16, 16);
-	static auto s_vstPluginFilePixmap = embed::getIconPixmap("vst_plugin_file", 16, 16);
-	static auto s_midiFilePixmap = embed::getIconPixmap("midi_file", 16, 16);
-	static auto s_unknownFilePixmap = embed::getIconPixmap("unknown_file");
+	// Shared icons, so that large directories don't create one per item
+	static auto s_projectFileIcon = QIcon{embed::getIconPixmap("project_file", 16, 16)};
+	static auto s_presetFileIcon = QIcon{embed::getIconPixmap("preset_file", 16, 16)};
+	static auto s_sampleFileIcon = QIcon{embed::getIconPixmap("sample_file", 16, 16)};
+	static auto s_soundfontFileIcon = QIcon{embed::getIconPixmap("soundfont_file", 16, 16)};
+	static auto s_vstPluginFileIcon = QIcon{embed::getIconPixmap("vst_plugin_file", 16, 16)};
+	static auto s_midiFileIcon = QIcon{embed::getIconPixmap("midi_file", 16, 16)};
+	static auto s_unknownFileIcon = QIcon{embed::getIconPixmap("unknown_file")};
 
 	switch( m_type )
 	{
 		case FileType::Project:
-			setIcon(0, s_projectFilePixmap);
+			setIcon(0, s_projectFileIcon);
 			break;
 		case FileType::Preset:
-			setIcon(0, s_presetFilePixmap);
+			setIcon(0, s_presetFileIcon);
 			break;
 		case FileType::SoundFont:
-			setIcon(0, s_soundfontFilePixmap);
+			setIcon(0, s_soundfontFileIcon);
 			break;
 		case FileType::VstPlugin:
-			setIcon(0, s_vstPluginFilePixmap);
+			setIcon(0, s_vstPluginFileIcon);
 			break;
 		case FileType::Sample:
 		case FileType::Patch:			// TODO
-			setIcon(0, s_sampleFilePixmap);
+			setIcon(0, s_sampleFileIcon);
 			break;
 		case FileType::Midi:
-			setIcon(0, s_midiFilePixmap);
+			setIcon(0, s_midiFileIcon);
 			break;
 		case FileType::Unknown:
 		default:
-			setIcon(0, s_unknownFilePixmap);
+			setIcon(0, s_unknownFileIcon);
 			break;
 	}
 }
@@ -0,0 +1,308 @@
+/*
+ * FileBrowserIndex.cpp - Persistent index of a directory tree for the file browser
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "FileBrowserIndex.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <sndfile.h>
+
+#include "FileBrowser.h"
+
+namespace lmms::gui {
+
+namespace {
+
+constexpr quint32 IndexMagic = 0x4c464249; // "LFBI"
+constexpr quint32 IndexVersion = 1;
+constexpr int MaxDepth = 256;
+
+auto childPath(const QString& path, const QString& name) -> QString
+{
+	return path.endsWith('/') ? path + name : path + '/' + name;
+}
+
+auto suffixOf(const QString& name) -> QString
+{
+	const auto dot = name.lastIndexOf('.');
+	return dot < 0 ? QString{} : name.mid(dot + 1);
+}
+
+auto modificationTime(const QFileInfo& info) -> qint64
+{
+	return info.lastModified().toMSecsSinceEpoch();
+}
+
+} // namespace
+
+FileBrowserIndex::FileBrowserIndex(const QString& root)
+	: m_root(QDir{root}.absolutePath())
+{
+	m_tree.isDir = true;
+	load();
+}
+
+auto FileBrowserIndex::stale(std::chrono::steady_clock::duration interval) const -> bool
+{
+	return !m_refreshed || std::chrono::steady_clock::now() - m_lastRefresh > interval;
+}
+
+auto FileBrowserIndex::refresh(const std::atomic<bool>& cancel, const Query* query) -> bool
+{
+	if (!walk(m_tree, m_root, cancel, query, true, query != nullptr)) { return false; }
+
+	m_complete = true;
+	m_refreshed = true;
+	m_lastRefresh = std::chrono::steady_clock::now();
+	return true;
+}
+
+auto FileBrowserIndex::query(const Query& query, const std::atomic<bool>& cancel) -> bool
+{
+	return walk(m_tree, m_root, cancel, &query, false, true);
+}
+
+auto FileBrowserIndex::collectMetadata(const std::atomic<bool>& cancel) -> bool
+{
+	if (!m_metadataPending) { return true; }
+	if (!collectMetadata(m_tree, m_root, cancel)) { return false; }
+
+	m_metadataPending = false;
+	return true;
+}
+
+auto FileBrowserIndex::walk(Node& node, const QString& path, const std::atomic<bool>& cancel, const Query* query,
+	bool rescan, bool report) -> bool
+{
+	if (cancel) { return false; }
+	if (rescan) { list(node, path); }
+
+	for (auto& child : node.children)
+	{
+		if (cancel) { return false; }
+
+		const auto entryPath = childPath(path, child.name);
+		if (child.isDir && FileBrowser::directoryBlacklist().contains(entryPath)) { continue; }
+
+		const auto matched = report && matches(child, entryPath, *query);
+		if (matched) { query->onMatch(entryPath); }
+
+		// The contents of a matching directory are not reported, but still have to be kept up to date
+		if (child.isDir && (rescan || !matched))
+		{
+			if (!walk(child, entryPath, cancel, query, rescan, report && !matched)) { return false; }
+		}
+	}
+
+	return true;
+}
+
+auto FileBrowserIndex::list(Node& node, const QString& path) -> void
+{
+	const auto info = QFileInfo{path};
+	const auto modified = info.exists() ? modificationTime(info) : 0;
+	if (modified == node.modified) { return; }
+
+	auto previous = std::move(node.children);
+	auto previousIndex = QHash<QString, std::size_t>{};
+	for (auto i = std::size_t{0}; i < previous.size(); ++i)
+	{
+		previousIndex.insert(previous[i].name, i);
+	}
+
+	node.children.clear();
+	const auto entries = QDir{path}.entryInfoList(FileBrowser::dirFilters(), FileBrowser::sortFlags());
+	node.children.reserve(entries.size());
+
+	for (const auto& entry : entries)
+	{
+		auto child = Node{};
+		const auto it = previousIndex.find(entry.fileName());
+		if (it != previousIndex.end() && previous[*it].isDir == entry.isDir())
+		{
+			// Keep what we already know about the entry, including the listing of unchanged subdirectories
+			child = std::move(previous[*it]);
+		}
+		else
+		{
+			child.name = entry.fileName();
+			child.isDir = entry.isDir();
+		}
+
+		if (!child.isDir)
+		{
+			const auto fileModified = modificationTime(entry);
+			if (child.modified != fileModified)
+			{
+				child.modified = fileModified;
+				child.probed = false;
+				child.metadata = Metadata{};
+				m_metadataPending = true;
+			}
+		}
+
+		node.children.push_back(std::move(child));
+	}
+
+	node.modified = modified;
+	m_dirty = true;
+}
+
+auto FileBrowserIndex::matches(Node& node, const QString& path, const Query& query) -> bool
+{
+	if (!node.name.contains(query.filter, Qt::CaseInsensitive)) { return false; }
+	if (node.isDir) { return !query.metadataFilter.active(); }
+	if (!query.extensions.contains(suffixOf(node.name), Qt::CaseInsensitive)) { return false; }
+	if (!query.metadataFilter.active()) { return true; }
+
+	if (!node.probed) { probe(node, path); }
+	return query.metadataFilter.accepts(node.metadata);
+}
+
+auto FileBrowserIndex::probe(Node& node, const QString& path) -> void
+{
+	static const auto s_audioSuffixes
+		= QStringList{"wav", "ogg", "flac", "aif", "aiff", "au", "voc", "w64", "caf", "rf64", "mp3"};
+
+	node.probed = true;
+	node.metadata = Metadata{};
+	m_dirty = true;
+
+	if (!s_audioSuffixes.contains(suffixOf(node.name), Qt::CaseInsensitive)) { return; }
+
+	auto file = QFile{path};
+	if (!file.open(QIODevice::ReadOnly)) { return; }
+
+	auto sfInfo = SF_INFO{};
+	const auto sndFile = sf_open_fd(file.handle(), SFM_READ, &sfInfo, false);
+	if (!sndFile) { return; }
+
+	node.metadata.sampleRate = sfInfo.samplerate;
+	node.metadata.channels = sfInfo.channels;
+	node.metadata.frames = sfInfo.frames;
+	sf_close(sndFile);
+}
+
+auto FileBrowserIndex::collectMetadata(Node& node, const QString& path, const std::atomic<bool>& cancel) -> bool
+{
+	for (auto& child : node.children)
+	{
+		if (cancel) { return false; }
+
+		const auto entryPath = childPath(path, child.name);
+		if (child.isDir)
+		{
+			if (FileBrowser::directoryBlacklist().contains(entryPath)) { continue; }
+			if (!collectMetadata(child, entryPath, cancel)) { return false; }
+		}
+		else if (!child.probed) { probe(child, entryPath); }
+	}
+
+	return true;
+}
+
+auto FileBrowserIndex::cacheFile() const -> QString
+{
+	const auto hash = QCryptographicHash::hash(m_root.toUtf8(), QCryptographicHash::Sha1).toHex();
+	return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/filebrowser/"
+		+ QString::fromLatin1(hash) + ".idx";
+}
+
+auto FileBrowserIndex::load() -> void
+{
+	auto file = QFile{cacheFile()};
+	if (!file.open(QIODevice::ReadOnly)) { return; }
+
+	auto stream = QDataStream{&file};
+	stream.setVersion(QDataStream::Qt_5_6);
+
+	auto magic = quint32{0};
+	auto version = quint32{0};
+	auto root = QString{};
+	auto complete = false;
+	stream >> magic >> version;
+	if (magic != IndexMagic || version != IndexVersion) { return; }
+
+	stream >> root >> complete;
+	if (root != m_root) { return; }
+
+	auto tree = Node{};
+	if (!readNode(stream, tree, 0) || !tree.isDir) { return; }
+
+	m_tree = std::move(tree);
+	m_complete = complete;
+}
+
+auto FileBrowserIndex::save() -> void
+{
+	if (!m_dirty) { return; }
+
+	const auto fileName = cacheFile();
+	QDir{}.mkpath(QFileInfo{fileName}.absolutePath());
+
+	auto file = QSaveFile{fileName};
+	if (!file.open(QIODevice::WriteOnly)) { return; }
+
+	auto stream = QDataStream{&file};
+	stream.setVersion(QDataStream::Qt_5_6);
+	stream << IndexMagic << IndexVersion << m_root << m_complete;
+	writeNode(stream, m_tree);
+
+	if (stream.status() == QDataStream::Ok && file.commit()) { m_dirty = false; }
+}
+
+auto FileBrowserIndex::readNode(QDataStream& stream, Node& node, int depth) -> bool
+{
+	auto childCount = quint32{0};
+	stream >> node.name >> node.isDir >> node.probed >> node.modified >> node.metadata.sampleRate
+		>> node.metadata.channels >> node.metadata.frames >> childCount;
+	if (stream.status() != QDataStream::Ok || depth > MaxDepth) { return false; }
+
+	// Grow one entry at a time so a corrupted count fails on the read instead of the allocation
+	for (auto i = quint32{0}; i < childCount; ++i)
+	{
+		node.children.emplace_back();
+		if (!readNode(stream, node.children.back(), depth + 1)) { return false; }
+	}
+
+	return true;
+}
+
+auto FileBrowserIndex::writeNode(QDataStream& stream, const Node& node) -> void
+{
+	stream << node.name << node.isDir << node.probed << node.modified << node.metadata.sampleRate
+		<< node.metadata.channels << node.metadata.frames << static_cast<quint32>(node.children.size());
+
+	for (const auto& child : node.children)
+	{
+		writeNode(stream, child);
+	}
+}
+
+} // namespace lmms::gui
@@ -25,8 +25,8 @@
 #include "FileBrowserSearcher.h"
 
 #include <QDir>
-#include <stack>
 
+#include "ConfigManager.h"
 #include "FileBrowser.h"
 
 namespace lmms::gui {
@@ -44,35 +44,78 @@ FileBrowserSearcher::~FileBrowserSearcher()
 	m_worker.join();
 }
 
-auto FileBrowserSearcher::search(const QString& filter, const QStringList& paths, const QStringList& extensions)
-	-> std::shared_ptr<SearchFuture>
+auto FileBrowserSearcher::search(const QString& filter, const QStringList& paths, const QStringList& extensions,
+	const FileBrowserIndex::MetadataFilter& metadataFilter) -> std::shared_ptr<SearchFuture>
 {
-	m_cancelRunningSearch = true;
-	auto future = std::make_shared<SearchFuture>(filter, paths, extensions);
+	auto future = std::make_shared<SearchFuture>(filter, paths, extensions, metadataFilter);
 
 	{
+		// The worker only holds the lock to pick up work, never while touching the filesystem
 		const auto lock = std::lock_guard{m_workerMutex};
 		m_searchQueue.push(future);
-		m_cancelRunningSearch = false;
+		m_cancelRunningSearch = true;
 	}
 
 	m_workerCond.notify_one();
 	return future;
 }
 
+auto FileBrowserSearcher::prepare(const QStringList& paths) -> void
+{
+	const auto lock = std::lock_guard{m_pendingPathsMutex};
+	for (const auto& path : paths)
+	{
+		if (indexedInBackground(path)) { m_pendingPaths.append(path); }
+	}
+}
+
+auto FileBrowserSearcher::indexedInBackground(const QString& path) -> bool
+{
+	const auto config = ConfigManager::inst();
+	const auto roots = QStringList{config->userSamplesDir(), config->userPresetsDir(), config->userProjectsDir(),
+		config->factorySamplesDir(), config->factoryPresetsDir(), config->factoryProjectsDir()};
+
+	const auto absolutePath = QDir::cleanPath(QDir{path}.absolutePath());
+	for (const auto& root : roots)
+	{
+		const auto absoluteRoot = QDir::cleanPath(QDir{root}.absolutePath());
+		if (absolutePath == absoluteRoot || absolutePath.startsWith(absoluteRoot + '/')) { return true; }
+	}
+	return false;
+}
+
 auto FileBrowserSearcher::run() -> void
 {
 	while (true)
 	{
 		auto lock = std::unique_lock{m_workerMutex};
-		m_workerCond.wait(lock, [this] { return m_workerStopped || !m_searchQueue.empty(); });
+		const auto woken
+			= m_workerCond.wait_for(lock, IdleInterval, [this] { return m_workerStopped || !m_searchQueue.empty(); });
 
-		if (m_workerStopped) { return; }
+		if (m_workerStopped)
+		{
+			lock.unlock();
+			for (auto& [path, index] : m_indexes) { index->save(); }
+			return;
+		}
+
+		if (!woken)
+		{
+			// A cancelled search may have left the flag set
+			m_cancelRunningSearch = false;
+			lock.unlock();
+			maintain();
+			continue;
+		}
 
 		const auto future = m_searchQueue.front();
 		future->m_state = SearchFuture::State::Running;
 		m_searchQueue.pop();
 
+		// Only searches queued from now on cancel this one
+		m_cancelRunningSearch = !m_searchQueue.empty();
+		lock.unlock();
+
 		auto cancelled = false;
 		for (const auto& path : future->m_paths)
 		{
@@ -92,44 +135,55 @@ auto FileBrowserSearcher::run() -> void
 
 auto FileBrowserSearcher::process(SearchFuture* searchFuture, const QString& path) -> bool
 {
-	auto stack = QFileInfoList{};
-
-	auto dir = QDir{path};
-	stack.append(dir.entryInfoList(FileBrowser::dirFilters(), FileBrowser::sortFlags()));
+	auto query = FileBrowserIndex::Query{};
+	query.filter = searchFuture->m_filter;
+	query.extensions = searchFuture->m_extensions;
+	query.metadataFilter = searchFuture->m_metadataFilter;
+	query.onMatch = [searchFuture](const QString& match) { searchFuture->addMatch(match); };
+
+	// Unless the index was just brought up to date, the searched tree is refreshed while answering, which only lists
+	// the directories that changed and reports matches as it goes. That also completes a new index.
+	auto& pathIndex = index(path);
+	return pathIndex.stale(SearchRefreshInterval)
+		? pathIndex.refresh(m_cancelRunningSearch, &query)
+		: pathIndex.query(query, m_cancelRunningSearch);
+}
 
-	while (!stack.empty())
+auto FileBrowserSearcher::maintain() -> void
+{
+	auto pendingPaths = QStringList{};
 	{
-		if (m_cancelRunningSearch)
-		{
-			m_cancelRunningSearch = false;
-			return false;
-		}
+		const auto lock = std::lock_guard{m_pendingPathsMutex};
+		pendingPaths.swap(m_pendingPaths);
+	}
 
-		const auto info = stack.takeFirst();
-		const auto path = info.absoluteFilePath();
-		if (FileBrowser::directoryBlacklist().contains(path)) { continue; }
+	for (const auto& path : pendingPaths)
+	{
+		if (!FileBrowser::directoryBlacklist().contains(path)) { m_backgroundRoots.insert(index(path).root()); }
+	}
 
-		const auto name = info.fileName();
-		const auto validFile = info.isFile() && searchFuture->m_extensions.contains(info.suffix(), Qt::CaseInsensitive);
-		const auto passesFilter = name.contains(searchFuture->m_filter, Qt::CaseInsensitive);
+	for (auto& [path, index] : m_indexes)
+	{
+		// Other indexes were built by searches and are only refreshed by them, so searching "/" once doesn't keep
+		// the whole filesystem and every audio file on it busy in the background
+		if (m_backgroundRoots.count(path) == 0) { continue; }
 
-		// Only when a directory doesn't pass the filter should we search further
-		if (info.isDir() && !passesFilter)
-		{
-			dir.setPath(path);
-			auto entries = dir.entryInfoList(FileBrowser::dirFilters(), FileBrowser::sortFlags());
+		const auto finished = (!index->stale(RefreshInterval) || index->refresh(m_cancelRunningSearch))
+			&& index->collectMetadata(m_cancelRunningSearch);
 
-			// Reverse to maintain the sorting within this directory when popped
-			std::reverse(entries.begin(), entries.end());
+		// Whatever was done so far is worth keeping, even if a search interrupted us
+		index->save();
 
-			for (const auto& entry : entries)
-			{
-				stack.push_front(entry);
-			}
-		}
-		else if ((validFile || info.isDir()) && passesFilter) { searchFuture->addMatch(path); }
+		if (!finished) { return; }
 	}
-	return true;
+}
+
+auto FileBrowserSearcher::index(const QString& path) -> FileBrowserIndex&
+{
+	const auto root = QDir{path}.absolutePath();
+	auto& index = m_indexes[root];
+	if (!index) { index = std::make_unique<FileBrowserIndex>(root); }
+	return *index;
 }
 
 } // namespace lmms::gui
@@ -31,6 +31,7 @@
 #include "CPULoadWidget.h"
 #include "embed.h"
 #include "Engine.h"
+#include "Song.h"
 
 
 namespace lmms::gui
@@ -99,9 +100,20 @@ void CPULoadWidget::updateCpuLoad()
 	if (new_load != m_currentLoad)
 	{
 		auto engine = Engine::audioEngine();
+
+		// List the controllers which take a noticeable share on their own
+		auto controllerLoads = QString{};
+		for (const auto controller : Engine::getSong()->controllers())
+		{
+			if (controller->evaluationLoad() < 1) { continue; }
+			controllerLoads += tr("    %1: %2%").arg(controller->name()).arg(controller->evaluationLoad()) + "\n";
+		}
+
 		setToolTip(
 			tr("DSP total: %1%").arg(new_load) + "\n"
 			+ tr(" - Notes and setup: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::NoteSetup)) + "\n"
+			+ tr(" - Controllers: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Controllers)) + "\n"
+			+ controllerLoads
 			+ tr(" - Instruments: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Instruments)) + "\n"
 			+ tr(" - Effects: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Effects)) + "\n"
 			+ tr(" - Mixing: %1%").arg(engine->detailLoad(AudioEngineProfiler::DetailType::Mixing))
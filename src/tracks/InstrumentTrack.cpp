@@ -110,6 +110,9 @@ InstrumentTrack::InstrumentTrack( TrackContainer* tc ) :
 	connect(&m_pitchModel, SIGNAL(dataChanged()), this, SLOT(updatePitch()), Qt::DirectConnection);
 	connect(&m_pitchRangeModel, SIGNAL(dataChanged()), this, SLOT(updatePitchRange()), Qt::DirectConnection);
 	connect(&m_mixerChannelModel, SIGNAL(dataChanged()), this, SLOT(updateMixerChannel()), Qt::DirectConnection);
+
+	// Live input reaches the instrument at the start of a period, placed as precisely as its notes can be
+	m_midiPort.setInputQueued(true);
 }
 
 
@@ -203,6 +206,9 @@ float InstrumentTrack::baseFreq() const
 
 InstrumentTrack::~InstrumentTrack()
 {
+	// No more input from the audio engine while the track goes away
+	m_midiPort.setInputQueued(false);
+
 	// De-assign midi device
 	if (m_hasAutoMidiDev)
 	{
@@ -778,9 +784,21 @@ bool InstrumentTrack::play( const TimePos & _start, const fpp_t _frames,
 		{
 			// If the note is a Step Note, frames will be 0 so the NotePlayHandle
 			// plays for the whole length of the sample
-			const auto note_frames = cur_note->type() == Note::Type::Step
-				? 0
-				: cur_note->length().frames(frames_per_tick);
+			auto note_frames = f_cnt_t{0};
+			if (cur_note->type() != Note::Type::Step)
+			{
+				note_frames = cur_note->length().frames(frames_per_tick);
+
+				// Notes of the song last as long as the tempo map says, however the tempo changes meanwhile
+				const auto song = Engine::getSong();
+				if (song->playMode() == Song::PlayMode::Song)
+				{
+					const auto& tempoMap = song->playbackTempoMap();
+					const auto songTick = song->getPlayPos(Song::PlayMode::Song).getTicks();
+					note_frames = static_cast<f_cnt_t>(tempoMap.frames(songTick + cur_note->length().getTicks())
+						- tempoMap.frames(songTick));
+				}
+			}
 
 			NotePlayHandle* notePlayHandle = NotePlayHandleManager::acquire( this, _offset, note_frames, *cur_note );
 			notePlayHandle->setPatternTrack(pattern_track);
@@ -108,9 +108,12 @@ bool SampleTrack::play( const TimePos & _start, const fpp_t _frames,
 			{
 				if( sClip->isPlaying() == false && _start >= (sClip->startPosition() + sClip->startTimeOffset()) )
 				{
-					auto bufferFramesPerTick = Engine::framesPerTick(sClip->sample().sampleRate());
-					f_cnt_t sampleStart = bufferFramesPerTick * ( _start - sClip->startPosition() - sClip->startTimeOffset() );
-					f_cnt_t clipFrameLength = bufferFramesPerTick * ( sClip->endPosition() - sClip->startPosition() - sClip->startTimeOffset() );
+					// Samples play in real time, so they start and end where the tempo map puts their ticks
+					const auto& tempoMap = Engine::getSong()->playbackTempoMap();
+					const auto bufferFramesPerFrame = static_cast<double>(sClip->sample().sampleRate()) / tempoMap.sampleRate();
+					const auto sampleBegin = tempoMap.frames(sClip->startPosition() + sClip->startTimeOffset());
+					f_cnt_t sampleStart = bufferFramesPerFrame * (tempoMap.frames(_start) - sampleBegin);
+					f_cnt_t clipFrameLength = bufferFramesPerFrame * (tempoMap.frames(sClip->endPosition()) - sampleBegin);
 					f_cnt_t sampleBufferLength = sClip->sample().sampleSize();
 					//if the Clip smaller than the sample length we play only until Clip end
 					//else we play the sample to the end but nothing more
@@ -0,0 +1,90 @@
+/*
+ * GenerateProject.cpp - writes generated projects of a given size for load and scaling tests
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <cstdio>
+#include <cstdlib>
+
+#include "Engine.h"
+#include "Song.h"
+#include "SyntheticProject.h"
+
+int main(int argc, char** argv)
+{
+	using namespace lmms;
+
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("lmms-genproject");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Writes a generated project. The same size and seed always give the same project.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("output", "Project file to write, ending in .mmp or .mmpz.");
+
+	const QCommandLineOption sizeOption({"s", "size"},
+		QString("Size of the project: one of %1, optionally followed by dimensions to change, e.g. "
+			"\"large,seed=3\". The dimensions are seed, tracks, voices, clips, effects, automation, samples, "
+			"patterns, mixer, sends and bars.").arg(SyntheticProjectSize::profiles().join(", ")),
+		"size", "small");
+	parser.addOption(sizeOption);
+	parser.process(app);
+
+	const auto outputs = parser.positionalArguments();
+	if (outputs.size() != 1)
+	{
+		parser.showHelp(EXIT_FAILURE);
+	}
+
+	bool ok;
+	const auto size = SyntheticProjectSize::fromString(parser.value(sizeOption), &ok);
+	if (!ok)
+	{
+		fprintf(stderr, "Invalid project size: %s\n", parser.value(sizeOption).toUtf8().constData());
+		return EXIT_FAILURE;
+	}
+
+	Engine::init(true);
+
+	const auto stats = generateSyntheticProject(Engine::getSong(), size);
+	if (stats.missingSamples > 0)
+	{
+		fprintf(stderr, "%d factory samples could not be loaded, their clips will be silent\n", stats.missingSamples);
+	}
+
+	const auto saved = Engine::getSong()->saveProjectFile(outputs.front());
+
+	auto report = stats.toJson();
+	report["size"] = size.toString();
+	const auto json = QJsonDocument(report).toJson();
+	fwrite(json.constData(), 1, json.size(), stdout);
+
+	Engine::destroy();
+
+	if (!saved)
+	{
+		fprintf(stderr, "Could not write %s\n", outputs.front().toUtf8().constData());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
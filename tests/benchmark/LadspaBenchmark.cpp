@@ -0,0 +1,140 @@
+/*
+ * LadspaBenchmark.cpp - measures the LADSPA scan at startup with and without the metadata cache
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QStandardPaths>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "LadspaManager.h"
+
+int main(int argc, char** argv)
+{
+	using namespace lmms;
+	using Clock = std::chrono::steady_clock;
+
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("lmms-bench-ladspa");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measures how long scanning the LADSPA plugins takes with and without the "
+		"metadata cache and reports the median times in milliseconds as JSON.");
+	parser.addHelpOption();
+
+	const QCommandLineOption runsOption("runs", "Number of scans per measurement, the median is reported (default 9).",
+		"count", "9");
+	const QCommandLineOption outputOption({"o", "output"}, "Write the report to <file> instead of stdout.", "file");
+	// Every scan runs in a process of its own, so no library is loaded yet when it starts
+	const QCommandLineOption scanOption("scan", "Scan once and only print the time and the number of plugins, "
+		"used by the benchmark itself.");
+	parser.addOptions({runsOption, outputOption, scanOption});
+	parser.process(app);
+
+	// Keep the cache away from the user's one
+	QStandardPaths::setTestModeEnabled(true);
+
+	if (parser.isSet(scanOption))
+	{
+		const auto start = Clock::now();
+		auto manager = LadspaManager{};
+		const auto milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+		const auto line = QString::number(milliseconds) + ' ' + QString::number(manager.getSortedPlugins().size());
+		puts(line.toUtf8().constData());
+		return EXIT_SUCCESS;
+	}
+
+	bool runsOk;
+	const auto runs = parser.value(runsOption).toInt(&runsOk);
+	if (!runsOk || runs <= 0)
+	{
+		fprintf(stderr, "Invalid number of runs\n");
+		return EXIT_FAILURE;
+	}
+
+	auto plugins = 0;
+	const auto scan = [&]
+	{
+		QProcess process;
+		process.start(QCoreApplication::applicationFilePath(), {"--scan"});
+		auto milliseconds = -1.0;
+		if (process.waitForFinished(-1) && process.exitCode() == EXIT_SUCCESS)
+		{
+			const auto fields = QString::fromUtf8(process.readAllStandardOutput()).trimmed().split(' ');
+			if (fields.size() == 2)
+			{
+				milliseconds = fields[0].toDouble();
+				plugins = fields[1].toInt();
+			}
+		}
+		return milliseconds;
+	};
+
+	const auto measure = [&](bool cached)
+	{
+		auto milliseconds = std::vector<double>{};
+		for (int run = 0; run < runs; ++run)
+		{
+			if (cached) { scan(); }
+			else { QFile::remove(LadspaManager::cacheFile()); }
+
+			milliseconds.push_back(scan());
+		}
+		std::sort(milliseconds.begin(), milliseconds.end());
+		return milliseconds[milliseconds.size() / 2];
+	};
+
+	auto report = QJsonObject{};
+	report["runs"] = runs;
+	report["withoutCacheMs"] = measure(false);
+	report["withCacheMs"] = measure(true);
+	report["plugins"] = plugins;
+	if (report["withoutCacheMs"].toDouble() < 0 || report["withCacheMs"].toDouble() < 0)
+	{
+		fprintf(stderr, "A scan failed\n");
+		return EXIT_FAILURE;
+	}
+
+	const auto json = QJsonDocument(report).toJson();
+	if (parser.isSet(outputOption))
+	{
+		QFile file(parser.value(outputOption));
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		{
+			fprintf(stderr, "Could not write %s\n", file.fileName().toUtf8().constData());
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		fwrite(json.constData(), 1, json.size(), stdout);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,211 @@
+/*
+ * MixHelpersBenchmark.cpp - measures the mixing kernels on their own
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include "MixHelpers.h"
+#include "ValueBuffer.h"
+#include "denormals.h"
+
+namespace
+{
+
+using namespace lmms;
+
+struct Buffers
+{
+	explicit Buffers(int frames) :
+		dst(frames),
+		src(frames),
+		silence(frames),
+		left(frames),
+		right(frames),
+		coeffs1(frames),
+		coeffs2(frames),
+		ramp(frames)
+	{
+		auto random = std::mt19937{1};
+		auto dist = std::uniform_real_distribution<float>{-1.f, 1.f};
+		for (int f = 0; f < frames; ++f)
+		{
+			src[f] = {dist(random), dist(random)};
+			left[f] = src[f][0];
+			right[f] = src[f][1];
+			coeffs1.values()[f] = dist(random);
+			coeffs2.values()[f] = dist(random);
+			ramp.values()[f] = 50.f + 50.f * f / frames;
+		}
+	}
+
+	std::vector<sampleFrame> dst;
+	std::vector<sampleFrame> src;
+	std::vector<sampleFrame> silence; //!< Makes isSilent() look at every frame
+	std::vector<sample_t> left;
+	std::vector<sample_t> right;
+	ValueBuffer coeffs1;
+	ValueBuffer coeffs2;
+	ValueBuffer ramp;
+};
+
+struct Kernel
+{
+	const char* name;
+	std::function<void(Buffers&, int)> run;
+};
+
+std::vector<Kernel> kernels()
+{
+	namespace mh = MixHelpers;
+	return {
+		{"isSilent", [](Buffers& b, int frames) { b.dst[0][0] += mh::isSilent(b.silence.data(), frames) ? 1.f : 0.f; }},
+		{"sanitize", [](Buffers& b, int frames) { mh::sanitize(b.dst.data(), frames); }},
+		{"add", [](Buffers& b, int frames) { mh::add(b.dst.data(), b.src.data(), frames); }},
+		{"addMultiplied", [](Buffers& b, int frames) { mh::addMultiplied(b.dst.data(), b.src.data(), 0.5f, frames); }},
+		{"addSwappedMultiplied", [](Buffers& b, int frames) {
+			mh::addSwappedMultiplied(b.dst.data(), b.src.data(), 0.5f, frames); }},
+		{"addMultipliedByBuffer", [](Buffers& b, int frames) {
+			mh::addMultipliedByBuffer(b.dst.data(), b.src.data(), 0.5f, &b.coeffs1, frames); }},
+		{"addMultipliedByBuffers", [](Buffers& b, int frames) {
+			mh::addMultipliedByBuffers(b.dst.data(), b.src.data(), &b.coeffs1, &b.coeffs2, frames); }},
+		{"addSanitizedMultiplied", [](Buffers& b, int frames) {
+			mh::addSanitizedMultiplied(b.dst.data(), b.src.data(), 0.5f, frames); }},
+		{"addSanitizedMultipliedByBuffer", [](Buffers& b, int frames) {
+			mh::addSanitizedMultipliedByBuffer(b.dst.data(), b.src.data(), 0.5f, &b.coeffs1, frames); }},
+		{"addSanitizedMultipliedByBuffers", [](Buffers& b, int frames) {
+			mh::addSanitizedMultipliedByBuffers(b.dst.data(), b.src.data(), &b.coeffs1, &b.coeffs2, frames); }},
+		{"addSanitizedMultipliedBySpans", [](Buffers& b, int frames) {
+			mh::addSanitizedMultipliedBySpans(b.dst.data(), b.src.data(), ValueSpan(b.coeffs1.values(), frames),
+				ValueSpan(0.5f, 1.f, frames), frames); }},
+		{"addMultipliedStereo", [](Buffers& b, int frames) {
+			mh::addMultipliedStereo(b.dst.data(), b.src.data(), 0.3f, 0.7f, frames); }},
+		{"multiplyByVolumeAndPanning (constant)", [](Buffers& b, int frames) {
+			mh::multiplyByVolumeAndPanning(b.dst.data(), ValueSpan(100.f, frames), ValueSpan(-20.f, frames), frames); }},
+		{"multiplyByVolumeAndPanning (automated)", [](Buffers& b, int frames) {
+			mh::multiplyByVolumeAndPanning(b.dst.data(), ValueSpan(b.ramp.values(), frames),
+				ValueSpan(-20.f, 20.f, frames), frames); }},
+		{"multiplyAndAddMultiplied", [](Buffers& b, int frames) {
+			mh::multiplyAndAddMultiplied(b.dst.data(), b.src.data(), 0.5f, 0.5f, frames); }},
+		{"multiplyAndAddMultipliedJoined", [](Buffers& b, int frames) {
+			mh::multiplyAndAddMultipliedJoined(b.dst.data(), b.left.data(), b.right.data(), 0.5f, 0.5f, frames); }},
+	};
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	using namespace lmms;
+	using Clock = std::chrono::steady_clock;
+
+	disable_denormals();
+
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("lmms-bench-mixhelpers");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measures the MixHelpers kernels on their own and reports the time per frame as JSON.");
+	parser.addHelpOption();
+
+	const QCommandLineOption framesOption("frames", "Frames per call, like the period size (default 256).",
+		"count", "256");
+	const QCommandLineOption callsOption("calls", "Number of calls per measurement (default 10000).", "count", "10000");
+	const QCommandLineOption runsOption("runs", "Number of measurements per kernel, the median is reported (default 9).",
+		"count", "9");
+	const QCommandLineOption outputOption({"o", "output"}, "Write the report to <file> instead of stdout.", "file");
+	parser.addOptions({framesOption, callsOption, runsOption, outputOption});
+	parser.process(app);
+
+	bool framesOk, callsOk, runsOk;
+	const auto frames = parser.value(framesOption).toInt(&framesOk);
+	const auto calls = parser.value(callsOption).toInt(&callsOk);
+	const auto runs = parser.value(runsOption).toInt(&runsOk);
+	if (!framesOk || !callsOk || !runsOk || frames <= 0 || calls <= 0 || runs <= 0)
+	{
+		fprintf(stderr, "Invalid number of frames, calls or runs\n");
+		return EXIT_FAILURE;
+	}
+
+	// the sanitizing kernels only do their work with the NaN handler on, as the audio engine usually runs them
+	MixHelpers::setNaNHandler(true);
+
+	auto buffers = Buffers{frames};
+	auto results = QJsonArray{};
+	for (const auto& kernel : kernels())
+	{
+		auto nanosecondsPerFrame = std::vector<double>{};
+		for (int run = 0; run < runs; ++run)
+		{
+			// keep the destination from growing without bounds over many calls
+			std::fill(buffers.dst.begin(), buffers.dst.end(), sampleFrame{});
+
+			const auto start = Clock::now();
+			for (int call = 0; call < calls; ++call)
+			{
+				kernel.run(buffers, frames);
+			}
+			const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			nanosecondsPerFrame.push_back(elapsed / (static_cast<double>(calls) * frames));
+		}
+
+		std::sort(nanosecondsPerFrame.begin(), nanosecondsPerFrame.end());
+		auto result = QJsonObject{};
+		result["kernel"] = kernel.name;
+		result["nsPerFrame"] = nanosecondsPerFrame[nanosecondsPerFrame.size() / 2];
+		result["minNsPerFrame"] = nanosecondsPerFrame.front();
+		results.append(result);
+	}
+
+	auto report = QJsonObject{};
+	report["framesPerCall"] = frames;
+	report["calls"] = calls;
+	report["runs"] = runs;
+	report["results"] = results;
+
+	const auto json = QJsonDocument(report).toJson();
+	if (parser.isSet(outputOption))
+	{
+		QFile file(parser.value(outputOption));
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		{
+			fprintf(stderr, "Could not write %s\n", file.fileName().toUtf8().constData());
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		fwrite(json.constData(), 1, json.size(), stdout);
+	}
+
+	return EXIT_SUCCESS;
+}
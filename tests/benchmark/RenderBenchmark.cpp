@@ -0,0 +1,504 @@
+/*
+ * RenderBenchmark.cpp - renders projects as fast as possible and reports how long it took
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+#include "lmmsconfig.h"
+
+#ifdef LMMS_BUILD_WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "AudioDevice.h"
+#include "AudioEngine.h"
+#include "AudioEngineProfiler.h"
+#include "Engine.h"
+#include "Song.h"
+#include "SyntheticProject.h"
+#include "denormals.h"
+
+namespace
+{
+
+//! Number of calls to operator new since the start of the program, from any thread
+std::atomic<std::uint64_t> s_allocations{0};
+
+} // namespace
+
+// Counting every allocation is the only way to see allocations made by plugins and the engine alike.
+// The aligned variants are left alone; they are rare and pair with their own operator delete.
+void* operator new(std::size_t size)
+{
+	s_allocations.fetch_add(1, std::memory_order_relaxed);
+	if (void* ptr = std::malloc(size > 0 ? size : 1)) { return ptr; }
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+
+namespace lmms
+{
+
+namespace
+{
+
+//! Output device that throws the audio away, so rendering is only limited by the engine itself
+class NullAudioDevice : public AudioDevice
+{
+public:
+	NullAudioDevice(AudioEngine* audioEngine) :
+		AudioDevice(DEFAULT_CHANNELS, audioEngine)
+	{
+	}
+
+	bool needsFifo() override
+	{
+		return false;
+	}
+};
+
+
+struct BenchmarkSettings
+{
+	int warmupPeriods;
+	int periods;
+};
+
+
+//! Peak resident set size of the process in KiB, or -1 if unknown
+qint64 peakRssKiB()
+{
+#ifdef LMMS_BUILD_WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+	}
+	return -1;
+#else
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) { return -1; }
+#ifdef LMMS_BUILD_APPLE
+	return static_cast<qint64>(usage.ru_maxrss / 1024); // bytes on macOS
+#else
+	return static_cast<qint64>(usage.ru_maxrss);
+#endif
+#endif
+}
+
+
+//! Loops over the whole song, so every project can be measured for the same number of periods
+void loopWholeSong(Song* song)
+{
+	Timeline& timeline = song->getTimeline(Song::PlayMode::Song);
+	timeline.setLoopPoints(TimePos{0}, TimePos{std::max(song->length(), 1), 0});
+	timeline.setLoopEnabled(true);
+}
+
+
+//! Plays the song and renders the requested number of periods
+QJsonObject renderSong(const QString& name, double loadSeconds, const BenchmarkSettings& settings)
+{
+	using Clock = std::chrono::steady_clock;
+	using DetailType = AudioEngineProfiler::DetailType;
+
+	AudioEngine* audioEngine = Engine::audioEngine();
+	AudioDevice* device = audioEngine->audioDev();
+	const AudioEngineProfiler& profiler = audioEngine->profiler();
+
+	Song* song = Engine::getSong();
+	song->playSong();
+
+	for (int p = 0; p < settings.warmupPeriods; ++p)
+	{
+		device->processNextBuffer();
+	}
+
+	// Allocate everything needed for the measurement up front, so only the engine's allocations are counted
+	auto periodTimes = std::vector<double>(settings.periods);
+	auto stageTimes = std::array<std::int64_t, AudioEngineProfiler::DetailCount>{};
+
+	const auto allocationsBefore = s_allocations.load(std::memory_order_relaxed);
+	const auto renderStart = Clock::now();
+
+	for (auto& periodTime : periodTimes)
+	{
+		const auto periodStart = Clock::now();
+		device->processNextBuffer();
+		periodTime = std::chrono::duration<double, std::micro>(Clock::now() - periodStart).count();
+
+		for (std::size_t i = 0; i < AudioEngineProfiler::DetailCount; ++i)
+		{
+			stageTimes[i] += profiler.detailTime(static_cast<DetailType>(i));
+		}
+	}
+
+	const auto renderSeconds = std::chrono::duration<double>(Clock::now() - renderStart).count();
+	const auto allocations = s_allocations.load(std::memory_order_relaxed) - allocationsBefore;
+
+	song->stop();
+
+	const auto audioSeconds = static_cast<double>(settings.periods) * audioEngine->framesPerPeriod()
+		/ audioEngine->processingSampleRate();
+
+	std::sort(periodTimes.begin(), periodTimes.end());
+	const auto percentile = [&periodTimes](double p)
+	{
+		return periodTimes.empty() ? 0.0 : periodTimes[static_cast<std::size_t>(p * (periodTimes.size() - 1))];
+	};
+
+	auto periodStats = QJsonObject{};
+	periodStats["mean"] = settings.periods > 0 ? renderSeconds * 1e6 / settings.periods : 0.0;
+	periodStats["median"] = percentile(0.5);
+	periodStats["p99"] = percentile(0.99);
+	periodStats["max"] = percentile(1.0);
+	periodStats["budget"] = 1e6 * audioEngine->framesPerPeriod() / audioEngine->processingSampleRate();
+
+	const auto stageTime = [&stageTimes](DetailType type)
+	{
+		return static_cast<double>(stageTimes[static_cast<std::size_t>(type)]) / 1e6;
+	};
+
+	auto stages = QJsonObject{};
+	stages["noteSetup"] = stageTime(DetailType::NoteSetup);
+	stages["controllers"] = stageTime(DetailType::Controllers);
+	stages["instruments"] = stageTime(DetailType::Instruments);
+	stages["effects"] = stageTime(DetailType::Effects);
+	stages["mixing"] = stageTime(DetailType::Mixing);
+
+	auto result = QJsonObject{};
+	result["name"] = name;
+	result["loadSeconds"] = loadSeconds;
+	result["renderSeconds"] = renderSeconds;
+	result["audioSeconds"] = audioSeconds;
+	result["realtimeFactor"] = renderSeconds > 0 ? audioSeconds / renderSeconds : 0.0;
+	result["periodMicroseconds"] = periodStats;
+	result["stageSeconds"] = stages;
+	result["allocations"] = static_cast<qint64>(allocations);
+	result["allocationsPerPeriod"] = settings.periods > 0 ? static_cast<double>(allocations) / settings.periods : 0.0;
+	result["peakRssKiB"] = peakRssKiB();
+	return result;
+}
+
+
+//! Compares the realtime factors against an earlier run and prints every result that got slower than allowed
+bool checkBaseline(const QJsonArray& results, const QString& baselineFile, double tolerance)
+{
+	QFile file(baselineFile);
+	if (!file.open(QFile::ReadOnly))
+	{
+		fprintf(stderr, "Could not open baseline %s\n", baselineFile.toUtf8().constData());
+		return false;
+	}
+
+	auto baseline = QHash<QString, double>{};
+	for (const auto& value : QJsonDocument::fromJson(file.readAll()).object().value("results").toArray())
+	{
+		const auto result = value.toObject();
+		baseline[result["name"].toString()] = result["realtimeFactor"].toDouble();
+	}
+
+	auto passed = true;
+	for (const auto& value : results)
+	{
+		const auto result = value.toObject();
+		const auto name = result["name"].toString();
+		if (!baseline.contains(name)) { continue; }
+
+		const auto expected = baseline[name];
+		const auto actual = result["realtimeFactor"].toDouble();
+		if (actual < expected * (1.0 - tolerance))
+		{
+			fprintf(stderr, "Regression in %s: realtime factor %.2f, baseline %.2f\n",
+				name.toUtf8().constData(), actual, expected);
+			passed = false;
+		}
+	}
+	return passed;
+}
+
+
+//! Renders the same projects again with periods of @p framesPerPeriod frames in a process of its own, as the
+//! period is fixed once the engine runs, and adds how much faster each project rendered that way
+bool compareFramesPerPeriod(QJsonArray& results, fpp_t framesPerPeriod, const QStringList& arguments,
+	const QString& reportFile)
+{
+	QProcess process;
+	process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	process.start(QCoreApplication::applicationFilePath(), QStringList{arguments}
+		<< "--frames-per-period" << QString::number(framesPerPeriod) << "-o" << reportFile);
+	QFile file(reportFile);
+	if (!process.waitForFinished(-1) || process.exitCode() != EXIT_SUCCESS || !file.open(QFile::ReadOnly))
+	{
+		fprintf(stderr, "Rendering with %d frames per period failed\n", static_cast<int>(framesPerPeriod));
+		return false;
+	}
+
+	auto compared = QHash<QString, double>{};
+	for (const auto& value : QJsonDocument::fromJson(file.readAll()).object().value("results").toArray())
+	{
+		const auto result = value.toObject();
+		compared[result["name"].toString()] = result["realtimeFactor"].toDouble();
+	}
+
+	for (auto&& value : results)
+	{
+		auto result = value.toObject();
+		const auto name = result["name"].toString();
+		if (!compared.contains(name)) { continue; }
+
+		const auto realtimeFactor = result["realtimeFactor"].toDouble();
+		auto comparison = QJsonObject{};
+		comparison["framesPerPeriod"] = static_cast<int>(framesPerPeriod);
+		comparison["realtimeFactor"] = compared[name];
+		comparison["speedup"] = realtimeFactor > 0 ? compared[name] / realtimeFactor : 0.0;
+		result["compared"] = comparison;
+		value = result;
+	}
+	return true;
+}
+
+} // namespace
+
+} // namespace lmms
+
+
+int main(int argc, char** argv)
+{
+	using namespace lmms;
+	using Clock = std::chrono::steady_clock;
+
+	disable_denormals();
+
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("lmms-bench");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Renders projects as fast as possible and reports the performance as JSON.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("projects", "Reference projects to render.", "[projects...]");
+
+	const QCommandLineOption syntheticOption("synthetic",
+		QString("Render a generated project of the given size, e.g. \"medium\" or \"tracks=16,voices=8\". "
+			"The profiles are %1. Can be given several times.").arg(SyntheticProjectSize::profiles().join(", ")),
+		"size");
+	const QCommandLineOption periodsOption("periods", "Number of periods to measure (default 2000).", "count", "2000");
+	const QCommandLineOption warmupOption("warmup", "Number of periods to render before measuring (default 100).",
+		"count", "100");
+	const QCommandLineOption framesPerPeriodOption("frames-per-period",
+		QString("Period size of the engine (default %1).").arg(DEFAULT_BUFFER_SIZE),
+		"frames", QString::number(DEFAULT_BUFFER_SIZE));
+	const QCommandLineOption compareOption("compare-frames-per-period",
+		"Render the projects again with periods of <frames> frames, e.g. 2048, and report the speedup. "
+		"Exports don't use larger periods, since most plugins only follow automation once per period.",
+		"frames");
+	const QCommandLineOption outputOption({"o", "output"}, "Write the report to <file> instead of stdout.", "file");
+	const QCommandLineOption baselineOption("baseline",
+		"Compare against an earlier report and fail if a project rendered slower.", "file");
+	const QCommandLineOption toleranceOption("tolerance",
+		"Allowed slowdown against the baseline as a fraction (default 0.1).", "fraction", "0.1");
+	parser.addOptions({syntheticOption, periodsOption, warmupOption, framesPerPeriodOption, compareOption,
+		outputOption, baselineOption, toleranceOption});
+	parser.process(app);
+
+	auto settings = BenchmarkSettings{};
+	auto validNumbers = true;
+	bool ok;
+	settings.periods = parser.value(periodsOption).toInt(&ok);
+	validNumbers = validNumbers && ok && settings.periods > 0;
+	settings.warmupPeriods = parser.value(warmupOption).toInt(&ok);
+	validNumbers = validNumbers && ok && settings.warmupPeriods >= 0;
+	const auto tolerance = parser.value(toleranceOption).toDouble(&ok);
+	validNumbers = validNumbers && ok;
+	const auto framesPerPeriod = parser.value(framesPerPeriodOption).toInt(&ok);
+	validNumbers = validNumbers && ok && framesPerPeriod >= MINIMUM_BUFFER_SIZE
+		&& framesPerPeriod <= MAXIMUM_RENDER_BUFFER_SIZE;
+	const auto compareFrames = parser.isSet(compareOption) ? parser.value(compareOption).toInt(&ok) : 0;
+	validNumbers = validNumbers && (!parser.isSet(compareOption)
+		|| (ok && compareFrames >= MINIMUM_BUFFER_SIZE && compareFrames <= MAXIMUM_RENDER_BUFFER_SIZE));
+	if (!validNumbers)
+	{
+		fprintf(stderr, "Invalid number of periods, period size or tolerance\n");
+		return EXIT_FAILURE;
+	}
+
+	auto sizes = std::vector<SyntheticProjectSize>{};
+	for (const auto& spec : parser.values(syntheticOption))
+	{
+		sizes.push_back(SyntheticProjectSize::fromString(spec, &ok));
+		if (!ok)
+		{
+			fprintf(stderr, "Invalid project size: %s\n", spec.toUtf8().constData());
+			return EXIT_FAILURE;
+		}
+	}
+
+	const auto projects = parser.positionalArguments();
+	if (projects.isEmpty() && sizes.empty())
+	{
+		parser.showHelp(EXIT_FAILURE);
+	}
+
+	Engine::init(true, static_cast<fpp_t>(framesPerPeriod));
+
+	// Replace the real time paced dummy device by one that renders straight from our loop
+	AudioEngine* audioEngine = Engine::audioEngine();
+	audioEngine->setAudioDevice(new NullAudioDevice(audioEngine), audioEngine->currentQualitySettings(), false, true);
+
+	auto results = QJsonArray{};
+	auto failed = false;
+
+	// Generated projects go through a project file, so loading them is measured like for any other project
+	const QTemporaryDir tempDir;
+	for (const auto& size : sizes)
+	{
+		Song* song = Engine::getSong();
+		const auto stats = generateSyntheticProject(song, size);
+
+		const auto file = tempDir.filePath("synthetic.mmp");
+		if (!tempDir.isValid() || !song->saveProjectFile(file))
+		{
+			fprintf(stderr, "Could not save the generated project %s\n", size.toString().toUtf8().constData());
+			failed = true;
+			continue;
+		}
+
+		const auto loadStart = Clock::now();
+		song->loadProject(file);
+		const auto loadSeconds = std::chrono::duration<double>(Clock::now() - loadStart).count();
+		loopWholeSong(song);
+
+		auto result = renderSong("synthetic:" + size.toString(), loadSeconds, settings);
+		result["projectStats"] = stats.toJson();
+		results.append(result);
+	}
+
+	for (const auto& project : projects)
+	{
+		Song* song = Engine::getSong();
+
+		const auto loadStart = Clock::now();
+		song->loadProject(project);
+		const auto loadSeconds = std::chrono::duration<double>(Clock::now() - loadStart).count();
+
+		if (song->isEmpty())
+		{
+			fprintf(stderr, "The project %s is empty or could not be loaded\n", project.toUtf8().constData());
+			failed = true;
+			continue;
+		}
+
+		loopWholeSong(song);
+		results.append(renderSong(QFileInfo(project).fileName(), loadSeconds, settings));
+	}
+
+	if (parser.isSet(compareOption))
+	{
+		// The other run gets the same projects and measurement settings
+		auto arguments = QStringList{"--periods", QString::number(settings.periods),
+			"--warmup", QString::number(settings.warmupPeriods)};
+		for (const auto& spec : parser.values(syntheticOption)) { arguments << "--synthetic" << spec; }
+		arguments << projects;
+
+		if (!compareFramesPerPeriod(results, static_cast<fpp_t>(compareFrames), arguments,
+			tempDir.filePath("compared.json")))
+		{
+			failed = true;
+		}
+	}
+
+	auto report = QJsonObject{};
+	report["sampleRate"] = static_cast<qint64>(audioEngine->processingSampleRate());
+	report["framesPerPeriod"] = static_cast<int>(audioEngine->framesPerPeriod());
+	report["periods"] = settings.periods;
+	report["warmupPeriods"] = settings.warmupPeriods;
+	report["results"] = results;
+
+	const auto json = QJsonDocument(report).toJson();
+	if (parser.isSet(outputOption))
+	{
+		QFile file(parser.value(outputOption));
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		{
+			fprintf(stderr, "Could not write %s\n", file.fileName().toUtf8().constData());
+			failed = true;
+		}
+	}
+	else
+	{
+		fwrite(json.constData(), 1, json.size(), stdout);
+	}
+
+	if (parser.isSet(baselineOption) && !checkBaseline(results, parser.value(baselineOption), tolerance))
+	{
+		failed = true;
+	}
+
+	Engine::destroy();
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
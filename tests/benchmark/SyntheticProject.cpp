@@ -0,0 +1,380 @@
+/*
+ * SyntheticProject.cpp - generates projects of a given size for benchmarking
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "SyntheticProject.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "AudioPort.h"
+#include "AutomationClip.h"
+#include "AutomationTrack.h"
+#include "Effect.h"
+#include "EffectChain.h"
+#include "Engine.h"
+#include "InstrumentTrack.h"
+#include "MidiClip.h"
+#include "Mixer.h"
+#include "PathUtil.h"
+#include "PatternClip.h"
+#include "PatternStore.h"
+#include "PatternTrack.h"
+#include "ProjectJournal.h"
+#include "SampleClip.h"
+#include "SampleLoader.h"
+#include "SampleTrack.h"
+#include "Song.h"
+
+namespace lmms
+{
+
+namespace
+{
+
+struct Profile
+{
+	const char* name;
+	SyntheticProjectSize size;
+};
+
+const auto Profiles = std::array<Profile, 4>{{
+	//         seed tracks voices clips effects automation samples patterns mixer sends bars
+	{"small",  {1,   10,    4,     4,    1,      4,         2,      2,       4,    1,    16}},
+	{"medium", {1,   100,   4,     8,    2,      32,        16,     8,       32,   1,    32}},
+	{"large",  {1,   300,   6,     16,   2,      100,       50,     16,      64,   2,    64}},
+	{"huge",   {1,   1000,  8,     32,   2,      300,       200,    32,      128,  2,    64}},
+}};
+
+//! Effects without external dependencies, so every build can load them
+constexpr auto SyntheticEffects = std::array{"amplifier", "bassbooster", "delay", "flanger", "reverbsc", "stereoenhancer"};
+
+constexpr auto SyntheticSamples = std::array{"drums/kick01.ogg", "drums/snare01.ogg", "drums/hihat_closed01.ogg",
+	"drums/clap01.ogg", "beats/909beat01 - 122 BPM.ogg", "bassloops/techno_bass01 - 140 BPM.ogg"};
+
+//! Instruments of the pattern editor, shared by all pattern tracks
+constexpr auto PatternInstruments = std::array{"kicker", "kicker", "tripleoscillator", "tripleoscillator"};
+
+
+//! std::mt19937 gives the same numbers everywhere, but the standard distributions do not,
+//! so the mapping to ranges is done here to keep projects identical across platforms
+class Random
+{
+public:
+	explicit Random(unsigned int seed) :
+		m_engine(seed)
+	{
+	}
+
+	int integer(int min, int max)
+	{
+		return min + static_cast<int>(m_engine() % static_cast<unsigned int>(max - min + 1));
+	}
+
+	float real(float min, float max)
+	{
+		return min + (max - min) * static_cast<float>(m_engine() / 4294967296.0);
+	}
+
+	bool chance(int percent)
+	{
+		return integer(0, 99) < percent;
+	}
+
+private:
+	std::mt19937 m_engine;
+};
+
+
+//! Calls func(firstBar, bars) for every clip when splitting the project into the given number of clips
+template<typename Func>
+void forEachClip(const SyntheticProjectSize& size, Func func)
+{
+	const int clipBars = std::max(1, (size.bars + size.clips - 1) / std::max(1, size.clips));
+	for (int bar = 0; bar < size.bars; bar += clipBars)
+	{
+		func(bar, std::min(clipBars, size.bars - bar));
+	}
+}
+
+} // namespace
+
+
+SyntheticProjectSize SyntheticProjectSize::fromString(const QString& spec, bool* ok)
+{
+	auto size = SyntheticProjectSize{};
+	auto valid = true;
+
+	for (const auto& entry : spec.split(','))
+	{
+		if (entry.trimmed().isEmpty()) { continue; }
+
+		const auto pair = entry.split('=');
+		const auto key = pair[0].trimmed();
+
+		if (pair.size() == 1)
+		{
+			const auto profile = std::find_if(Profiles.begin(), Profiles.end(),
+				[&key](const Profile& p) { return key == p.name; });
+			if (profile == Profiles.end()) { valid = false; }
+			else { size = profile->size; }
+			continue;
+		}
+
+		auto isNumber = false;
+		const auto value = pair.size() == 2 ? pair[1].trimmed().toInt(&isNumber) : 0;
+		if (!isNumber || value < 0)
+		{
+			valid = false;
+			continue;
+		}
+
+		if (key == "seed") { size.seed = static_cast<unsigned int>(value); }
+		else if (key == "tracks") { size.tracks = value; }
+		else if (key == "voices") { size.voices = value; }
+		else if (key == "clips" && value > 0) { size.clips = value; }
+		else if (key == "effects") { size.effects = value; }
+		else if (key == "automation") { size.automation = value; }
+		else if (key == "samples") { size.samples = value; }
+		else if (key == "patterns") { size.patterns = value; }
+		else if (key == "mixer") { size.mixer = value; }
+		else if (key == "sends") { size.sends = value; }
+		else if (key == "bars" && value > 0) { size.bars = value; }
+		else { valid = false; }
+	}
+
+	if (ok) { *ok = valid; }
+	return size;
+}
+
+
+
+
+QStringList SyntheticProjectSize::profiles()
+{
+	auto names = QStringList{};
+	for (const auto& profile : Profiles)
+	{
+		names << profile.name;
+	}
+	return names;
+}
+
+
+
+
+QString SyntheticProjectSize::toString() const
+{
+	return QString("seed=%1,tracks=%2,voices=%3,clips=%4,effects=%5,automation=%6,"
+		"samples=%7,patterns=%8,mixer=%9,sends=%10,bars=%11")
+		.arg(seed).arg(tracks).arg(voices).arg(clips).arg(effects).arg(automation)
+		.arg(samples).arg(patterns).arg(mixer).arg(sends).arg(bars);
+}
+
+
+
+
+QJsonObject SyntheticProjectStats::toJson() const
+{
+	auto json = QJsonObject{};
+	json["tracks"] = tracks;
+	json["clips"] = clips;
+	json["notes"] = notes;
+	json["automationNodes"] = automationNodes;
+	json["mixerSends"] = mixerSends;
+	json["missingSamples"] = missingSamples;
+	return json;
+}
+
+
+
+
+SyntheticProjectStats generateSyntheticProject(Song* song, const SyntheticProjectSize& size)
+{
+	song->clearProject();
+	Engine::projectJournal()->setJournalling(false);
+
+	auto random = Random{size.seed};
+	auto stats = SyntheticProjectStats{};
+
+	const auto ticksPerBar = TimePos::ticksPerBar();
+	const auto ticksPerBeat = ticksPerBar / 4;
+
+	// Mixer channels form a tree: channel n sends to channel n / 2, and channel 1 to master.
+	// Extra sends only go towards master, so they can never form a loop.
+	Mixer* mixer = Engine::mixer();
+	for (int c = 1; c <= size.mixer; ++c)
+	{
+		mixer->createChannel();
+		mixer->mixerChannel(c)->m_name = QString("Bus %1").arg(c);
+
+		if (c < 2) { continue; }
+
+		mixer->deleteChannelSend(c, 0);
+		mixer->createChannelSend(c, c / 2);
+		for (int s = 0; s < size.sends; ++s)
+		{
+			mixer->createChannelSend(c, random.integer(1, c - 1), random.real(0.2f, 1.f));
+		}
+	}
+
+	const auto randomMixerChannel = [&random, &size] { return size.mixer > 0 ? random.integer(1, size.mixer) : 0; };
+
+	auto automationTargets = std::vector<FloatModel*>{};
+	for (int c = 1; c <= size.mixer; ++c)
+	{
+		// Sends to a channel that is already a target are merged, so count what is actually there
+		stats.mixerSends += static_cast<int>(mixer->mixerChannel(c)->m_sends.size());
+		automationTargets.push_back(&mixer->mixerChannel(c)->m_volumeModel);
+	}
+
+	for (int t = 0; t < size.tracks; ++t)
+	{
+		auto track = dynamic_cast<InstrumentTrack*>(Track::create(Track::Type::Instrument, song));
+		track->setName(QString("Instrument %1").arg(t + 1));
+		track->loadInstrument("tripleoscillator");
+		track->mixerChannelModel()->setValue(randomMixerChannel());
+
+		// One chord per beat, so exactly `voices` notes sound at any time
+		forEachClip(size, [&](int firstBar, int bars)
+		{
+			auto clip = dynamic_cast<MidiClip*>(track->createClip(TimePos{firstBar, 0}));
+			for (int beat = 0; beat < bars * 4; ++beat)
+			{
+				for (int v = 0; v < size.voices; ++v)
+				{
+					const auto note = Note{TimePos{ticksPerBeat}, TimePos{beat * ticksPerBeat},
+						random.integer(36, 84), static_cast<volume_t>(random.integer(60, 100))};
+					clip->addNote(note, false);
+				}
+			}
+			++stats.clips;
+			stats.notes += bars * 4 * size.voices;
+		});
+
+		EffectChain* chain = track->audioPort()->effects();
+		for (int e = 0; e < size.effects; ++e)
+		{
+			const auto name = SyntheticEffects[random.integer(0, static_cast<int>(SyntheticEffects.size()) - 1)];
+			if (Effect* effect = Effect::instantiate(name, chain, nullptr))
+			{
+				chain->appendEffect(effect);
+			}
+		}
+
+		automationTargets.push_back(track->volumeModel());
+		automationTargets.push_back(track->panningModel());
+	}
+
+	// Every distinct sample is decoded once and shared between its clips
+	auto sampleBuffers = std::map<int, std::shared_ptr<const SampleBuffer>>{};
+	for (int t = 0; t < size.samples; ++t)
+	{
+		auto track = dynamic_cast<SampleTrack*>(Track::create(Track::Type::Sample, song));
+		track->setName(QString("Sample %1").arg(t + 1));
+		track->mixerChannelModel()->setValue(randomMixerChannel());
+
+		const int sample = random.integer(0, static_cast<int>(SyntheticSamples.size()) - 1);
+		if (sampleBuffers.find(sample) == sampleBuffers.end())
+		{
+			sampleBuffers[sample] = gui::SampleLoader::createBufferFromFile(
+				PathUtil::basePrefix(PathUtil::Base::FactorySample) + SyntheticSamples[sample]);
+			if (sampleBuffers[sample]->empty()) { ++stats.missingSamples; }
+		}
+
+		forEachClip(size, [&](int firstBar, int bars)
+		{
+			auto clip = dynamic_cast<SampleClip*>(track->createClip(TimePos{firstBar, 0}));
+			clip->setSampleBuffer(sampleBuffers[sample]);
+			clip->changeLength(std::min<int>(clip->sampleLength(), bars * ticksPerBar));
+			++stats.clips;
+		});
+	}
+
+	// Pattern tracks have to exist before the instruments of the pattern editor, which then get a clip for each
+	for (int p = 0; p < size.patterns; ++p)
+	{
+		auto track = Track::create(Track::Type::Pattern, song);
+		forEachClip(size, [&](int firstBar, int bars)
+		{
+			Clip* clip = track->createClip(TimePos{firstBar, 0});
+			clip->changeLength(TimePos{bars, 0});
+			++stats.clips;
+		});
+	}
+
+	if (size.patterns > 0)
+	{
+		for (const auto name : PatternInstruments)
+		{
+			auto track = dynamic_cast<InstrumentTrack*>(Track::create(Track::Type::Instrument, Engine::patternStore()));
+			track->loadInstrument(name);
+			track->mixerChannelModel()->setValue(randomMixerChannel());
+
+			for (int p = 0; p < size.patterns; ++p)
+			{
+				auto clip = dynamic_cast<MidiClip*>(track->getClip(p));
+				for (int step = 0; step < TimePos::stepsPerBar(); ++step)
+				{
+					if (random.chance(25))
+					{
+						clip->setStep(step, true);
+						++stats.notes;
+					}
+				}
+				++stats.clips;
+			}
+		}
+	}
+
+	for (int a = 0; a < size.automation && !automationTargets.empty(); ++a)
+	{
+		FloatModel* target = automationTargets[random.integer(0, static_cast<int>(automationTargets.size()) - 1)];
+
+		auto track = Track::create(Track::Type::Automation, song);
+		auto clip = dynamic_cast<AutomationClip*>(track->createClip(TimePos{0}));
+		clip->addObject(target);
+		clip->setProgressionType(AutomationClip::ProgressionType::Linear);
+
+		for (int beat = 0; beat <= size.bars * 4; ++beat)
+		{
+			clip->putValue(TimePos{beat * ticksPerBeat}, random.real(target->minValue(), target->maxValue()), false);
+			++stats.automationNodes;
+		}
+		++stats.clips;
+	}
+
+	stats.tracks = static_cast<int>(song->tracks().size() + Engine::patternStore()->tracks().size());
+
+	Timeline& timeline = song->getTimeline(Song::PlayMode::Song);
+	timeline.setLoopPoints(TimePos{0}, TimePos{size.bars, 0});
+	timeline.setLoopEnabled(true);
+
+	Engine::projectJournal()->setJournalling(true);
+
+	return stats;
+}
+
+} // namespace lmms
@@ -0,0 +1,83 @@
+/*
+ * SyntheticProject.h - generates projects of a given size for benchmarking
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef LMMS_SYNTHETIC_PROJECT_H
+#define LMMS_SYNTHETIC_PROJECT_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+namespace lmms
+{
+
+class Song;
+
+/**
+	Size of a generated project. Every dimension scales one kind of load on its own, and the same size with the same
+	seed always gives the same project.
+*/
+struct SyntheticProjectSize
+{
+	unsigned int seed = 1;
+	int tracks = 8; //!< Instrument tracks
+	int voices = 4; //!< Notes sounding at the same time on every instrument track
+	int clips = 1; //!< Clips per track, which split the project into equal parts
+	int effects = 1; //!< Effects in the chain of every instrument track
+	int automation = 2; //!< Automation tracks, each moving one volume or panning knob every beat
+	int samples = 0; //!< Sample tracks playing factory samples
+	int patterns = 0; //!< Pattern tracks, all sharing the instruments of the pattern editor
+	int mixer = 0; //!< Mixer channels besides master, routed as a tree
+	int sends = 0; //!< Extra sends from every mixer channel to channels closer to master
+	int bars = 4;
+
+	//! Parses a specification like "large,seed=3,tracks=500". A profile name sets every dimension, later keys
+	//! override single ones and missing keys keep their defaults.
+	static SyntheticProjectSize fromString(const QString& spec, bool* ok = nullptr);
+
+	//! Names of the predefined sizes, from smallest to largest
+	static QStringList profiles();
+
+	QString toString() const;
+};
+
+
+//! What was generated, for relating measurements to the size of the project
+struct SyntheticProjectStats
+{
+	int tracks = 0;
+	int clips = 0;
+	int notes = 0;
+	int automationNodes = 0;
+	int mixerSends = 0;
+	int missingSamples = 0; //!< Factory samples that could not be loaded; their clips stay silent
+
+	QJsonObject toJson() const;
+};
+
+
+//! Replaces the contents of the song with a generated project and loops playback over it
+SyntheticProjectStats generateSyntheticProject(Song* song, const SyntheticProjectSize& size);
+
+} // namespace lmms
+
+#endif // LMMS_SYNTHETIC_PROJECT_H
@@ -0,0 +1,218 @@
+/*
+ * XpressiveBenchmark.cpp - measures how many Xpressive voices one core can play
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "ExprSynth.h"
+#include "denormals.h"
+
+namespace
+{
+
+using namespace lmms;
+
+constexpr int WaveLength = 200;
+
+// Typical oscillator expressions, from a plain sine to the presets' heavier ones
+const char* const Expressions[] = {
+	"sinew(t*f)",
+	"0.5*sinew(t*f)+0.3*saww(t*f*2.01)+0.2*squarew(t*f/2)",
+	"W1(t*f)*exp(-t*3)",
+	"sinew(integrate(f)+0.3*sinew(integrate(f*2)))",
+	"clamp(-1,2*trianglew(t*f)*(1-rel)+randv(t*f*10)*0.1,1)",
+};
+
+//! One oscillator of a voice with the variables ExprSynth gives it
+struct Voice
+{
+	Voice(const char* expression, const float* wave, sample_rate_t sampleRate) :
+		front(expression, 100),
+		sampleRate(sampleRate)
+	{
+		front.add_cyclic_vector("W1", wave, WaveLength, true);
+		front.add_variable("t", t, blockT.data());
+		front.add_variable("f", f, blockF.data());
+		front.add_variable("rel", rel, blockRel.data());
+		front.setIntegrate(&frame, sampleRate);
+		front.compile();
+	}
+
+	//! Evaluates frame by frame like ExprSynth does for expressions only exprtk handles
+	void renderFrames(float* out, int frames)
+	{
+		for (int i = 0; i < frames; ++i)
+		{
+			out[i] = front.evaluate();
+			++frame;
+			t = frame / static_cast<float>(sampleRate);
+		}
+	}
+
+	void renderBlocks(float* out, int frames)
+	{
+		for (int offset = 0; offset < frames; offset += ExprFront::BlockSize)
+		{
+			const int blockFrames = std::min(frames - offset, ExprFront::BlockSize);
+			for (int i = 0; i < blockFrames; ++i)
+			{
+				blockT[i] = t;
+				blockF[i] = f;
+				blockRel[i] = rel;
+				++frame;
+				t = frame / static_cast<float>(sampleRate);
+			}
+			front.evaluateBlock(out + offset, blockFrames);
+		}
+	}
+
+	ExprFront front;
+	const sample_rate_t sampleRate;
+	float t = 0;
+	float f = 440;
+	float rel = 0;
+	unsigned int frame = 0;
+	std::array<float, ExprFront::BlockSize> blockT{};
+	std::array<float, ExprFront::BlockSize> blockF{};
+	std::array<float, ExprFront::BlockSize> blockRel{};
+};
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	using namespace lmms;
+	using Clock = std::chrono::steady_clock;
+
+	disable_denormals();
+
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("lmms-bench-xpressive");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Measures Xpressive's expression evaluation per frame and a block at a time, "
+		"and reports how many voices a single core could play in real time as JSON.");
+	parser.addHelpOption();
+
+	const QCommandLineOption framesOption("frames", "Frames per period (default 256).", "count", "256");
+	const QCommandLineOption periodsOption("periods", "Number of periods per measurement (default 2000).",
+		"count", "2000");
+	const QCommandLineOption runsOption("runs", "Number of measurements per expression, the median is reported "
+		"(default 5).", "count", "5");
+	const QCommandLineOption sampleRateOption("samplerate", "Sample rate the voices play at (default 44100).",
+		"rate", "44100");
+	const QCommandLineOption outputOption({"o", "output"}, "Write the report to <file> instead of stdout.", "file");
+	parser.addOptions({framesOption, periodsOption, runsOption, sampleRateOption, outputOption});
+	parser.process(app);
+
+	bool framesOk, periodsOk, runsOk, sampleRateOk;
+	const auto frames = parser.value(framesOption).toInt(&framesOk);
+	const auto periods = parser.value(periodsOption).toInt(&periodsOk);
+	const auto runs = parser.value(runsOption).toInt(&runsOk);
+	const auto sampleRate = parser.value(sampleRateOption).toUInt(&sampleRateOk);
+	if (!framesOk || !periodsOk || !runsOk || !sampleRateOk || frames <= 0 || periods <= 0 || runs <= 0
+		|| sampleRate == 0)
+	{
+		fprintf(stderr, "Invalid number of frames, periods, runs or sample rate\n");
+		return EXIT_FAILURE;
+	}
+
+	auto wave = std::vector<float>(WaveLength);
+	for (int i = 0; i < WaveLength; ++i)
+	{
+		wave[i] = std::sin(2 * 3.14159265f * i / WaveLength);
+	}
+
+	auto out = std::vector<float>(frames);
+	const auto measure = [&](const char* expression, bool blocks)
+	{
+		auto nanosecondsPerFrame = std::vector<double>{};
+		for (int run = 0; run < runs; ++run)
+		{
+			auto voice = Voice{expression, wave.data(), sampleRate};
+			const auto start = Clock::now();
+			for (int period = 0; period < periods; ++period)
+			{
+				if (blocks) { voice.renderBlocks(out.data(), frames); }
+				else { voice.renderFrames(out.data(), frames); }
+			}
+			const auto elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			nanosecondsPerFrame.push_back(elapsed / (static_cast<double>(periods) * frames));
+		}
+		std::sort(nanosecondsPerFrame.begin(), nanosecondsPerFrame.end());
+		return nanosecondsPerFrame[nanosecondsPerFrame.size() / 2];
+	};
+
+	auto results = QJsonArray{};
+	for (const auto expression : Expressions)
+	{
+		auto result = QJsonObject{};
+		result["expression"] = expression;
+
+		const auto frameWise = measure(expression, false);
+		result["exprtkNsPerFrame"] = frameWise;
+		result["exprtkVoicesPerCore"] = 1e9 / (frameWise * sampleRate);
+
+		if (Voice{expression, wave.data(), sampleRate}.front.isBlockCompiled())
+		{
+			const auto blockWise = measure(expression, true);
+			result["blockNsPerFrame"] = blockWise;
+			result["blockVoicesPerCore"] = 1e9 / (blockWise * sampleRate);
+		}
+		results.append(result);
+	}
+
+	auto report = QJsonObject{};
+	report["framesPerPeriod"] = frames;
+	report["periods"] = periods;
+	report["runs"] = runs;
+	report["sampleRate"] = static_cast<int>(sampleRate);
+	report["results"] = results;
+
+	const auto json = QJsonDocument(report).toJson();
+	if (parser.isSet(outputOption))
+	{
+		QFile file(parser.value(outputOption));
+		if (!file.open(QFile::WriteOnly | QFile::Truncate) || file.write(json) != json.size())
+		{
+			fprintf(stderr, "Could not write %s\n", file.fileName().toUtf8().constData());
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		fwrite(json.constData(), 1, json.size(), stdout);
+	}
+
+	return EXIT_SUCCESS;
+}
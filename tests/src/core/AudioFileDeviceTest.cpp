@@ -0,0 +1,117 @@
+/*
+ * AudioFileDeviceTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "AudioFileDevice.h"
+#include "Engine.h"
+
+namespace
+{
+
+using namespace lmms;
+
+//! Records what it is asked to encode, taking its time like a slow encoder
+class SlowEncoder : public AudioFileDevice
+{
+public:
+	explicit SlowEncoder(const QString& file) :
+		AudioFileDevice(OutputSettings{Engine::audioEngine()->processingSampleRate(), {160, false},
+			OutputSettings::BitDepth::Depth16Bit}, DEFAULT_CHANNELS, file, Engine::audioEngine())
+	{
+	}
+
+	std::vector<float> samples;
+	std::vector<float> gains;
+
+protected:
+	void writeBuffer(const surroundSampleFrame* buffer, const fpp_t frames, const float masterGain) override
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds{20});
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			samples.push_back(buffer[f][0]);
+			gains.push_back(masterGain);
+		}
+	}
+};
+
+} // namespace
+
+class AudioFileDeviceTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void SlowEncoderGetsEveryFrameOnce()
+	{
+		using namespace lmms;
+
+		QTemporaryDir dir;
+		QVERIFY(dir.isValid());
+		SlowEncoder device(dir.filePath("out.raw"));
+		device.startProcessing();
+
+		// The renderer runs far ahead of the encoder and keeps filling the whole ring. The gain changes a
+		// few times, which submits blocks early.
+		const auto period = Engine::audioEngine()->framesPerPeriod();
+		const auto periods = 1000;
+		auto buffer = std::vector<surroundSampleFrame>(period);
+		auto frame = 0;
+		for (int p = 0; p < periods; ++p)
+		{
+			for (auto& f : buffer) { f.fill(static_cast<float>(frame++)); }
+			device.enqueue(buffer.data(), period, p < 300 || p >= 700 ? 1.0f : 0.5f);
+		}
+		device.stopProcessing();
+
+		QCOMPARE(device.samples.size(), static_cast<std::size_t>(frame));
+		for (int f = 0; f < frame; ++f)
+		{
+			if (device.samples[f] != static_cast<float>(f))
+			{
+				QFAIL(qPrintable(QString{"frame %1 was encoded as %2"}.arg(f).arg(device.samples[f])));
+			}
+			QCOMPARE(device.gains[f], f / period < 300 || f / period >= 700 ? 1.0f : 0.5f);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(AudioFileDeviceTest)
+#include "AudioFileDeviceTest.moc"
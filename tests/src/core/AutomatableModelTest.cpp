@@ -24,6 +24,7 @@
 
 
 #include <QtTest/QtTest>
+#include "AudioEngine.h"
 #include "AutomatableModel.h"
 #include "ComboBoxModel.h"
 #include "Engine.h"
@@ -114,6 +115,80 @@ private slots: // tests
 		QVERIFY(m2.value());
 		QVERIFY(!m3.value());
 	}
+
+	void ValueSpanTests()
+	{
+		using namespace lmms;
+
+		// keep the audio engine from starting new periods while we look at this one
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+		const int fpp = Engine::audioEngine()->framesPerPeriod();
+
+		FloatModel m(10.f, 0.f, 100.f, 0.1f);
+		QVERIFY(m.valueSpan().isConstant());
+		QCOMPARE(m.valueSpan().front(), 10.f);
+		QVERIFY(m.valueBuffer() == nullptr);
+
+		// a change ramps from the value of the last period
+		m.setValue(50.f);
+		AutomatableModel::incrementPeriodCounter();
+		const ValueSpan ramp = m.valueSpan();
+		QVERIFY(!ramp.isConstant());
+		QVERIFY(ramp.values() == nullptr);
+		QCOMPARE(ramp.length(), fpp);
+		QCOMPARE(ramp[0], 10.f);
+		QCOMPARE(ramp[fpp / 2], 30.f);
+
+		// the buffer is only written when asked for, and stays the same during the period
+		ValueBuffer* buffer = m.valueBuffer();
+		QVERIFY(buffer != nullptr);
+		QCOMPARE(buffer->length(), fpp);
+		QCOMPARE(buffer->value(0), 10.f);
+		QCOMPARE(buffer->value(fpp / 2), 30.f);
+		QCOMPARE(m.valueBuffer(), buffer);
+		QVERIFY(m.valueSpan().values() == buffer->values());
+
+		// without another change, the next period is constant again
+		AutomatableModel::incrementPeriodCounter();
+		QVERIFY(m.valueSpan().isConstant());
+		QCOMPARE(m.valueSpan().front(), 50.f);
+		QVERIFY(m.valueBuffer() == nullptr);
+	}
+
+	void AutomationWithinPeriodTests()
+	{
+		using namespace lmms;
+
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+		const int fpp = Engine::audioEngine()->framesPerPeriod();
+
+		FloatModel m(0.f, 0.f, 100.f, 0.1f);
+
+		// automation changing the model twice in a period: the values ramp towards each change, then hold
+		AutomatableModel::incrementPeriodCounter();
+		m.setAutomatedValue(40.f, fpp / 4);
+		m.setAutomatedValue(20.f, fpp / 2);
+		const ValueSpan span = m.valueSpan();
+		QVERIFY(span.values() != nullptr);
+		QCOMPARE(span[0], 0.f);
+		QCOMPARE(span[fpp / 8], 20.f);
+		QCOMPARE(span[fpp / 4], 40.f);
+		QCOMPARE(span[3 * fpp / 8], 30.f);
+		QCOMPARE(span[fpp / 2], 20.f);
+		QCOMPARE(span[fpp - 1], 20.f);
+		QCOMPARE(m.value(), 20.f);
+
+		// the next period goes on from the last change
+		AutomatableModel::incrementPeriodCounter();
+		QVERIFY(m.valueSpan().isConstant());
+		QCOMPARE(m.valueSpan().front(), 20.f);
+
+		// a change at the start of a period ramps over the period like any other change
+		AutomatableModel::incrementPeriodCounter();
+		m.setAutomatedValue(60.f, 0);
+		QVERIFY(m.valueSpan().values() == nullptr);
+		QCOMPARE(m.valueSpan()[fpp / 2], 40.f);
+	}
 };
 
 QTEST_GUILESS_MAIN(AutomatableModelTest)
@@ -0,0 +1,293 @@
+/*
+ * EffectChainTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QDomDocument>
+#include <QObject>
+#include <QTemporaryDir>
+#include <QtTest/QtTest>
+#include <cmath>
+#include <random>
+#include <sndfile.h>
+#include <vector>
+
+#include "ConfigManager.h"
+#include "Effect.h"
+#include "EffectChain.h"
+#include "EffectControls.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "PartitionedConvolver.h"
+
+namespace
+{
+
+//! Leaves the signal alone, reports a fixed tail and counts the frames it was asked to process
+class TailEffect : public lmms::Effect
+{
+public:
+	TailEffect(lmms::Model* parent, lmms::f_cnt_t tail) :
+		Effect(nullptr, parent, nullptr),
+		m_controls(this),
+		m_tail(tail)
+	{
+	}
+
+	bool processAudioBuffer(lmms::sampleFrame*, const lmms::fpp_t frames) override
+	{
+		if (!isRunning()) { return false; }
+		processedFrames += frames;
+		return isRunning();
+	}
+
+	lmms::f_cnt_t tailLength() const override { return m_tail; }
+	lmms::EffectControls* controls() override { return &m_controls; }
+
+	lmms::f_cnt_t processedFrames = 0;
+
+private:
+	class Controls : public lmms::EffectControls
+	{
+	public:
+		using EffectControls::EffectControls;
+		int controlCount() override { return 0; }
+		lmms::gui::EffectControlDialog* createView() override { return nullptr; }
+		void saveSettings(QDomDocument&, QDomElement&) override {}
+		void loadSettings(const QDomElement&) override {}
+		QString nodeName() const override { return "tailcontrols"; }
+	};
+
+	Controls m_controls;
+	lmms::f_cnt_t m_tail;
+};
+
+TailEffect* addTailEffect(lmms::EffectChain& chain, lmms::f_cnt_t tail)
+{
+	const auto effect = new TailEffect(&chain, tail);
+	chain.appendEffect(effect);
+	effect->startRunning();
+	return effect;
+}
+
+std::vector<lmms::sampleFrame> noise(std::size_t frames, unsigned int seed)
+{
+	auto generator = std::mt19937{seed};
+	auto distribution = std::uniform_real_distribution<float>{-1.f, 1.f};
+
+	auto buffer = std::vector<lmms::sampleFrame>(frames);
+	for (auto& frame : buffer)
+	{
+		frame = {distribution(generator), distribution(generator)};
+	}
+	return buffer;
+}
+
+//! Renders one period of the mixer, with @p input fed into channel @p channel if given
+void mixPeriod(lmms::Mixer* mixer, const lmms::sampleFrame* input = nullptr, lmms::mix_ch_t channel = 0)
+{
+	auto output = std::vector<lmms::sampleFrame>(lmms::Engine::audioEngine()->framesPerPeriod());
+	mixer->prepareMasterMix();
+	if (input != nullptr) { mixer->mixToChannel(input, channel); }
+	mixer->masterMix(output.data());
+}
+
+} // namespace
+
+class EffectChainTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void cleanup()
+	{
+		using namespace lmms;
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+		Engine::mixer()->clear();
+	}
+
+	void EffectStopsAfterItsTail()
+	{
+		using namespace lmms;
+
+		const auto frames = Engine::audioEngine()->framesPerPeriod();
+		const auto tail = f_cnt_t{3 * frames + frames / 2};
+
+		auto chain = EffectChain{nullptr};
+		const auto effect = addTailEffect(chain, tail);
+
+		auto buffer = noise(frames, 1);
+		QVERIFY(chain.processAudioBuffer(buffer.data(), frames, true));
+		QCOMPARE(effect->processedFrames, f_cnt_t{frames});
+
+		// The effect keeps running until it has seen its whole tail in silence
+		std::fill(buffer.begin(), buffer.end(), sampleFrame{});
+		auto silentFrames = f_cnt_t{0};
+		while (silentFrames < tail)
+		{
+			QVERIFY(chain.processAudioBuffer(buffer.data(), frames, false));
+			QVERIFY(effect->isRunning());
+			silentFrames += frames;
+			QCOMPARE(effect->processedFrames, frames + silentFrames);
+		}
+
+		QVERIFY(!chain.processAudioBuffer(buffer.data(), frames, false));
+		QVERIFY(!effect->isRunning());
+		QCOMPARE(effect->processedFrames, frames + silentFrames);
+
+		// Sound starts the count over
+		effect->startRunning();
+		buffer = noise(frames, 2);
+		chain.processAudioBuffer(buffer.data(), frames, true);
+		std::fill(buffer.begin(), buffer.end(), sampleFrame{});
+		QVERIFY(chain.processAudioBuffer(buffer.data(), frames, false));
+		QVERIFY(effect->isRunning());
+	}
+
+	void EffectWithoutAutoQuitKeepsRunning()
+	{
+		using namespace lmms;
+
+		const auto config = ConfigManager::inst();
+		const auto disabled = config->value("ui", "disableautoquit");
+		config->setValue("ui", "disableautoquit", "1");
+
+		auto chain = EffectChain{nullptr};
+		const auto effect = addTailEffect(chain, 0);
+		config->setValue("ui", "disableautoquit", disabled);
+
+		const auto frames = Engine::audioEngine()->framesPerPeriod();
+		auto buffer = std::vector<sampleFrame>(frames);
+		for (int period = 1; period <= 16; ++period)
+		{
+			QVERIFY(chain.processAudioBuffer(buffer.data(), frames, false));
+			QVERIFY(effect->isRunning());
+			QCOMPARE(effect->processedFrames, f_cnt_t{period * frames});
+		}
+	}
+
+	void SilentChannelSkipsItsEffects()
+	{
+		using namespace lmms;
+
+		// Keep the engine from rendering periods meanwhile
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+
+		const auto mixer = Engine::mixer();
+		const auto senderIndex = mixer->createChannel();
+		const auto receiverIndex = mixer->createChannel();
+		mixer->createChannelSend(senderIndex, receiverIndex);
+		const auto effect = addTailEffect(mixer->mixerChannel(receiverIndex)->m_fxChain, 0);
+
+		const auto frames = Engine::audioEngine()->framesPerPeriod();
+		const auto input = noise(frames, 3);
+
+		mixPeriod(mixer, input.data(), senderIndex);
+		QCOMPARE(effect->processedFrames, f_cnt_t{frames});
+
+		// Without a tail the effect is stopped on the first silent period and not run again
+		for (int period = 0; period < 4; ++period)
+		{
+			mixPeriod(mixer);
+			QVERIFY(!effect->isRunning());
+			QCOMPARE(effect->processedFrames, f_cnt_t{frames});
+		}
+
+		// The next sound from the sender wakes the channel up
+		mixPeriod(mixer, input.data(), senderIndex);
+		QVERIFY(effect->isRunning());
+		QCOMPARE(effect->processedFrames, f_cnt_t{2 * frames});
+	}
+
+	void ConvolutionReverbPlaysItsWholeTail()
+	{
+		using namespace lmms;
+
+		const auto sampleRate = Engine::audioEngine()->processingSampleRate();
+		const auto ir = noise(2 * PartitionedConvolver::TailOffset + 1000, 4);
+
+		auto dir = QTemporaryDir{};
+		QVERIFY(dir.isValid());
+		const auto file = dir.filePath("response.wav");
+		auto info = SF_INFO{};
+		info.samplerate = static_cast<int>(sampleRate);
+		info.channels = DEFAULT_CHANNELS;
+		info.format = SF_FORMAT_WAV | SF_FORMAT_FLOAT;
+		const auto sf = sf_open(file.toLocal8Bit().constData(), SFM_WRITE, &info);
+		QVERIFY(sf != nullptr);
+		sf_writef_float(sf, ir.front().data(), static_cast<sf_count_t>(ir.size()));
+		sf_close(sf);
+
+		auto chain = EffectChain{nullptr};
+		const auto reverb = Effect::instantiate("convolutionreverb", &chain, nullptr);
+		if (reverb == nullptr) { QSKIP("Convolution reverb plugin not found"); }
+		chain.appendEffect(reverb);
+		reverb->startRunning();
+
+		auto doc = QDomDocument{};
+		auto element = doc.createElement(reverb->controls()->nodeName());
+		element.setAttribute("src", file);
+		reverb->controls()->loadSettings(element);
+		QCOMPARE(reverb->tailLength(), f_cnt_t(ir.size() + PartitionedConvolver::TailBlockSize));
+
+		// An impulse brings back the response, scaled to unit energy
+		const auto frames = Engine::audioEngine()->framesPerPeriod();
+		auto output = std::vector<sampleFrame>{};
+		auto buffer = std::vector<sampleFrame>(frames);
+		buffer[0] = {1.f, 1.f};
+		auto sounding = chain.processAudioBuffer(buffer.data(), frames, true);
+		output.insert(output.end(), buffer.begin(), buffer.end());
+		const auto maxPeriods = reverb->tailLength() / frames + 4;
+		for (int period = 0; sounding && period < maxPeriods; ++period)
+		{
+			std::fill(buffer.begin(), buffer.end(), sampleFrame{});
+			sounding = chain.processAudioBuffer(buffer.data(), frames, false);
+			output.insert(output.end(), buffer.begin(), buffer.end());
+		}
+		QVERIFY(!reverb->isRunning());
+		QVERIFY(output.size() >= ir.size());
+
+		auto energy = 0.0;
+		for (const auto& frame : ir)
+		{
+			energy += frame[0] * frame[0] + frame[1] * frame[1];
+		}
+		const auto scale = static_cast<float>(1.0 / std::sqrt(energy / DEFAULT_CHANNELS));
+		for (auto f = std::size_t{0}; f < ir.size(); ++f)
+		{
+			QVERIFY(std::abs(output[f][0] - scale * ir[f][0]) < 1e-4f);
+			QVERIFY(std::abs(output[f][1] - scale * ir[f][1]) < 1e-4f);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(EffectChainTest)
+#include "EffectChainTest.moc"
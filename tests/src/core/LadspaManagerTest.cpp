@@ -0,0 +1,83 @@
+/*
+ * LadspaManagerTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QDir>
+#include <QFile>
+#include <QObject>
+#include <QStandardPaths>
+#include <QtTest/QtTest>
+
+#include "LadspaManager.h"
+
+class LadspaManagerTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		// Keep the cache away from the user's one
+		QStandardPaths::setTestModeEnabled(true);
+
+		// Scan the LADSPA plugins built with LMMS, as PluginFactory would find them
+		const auto pluginDir = qgetenv("LMMS_PLUGIN_DIR");
+		if (!pluginDir.isEmpty()) { QDir::addSearchPath("plugins", QString::fromLocal8Bit(pluginDir)); }
+	}
+
+	void CachedMetadataMatchesLibraries()
+	{
+		using namespace lmms;
+
+		QFile::remove(LadspaManager::cacheFile());
+		LadspaManager scanned;
+		const auto plugins = scanned.getSortedPlugins();
+		// Without plugins there is no cache either
+		if (plugins.empty()) { QSKIP("No LADSPA plugins found, nothing to compare"); }
+		QVERIFY(QFile::exists(LadspaManager::cacheFile()));
+
+		LadspaManager cached;
+		QCOMPARE(cached.getSortedPlugins(), plugins);
+
+		for (const auto& plugin : plugins)
+		{
+			const auto& key = plugin.second;
+			QCOMPARE(cached.getMaker(key), scanned.getMaker(key));
+			QCOMPARE(cached.isRealTimeCapable(key), scanned.isRealTimeCapable(key));
+			QCOMPARE(cached.getDescription(key)->type, scanned.getDescription(key)->type);
+
+			const auto portCount = scanned.getPortCount(key);
+			QCOMPARE(cached.getPortCount(key), portCount);
+			for (uint32_t port = 0; port < portCount; ++port)
+			{
+				QCOMPARE(cached.getPortName(key, port), scanned.getPortName(key, port));
+				QCOMPARE(cached.isPortInput(key, port), scanned.isPortInput(key, port));
+				QCOMPARE(cached.getDefaultSetting(key, port), scanned.getDefaultSetting(key, port));
+			}
+
+			// The library is only loaded when the descriptor is needed
+			QVERIFY(cached.getDescriptor(key) != nullptr);
+			QCOMPARE(QString(cached.getDescriptor(key)->Label), cached.getLabel(key));
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(LadspaManagerTest)
+#include "LadspaManagerTest.moc"
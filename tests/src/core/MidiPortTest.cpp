@@ -0,0 +1,140 @@
+/*
+ * MidiPortTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <chrono>
+#include <vector>
+
+#include "AudioEngine.h"
+#include "Engine.h"
+#include "MidiDummy.h"
+#include "MidiEventProcessor.h"
+#include "MidiPort.h"
+
+namespace
+{
+
+using namespace lmms;
+
+//! Keeps the events the port hands over
+struct EventRecorder : public MidiEventProcessor
+{
+	void processInEvent(const MidiEvent& event, const TimePos& /*time*/, f_cnt_t offset) override
+	{
+		events.push_back(event);
+		offsets.push_back(offset);
+	}
+
+	void processOutEvent(const MidiEvent&, const TimePos&, f_cnt_t) override {}
+
+	std::vector<MidiEvent> events;
+	std::vector<f_cnt_t> offsets;
+};
+
+} // namespace
+
+class MidiPortTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void PlacesEventsWhereTheyArrived()
+	{
+		using namespace lmms;
+		using namespace std::chrono_literals;
+
+		const auto start = MidiPort::Clock::time_point{} + 1s;
+		QCOMPARE(MidiPort::inputFrameOffset(start, start, 100, 1000), f_cnt_t{0});
+		QCOMPARE(MidiPort::inputFrameOffset(start + 25ms, start, 100, 1000), f_cnt_t{25});
+		QCOMPARE(MidiPort::inputFrameOffset(start + 20ms, start, 100, 2000), f_cnt_t{40});
+
+		// Late events start right away, events stamped after the period at its last frame
+		QCOMPARE(MidiPort::inputFrameOffset(start - 300ms, start, 100, 1000), f_cnt_t{0});
+		QCOMPARE(MidiPort::inputFrameOffset(start + 100ms, start, 100, 1000), f_cnt_t{99});
+		QCOMPARE(MidiPort::inputFrameOffset(start + 1s, start, 100, 1000), f_cnt_t{99});
+	}
+
+	void QueueGrowsWithThePeriod()
+	{
+		using namespace lmms;
+
+		QCOMPARE(MidiPort::inputQueueSize(256, 44100), std::size_t{256});
+		QVERIFY(MidiPort::inputQueueSize(4096, 44100) > MidiPort::inputQueueSize(2048, 44100));
+		QVERIFY(MidiPort::inputQueueSize(4096, 44100) > MidiPort::inputQueueSize(4096, 96000));
+	}
+
+	void NeverDropsNoteOffs()
+	{
+		using namespace lmms;
+
+		// Keep the engine from emptying the queue meanwhile
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+
+		MidiDummy client;
+		EventRecorder recorder;
+		MidiPort port("test", &client, &recorder, nullptr, MidiPort::Mode::Input);
+		port.setInputQueued(true);
+
+		const auto frames = Engine::audioEngine()->framesPerPeriod();
+		const auto sampleRate = Engine::audioEngine()->processingSampleRate();
+		const auto size = MidiPort::inputQueueSize(frames, sampleRate);
+		for (std::size_t i = 0; i < 3 * size; ++i)
+		{
+			port.processInEvent(MidiEvent(MidiNoteOn, 0, 60, 100));
+		}
+		port.processInEvent(MidiEvent(MidiNoteOff, 0, 60, 0));
+		port.processInEvent(MidiEvent(MidiControlChange, 0, MidiControllerAllNotesOff, 0));
+
+		// Note ons beyond the queue and the overflow are lost, the note offs come last as they arrived
+		MidiPort::processQueuedInEvents(frames, sampleRate);
+		const auto& events = recorder.events;
+		QVERIFY(events.size() >= size + 2);
+		QVERIFY(events.size() < 3 * size + 2);
+		QCOMPARE(events[events.size() - 2].type(), MidiNoteOff);
+		QCOMPARE(events.back().type(), MidiControlChange);
+		QCOMPARE(events.back().controllerNumber(), static_cast<uint8_t>(MidiControllerAllNotesOff));
+
+		// Once emptied, events go through the queue again
+		recorder.events.clear();
+		port.processInEvent(MidiEvent(MidiNoteOn, 0, 62, 100));
+		MidiPort::processQueuedInEvents(frames, sampleRate);
+		QCOMPARE(recorder.events.size(), std::size_t{1});
+		QCOMPARE(recorder.events.front().key(), int16_t{62});
+
+		port.setInputQueued(false);
+	}
+};
+
+QTEST_GUILESS_MAIN(MidiPortTest)
+#include "MidiPortTest.moc"
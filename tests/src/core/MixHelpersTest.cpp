@@ -0,0 +1,188 @@
+/*
+ * MixHelpersTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "MixHelpers.h"
+#include "ValueBuffer.h"
+
+namespace
+{
+
+using namespace lmms;
+
+using Frames = std::vector<sampleFrame>;
+
+Frames testSignal(int frames, float offset)
+{
+	auto buffer = Frames(frames);
+	for (int f = 0; f < frames; ++f)
+	{
+		buffer[f] = {std::sin(offset + f * 0.1f), std::cos(offset + f * 0.3f)};
+	}
+	return buffer;
+}
+
+} // namespace
+
+class MixHelpersTest : public QObject
+{
+	Q_OBJECT
+private:
+	void compareFrames(const Frames& actual, const Frames& expected)
+	{
+		QCOMPARE(actual.size(), expected.size());
+		for (std::size_t f = 0; f < actual.size(); ++f)
+		{
+			QCOMPARE(actual[f][0], expected[f][0]);
+			QCOMPARE(actual[f][1], expected[f][1]);
+		}
+	}
+
+private slots:
+	void initTestCase()
+	{
+		lmms::MixHelpers::setNaNHandler(true);
+	}
+
+	void cleanupTestCase()
+	{
+		lmms::MixHelpers::setNaNHandler(false);
+	}
+
+	//! The kernels process two frames at a time, so odd lengths and tiny buffers need checking
+	void KernelTests_data()
+	{
+		QTest::addColumn<int>("frames");
+		QTest::newRow("empty") << 0;
+		QTest::newRow("one frame") << 1;
+		QTest::newRow("odd") << 7;
+		QTest::newRow("period") << 256;
+	}
+
+	void KernelTests()
+	{
+		using namespace lmms;
+		QFETCH(int, frames);
+
+		const auto src = testSignal(frames, 0.f);
+		const auto dst = testSignal(frames, 1.f);
+		auto coeffs = ValueBuffer(frames);
+		for (int f = 0; f < frames; ++f) { coeffs.values()[f] = 0.5f + 0.01f * f; }
+
+		auto actual = dst;
+		auto expected = dst;
+		MixHelpers::addSwappedMultiplied(actual.data(), src.data(), 0.5f, frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			expected[f][0] += src[f][1] * 0.5f;
+			expected[f][1] += src[f][0] * 0.5f;
+		}
+		compareFrames(actual, expected);
+
+		actual = dst;
+		expected = dst;
+		MixHelpers::addMultipliedByBuffer(actual.data(), src.data(), 0.5f, &coeffs, frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			expected[f][0] += src[f][0] * 0.5f * coeffs.values()[f];
+			expected[f][1] += src[f][1] * 0.5f * coeffs.values()[f];
+		}
+		compareFrames(actual, expected);
+
+		const auto left = std::vector<sample_t>(frames, 0.25f);
+		const auto right = std::vector<sample_t>(frames, -0.25f);
+		actual = dst;
+		expected = dst;
+		MixHelpers::multiplyAndAddMultipliedJoined(actual.data(), left.data(), right.data(), 0.5f, 2.f, frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			expected[f][0] = dst[f][0] * 0.5f + 0.5f;
+			expected[f][1] = dst[f][1] * 0.5f - 0.5f;
+		}
+		compareFrames(actual, expected);
+
+		// panning only attenuates the opposite channel
+		const auto volume = ValueSpan(coeffs.values(), frames);
+		const auto panning = ValueSpan(-100.f, 100.f, frames);
+		actual = dst;
+		expected = dst;
+		MixHelpers::multiplyByVolumeAndPanning(actual.data(), volume, panning, frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			const float v = volume[f] * 0.01f;
+			const float p = panning[f] * 0.01f;
+			expected[f][0] *= (p <= 0 ? 1.0f : 1.0f - p) * v;
+			expected[f][1] *= (p >= 0 ? 1.0f : 1.0f + p) * v;
+		}
+		compareFrames(actual, expected);
+
+		auto silence = Frames(frames);
+		QVERIFY(MixHelpers::isSilent(silence.data(), frames));
+		if (frames > 0)
+		{
+			silence.back()[1] = 0.001f;
+			QVERIFY(!MixHelpers::isSilent(silence.data(), frames));
+		}
+	}
+
+	void SanitizeTests()
+	{
+		using namespace lmms;
+		const int frames = 7;
+		const auto dst = testSignal(frames, 1.f);
+
+		auto src = testSignal(frames, 0.f);
+		src[2][0] = std::numeric_limits<float>::infinity();
+		src[6][1] = std::numeric_limits<float>::quiet_NaN();
+
+		// bad samples are skipped when mixing...
+		auto actual = dst;
+		auto expected = dst;
+		MixHelpers::addSanitizedMultipliedBySpans(actual.data(), src.data(), ValueSpan(0.5f, frames),
+			ValueSpan(0.f, 1.f, frames), frames);
+		for (int f = 0; f < frames; ++f)
+		{
+			const float ramp = static_cast<float>(f) / frames;
+			for (int c = 0; c < 2; ++c)
+			{
+				expected[f][c] += std::isfinite(src[f][c]) ? src[f][c] * 0.5f * ramp : 0.f;
+			}
+		}
+		compareFrames(actual, expected);
+
+		// ...and clear the whole buffer when sanitizing it
+		QVERIFY(MixHelpers::sanitize(src.data(), frames));
+		compareFrames(src, Frames(frames));
+
+		auto loud = Frames(frames, sampleFrame{2000.f, -2000.f});
+		QVERIFY(!MixHelpers::sanitize(loud.data(), frames));
+		compareFrames(loud, Frames(frames, sampleFrame{1000.f, -1000.f}));
+	}
+};
+
+QTEST_GUILESS_MAIN(MixHelpersTest)
+#include "MixHelpersTest.moc"
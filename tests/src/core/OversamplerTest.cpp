@@ -0,0 +1,158 @@
+/*
+ * OversamplerTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "Oversampler.h"
+#include "lmms_constants.h"
+
+namespace
+{
+
+//! Frames per measurement window at the original rate. Test tones sit on exact bins of it.
+constexpr int Window = 4096;
+constexpr int Period = 256;
+
+//! Amplitude of the component at @p bin in channel @p channel, with the whole buffer as one window
+double amplitude(const std::vector<lmms::sampleFrame>& buffer, int channel, int bin)
+{
+	const auto samples = buffer.size();
+	auto sum = std::complex<double>{};
+	for (auto n = std::size_t{0}; n < samples; ++n)
+	{
+		sum += static_cast<double>(buffer[n][channel]) * std::polar(1.0, -lmms::D_2PI * bin * n / samples);
+	}
+	return 2 * std::abs(sum) / samples;
+}
+
+double toDecibels(double amplitude)
+{
+	return 20 * std::log10(amplitude);
+}
+
+//! Sends a sine at @p bin through the oversampler for a few windows so the filters settle, then returns the
+//! last window of the oversampled signal in @p upsampled and of the downsampled signal in @p output
+void runSine(lmms::Oversampler& oversampler, int bin,
+	std::vector<lmms::sampleFrame>& upsampled, std::vector<lmms::sampleFrame>& output)
+{
+	using namespace lmms;
+
+	constexpr int Windows = 4;
+	const auto factor = oversampler.factor();
+	upsampled.resize(Window * factor);
+	output.resize(Window);
+
+	auto period = std::vector<sampleFrame>(Period);
+	for (int frame = 0; frame < Windows * Window; frame += Period)
+	{
+		for (int f = 0; f < Period; ++f)
+		{
+			const auto phase = D_2PI * bin * (frame + f) / Window;
+			// Distinct channels make sure they are not mixed up
+			period[f] = {static_cast<float>(std::sin(phase)), static_cast<float>(0.5 * std::cos(phase))};
+		}
+
+		const auto up = oversampler.upsample(period.data(), Period);
+		const auto pos = frame % Window;
+		std::copy(up, up + Period * factor, upsampled.begin() + pos * factor);
+		oversampler.downsample(period.data(), Period);
+		std::copy(period.begin(), period.end(), output.begin() + pos);
+	}
+}
+
+} // namespace
+
+class OversamplerTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	//! Tones throughout the audible band come through at their level, at the higher rate and back
+	void PassbandHasUnityGain()
+	{
+		using namespace lmms;
+
+		// About 1 kHz and 18 kHz at 44.1 kHz
+		const int bins[] = {93, 1672};
+		const double levels[] = {1.0, 0.5};
+
+		for (int stages = 1; stages <= Oversampler::MaxStages; ++stages)
+		{
+			auto oversampler = Oversampler{stages};
+			for (const auto bin : bins)
+			{
+				auto upsampled = std::vector<sampleFrame>{};
+				auto output = std::vector<sampleFrame>{};
+				runSine(oversampler, bin, upsampled, output);
+
+				for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+				{
+					const auto up = toDecibels(amplitude(upsampled, ch, bin) / levels[ch]);
+					const auto down = toDecibels(amplitude(output, ch, bin) / levels[ch]);
+					QVERIFY2(std::abs(up) < 0.1, qPrintable(QString("%1x, bin %2: %3 dB at the higher rate")
+						.arg(oversampler.factor()).arg(bin).arg(up)));
+					QVERIFY2(std::abs(down) < 0.1, qPrintable(QString("%1x, bin %2: %3 dB after downsampling")
+						.arg(oversampler.factor()).arg(bin).arg(down)));
+				}
+			}
+		}
+	}
+
+	//! Upsampling leaves no audible images of a tone above the original Nyquist frequency
+	void ImagesAreRejected()
+	{
+		using namespace lmms;
+
+		constexpr double MinRejection = 80.0;
+		const int bins[] = {93, 1672};
+
+		for (int stages = 1; stages <= Oversampler::MaxStages; ++stages)
+		{
+			auto oversampler = Oversampler{stages};
+			const auto factor = oversampler.factor();
+			for (const auto bin : bins)
+			{
+				auto upsampled = std::vector<sampleFrame>{};
+				auto output = std::vector<sampleFrame>{};
+				runSine(oversampler, bin, upsampled, output);
+
+				// The images of the tone lie mirrored around every multiple of the original rate
+				for (int multiple = 1; multiple < factor; ++multiple)
+				{
+					for (const auto image : {multiple * Window - bin, multiple * Window + bin})
+					{
+						if (image > factor * Window / 2) { continue; }
+						const auto rejection = -toDecibels(amplitude(upsampled, 0, image));
+						QVERIFY2(rejection > MinRejection, qPrintable(QString("%1x, bin %2: image at bin %3 is only "
+							"%4 dB down").arg(factor).arg(bin).arg(image).arg(rejection)));
+					}
+				}
+			}
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(OversamplerTest)
+#include "OversamplerTest.moc"
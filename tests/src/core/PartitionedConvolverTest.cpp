@@ -0,0 +1,169 @@
+/*
+ * PartitionedConvolverTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "PartitionedConvolver.h"
+
+namespace
+{
+
+std::vector<lmms::sampleFrame> noise(std::size_t frames, unsigned int seed)
+{
+	auto generator = std::mt19937{seed};
+	auto distribution = std::uniform_real_distribution<float>{-1.f, 1.f};
+
+	auto buffer = std::vector<lmms::sampleFrame>(frames);
+	for (auto& frame : buffer)
+	{
+		frame = {distribution(generator), distribution(generator)};
+	}
+	return buffer;
+}
+
+//! Processes the buffer in place, in periods of varying length like the engine would after tempo or setting changes
+void processInPeriods(lmms::PartitionedConvolver& convolver, std::vector<lmms::sampleFrame>& buffer)
+{
+	const int periods[] = {64, 37, 256, 1000};
+	auto period = std::size_t{0};
+	for (auto pos = std::size_t{0}; pos < buffer.size(); )
+	{
+		const auto frames = std::min<std::size_t>(periods[period++ % 4], buffer.size() - pos);
+		convolver.process(&buffer[pos], &buffer[pos], frames);
+		pos += frames;
+	}
+}
+
+} // namespace
+
+class PartitionedConvolverTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void ImpulseReproducesResponseWithoutLatency()
+	{
+		using namespace lmms;
+
+		const auto ir = noise(3 * PartitionedConvolver::TailOffset, 1);
+		PartitionedConvolver convolver;
+		convolver.setImpulseResponse(ir.data(), ir.size());
+
+		auto buffer = std::vector<sampleFrame>(ir.size() + PartitionedConvolver::TailBlockSize);
+		buffer[0] = {1.f, 1.f};
+		processInPeriods(convolver, buffer);
+
+		for (auto f = std::size_t{0}; f < buffer.size(); ++f)
+		{
+			const auto expected = f < ir.size() ? ir[f] : sampleFrame{};
+			QVERIFY(std::abs(buffer[f][0] - expected[0]) < 1e-4f);
+			QVERIFY(std::abs(buffer[f][1] - expected[1]) < 1e-4f);
+		}
+	}
+
+	void MatchesDirectConvolution()
+	{
+		using namespace lmms;
+
+		// Long enough to use all three segments of the response
+		const auto ir = noise(PartitionedConvolver::TailOffset + 5000, 2);
+		const auto input = noise(20000, 3);
+
+		PartitionedConvolver convolver;
+		convolver.setImpulseResponse(ir.data(), ir.size());
+
+		auto output = input;
+		processInPeriods(convolver, output);
+
+		for (auto f = std::size_t{0}; f < output.size(); f += 7)
+		{
+			for (int ch = 0; ch < DEFAULT_CHANNELS; ++ch)
+			{
+				auto expected = 0.0;
+				for (auto tap = std::size_t{0}; tap < ir.size() && tap <= f; ++tap)
+				{
+					expected += ir[tap][ch] * input[f - tap][ch];
+				}
+				QVERIFY(std::abs(output[f][ch] - expected) < 1e-3);
+			}
+		}
+	}
+
+	void ResetClearsHistory()
+	{
+		using namespace lmms;
+
+		const auto ir = noise(PartitionedConvolver::TailOffset * 2, 4);
+		PartitionedConvolver convolver;
+		convolver.setImpulseResponse(ir.data(), ir.size());
+
+		auto buffer = noise(PartitionedConvolver::TailOffset, 5);
+		processInPeriods(convolver, buffer);
+		convolver.reset();
+
+		auto silence = std::vector<sampleFrame>(ir.size());
+		processInPeriods(convolver, silence);
+		for (const auto& frame : silence)
+		{
+			QCOMPARE(frame[0], 0.f);
+			QCOMPARE(frame[1], 0.f);
+		}
+	}
+
+	//! One second of audio through a six second stereo response at 44.1 kHz in 64 frame periods.
+	//! The time per iteration is the share of one core the effect would need.
+	void BenchmarkSixSecondResponse()
+	{
+		using namespace lmms;
+
+		constexpr auto SampleRate = 44100;
+		constexpr auto Period = 64;
+
+		auto ir = noise(6 * SampleRate, 6);
+		for (auto f = std::size_t{0}; f < ir.size(); ++f)
+		{
+			const auto decay = std::exp(-6.9f * f / ir.size());
+			ir[f][0] *= decay;
+			ir[f][1] *= decay;
+		}
+
+		PartitionedConvolver convolver;
+		convolver.setImpulseResponse(ir.data(), ir.size());
+
+		auto input = noise(SampleRate / Period * Period, 7);
+		auto output = std::vector<sampleFrame>(input.size());
+
+		QBENCHMARK
+		{
+			for (auto pos = std::size_t{0}; pos < input.size(); pos += Period)
+			{
+				convolver.process(&input[pos], &output[pos], Period);
+			}
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(PartitionedConvolverTest)
+#include "PartitionedConvolverTest.moc"
@@ -0,0 +1,155 @@
+/*
+ * PeakControllerTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <cmath>
+#include <vector>
+
+#include "ControllerConnection.h"
+#include "Effect.h"
+#include "EffectChain.h"
+#include "Engine.h"
+#include "Mixer.h"
+#include "PeakController.h"
+#include "ValueBuffer.h"
+#include "plugins/PeakControllerEffect/PeakControllerEffect.h"
+
+class PeakControllerTest : public QObject
+{
+	Q_OBJECT
+private:
+	//! Adds a detector to @p chain, nullptr if the plugin isn't available
+	static lmms::PeakControllerEffect* addDetector(lmms::EffectChain& chain)
+	{
+		using namespace lmms;
+
+		const auto effect = Effect::instantiate("peakcontrollereffect", &chain, nullptr);
+		if (effect == nullptr) { return nullptr; }
+		chain.appendEffect(effect);
+		effect->startRunning();
+		return static_cast<PeakControllerEffect*>(effect);
+	}
+
+private slots:
+	void initTestCase()
+	{
+		using namespace lmms;
+		Engine::init(true);
+	}
+
+	void cleanupTestCase()
+	{
+		using namespace lmms;
+		Engine::destroy();
+	}
+
+	void cleanup()
+	{
+		using namespace lmms;
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+		Engine::mixer()->clear();
+	}
+
+	void EnvelopeFollowsEachFrame()
+	{
+		using namespace lmms;
+
+		// Keep the engine from rendering periods meanwhile
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+
+		auto chain = EffectChain{nullptr};
+		const auto detector = addDetector(chain);
+		if (detector == nullptr) { QSKIP("Peak controller plugin not found"); }
+
+		// The default settings add the RMS level of the signal to a base of 0.5
+		const auto frames = Engine::audioEngine()->framesPerPeriod();
+		const auto expected = 0.5f + std::sqrt(2 * 0.25f * 0.25f);
+		auto buffer = std::vector<sampleFrame>(frames);
+		auto last = 0.f;
+		for (int period = 0; period < 8; ++period)
+		{
+			std::fill(buffer.begin(), buffer.end(), sampleFrame{0.25f, 0.25f});
+			detector->processAudioBuffer(buffer.data(), frames);
+
+			const auto& envelope = detector->envelope();
+			QCOMPARE(envelope.size(), static_cast<std::size_t>(frames));
+			// The envelope rises within the period rather than once per period
+			if (period == 0) { QVERIFY(envelope.front() < envelope.back()); }
+			for (const auto value : envelope)
+			{
+				QVERIFY(value >= last);
+				last = value;
+			}
+		}
+		QVERIFY(std::abs(last - expected) < 0.01f);
+
+		// The controller hands out the envelope of the period once it is published
+		PeakController::publishEnvelopes(&chain);
+		const auto values = detector->controller()->valueBuffer()->values();
+		for (fpp_t f = 0; f < frames; ++f)
+		{
+			QCOMPARE(values[f], detector->envelope()[f]);
+		}
+	}
+
+	void ChannelsWaitForTheirDetectors()
+	{
+		using namespace lmms;
+
+		const auto guard = Engine::audioEngine()->requestChangesGuard();
+
+		const auto mixer = Engine::mixer();
+		const auto source = mixer->mixerChannel(mixer->createChannel());
+		const auto targetIndex = mixer->createChannel();
+		const auto target = mixer->mixerChannel(targetIndex);
+
+		const auto detector = addDetector(source->m_fxChain);
+		if (detector == nullptr) { QSKIP("Peak controller plugin not found"); }
+		target->m_volumeModel.setControllerConnection(new ControllerConnection(detector->controller()));
+
+		mixer->updateSidechains();
+		QCOMPARE(source->m_sidechainTargets, std::vector<MixerChannel*>{target});
+		QCOMPARE(target->m_sidechainSources, 1);
+		QVERIFY(target->m_sidechainTargets.empty());
+		QCOMPARE(source->m_sidechainSources, 0);
+
+		// A channel feeding the detector's channel runs before it anyway
+		mixer->createChannelSend(targetIndex, source->m_channelIndex);
+		mixer->updateSidechains();
+		QVERIFY(source->m_sidechainTargets.empty());
+		QCOMPARE(target->m_sidechainSources, 0);
+
+		mixer->deleteChannelSend(targetIndex, source->m_channelIndex);
+		mixer->updateSidechains();
+		QCOMPARE(source->m_sidechainTargets, std::vector<MixerChannel*>{target});
+
+		// Disconnecting the controller lets the channel run right away again
+		delete target->m_volumeModel.controllerConnection();
+		mixer->updateSidechains();
+		QVERIFY(source->m_sidechainTargets.empty());
+		QCOMPARE(target->m_sidechainSources, 0);
+	}
+};
+
+QTEST_GUILESS_MAIN(PeakControllerTest)
+#include "PeakControllerTest.moc"
@@ -0,0 +1,101 @@
+/*
+ * TempoMapTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+
+#include "TempoMap.h"
+
+class TempoMapTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void ConstantTempo()
+	{
+		using namespace lmms;
+
+		// 44100 * 60 * 4 / 192 / 140 frames per tick
+		auto map = TempoMap{44100, 140};
+		QCOMPARE(map.framesPerTickAt(1000), 393.75);
+		QCOMPARE(map.frames(192), 192 * 393.75);
+		QCOMPARE(map.frames(-10), -3937.5);
+		QCOMPARE(map.ticks(393.75 * 2.5), 2.5);
+		QCOMPARE(map.milliseconds(192 * 4), 60000.0 / 140 * 4);
+	}
+
+	void IntegratesTempoChanges()
+	{
+		using namespace lmms;
+
+		auto map = TempoMap{44100, 140};
+		map.setTempo(100, 120);
+		map.setTempo(300, 60);
+		QCOMPARE(map.changes(), std::size_t{3});
+
+		QCOMPARE(map.tempoAt(99), bpm_t{140});
+		QCOMPARE(map.tempoAt(100), bpm_t{120});
+		QCOMPARE(map.tempoAt(100000), bpm_t{60});
+
+		const auto at300 = 100 * 393.75 + 200 * 459.375;
+		QCOMPARE(map.frames(100), 100 * 393.75);
+		QCOMPARE(map.frames(300), at300);
+		QCOMPARE(map.frames(310.5), at300 + 10.5 * 918.75);
+
+		for (double tick : {0.0, 50.25, 100.0, 299.5, 300.0, 1234.75})
+		{
+			QCOMPARE(map.ticks(map.frames(tick)), tick);
+		}
+	}
+
+	void SettingTempoDropsLaterChanges()
+	{
+		using namespace lmms;
+
+		auto map = TempoMap{44100, 140};
+		map.setTempo(100, 120);
+		map.setTempo(300, 60);
+
+		map.setTempo(200, 120);
+		QCOMPARE(map.changes(), std::size_t{2});
+		QCOMPARE(map.tempoAt(1000), bpm_t{120});
+
+		map.setTempo(0, 60);
+		QCOMPARE(map.changes(), std::size_t{1});
+		QCOMPARE(map.frames(10), 10 * 918.75);
+	}
+
+	void FollowsSampleRate()
+	{
+		using namespace lmms;
+
+		auto map = TempoMap{44100, 140};
+		map.setTempo(100, 120);
+		map.setSampleRate(88200);
+
+		QCOMPARE(map.sampleRate(), sample_rate_t{88200});
+		QCOMPARE(map.frames(200), 2 * (100 * 393.75 + 100 * 459.375));
+		QCOMPARE(map.milliseconds(200), 1000.0 * (100 * 393.75 + 100 * 459.375) / 44100);
+	}
+};
+
+QTEST_GUILESS_MAIN(TempoMapTest)
+#include "TempoMapTest.moc"
@@ -0,0 +1,131 @@
+/*
+ * UserWaveformTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <cmath>
+#include <vector>
+
+#include "UserWaveform.h"
+#include "lmms_constants.h"
+
+class UserWaveformTest : public QObject
+{
+	Q_OBJECT
+private:
+	static std::vector<float> square(int length)
+	{
+		auto wave = std::vector<float>(length);
+		for (int i = 0; i < length; ++i)
+		{
+			wave[i] = i < length / 2 ? 1.f : -1.f;
+		}
+		return wave;
+	}
+
+private slots:
+	void LowBandsKeepTheWave()
+	{
+		using namespace lmms;
+
+		const auto wave = square(200);
+		const auto waveform = UserWaveform::generate(wave.data(), static_cast<int>(wave.size()));
+
+		// With every harmonic kept, the table is the wave stretched over it. Right before the edges, the table
+		// already interpolates towards the next sample.
+		for (int i = 0; i < 200; ++i)
+		{
+			if (wave[i] != wave[(i + 1) % 200]) { continue; }
+			QVERIFY(std::abs(UserWaveform::sample(*waveform, 1, i / 200.f) - wave[i]) < 0.01f);
+		}
+	}
+
+	void HighBandsOnlyKeepAudibleHarmonics()
+	{
+		using namespace lmms;
+
+		const auto wave = square(200);
+		const auto waveform = UserWaveform::generate(wave.data(), static_cast<int>(wave.size()));
+
+		// The highest band only has room for the fundamental, which for a square has an amplitude of 4 / pi. The
+		// edges of the interpolated square lie half a sample late.
+		const auto band = OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1;
+		for (float phase = 0.f; phase < 1.f; phase += 0.01f)
+		{
+			const auto expected = 4.f / F_PI * std::sin(F_2PI * (phase + 0.5f / 200));
+			QVERIFY(std::abs(UserWaveform::sample(*waveform, band, phase) - expected) < 0.01f);
+		}
+	}
+
+	void PicksBandsLikeOscillator()
+	{
+		using namespace lmms;
+
+		QCOMPARE(UserWaveform::band(440.f), 69);
+		QCOMPARE(UserWaveform::band(1.f), 1);
+		QCOMPARE(UserWaveform::band(100000.f), OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1);
+	}
+
+	void GeneratesInTheBackground()
+	{
+		using namespace lmms;
+
+		auto userWaveform = UserWaveform{};
+		QVERIFY(!userWaveform.waveform());
+
+		const auto wave = square(200);
+		userWaveform.update(wave.data(), static_cast<int>(wave.size()));
+		QTRY_VERIFY(userWaveform.waveform() != nullptr);
+
+		const auto band = OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1;
+		QVERIFY(std::abs(UserWaveform::sample(*userWaveform.waveform(), band, 0.25f) - 4.f / F_PI) < 0.01f);
+	}
+
+	void NeverReturnsTablesOfAnOlderWave()
+	{
+		using namespace lmms;
+
+		auto userWaveform = UserWaveform{};
+		const auto wave = square(200);
+		userWaveform.updateNow(wave.data(), static_cast<int>(wave.size()));
+		QVERIFY(userWaveform.waveform() != nullptr);
+
+		// Until the tables of the inverted wave are done, voices have to play the wave itself
+		auto inverted = wave;
+		for (auto& sample : inverted) { sample = -sample; }
+		userWaveform.update(inverted.data(), static_cast<int>(inverted.size()));
+		QVERIFY(!userWaveform.waveform());
+		QTRY_VERIFY(userWaveform.waveform() != nullptr);
+
+		const auto band = OscillatorConstants::WAVE_TABLES_PER_WAVEFORM_COUNT - 1;
+		QVERIFY(std::abs(UserWaveform::sample(*userWaveform.waveform(), band, 0.25f) + 4.f / F_PI) < 0.01f);
+
+		// Generating right away wins over a background update still in progress
+		userWaveform.update(wave.data(), static_cast<int>(wave.size()));
+		userWaveform.updateNow(inverted.data(), static_cast<int>(inverted.size()));
+		QTest::qWait(100);
+		QVERIFY(std::abs(UserWaveform::sample(*userWaveform.waveform(), band, 0.25f) + 4.f / F_PI) < 0.01f);
+	}
+};
+
+QTEST_GUILESS_MAIN(UserWaveformTest)
+#include "UserWaveformTest.moc"
@@ -0,0 +1,163 @@
+/*
+ * VoicePoolTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <atomic>
+#include <set>
+#include <vector>
+
+#ifdef __MINGW32__
+#include <mingw.thread.h>
+#else
+#include <thread>
+#endif
+
+#include "VoicePool.h"
+
+namespace
+{
+
+std::atomic<int> s_liveVoices = 0;
+
+struct TestVoice
+{
+	TestVoice(int note, float velocity) : note(note), velocity(velocity) { ++s_liveVoices; }
+	~TestVoice() { --s_liveVoices; }
+
+	int note;
+	float velocity;
+};
+
+} // namespace
+
+class VoicePoolTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void init()
+	{
+		s_liveVoices = 0;
+	}
+
+	void ConstructsAndDestroysVoices()
+	{
+		using namespace lmms;
+
+		auto pool = VoicePool<TestVoice>{4};
+		QCOMPARE(pool.capacity(), std::size_t{4});
+
+		auto voice = pool.acquire(60, 0.5f);
+		QCOMPARE(voice->note, 60);
+		QCOMPARE(voice->velocity, 0.5f);
+		QCOMPARE(s_liveVoices.load(), 1);
+
+		pool.release(voice);
+		QCOMPARE(s_liveVoices.load(), 0);
+
+		pool.release(nullptr);
+		QCOMPARE(s_liveVoices.load(), 0);
+	}
+
+	void ReusesReleasedSlots()
+	{
+		using namespace lmms;
+
+		auto pool = VoicePool<TestVoice>{2};
+		auto first = pool.acquire(1, 1.f);
+		auto second = pool.acquire(2, 1.f);
+		QVERIFY(first != second);
+
+		pool.release(first);
+		auto third = pool.acquire(3, 1.f);
+		QCOMPARE(third, first);
+		QCOMPARE(third->note, 3);
+
+		pool.release(second);
+		pool.release(third);
+		QCOMPARE(s_liveVoices.load(), 0);
+	}
+
+	void FallsBackToHeapWhenExhausted()
+	{
+		using namespace lmms;
+
+		auto pool = VoicePool<TestVoice>{2};
+		auto voices = std::vector<TestVoice*>{};
+		for (int note = 0; note < 5; ++note)
+		{
+			voices.push_back(pool.acquire(note, 1.f));
+		}
+		QCOMPARE(s_liveVoices.load(), 5);
+		QCOMPARE(std::set<TestVoice*>(voices.begin(), voices.end()).size(), voices.size());
+		for (int note = 0; note < 5; ++note)
+		{
+			QCOMPARE(voices[note]->note, note);
+		}
+
+		// Releasing the heap voices must not hand them out as pool slots later on
+		for (auto voice : voices) { pool.release(voice); }
+		QCOMPARE(s_liveVoices.load(), 0);
+
+		auto reused = std::set<TestVoice*>{pool.acquire(0, 1.f), pool.acquire(1, 1.f)};
+		QVERIFY(reused.count(voices[0]) == 1 && reused.count(voices[1]) == 1);
+		for (auto voice : reused) { pool.release(voice); }
+	}
+
+	void SurvivesConcurrentUse()
+	{
+		using namespace lmms;
+
+		constexpr int Threads = 4;
+		constexpr int Rounds = 20000;
+		auto pool = VoicePool<TestVoice>{Threads * 2};
+		auto failures = std::atomic<int>{0};
+
+		auto worker = [&](int id)
+		{
+			for (int round = 0; round < Rounds; ++round)
+			{
+				// Take more voices than each thread's share so the heap fallback races as well
+				auto a = pool.acquire(id, 0.f);
+				auto b = pool.acquire(id + Threads, 0.f);
+				auto c = pool.acquire(id + 2 * Threads, 0.f);
+				if (a->note != id || b->note != id + Threads || c->note != id + 2 * Threads) { ++failures; }
+				pool.release(b);
+				pool.release(a);
+				pool.release(c);
+			}
+		};
+
+		auto threads = std::vector<std::thread>{};
+		for (int id = 0; id < Threads; ++id)
+		{
+			threads.emplace_back(worker, id);
+		}
+		for (auto& thread : threads) { thread.join(); }
+
+		QCOMPARE(failures.load(), 0);
+		QCOMPARE(s_liveVoices.load(), 0);
+	}
+};
+
+QTEST_GUILESS_MAIN(VoicePoolTest)
+#include "VoicePoolTest.moc"
@@ -0,0 +1,169 @@
+/*
+ * XpressiveTest.cpp
+ *
+ * This file is part of LMMS - https://lmms.io
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public
+ * License along with this program (see COPYING); if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include <QObject>
+#include <QtTest/QtTest>
+#include <array>
+#include <cmath>
+#include <vector>
+
+#include "ExprSynth.h"
+
+namespace
+{
+
+using namespace lmms;
+
+constexpr int Frames = ExprFront::BlockSize * 3;
+constexpr int WaveLength = 32;
+
+//! An expression with the variables ExprSynth gives it, evaluated by exprtk and a block at a time
+struct Expression
+{
+	explicit Expression(const char* source) :
+		front(source, 100)
+	{
+		for (int i = 0; i < WaveLength; ++i)
+		{
+			wave[i] = std::sin(i * 0.3f) + 0.1f * i;
+		}
+		front.add_variable("t", t, blockT.data());
+		front.add_variable("f", f, blockF.data());
+		front.add_constant("key", 60);
+		front.add_cyclic_vector("W1", wave.data(), WaveLength, false);
+		front.add_cyclic_vector("W2", wave.data(), WaveLength, true);
+		front.setIntegrate(&frame, 44100);
+		front.compile();
+	}
+
+	// t sweeps through negative and positive values, f through typical frequencies
+	static float tAt(int i) { return -2.0f + 4.0f * i / Frames; }
+	static float fAt(int i) { return 50.0f + 3.3f * i; }
+
+	std::vector<float> evaluate()
+	{
+		auto out = std::vector<float>(Frames);
+		for (int i = 0; i < Frames; ++i)
+		{
+			t = tAt(i);
+			f = fAt(i);
+			frame = i;
+			out[i] = front.evaluate();
+		}
+		return out;
+	}
+
+	std::vector<float> evaluateBlocks()
+	{
+		auto out = std::vector<float>(Frames);
+		for (int offset = 0; offset < Frames; offset += ExprFront::BlockSize)
+		{
+			for (int i = 0; i < ExprFront::BlockSize; ++i)
+			{
+				blockT[i] = tAt(offset + i);
+				blockF[i] = fAt(offset + i);
+			}
+			t = blockT[0];
+			f = blockF[0];
+			front.evaluateBlock(out.data() + offset, ExprFront::BlockSize);
+		}
+		return out;
+	}
+
+	ExprFront front;
+	float t = 0;
+	float f = 0;
+	unsigned int frame = 0;
+	std::array<float, ExprFront::BlockSize> blockT{};
+	std::array<float, ExprFront::BlockSize> blockF{};
+	std::array<float, WaveLength> wave{};
+};
+
+} // namespace
+
+class XpressiveTest : public QObject
+{
+	Q_OBJECT
+private slots:
+	void BlockEvaluationMatchesExprtk_data()
+	{
+		QTest::addColumn<QString>("expression");
+
+		const char* expressions[] = {
+			// Operators and their precedence
+			"t+f", "t-f*2", "f/(t+3)", "t%0.3", "t^2", "-t^2", "2^t", "t*-2", "-t+1", "(t+1)*(f-3)",
+			"t<0.5", "t<=0", "t>0.5", "t>=0", "1.5e-1+t",
+			// Functions
+			"abs(t)", "sin(t)", "cos(t)", "tan(t)", "asin(t/2)", "acos(t/2)", "atan(t)",
+			"sinh(t)", "cosh(t)", "tanh(t)", "exp(t)", "log(f)", "log10(f)", "log2(f)", "sqrt(f)",
+			"floor(t*3)", "ceil(t*3)", "round(t*3)", "trunc(t*3)", "frac(t*3)", "sgn(t)",
+			"pow(f,0.5)", "atan2(t,f)", "hypot(t,f)", "min(t,0.5)", "max(t,0,-1)", "clamp(-0.5,t,0.5)",
+			// Xpressive's own functions and symbols
+			"sinew(t)", "squarew(t)", "trianglew(t)", "saww(t)", "moogsaww(t)", "moogw(t)",
+			"expw(t)", "expnw(t)", "cent(t*100)", "semitone(t*12)", "randv(f*10)", "randsv(f*10,3)",
+			"W1(t)", "W2(t)", "key+t", "pi*t", "e^t", "integrate(f)", "sinew(integrate(f))",
+			"0.5*sinew(t*f)+0.25*W2(t*f+key)",
+		};
+		for (const auto expression : expressions)
+		{
+			QTest::newRow(expression) << QString{expression};
+		}
+	}
+
+	void BlockEvaluationMatchesExprtk()
+	{
+		QFETCH(QString, expression);
+
+		// Both evaluators of one expression share the random seed
+		auto e = Expression{expression.toUtf8().constData()};
+		QVERIFY(e.front.isValid());
+		QVERIFY(e.front.isBlockCompiled());
+
+		const auto reference = e.evaluate();
+		const auto blocks = e.evaluateBlocks();
+		for (int i = 0; i < Frames; ++i)
+		{
+			const float a = reference[i];
+			const float b = blocks[i];
+			// Some library functions are computed differently by exprtk, allow for rounding
+			const bool equal = (std::isnan(a) && std::isnan(b)) || a == b
+				|| std::fabs(a - b) <= 1e-5f + 1e-4f * std::fabs(a);
+			if (!equal)
+			{
+				QFAIL(qPrintable(QString{"frame %1: exprtk gives %2, block evaluation %3"}.arg(i).arg(a).arg(b)));
+			}
+		}
+	}
+
+	void UnsupportedSyntaxFallsBackToExprtk()
+	{
+		for (const auto expression : {"last(1)+t", "2t", "t==0", "t^2^2"})
+		{
+			auto e = Expression{expression};
+			QVERIFY2(e.front.isValid(), expression);
+			QVERIFY2(!e.front.isBlockCompiled(), expression);
+		}
+	}
+};
+
+QTEST_GUILESS_MAIN(XpressiveTest)
+#include "XpressiveTest.moc"